@@ -0,0 +1,68 @@
+#import <XCTest/XCTest.h>
+#import <WPPostModel.h>
+#import <WPXMLRPC/WPXMLRPC.h>
+
+@interface WPLazyModelTests : XCTestCase
+@end
+
+@implementation WPLazyModelTests
+
+- (void)testPostModelsDecodeMembersOnFirstAccess {
+    NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data>"
+                          "<value><struct><member><name>postid</name><value><string>1</string></value></member>"
+                          "<member><name>title</name><value>Hello &amp; welcome</value></member>"
+                          "<member><name>categories</name><value><array><data><value><string>News</string></value></data></array></value></member>"
+                          "<member><name>dateCreated</name><value><dateTime.iso8601>20140102T03:04:05</dateTime.iso8601></value></member></struct></value>"
+                          "<value><struct><member><name>postid</name><value><int>2</int></value></member>"
+                          "<member><name>title</name><value><string></string></value></member></struct></value>"
+                          "</data></array></value></param></params></methodResponse>";
+    NSData *data = [response dataUsingEncoding:NSUTF8StringEncoding];
+
+    NSError *error = nil;
+    NSArray *posts = [WPPostModel modelsWithXMLRPCResponseData:data error:&error];
+    XCTAssertNil(error, @"Expected the response to be scanned without errors");
+    XCTAssertEqual([posts count], 2, @"Expected a model per post");
+    WPPostModel *first = posts[0];
+    WPPostModel *second = posts[1];
+    XCTAssertEqual(first.allKeys[0], second.allKeys[0], @"Expected member names to be shared");
+    XCTAssertEqualObjects(first.postId, @"1", @"Expected the post ID to be decoded");
+    XCTAssertEqualObjects(second.postId, @"2", @"Expected numeric IDs to be returned as strings");
+    XCTAssertEqualObjects(first.title, @"Hello & welcome", @"Expected untyped values to be decoded as strings");
+    XCTAssertNotNil(first.date, @"Expected dates to be decoded");
+    NSArray *decoded = [[WPXMLRPCDecoder alloc] initWithData:data].object;
+    XCTAssertEqualObjects(first.dictionaryValue, decoded[0], @"Expected models to decode like the full response");
+    XCTAssertEqualObjects(second.dictionaryValue, decoded[1], @"Expected models to decode like the full response");
+
+    NSString *fault = @"<?xml version=\"1.0\"?><methodResponse><fault><value><struct><member><name>faultCode</name><value><int>403</int></value></member>"
+                       "<member><name>faultString</name><value><string>Incorrect username or password.</string></value></member></struct></value></fault></methodResponse>";
+    XCTAssertNil([WPPostModel modelsWithXMLRPCResponseData:[fault dataUsingEncoding:NSUTF8StringEncoding] error:&error], @"Expected faults to return no models");
+    XCTAssertEqual(error.code, 403, @"Expected the fault to be returned as an error");
+}
+
+- (void)testPostModelsDecodeScalarsLikeTheXMLRPCDecoder {
+    NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data>"
+                          "<value><struct><member><name>title</name><value><string>Caf&#233; &amp; cr&#xE8;me &lt;b&gt; &quot;&apos;</string></value></member>"
+                          "<member><name>untyped</name><value>Plain &amp; simple</value></member>"
+                          "<member><name>empty</name><value><string/></value></member>"
+                          "<member><name>padded</name><value><string>Line\n</string></value></member>"
+                          "<member><name>cdata</name><value><string><![CDATA[<p>Raw</p>]]></string></value></member>"
+                          "<member><name>count</name><value><int>-42</int></value></member>"
+                          "<member><name>parent</name><value><i4>7</i4></value></member>"
+                          "<member><name>sticky</name><value><boolean>1</boolean></value></member>"
+                          "<member><name>ratio</name><value><double>0.25</double></value></member>"
+                          "<member><name>date</name><value><dateTime.iso8601>20140102T03:04:05</dateTime.iso8601></value></member>"
+                          "<member><name>terms</name><value><array><data><value><string>News</string></value></data></array></value></member>"
+                          "</struct></value></data></array></value></param></params></methodResponse>";
+    NSData *data = [response dataUsingEncoding:NSUTF8StringEncoding];
+
+    WPPostModel *model = [[WPPostModel modelsWithXMLRPCResponseData:data error:nil] firstObject];
+    NSDictionary *decoded = [[[WPXMLRPCDecoder alloc] initWithData:data].object firstObject];
+    for (NSString *key in decoded) {
+        XCTAssertEqualObjects([model objectForKey:key], decoded[key], @"Expected %@ to decode like the full response", key);
+    }
+    XCTAssertEqualObjects([model objectForKey:@"title"], @"Caf\u00e9 & cr\u00e8me <b> \"'", @"Expected entities to be replaced");
+    XCTAssertEqualObjects([model objectForKey:@"sticky"], @YES, @"Expected booleans to be decoded as numbers");
+    XCTAssertEqual([model objectForKey:@"title"], [model objectForKey:@"title"], @"Expected decoded values to be kept");
+}
+
+@end
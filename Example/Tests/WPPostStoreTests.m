@@ -0,0 +1,71 @@
+#import <XCTest/XCTest.h>
+#import <WPPostStore.h>
+#import <WPPostModel.h>
+
+@interface WPPostStoreTests : XCTestCase
+@end
+
+@implementation WPPostStoreTests
+
+- (void)testPostStoreIsReadBackAfterReopeningAndDropsCutRecords {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"poststore-%@/posts.store", [[NSUUID UUID] UUIDString]]];
+    NSString *site = @"http://mywordpresssite.com/xmlrpc.php#user";
+    unsigned long long length = 0;
+    // The store is closed before the file is reopened
+    @autoreleasepool {
+        WPPostStore *store = [[WPPostStore alloc] initWithPath:path];
+        [store storePosts:@[@{@"postid": @"1", @"title": @"Older", @"date_modified_gmt": [NSDate dateWithTimeIntervalSince1970:1000]},
+                            @{@"postid": @"2", @"title": @"Newer", @"date_modified_gmt": [NSDate dateWithTimeIntervalSince1970:2000], @"sticky": [NSNull null]}]
+                  forSite:site];
+        [store storePosts:@[@{@"postid": @"1", @"title": @"Edited", @"date_modified_gmt": [NSDate dateWithTimeIntervalSince1970:3000]}] forSite:site];
+        [store waitUntilWritten];
+        length = [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileSize];
+
+        // An unchanged post isn't written again
+        [store storePosts:@[@{@"postid": @"2", @"title": @"Newer", @"date_modified_gmt": [NSDate dateWithTimeIntervalSince1970:2000]}] forSite:site];
+        [store waitUntilWritten];
+        XCTAssertEqual([[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileSize], length);
+    }
+
+    // The app being killed in the middle of a write leaves part of a record
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+    [fileHandle seekToEndOfFile];
+    [fileHandle writeData:[@"WREC" dataUsingEncoding:NSUTF8StringEncoding]];
+    [fileHandle closeFile];
+
+    WPPostStore *reopenedStore = [[WPPostStore alloc] initWithPath:path];
+    NSArray *posts = [reopenedStore postsForSite:site limit:0];
+    XCTAssertEqual([posts count], 2u);
+    XCTAssertEqualObjects([posts[0] title], @"Edited", @"Expected the latest version, most recently modified first");
+    XCTAssertEqualObjects([posts[1] title], @"Newer");
+    XCTAssertEqual([[reopenedStore postsForSite:site limit:1] count], 1u);
+    XCTAssertEqual([reopenedStore numberOfPostsForSite:@"another site"], 0u);
+    XCTAssertEqual([[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil] fileSize], length, @"Expected the cut record to be dropped");
+
+    [reopenedStore removePostsForSite:site];
+    [reopenedStore waitUntilWritten];
+    XCTAssertEqual([[[[WPPostStore alloc] initWithPath:path] postsForSite:site limit:0] count], 0u);
+    [[NSFileManager defaultManager] removeItemAtPath:[path stringByDeletingLastPathComponent] error:nil];
+}
+
+- (void)testStoresOfTheSameFileDontOverwriteEachOther {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"poststore-%@/posts.store", [[NSUUID UUID] UUIDString]]];
+    NSString *site = @"http://mywordpresssite.com/xmlrpc.php#user";
+    @autoreleasepool {
+        WPPostStore *store = [[WPPostStore alloc] initWithPath:path];
+        WPPostStore *otherStore = [WPPostStore storeWithPath:[[path stringByDeletingLastPathComponent] stringByAppendingPathComponent:@"./posts.store"]];
+        XCTAssertEqual(store, otherStore, @"Expected the open store of the file");
+        [store storePosts:@[@{@"postid": @"1", @"title": @"First", @"date_modified_gmt": [NSDate dateWithTimeIntervalSince1970:1000]}] forSite:site];
+        [otherStore storePosts:@[@{@"postid": @"2", @"title": @"Second", @"date_modified_gmt": [NSDate dateWithTimeIntervalSince1970:2000]}] forSite:site];
+        [store waitUntilWritten];
+    }
+
+    WPPostStore *reopenedStore = [[WPPostStore alloc] initWithPath:path];
+    NSArray *posts = [reopenedStore postsForSite:site limit:0];
+    XCTAssertEqual([posts count], 2u, @"Expected the records of both writes");
+    XCTAssertEqualObjects([posts[0] title], @"Second");
+    XCTAssertEqualObjects([posts[1] title], @"First");
+    [[NSFileManager defaultManager] removeItemAtPath:[path stringByDeletingLastPathComponent] error:nil];
+}
+
+@end
@@ -0,0 +1,150 @@
+#import <XCTest/XCTest.h>
+#import <WordPressApi.h>
+#import <WPPublishOutbox.h>
+#import <OHHTTPStubs/OHHTTPStubs.h>
+#import <OHHTTPStubs/OHHTTPStubsResponse.h>
+
+@interface WPPublishOutboxTests : XCTestCase <WPPublishOutboxDelegate>
+@property (nonatomic, strong) NSMutableDictionary *publishedPostIds;
+@property (nonatomic, strong) XCTestExpectation *outboxExpectation;
+@property (nonatomic, strong) NSMutableDictionary *failedItemErrors;
+@end
+
+@implementation WPPublishOutboxTests
+
+- (void)tearDown {
+    [super tearDown];
+    [OHHTTPStubs removeAllStubs];
+}
+
+- (void)testOutboxCoalescesEditsOfTheSameDraft {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSMutableArray *bodies = [NSMutableArray array];
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        [bodies addObject:[[NSString alloc] initWithData:request.HTTPBody encoding:NSUTF8StringEncoding] ?: @""];
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>42</string></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    NSString *journalPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"username" password:@"password"];
+    WPPublishOutbox *outbox = [[WPPublishOutbox alloc] initWithApi:api journalPath:journalPath];
+    outbox.delegate = self;
+    self.publishedPostIds = [NSMutableDictionary dictionary];
+    self.outboxExpectation = [self expectationWithDescription:@"Coalesced item should be published"];
+
+    NSString *firstIdentifier = [outbox enqueuePostWithText:@"First edit" title:@"Title" images:nil draftKey:@"draft-1"];
+    NSString *secondIdentifier = [outbox enqueuePostWithText:@"Second edit" title:@"Title" images:nil draftKey:@"draft-1"];
+    XCTAssertEqualObjects(firstIdentifier, secondIdentifier, @"Expected the edits to share an item");
+    XCTAssertEqual([outbox.pendingItemIdentifiers count], 1, @"Expected a single queued item");
+
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertEqual([bodies count], 1, @"Expected a single request");
+    XCTAssertTrue([[bodies firstObject] containsString:@"Second edit"], @"Expected the last edit to be published");
+    XCTAssertEqualObjects(self.publishedPostIds[firstIdentifier], @42, @"Expected the post ID to be reported for the item");
+    XCTAssertEqual([outbox.pendingItemIdentifiers count], 0, @"Expected the outbox to be empty");
+    [[NSFileManager defaultManager] removeItemAtPath:journalPath error:nil];
+}
+
+- (void)testOutboxSendsItemsAgainOnlyWhenTheServerNeverGotThem {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        if (requestCount == 1) {
+            return [OHHTTPStubsResponse responseWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNotConnectedToInternet userInfo:nil]];
+        }
+        return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:503 headers:nil];
+    }];
+
+    NSString *journalPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"username" password:@"password"];
+    WPPublishOutbox *outbox = [[WPPublishOutbox alloc] initWithApi:api journalPath:journalPath];
+    outbox.retryInterval = 0.1;
+    outbox.delegate = self;
+    self.failedItemErrors = [NSMutableDictionary dictionary];
+    self.outboxExpectation = [self expectationWithDescription:@"Item should fail"];
+
+    NSString *identifier = [outbox enqueuePostWithText:@"Content" title:@"Title" images:nil draftKey:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual(requestCount, 2, @"Expected the item to be sent again after the unsent request, but not after the server error");
+    NSHTTPURLResponse *response = [self.failedItemErrors[identifier] userInfo][AFNetworkingOperationFailingURLResponseErrorKey];
+    XCTAssertEqual(response.statusCode, 503, @"Expected the server error to be reported");
+    XCTAssertEqual([outbox.pendingItemIdentifiers count], 0, @"Expected the failed item to be removed");
+    [[NSFileManager defaultManager] removeItemAtPath:journalPath error:nil];
+}
+
+- (void)testOutboxDoesNotSendAgainAnItemInterruptedByARelaunch {
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return YES;
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:200 headers:nil];
+    }];
+
+    NSString *journalPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:journalPath withIntermediateDirectories:YES attributes:nil error:nil];
+    NSArray *journal = @[@{@"identifier": @"sent", @"title": @"Title", @"content": @"Content", @"imageFileNames": @[], @"revision": @1, @"sendStarted": @YES}];
+    [journal writeToFile:[journalPath stringByAppendingPathComponent:@"outbox.plist"] atomically:YES];
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:@"http://mywordpresssite.com/xmlrpc.php"] username:@"username" password:@"password"];
+    WPPublishOutbox *outbox = [[WPPublishOutbox alloc] initWithApi:api journalPath:journalPath];
+    outbox.delegate = self;
+    self.failedItemErrors = [NSMutableDictionary dictionary];
+    self.outboxExpectation = [self expectationWithDescription:@"Interrupted item should fail"];
+    XCTAssertEqualObjects(outbox.pendingItemIdentifiers, @[@"sent"], @"Expected the item to be read back from the journal");
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual(requestCount, 0, @"Expected the item not to be sent again");
+    XCTAssertEqualObjects([self.failedItemErrors[@"sent"] domain], WPPublishOutboxErrorDomain);
+    XCTAssertEqual([self.failedItemErrors[@"sent"] code], WPPublishOutboxErrorInterrupted);
+    XCTAssertEqual([outbox.pendingItemIdentifiers count], 0, @"Expected the interrupted item to be removed");
+    [[NSFileManager defaultManager] removeItemAtPath:journalPath error:nil];
+}
+
+- (void)testOutboxFailsAnItemWhoseImageCantBeRead {
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return YES;
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:200 headers:nil];
+    }];
+
+    NSString *journalPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:journalPath withIntermediateDirectories:YES attributes:nil error:nil];
+    // The image file was removed after the item was saved
+    NSArray *journal = @[@{@"identifier": @"missing", @"title": @"Title", @"content": @"Content", @"imageFileNames": @[@"missing-0.jpg"], @"revision": @1}];
+    [journal writeToFile:[journalPath stringByAppendingPathComponent:@"outbox.plist"] atomically:YES];
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:@"http://mywordpresssite.com/xmlrpc.php"] username:@"username" password:@"password"];
+    WPPublishOutbox *outbox = [[WPPublishOutbox alloc] initWithApi:api journalPath:journalPath];
+    outbox.delegate = self;
+    self.failedItemErrors = [NSMutableDictionary dictionary];
+    self.outboxExpectation = [self expectationWithDescription:@"Item missing an image should fail"];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual(requestCount, 0, @"Expected the post not to be published without its image");
+    XCTAssertEqualObjects([self.failedItemErrors[@"missing"] domain], WPPublishOutboxErrorDomain);
+    XCTAssertEqual([self.failedItemErrors[@"missing"] code], WPPublishOutboxErrorMissingImage);
+    XCTAssertEqual([outbox.pendingItemIdentifiers count], 0, @"Expected the failed item to be removed");
+    [[NSFileManager defaultManager] removeItemAtPath:journalPath error:nil];
+}
+
+- (void)publishOutbox:(WPPublishOutbox *)outbox item:(NSString *)identifier didPublishPostWithId:(NSUInteger)postId permalink:(NSURL *)permalink {
+    self.publishedPostIds[identifier] = @(postId);
+    [self.outboxExpectation fulfill];
+}
+
+- (void)publishOutbox:(WPPublishOutbox *)outbox item:(NSString *)identifier didFailWithError:(NSError *)error {
+    self.failedItemErrors[identifier] = error;
+    [self.outboxExpectation fulfill];
+}
+
+@end
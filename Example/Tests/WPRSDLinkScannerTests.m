@@ -0,0 +1,25 @@
+#import <XCTest/XCTest.h>
+#import <WPRSDLinkScanner.h>
+
+@interface WPRSDLinkScannerTests : XCTestCase
+@end
+
+@implementation WPRSDLinkScannerTests
+
+- (void)testRSDLinkScannerFindsLinkAcrossChunks {
+    NSString *page = @"<html><head><!-- <link rel=\"EditURI\" href=\"http://commented.com/\"> -->"
+                      "<script>var s = '<link rel=\"EditURI\" href=\"http://script.com/\">';</script>"
+                      "<LINK href='http://mywordpresssite.com/xmlrpc.php?rsd&amp;x=1' title=\"RSD\" rel=\"EditURI\" type=\"application/rsd+xml\" />"
+                      "</head><body>Never scanned</body></html>";
+    NSData *data = [page dataUsingEncoding:NSUTF8StringEncoding];
+    WPRSDLinkScanner *scanner = [[WPRSDLinkScanner alloc] init];
+    NSUInteger chunkLength = 7;
+    for (NSUInteger offset = 0; offset < [data length] && !scanner.isFinished; offset += chunkLength) {
+        [scanner appendData:[data subdataWithRange:NSMakeRange(offset, MIN(chunkLength, [data length] - offset))]];
+    }
+
+    XCTAssertTrue(scanner.isFinished, @"Expected the scanner to stop at the link");
+    XCTAssertEqualObjects(scanner.rsdURL, @"http://mywordpresssite.com/xmlrpc.php?rsd&x=1", @"Expected the link outside comments and scripts to be found in any attribute order");
+}
+
+@end
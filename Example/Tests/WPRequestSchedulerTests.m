@@ -0,0 +1,176 @@
+#import <XCTest/XCTest.h>
+#import <WPRequestScheduler.h>
+#import <AFNetworking/AFNetworking.h>
+#import <OHHTTPStubs/OHHTTPStubs.h>
+#import <OHHTTPStubs/OHHTTPStubsResponse.h>
+
+@interface WPRequestSchedulerTests : XCTestCase
+@end
+
+@implementation WPRequestSchedulerTests
+
+- (void)tearDown {
+    [super tearDown];
+    [OHHTTPStubs removeAllStubs];
+}
+
+- (void)testSchedulerStartsInteractiveOperationsFirst {
+    WPRequestScheduler *scheduler = [[WPRequestScheduler alloc] init];
+    scheduler.maximumConcurrentOperationCount = 1;
+
+    dispatch_semaphore_t blocker = dispatch_semaphore_create(0);
+    NSMutableArray *order = [NSMutableArray array];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"All operations should run"];
+    NSBlockOperation *blocking = [NSBlockOperation blockOperationWithBlock:^{
+        dispatch_semaphore_wait(blocker, DISPATCH_TIME_FOREVER);
+    }];
+    NSBlockOperation *prefetch = [NSBlockOperation blockOperationWithBlock:^{
+        @synchronized(order) {
+            [order addObject:@"prefetch"];
+        }
+        [expectation fulfill];
+    }];
+    NSBlockOperation *interactive = [NSBlockOperation blockOperationWithBlock:^{
+        @synchronized(order) {
+            [order addObject:@"interactive"];
+        }
+    }];
+    [scheduler addOperation:blocking priority:WPRequestPriorityInteractive tag:nil owner:nil];
+    [scheduler addOperation:prefetch priority:WPRequestPriorityPrefetch tag:nil owner:nil];
+    [scheduler addOperation:interactive priority:WPRequestPriorityInteractive tag:nil owner:nil];
+    dispatch_semaphore_signal(blocker);
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqualObjects(order, (@[@"interactive", @"prefetch"]), @"Expected the interactive operation to run before the prefetch queued earlier");
+}
+
+- (AFHTTPRequestOperation *)schedulerTestOperationWithURL:(NSString *)URL {
+    AFHTTPRequestOperation *operation = [[AFHTTPRequestOperation alloc] initWithRequest:[NSURLRequest requestWithURL:[NSURL URLWithString:URL]]];
+    operation.responseSerializer = [AFHTTPResponseSerializer serializer];
+    return operation;
+}
+
+- (void)testSchedulerHalvesHostLimitOnServerErrorsAndGrowsItBack {
+    __block NSInteger statusCode = 503;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.host isEqualToString:@"aimd.example.com"];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:(int)statusCode headers:nil];
+    }];
+
+    WPRequestScheduler *scheduler = [[WPRequestScheduler alloc] init];
+    [scheduler addOperation:[self schedulerTestOperationWithURL:@"http://aimd.example.com/"] priority:WPRequestPriorityInteractive tag:nil owner:nil];
+    [self expectationForPredicate:[NSPredicate predicateWithBlock:^BOOL(id object, NSDictionary *bindings) {
+        return [scheduler concurrencyLimitForHost:@"aimd.example.com"] == 2;
+    }] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    statusCode = 200;
+    for (NSUInteger i = 0; i < 2; i++) {
+        [scheduler addOperation:[self schedulerTestOperationWithURL:@"http://aimd.example.com/"] priority:WPRequestPriorityInteractive tag:nil owner:nil];
+    }
+    [self expectationForPredicate:[NSPredicate predicateWithBlock:^BOOL(id object, NSDictionary *bindings) {
+        return [scheduler concurrencyLimitForHost:@"aimd.example.com"] == 3;
+    }] evaluatedWithObject:self handler:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testSchedulerLimitsOperationsPerHost {
+    NSMutableArray *operations = [NSMutableArray array];
+    __block NSUInteger maximumRunning = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.host isEqualToString:@"limited.example.com"];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        @synchronized(operations) {
+            NSUInteger running = [[operations filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"isExecuting == YES"]] count];
+            maximumRunning = MAX(maximumRunning, running);
+        }
+        return [[OHHTTPStubsResponse responseWithData:[NSData data] statusCode:200 headers:nil] requestTime:0.1 responseTime:0];
+    }];
+
+    WPRequestScheduler *scheduler = [[WPRequestScheduler alloc] init];
+    scheduler.maximumConcurrentOperationsPerHost = 2;
+    dispatch_group_t group = dispatch_group_create();
+    @synchronized(operations) {
+        for (NSUInteger i = 0; i < 5; i++) {
+            AFHTTPRequestOperation *operation = [self schedulerTestOperationWithURL:@"http://limited.example.com/"];
+            dispatch_group_enter(group);
+            [operation setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
+                dispatch_group_leave(group);
+            } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                dispatch_group_leave(group);
+            }];
+            [operations addObject:operation];
+        }
+    }
+    for (AFHTTPRequestOperation *operation in operations) {
+        [scheduler addOperation:operation priority:WPRequestPriorityInteractive tag:nil owner:nil];
+    }
+    XCTestExpectation *expectation = [self expectationWithDescription:@"All operations should finish"];
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    XCTAssertEqual(maximumRunning, 2, @"Expected no more than the host limit to run at once");
+}
+
+- (void)testSchedulerCancelsOperationsByTagAndOwner {
+    WPRequestScheduler *scheduler = [[WPRequestScheduler alloc] init];
+    scheduler.maximumConcurrentOperationCount = 1;
+    dispatch_semaphore_t blocker = dispatch_semaphore_create(0);
+    NSBlockOperation *blocking = [NSBlockOperation blockOperationWithBlock:^{
+        dispatch_semaphore_wait(blocker, DISPATCH_TIME_FOREVER);
+    }];
+    NSObject *owner = [[NSObject alloc] init];
+    NSObject *otherOwner = [[NSObject alloc] init];
+    NSBlockOperation *tagged = [NSBlockOperation blockOperationWithBlock:^{}];
+    NSBlockOperation *taggedForOtherOwner = [NSBlockOperation blockOperationWithBlock:^{}];
+    NSBlockOperation *untagged = [NSBlockOperation blockOperationWithBlock:^{}];
+    NSBlockOperation *otherOwnerUntagged = [NSBlockOperation blockOperationWithBlock:^{}];
+    [scheduler addOperation:blocking priority:WPRequestPriorityInteractive tag:nil owner:nil];
+    [scheduler addOperation:tagged priority:WPRequestPriorityInteractive tag:@"sync" owner:owner];
+    [scheduler addOperation:taggedForOtherOwner priority:WPRequestPriorityInteractive tag:@"sync" owner:otherOwner];
+    [scheduler addOperation:untagged priority:WPRequestPriorityInteractive tag:nil owner:owner];
+    [scheduler addOperation:otherOwnerUntagged priority:WPRequestPriorityInteractive tag:nil owner:otherOwner];
+
+    [scheduler cancelOperationsWithTag:@"sync" owner:owner];
+    XCTAssertTrue(tagged.isCancelled);
+    XCTAssertFalse(taggedForOtherOwner.isCancelled, @"Expected operations of other owners to be left alone");
+    XCTAssertFalse(untagged.isCancelled);
+
+    [scheduler cancelOperationsWithTag:@"sync"];
+    XCTAssertTrue(taggedForOtherOwner.isCancelled);
+    XCTAssertFalse(untagged.isCancelled);
+
+    [scheduler cancelOperationsForOwner:owner];
+    XCTAssertTrue(untagged.isCancelled);
+    XCTAssertFalse(otherOwnerUntagged.isCancelled);
+    XCTAssertFalse(blocking.isCancelled);
+
+    dispatch_semaphore_signal(blocker);
+    [otherOwnerUntagged waitUntilFinished];
+    XCTAssertEqual([[scheduler operationsForOwner:owner] count], 0);
+}
+
+- (void)testSchedulerQueueHoldsOperationsWhileSuspended {
+    WPRequestScheduler *scheduler = [[WPRequestScheduler alloc] init];
+    WPRequestSchedulerQueue *queue = [[WPRequestSchedulerQueue alloc] initWithScheduler:scheduler];
+    queue.suspended = YES;
+    XCTAssertTrue(queue.isSuspended);
+
+    __block BOOL ran = NO;
+    NSBlockOperation *operation = [NSBlockOperation blockOperationWithBlock:^{
+        ran = YES;
+    }];
+    [queue addOperation:operation];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertFalse(ran, @"Expected the operation to wait while the queue is suspended");
+    XCTAssertEqual(queue.operationCount, 1);
+
+    queue.suspended = NO;
+    [operation waitUntilFinished];
+    XCTAssertTrue(ran);
+}
+
+@end
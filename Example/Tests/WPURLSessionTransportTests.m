@@ -0,0 +1,113 @@
+#import <XCTest/XCTest.h>
+#import <WordPressApi.h>
+#import <WPURLSessionTransport.h>
+#import <WPRetryPolicy.h>
+#import <WPRequestScheduler.h>
+#import <OHHTTPStubs/OHHTTPStubs.h>
+#import <OHHTTPStubs/OHHTTPStubsResponse.h>
+
+@interface WPURLSessionTransportTests : XCTestCase
+@end
+
+@implementation WPURLSessionTransportTests
+
+- (void)tearDown {
+    [super tearDown];
+    [OHHTTPStubs removeAllStubs];
+}
+
+- (void)testSessionTransportSharesSessionsPerHostFamily {
+    NSString *endpoint = @"http://mywordpresssite.wordpress.com/xmlrpc.php";
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>ok</string></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    WPURLSessionTransport *transport = [[WPURLSessionTransport alloc] init];
+    XCTAssertEqual([transport sessionManagerForURL:[NSURL URLWithString:endpoint]], [transport sessionManagerForURL:[NSURL URLWithString:@"https://public-api.wordpress.com/rest/v1.1/"]], @"Expected hosts of the same family to share a session");
+    XCTAssertNotEqual([transport sessionManagerForURL:[NSURL URLWithString:endpoint]], [transport sessionManagerForURL:[NSURL URLWithString:@"http://example.org/xmlrpc.php"]], @"Expected other hosts to use their own session");
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.sessionTransport = transport;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Call should succeed"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTAssertNil(operation, @"Expected no operation for calls sent by the session transport");
+        XCTAssertEqualObjects(responseObject, @"ok", @"Expected the decoded response");
+        [expectation fulfill];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTFail(@"Call should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testHostFamiliesFollowCountryCodeSecondLevelDomains {
+    XCTAssertEqualObjects([WPURLSessionTransport hostFamilyForURL:[NSURL URLWithString:@"https://mysite.wordpress.com/"]], @"wordpress.com");
+    XCTAssertEqualObjects([WPURLSessionTransport hostFamilyForURL:[NSURL URLWithString:@"https://www.example.co.uk/"]], @"example.co.uk");
+    XCTAssertEqualObjects([WPURLSessionTransport hostFamilyForURL:[NSURL URLWithString:@"https://blog.example.com.au/"]], @"example.com.au");
+    XCTAssertEqualObjects([WPURLSessionTransport hostFamilyForURL:[NSURL URLWithString:@"https://example.co.uk/"]], @"example.co.uk");
+    XCTAssertEqualObjects([WPURLSessionTransport hostFamilyForURL:[NSURL URLWithString:@"https://www.example.io/"]], @"example.io", @"Expected other two-letter domains to keep two labels");
+    XCTAssertEqualObjects([WPURLSessionTransport hostFamilyForURL:[NSURL URLWithString:@"http://192.168.1.10/"]], @"192.168.1.10");
+
+    WPURLSessionTransport *transport = [[WPURLSessionTransport alloc] init];
+    XCTAssertNotEqual([transport sessionManagerForURL:[NSURL URLWithString:@"https://one.co.uk/"]], [transport sessionManagerForURL:[NSURL URLWithString:@"https://two.co.uk/"]], @"Expected unrelated sites under co.uk not to share a session");
+}
+
+- (void)testSessionTransportCallsAreRetriedByThePolicy {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        if (requestCount == 1) {
+            return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:503 headers:nil];
+        }
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>ok</string></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.sessionTransport = [[WPURLSessionTransport alloc] init];
+    WPRetryPolicy *retryPolicy = [WPRetryPolicy defaultPolicy];
+    retryPolicy.baseDelay = 0.01;
+    client.retryPolicy = retryPolicy;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Call should succeed after a retry"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTAssertEqualObjects(responseObject, @"ok", @"Expected the response of the retry");
+        [expectation fulfill];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTFail(@"Call should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertEqual(requestCount, 2, @"Expected the call to be sent twice");
+}
+
+- (void)testSessionTransportCallsAreCancelledByTag {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>ok</string></value></param></params></methodResponse>";
+        return [[OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil] requestTime:1 responseTime:0];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.sessionTransport = [[WPURLSessionTransport alloc] init];
+    [(WPRequestSchedulerQueue *)client.operationQueue setTag:@"sync"];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Call should be cancelled"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTFail(@"A cancelled call should not enter success block.");
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTAssertEqual(error.code, NSURLErrorCancelled);
+        [expectation fulfill];
+    }];
+    XCTAssertEqual(client.operationQueue.operationCount, 1, @"Expected the call to be scheduled as an operation");
+    [client cancelHTTPOperationsWithTag:@"sync"];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+@end
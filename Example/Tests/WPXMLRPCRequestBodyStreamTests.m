@@ -0,0 +1,56 @@
+#import <XCTest/XCTest.h>
+#import <WPXMLRPCRequestBodyStream.h>
+
+@interface WPXMLRPCRequestBodyStreamTests : XCTestCase
+@end
+
+@implementation WPXMLRPCRequestBodyStreamTests
+
+- (void)testRequestBodyStreamMatchesContentLength {
+    NSMutableData *media = [NSMutableData dataWithLength:200 * 1024 + 1];
+    ((uint8_t *)[media mutableBytes])[0] = 0xff;
+    NSDictionary *file = @{@"name": @"image.jpg", @"type": @"image/jpeg", @"bits": media};
+    WPXMLRPCRequestBodyStream *stream = [[WPXMLRPCRequestBodyStream alloc] initWithMethod:@"wp.uploadFile" parameters:@[@1, @"user", @"pass & <more>", file]];
+    XCTAssertNotNil(stream, @"Expected NSData parameters to be supported");
+
+    NSMutableData *body = [NSMutableData data];
+    uint8_t buffer[4096];
+    [stream open];
+    NSInteger bytesRead;
+    while ((bytesRead = [stream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        [body appendBytes:buffer length:(NSUInteger)bytesRead];
+    }
+    [stream close];
+
+    XCTAssertEqual((unsigned long long)[body length], stream.contentLength, @"Expected the Content-Length to match the body");
+    NSString *bodyString = [[NSString alloc] initWithData:body encoding:NSUTF8StringEncoding];
+    XCTAssertTrue([bodyString rangeOfString:@"pass &amp; &lt;more&gt;"].location != NSNotFound, @"Expected strings to be escaped");
+    XCTAssertTrue([bodyString rangeOfString:[media base64EncodedStringWithOptions:0]].location != NSNotFound, @"Expected the chunked base64 to match a single pass encoding");
+}
+
+- (void)testRequestBodyStreamFailsWhenFileIsCutShort {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [[NSMutableData dataWithLength:200 * 1024] writeToFile:path atomically:NO];
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingAtPath:path];
+    WPXMLRPCRequestBodyStream *stream = [[WPXMLRPCRequestBodyStream alloc] initWithMethod:@"wp.uploadFile" parameters:@[@1, @"user", @"pass", @{@"bits": fileHandle}]];
+    XCTAssertNotNil(stream);
+
+    // The file is replaced by a shorter one after the Content-Length was computed
+    [[NSFileHandle fileHandleForWritingAtPath:path] truncateFileAtOffset:1024];
+
+    uint8_t buffer[4096];
+    [stream open];
+    NSInteger bytesRead;
+    unsigned long long totalBytesRead = 0;
+    while ((bytesRead = [stream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        totalBytesRead += (unsigned long long)bytesRead;
+    }
+    XCTAssertEqual(bytesRead, -1, @"Expected the read to fail");
+    XCTAssertEqual(stream.streamStatus, NSStreamStatusError);
+    XCTAssertNotNil(stream.streamError);
+    XCTAssertLessThan(totalBytesRead, stream.contentLength);
+    [stream close];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+@end
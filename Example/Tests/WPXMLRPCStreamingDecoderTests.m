@@ -0,0 +1,53 @@
+#import <XCTest/XCTest.h>
+#import <WPXMLRPCStreamingDecoder.h>
+
+@interface WPXMLRPCStreamingDecoderTests : XCTestCase
+@end
+
+@implementation WPXMLRPCStreamingDecoderTests
+
+- (void)testStreamingDecoderReportsElementsAcrossChunks {
+    NSString *response = @"PHP Notice: something<br/>\n<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data>"
+                          "<value><struct><member><name>postid</name><value><string>1</string></value></member>"
+                          "<member><name>title</name><value>Hello &amp; welcome</value></member></struct></value>"
+                          "<value><struct><member><name>postid</name><value><string>2</string></value></member>"
+                          "<member><name>sticky</name><value><boolean>1</boolean></value></member></struct></value>"
+                          "</data></array></value></param></params></methodResponse>";
+    NSData *data = [response dataUsingEncoding:NSUTF8StringEncoding];
+
+    NSMutableArray *elements = [NSMutableArray array];
+    WPXMLRPCStreamingDecoder *decoder = [[WPXMLRPCStreamingDecoder alloc] initWithElementHandler:^(id element, NSUInteger index) {
+        XCTAssertEqual(index, [elements count], @"Expected elements to be reported in order");
+        [elements addObject:element];
+    }];
+    NSUInteger chunkSize = 7;
+    for (NSUInteger offset = 0; offset < [data length]; offset += chunkSize) {
+        [decoder appendData:[data subdataWithRange:NSMakeRange(offset, MIN(chunkSize, [data length] - offset))]];
+    }
+    [decoder finish];
+
+    XCTAssertNil(decoder.error, @"Expected the response to be decoded without errors");
+    XCTAssertEqual([elements count], 2, @"Expected both posts to be reported");
+    XCTAssertEqualObjects(elements[0][@"title"], @"Hello & welcome", @"Expected untyped values to be decoded as strings");
+    XCTAssertEqualObjects(elements[1][@"sticky"], @YES, @"Expected booleans to be decoded");
+    XCTAssertEqual([decoder.object count], 0, @"Expected reported elements not to be kept by the decoder");
+}
+
+- (void)testStreamingDecoderSkipsFilteredMembers {
+    NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data>"
+                          "<value><struct><member><name>post_id</name><value><string>1</string></value></member>"
+                          "<member><name>post_content</name><value><string>Long &lt;b&gt;content&lt;/b&gt;</string></value></member>"
+                          "<member><name>terms</name><value><array><data><value><struct><member><name>name</name><value>News</value></member></struct></value></data></array></value></member>"
+                          "<member><name>post_title</name><value><string>Hello</string></value></member></struct></value>"
+                          "</data></array></value></param></params></methodResponse>";
+
+    WPXMLRPCStreamingDecoder *decoder = [[WPXMLRPCStreamingDecoder alloc] init];
+    decoder.memberFilter = [NSSet setWithObjects:@"post_id", @"post_title", nil];
+    [decoder appendData:[response dataUsingEncoding:NSUTF8StringEncoding]];
+    [decoder finish];
+
+    XCTAssertNil(decoder.error, @"Expected the response to be decoded without errors");
+    XCTAssertEqualObjects(decoder.object, (@[@{@"post_id": @"1", @"post_title": @"Hello"}]), @"Expected only the requested members to be decoded");
+}
+
+@end
@@ -0,0 +1,415 @@
+#import <XCTest/XCTest.h>
+#import <WordPressApi.h>
+#import <WPXMLRPC/WPXMLRPC.h>
+#import <WPXMLRPCStreamingDecoder.h>
+#import <WPXMLRPCRequestBodyStream.h>
+#import <WPPostModel.h>
+#import <OHHTTPStubs/OHHTTPStubs.h>
+#import <OHHTTPStubs/OHHTTPStubsResponse.h>
+#import <mach/mach.h>
+
+/**
+ Offline benchmarks for the XML-RPC stack, run against stubbed responses.
+
+ They are skipped unless the `WPRunBenchmarks` environment variable is set. Results are written as JSON to the path in `WPBenchmarkResultsPath`, or to `WordPressApiBenchmarks.json` in the temporary directory, so they can be compared between releases.
+ */
+@interface WordPressApiBenchmarks : XCTestCase
+@end
+
+static NSString *const WPBenchmarkEndpoint = @"http://benchmark.wordpress.test/xmlrpc.php";
+static NSMutableArray *WPBenchmarkResults;
+
+static uint64_t WPBenchmarkResidentMemory(void) {
+    struct mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+}
+
+@implementation WordPressApiBenchmarks
+
++ (void)setUp {
+    [super setUp];
+    WPBenchmarkResults = [NSMutableArray array];
+}
+
++ (void)tearDown {
+    if ([WPBenchmarkResults count] > 0) {
+        [self writeResults];
+    }
+    [super tearDown];
+}
+
+- (void)setUp {
+    [super setUp];
+    [WordPressXMLRPCApi removeDiscoveredEndpoints];
+}
+
+- (void)tearDown {
+    [super tearDown];
+    [OHHTTPStubs removeAllStubs];
+}
+
+#pragma mark - Benchmarks
+
+- (void)testEncodeThroughput {
+    if (![self shouldRunBenchmarks]) {
+        return;
+    }
+    for (NSNumber *size in [self postCounts]) {
+        NSArray *posts = [self postsWithCount:[size unsignedIntegerValue]];
+
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        WPXMLRPCEncoder *encoder = [[WPXMLRPCEncoder alloc] initWithMethod:@"wp.editPosts" andParameters:@[posts]];
+        NSData *body = [encoder dataEncodedWithError:nil];
+        [self recordBenchmark:@"xmlrpc.encode.buffered" size:size bytes:[body length] seconds:CFAbsoluteTimeGetCurrent() - start extra:nil];
+
+        start = CFAbsoluteTimeGetCurrent();
+        WPXMLRPCRequestBodyStream *stream = [[WPXMLRPCRequestBodyStream alloc] initWithMethod:@"wp.editPosts" parameters:@[posts]];
+        unsigned long long streamed = [self drainStream:stream memoryHighWaterMark:NULL];
+        [self recordBenchmark:@"xmlrpc.encode.streamed" size:size bytes:streamed seconds:CFAbsoluteTimeGetCurrent() - start extra:nil];
+        XCTAssertEqual(streamed, stream.contentLength, @"Expected the stream to produce its announced length");
+    }
+}
+
+- (void)testDecodeThroughput {
+    if (![self shouldRunBenchmarks]) {
+        return;
+    }
+    for (NSNumber *size in [self postCounts]) {
+        NSData *response = [self postsResponseWithCount:[size unsignedIntegerValue]];
+
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        WPXMLRPCDecoder *decoder = [[WPXMLRPCDecoder alloc] initWithData:response];
+        XCTAssertEqual([[decoder object] count], [size unsignedIntegerValue], @"Expected every post to be decoded");
+        [self recordBenchmark:@"xmlrpc.decode.buffered" size:size bytes:[response length] seconds:CFAbsoluteTimeGetCurrent() - start extra:nil];
+
+        __block NSUInteger elementCount = 0;
+        start = CFAbsoluteTimeGetCurrent();
+        WPXMLRPCStreamingDecoder *streamingDecoder = [[WPXMLRPCStreamingDecoder alloc] initWithElementHandler:^(id element, NSUInteger index) {
+            elementCount++;
+        }];
+        NSUInteger chunkSize = 16 * 1024;
+        for (NSUInteger offset = 0; offset < [response length]; offset += chunkSize) {
+            [streamingDecoder appendData:[response subdataWithRange:NSMakeRange(offset, MIN(chunkSize, [response length] - offset))]];
+        }
+        [streamingDecoder finish];
+        XCTAssertEqual(elementCount, [size unsignedIntegerValue], @"Expected every post to be reported");
+        [self recordBenchmark:@"xmlrpc.decode.streaming" size:size bytes:[response length] seconds:CFAbsoluteTimeGetCurrent() - start extra:nil];
+    }
+}
+
+- (void)testLazyModelDecodeThroughput {
+    if (![self shouldRunBenchmarks]) {
+        return;
+    }
+    NSArray *listFields = @[@"post_id", @"post_title", @"post_date_gmt"];
+    for (NSNumber *size in [self postCounts]) {
+        NSData *response = [self postsResponseWithCount:[size unsignedIntegerValue]];
+
+        // What a list screen reads: a few fields of every post
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        NSArray *posts = [[WPXMLRPCDecoder alloc] initWithData:response].object;
+        for (NSDictionary *post in posts) {
+            for (NSString *field in listFields) {
+                [post objectForKey:field];
+            }
+        }
+        [self recordBenchmark:@"xmlrpc.decode.eager.fields" size:size bytes:[response length] seconds:CFAbsoluteTimeGetCurrent() - start extra:nil];
+
+        start = CFAbsoluteTimeGetCurrent();
+        NSArray *models = [WPPostModel modelsWithXMLRPCResponseData:response error:nil];
+        for (WPPostModel *model in models) {
+            for (NSString *field in listFields) {
+                [model objectForKey:field];
+            }
+        }
+        [self recordBenchmark:@"xmlrpc.decode.lazy.fields" size:size bytes:[response length] seconds:CFAbsoluteTimeGetCurrent() - start extra:nil];
+
+        // Every field, then every field again, which is answered from the decoded values
+        start = CFAbsoluteTimeGetCurrent();
+        models = [WPPostModel modelsWithXMLRPCResponseData:response error:nil];
+        for (WPPostModel *model in models) {
+            [model dictionaryValue];
+        }
+        [self recordBenchmark:@"xmlrpc.decode.lazy.all" size:size bytes:[response length] seconds:CFAbsoluteTimeGetCurrent() - start extra:nil];
+
+        start = CFAbsoluteTimeGetCurrent();
+        for (WPPostModel *model in models) {
+            [model dictionaryValue];
+        }
+        [self recordBenchmark:@"xmlrpc.decode.lazy.cached" size:size bytes:[response length] seconds:CFAbsoluteTimeGetCurrent() - start extra:nil];
+
+        XCTAssertEqual([models count], [size unsignedIntegerValue], @"Expected a model per post");
+        XCTAssertEqualObjects([[models lastObject] dictionaryValue], [posts lastObject], @"Expected models to decode like the full response");
+    }
+}
+
+- (void)testMulticallFanOut {
+    if (![self shouldRunBenchmarks]) {
+        return;
+    }
+    for (NSNumber *size in @[@10, @100, @1000]) {
+        NSUInteger callCount = [size unsignedIntegerValue];
+        __block NSUInteger requestCount = 0;
+        __block unsigned long long responseBytes = 0;
+        // Answers as many calls as the request has, so the client gets a well-formed response however the calls are batched
+        [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+            return [request.URL.absoluteString isEqualToString:WPBenchmarkEndpoint];
+        } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+            NSString *body = [[NSString alloc] initWithData:request.HTTPBody encoding:NSUTF8StringEncoding] ?: @"";
+            NSUInteger calls = [[body componentsSeparatedByString:@"<name>methodName</name>"] count] - 1;
+            NSMutableString *results = [NSMutableString string];
+            for (NSUInteger i = 0; i < calls; i++) {
+                [results appendString:@"<value><array><data><value><string>ok</string></value></data></array></value>"];
+            }
+            NSString *value = [body containsString:@"<methodName>system.multicall</methodName>"]
+                ? [NSString stringWithFormat:@"<array><data>%@</data></array>", results]
+                : @"<string>ok</string>";
+            NSData *response = [[NSString stringWithFormat:@"<?xml version=\"1.0\"?><methodResponse><params><param><value>%@</value></param></params></methodResponse>", value] dataUsingEncoding:NSUTF8StringEncoding];
+            @synchronized(self) {
+                requestCount++;
+                responseBytes += [response length];
+            }
+            return [OHHTTPStubsResponse responseWithData:response statusCode:200 headers:nil];
+        }];
+
+        WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:WPBenchmarkEndpoint]];
+        client.batchingEnabled = YES;
+        client.maximumBatchSize = callCount;
+
+        XCTestExpectation *expectation = [self expectationWithDescription:@"Every call should finish"];
+        __block NSUInteger pendingCalls = callCount;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < callCount; i++) {
+            [client callMethod:@"wp.getOptions" parameters:@[@(i)] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+                if (--pendingCalls == 0) {
+                    [expectation fulfill];
+                }
+            } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                XCTFail(@"Call should not enter failure block.");
+            }];
+        }
+        [self waitForExpectationsWithTimeout:60 handler:nil];
+        NSTimeInterval seconds = CFAbsoluteTimeGetCurrent() - start;
+        XCTAssertEqual(requestCount, 1, @"Expected the calls to be sent as a single multicall");
+        [self recordBenchmark:@"xmlrpc.multicall.fanout" size:size bytes:responseBytes seconds:seconds extra:@{@"coalescedCalls": @(client.numberOfCoalescedCalls), @"requests": @(requestCount)}];
+        [OHHTTPStubs removeAllStubs];
+    }
+}
+
+- (void)testStreamingUploadMemory {
+    if (![self shouldRunBenchmarks]) {
+        return;
+    }
+    for (NSNumber *megabytes in @[@1, @10, @50]) {
+        // The media is read from a file, like uploadMedia: does, so only the stream's buffers are in memory
+        NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+        [[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil];
+        NSFileHandle *writer = [NSFileHandle fileHandleForWritingAtPath:path];
+        NSMutableData *chunk = [NSMutableData dataWithLength:1024 * 1024];
+        for (NSUInteger i = 0; i < [megabytes unsignedIntegerValue]; i++) {
+            arc4random_buf([chunk mutableBytes], [chunk length]);
+            [writer writeData:chunk];
+        }
+        [writer closeFile];
+        chunk = nil;
+
+        NSFileHandle *media = [NSFileHandle fileHandleForReadingAtPath:path];
+        NSDictionary *file = @{@"name": @"benchmark.jpg", @"type": @"image/jpeg", @"bits": media};
+
+        uint64_t baseline = WPBenchmarkResidentMemory();
+        uint64_t highWaterMark = baseline;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        WPXMLRPCRequestBodyStream *stream = [[WPXMLRPCRequestBodyStream alloc] initWithMethod:@"wp.uploadFile" parameters:@[@1, @"username", @"password", file]];
+        unsigned long long streamed = [self drainStream:stream memoryHighWaterMark:&highWaterMark];
+        [self recordBenchmark:@"xmlrpc.upload.streamed" size:megabytes bytes:streamed seconds:CFAbsoluteTimeGetCurrent() - start extra:@{@"memoryGrowthBytes": @(highWaterMark - baseline)}];
+        [media closeFile];
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    }
+}
+
+- (void)testLatencyUnderConcurrentLoad {
+    if (![self shouldRunBenchmarks]) {
+        return;
+    }
+    for (NSNumber *size in @[@10, @100, @1000]) {
+        NSUInteger callCount = [size unsignedIntegerValue];
+        NSData *response = [self postsResponseWithCount:10];
+        [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+            return [request.URL.absoluteString isEqualToString:WPBenchmarkEndpoint];
+        } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+            // A short round trip, so queueing in the scheduler shows up in the latencies
+            return [[OHHTTPStubsResponse responseWithData:response statusCode:200 headers:nil] requestTime:0.02 responseTime:0.01];
+        }];
+
+        WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:WPBenchmarkEndpoint]];
+        NSMutableArray *latencies = [NSMutableArray arrayWithCapacity:callCount];
+        XCTestExpectation *expectation = [self expectationWithDescription:@"Every call should finish"];
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < callCount; i++) {
+            CFAbsoluteTime callStart = CFAbsoluteTimeGetCurrent();
+            NSURLRequest *request = [client requestWithMethod:@"wp.getPosts" parameters:@[@(i)]];
+            AFHTTPRequestOperation *operation = [client HTTPRequestOperationWithRequest:request success:^(AFHTTPRequestOperation *operation, id responseObject) {
+                [latencies addObject:@(CFAbsoluteTimeGetCurrent() - callStart)];
+                if ([latencies count] == callCount) {
+                    [expectation fulfill];
+                }
+            } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                XCTFail(@"Call should not enter failure block.");
+            }];
+            [client enqueueHTTPRequestOperation:operation];
+        }
+        [self waitForExpectationsWithTimeout:120 handler:nil];
+        NSTimeInterval elapsed = CFAbsoluteTimeGetCurrent() - start;
+
+        [latencies sortUsingSelector:@selector(compare:)];
+        NSDictionary *percentiles = @{
+                                      @"p50": [self percentile:0.5 ofSortedValues:latencies],
+                                      @"p90": [self percentile:0.9 ofSortedValues:latencies],
+                                      @"p99": [self percentile:0.99 ofSortedValues:latencies],
+                                      @"max": [latencies lastObject],
+                                      };
+        [self recordBenchmark:@"xmlrpc.latency.concurrent" size:size bytes:[response length] * callCount seconds:elapsed extra:percentiles];
+        [OHHTTPStubs removeAllStubs];
+    }
+}
+
+- (void)testEndpointDiscoveryTime {
+    if (![self shouldRunBenchmarks]) {
+        return;
+    }
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.host isEqualToString:@"benchmark.wordpress.test"];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSURL *mockDataURL = [[NSBundle bundleForClass:[self class]] URLForResource:@"system_list_methods" withExtension:@"xml"];
+        return [[OHHTTPStubsResponse responseWithData:[NSData dataWithContentsOfURL:mockDataURL] statusCode:200 headers:nil] requestTime:0.05 responseTime:0.01];
+    }];
+
+    // The first lookup goes through discovery, the second one is answered by the remembered endpoint
+    for (NSString *name in @[@"xmlrpc.discovery.cold", @"xmlrpc.discovery.remembered"]) {
+        XCTestExpectation *expectation = [self expectationWithDescription:@"Discovery should succeed"];
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [WordPressXMLRPCApi guessXMLRPCURLForSite:@"benchmark.wordpress.test" success:^(NSURL *xmlrpcURL) {
+            [expectation fulfill];
+        } failure:^(NSError *error) {
+            XCTFail(@"Discovery should not enter failure block.");
+        }];
+        [self waitForExpectationsWithTimeout:30 handler:nil];
+        [self recordBenchmark:name size:@1 bytes:0 seconds:CFAbsoluteTimeGetCurrent() - start extra:nil];
+    }
+}
+
+#pragma mark - Helpers
+
+- (BOOL)shouldRunBenchmarks {
+    return getenv("WPRunBenchmarks") != NULL;
+}
+
+- (NSArray *)postCounts {
+    return @[@10, @100, @1000, @10000];
+}
+
+- (NSArray *)postsWithCount:(NSUInteger)count {
+    NSMutableArray *posts = [NSMutableArray arrayWithCapacity:count];
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1476662400];
+    for (NSUInteger i = 0; i < count; i++) {
+        [posts addObject:@{
+                           @"post_id": [NSString stringWithFormat:@"%lu", (unsigned long)i],
+                           @"post_title": [NSString stringWithFormat:@"Benchmark post %lu", (unsigned long)i],
+                           @"post_status": @"publish",
+                           @"post_date_gmt": date,
+                           @"post_content": @"<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.</p>",
+                           @"sticky": @NO,
+                           @"comment_count": @(i % 20),
+                           }];
+    }
+    return posts;
+}
+
+- (NSData *)postsResponseWithCount:(NSUInteger)count {
+    NSMutableString *response = [NSMutableString stringWithString:@"<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data>"];
+    for (NSUInteger i = 0; i < count; i++) {
+        [response appendFormat:@"<value><struct>"
+                                "<member><name>post_id</name><value><string>%lu</string></value></member>"
+                                "<member><name>post_title</name><value><string>Benchmark post %lu</string></value></member>"
+                                "<member><name>post_status</name><value><string>publish</string></value></member>"
+                                "<member><name>post_date_gmt</name><value><dateTime.iso8601>20161017T00:00:00</dateTime.iso8601></value></member>"
+                                "<member><name>post_content</name><value><string>&lt;p&gt;Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.&lt;/p&gt;</string></value></member>"
+                                "<member><name>sticky</name><value><boolean>0</boolean></value></member>"
+                                "<member><name>comment_count</name><value><int>%lu</int></value></member>"
+                                "</struct></value>", (unsigned long)i, (unsigned long)i, (unsigned long)(i % 20)];
+    }
+    [response appendString:@"</data></array></value></param></params></methodResponse>"];
+    return [response dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (void)stubEndpointWithResponse:(NSData *)response {
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:WPBenchmarkEndpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        return [OHHTTPStubsResponse responseWithData:response statusCode:200 headers:nil];
+    }];
+}
+
+/**
+ Reads a stream to the end, the way the connection would, and returns the number of bytes read.
+ */
+- (unsigned long long)drainStream:(NSInputStream *)stream memoryHighWaterMark:(uint64_t *)highWaterMark {
+    uint8_t buffer[32 * 1024];
+    unsigned long long total = 0;
+    [stream open];
+    NSInteger read;
+    while ((read = [stream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        total += read;
+        if (highWaterMark && total % (1024 * 1024) < sizeof(buffer)) {
+            *highWaterMark = MAX(*highWaterMark, WPBenchmarkResidentMemory());
+        }
+    }
+    [stream close];
+    return total;
+}
+
+- (NSNumber *)percentile:(double)percentile ofSortedValues:(NSArray *)values {
+    if ([values count] == 0) {
+        return @0;
+    }
+    NSUInteger index = MIN((NSUInteger)ceil(percentile * [values count]), [values count]) - 1;
+    return values[index];
+}
+
+- (void)recordBenchmark:(NSString *)name size:(NSNumber *)size bytes:(unsigned long long)bytes seconds:(NSTimeInterval)seconds extra:(NSDictionary *)extra {
+    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithDictionary:@{
+                                                                                  @"name": name,
+                                                                                  @"size": size,
+                                                                                  @"bytes": @(bytes),
+                                                                                  @"seconds": @(seconds),
+                                                                                  @"bytesPerSecond": @(seconds > 0 ? bytes / seconds : 0),
+                                                                                  }];
+    [result addEntriesFromDictionary:extra];
+    [WPBenchmarkResults addObject:result];
+    NSLog(@"[Benchmark] %@ (%@): %.4fs", name, size, seconds);
+}
+
++ (void)writeResults {
+    NSDictionary *info = [[NSBundle mainBundle] infoDictionary];
+    NSDictionary *report = @{
+                             @"date": [[NSDate date] description],
+                             @"version": info[@"CFBundleShortVersionString"] ?: @"unknown",
+                             @"system": [NSString stringWithFormat:@"%@ %@", [[UIDevice currentDevice] systemName], [[UIDevice currentDevice] systemVersion]],
+                             @"model": [[UIDevice currentDevice] model],
+                             @"results": WPBenchmarkResults,
+                             };
+    NSData *json = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:nil];
+    NSString *path = [[[NSProcessInfo processInfo] environment] objectForKey:@"WPBenchmarkResultsPath"];
+    if ([path length] == 0) {
+        path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"WordPressApiBenchmarks.json"];
+    }
+    if ([json writeToFile:path atomically:YES]) {
+        NSLog(@"[Benchmark] Results written to %@", path);
+    }
+}
+
+@end
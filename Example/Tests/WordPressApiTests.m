@@ -13,6 +13,7 @@
 - (void)setUp {
     [super setUp];
     // Put setup code here. This method is called before the invocation of each test method in the class.
+    [WordPressXMLRPCApi removeDiscoveredEndpoints];
 }
 
 - (void)tearDown {
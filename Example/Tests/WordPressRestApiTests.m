@@ -0,0 +1,148 @@
+#import <XCTest/XCTest.h>
+#import <WordPressApi.h>
+#import <WPPostStore.h>
+#import <OHHTTPStubs/OHHTTPStubs.h>
+#import <OHHTTPStubs/OHHTTPStubsResponse.h>
+
+@interface WordPressRestApiTests : XCTestCase
+@end
+
+@implementation WordPressRestApiTests
+
+- (void)tearDown {
+    [super tearDown];
+    [OHHTTPStubs removeAllStubs];
+}
+
+- (UIImage *)imageWithSize:(CGSize)size {
+    UIGraphicsBeginImageContext(size);
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    return image;
+}
+
+- (void)testGalleryIsPostedAsMultipartForm {
+    __block NSUInteger requestCount = 0;
+    __block NSString *contentType = nil;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.path hasSuffix:@"/sites/1/posts/new"];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        contentType = [request valueForHTTPHeaderField:@"Content-Type"];
+        NSData *response = [NSJSONSerialization dataWithJSONObject:@{@"ID": @7, @"URL": @"https://mysite.wordpress.com/7"} options:0 error:nil];
+        return [OHHTTPStubsResponse responseWithData:response statusCode:200 headers:@{@"Content-Type": @"application/json"}];
+    }];
+
+    WordPressRestApi *api = [[WordPressRestApi alloc] initWithOauthToken:@"token" siteId:@"1"];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Gallery should be published"];
+    NSArray *images = @[[self imageWithSize:CGSizeMake(2, 2)], [self imageWithSize:CGSizeMake(3, 3)]];
+    [api publishPostWithGallery:images description:@"Content" title:@"Title" success:^(NSUInteger postId, NSURL *permalink) {
+        XCTAssertEqual(postId, 7);
+        XCTAssertEqualObjects(permalink, [NSURL URLWithString:@"https://mysite.wordpress.com/7"]);
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Gallery should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual(requestCount, 1);
+    XCTAssertTrue([contentType hasPrefix:@"multipart/form-data"], @"Expected the images to be sent as form parts");
+}
+
+- (void)testGalleryFailsWhenAnImageCantBeEncoded {
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.host isEqualToString:@"public-api.wordpress.com"];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:500 headers:nil];
+    }];
+
+    WordPressRestApi *api = [[WordPressRestApi alloc] initWithOauthToken:@"token" siteId:@"1"];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Gallery should fail"];
+    // An image without bitmap has no JPEG representation
+    NSArray *images = @[[self imageWithSize:CGSizeMake(2, 2)], [[UIImage alloc] init]];
+    [api publishPostWithGallery:images description:@"Content" title:@"Title" success:^(NSUInteger postId, NSURL *permalink) {
+        XCTFail(@"A gallery missing an image should not be published.");
+    } failure:^(NSError *error) {
+        XCTAssertEqualObjects(error.domain, WordPressRestApiErrorDomain);
+        XCTAssertEqual(error.code, WordPressRestApiErrorInvalidImage);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual(requestCount, 0, @"Expected nothing to be sent");
+}
+
+- (void)testStoredPostsAreKeptPerAccount {
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.path hasSuffix:@"/sites/1/posts"];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSDictionary *post = @{@"ID": @3, @"title": @"Private", @"modified": @"2026-10-03T10:00:00+00:00"};
+        NSData *response = [NSJSONSerialization dataWithJSONObject:@{@"found": @1, @"posts": @[post]} options:0 error:nil];
+        return [OHHTTPStubsResponse responseWithData:response statusCode:200 headers:@{@"Content-Type": @"application/json"}];
+    }];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    WPPostStore *store = [[WPPostStore alloc] initWithPath:path];
+    WordPressRestApi *api = [[WordPressRestApi alloc] initWithOauthToken:@"token" siteId:@"1"];
+    WordPressRestApi *otherAccountApi = [[WordPressRestApi alloc] initWithOauthToken:@"other-token" siteId:@"1"];
+    api.postStore = store;
+    otherAccountApi.postStore = store;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Posts should be fetched"];
+    [api getPosts:10 fields:nil success:^(NSArray *posts) {
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Get posts should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    [store waitUntilWritten];
+
+    XCTAssertEqual([[api storedPosts:0] count], 1);
+    XCTAssertEqual([[otherAccountApi storedPosts:0] count], 0, @"Expected another account on the same site not to see the stored posts");
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testFanOutBatchesWordPressComSitesAndReportsEachSite {
+    __block NSUInteger batchRequests = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.host isEqualToString:@"public-api.wordpress.com"];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        XCTAssertEqualObjects(request.URL.path, @"/rest/v1.1/batch");
+        batchRequests++;
+        NSDictionary *response = @{@"/sites/1/posts?number=5": @{@"posts": @[@{@"ID": @1}]},
+                                   @"/sites/2/posts?number=5": @{@"error": @"unauthorized", @"message": @"User cannot access this private blog."}};
+        return [OHHTTPStubsResponse responseWithData:[NSJSONSerialization dataWithJSONObject:response options:0 error:nil] statusCode:200 headers:@{@"Content-Type": @"application/json"}];
+    }];
+    NSString *xmlrpcEndpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:xmlrpcEndpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><fault><value><struct><member><name>faultCode</name><value><int>403</int></value></member><member><name>faultString</name><value><string>Incorrect username or password.</string></value></member></struct></value></fault></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    NSArray *apis = @[[[WordPressRestApi alloc] initWithOauthToken:@"token" siteId:@"1"],
+                      [[WordPressRestApi alloc] initWithOauthToken:@"token" siteId:@"2"],
+                      [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:xmlrpcEndpoint] username:@"user" password:@"pass"]];
+    WPMultiSiteFanOut *fanOut = [[WPMultiSiteFanOut alloc] initWithApis:apis];
+    NSMutableIndexSet *reportedSites = [NSMutableIndexSet indexSet];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Every site should be reported"];
+    [fanOut getPosts:5 siteHandler:^(NSUInteger siteIndex, id posts, NSError *error) {
+        XCTAssertFalse([reportedSites containsIndex:siteIndex], @"Expected each site to be reported once");
+        [reportedSites addIndex:siteIndex];
+    } completion:^(NSArray *results, NSDictionary *errors) {
+        XCTAssertEqual([reportedSites count], 3u);
+        XCTAssertEqual(batchRequests, 1u, @"Expected both WordPress.com sites in one batch request");
+        XCTAssertEqual([results[0] count], 1u);
+        XCTAssertEqualObjects(results[1], [NSNull null]);
+        XCTAssertEqualObjects([errors[@1] localizedDescription], @"User cannot access this private blog.");
+        XCTAssertNotNil(errors[@2]);
+        XCTAssertNil(errors[@0]);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+@end
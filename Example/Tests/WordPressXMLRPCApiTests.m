@@ -1,10 +1,18 @@
 #import <XCTest/XCTest.h>
 #import <WordPressApi.h>
+#import <WPRequestScheduler.h>
+#import <WPPostSyncState.h>
+#import <WPPostModel.h>
+#import <WPRetryPolicy.h>
+#import <WPInFlightRequests.h>
+#import <WPConnectionPrewarmer.h>
+#import <WPResponseCache.h>
+#import <WPXMLRPCEndpointDiscovery.h>
 #import <OHHTTPStubs/OHHTTPStubs.h>
 #import <OHHTTPStubs/OHHTTPStubsResponse.h>
 
-@interface WordPressXMLRPCApiTests : XCTestCase
-
+@interface WordPressXMLRPCApiTests : XCTestCase <WPRequestMetricsObserver>
+@property (nonatomic, strong) NSMutableArray *reportedMetrics;
 @end
 
 @implementation WordPressXMLRPCApiTests
@@ -12,6 +20,7 @@
 - (void)setUp {
     [super setUp];
     // Put setup code here. This method is called before the invocation of each test method in the class.
+    [WordPressXMLRPCApi removeDiscoveredEndpoints];
 }
 
 - (void)tearDown {
@@ -386,4 +395,1108 @@
     [self waitForExpectationsWithTimeout:2 handler:nil];
 }
 
+- (void)testDiscoveryStaggersStrategiesAndCancelsTheLosers {
+    NSBlockOperation *slowOperation = [NSBlockOperation blockOperationWithBlock:^{}];
+    __block CFAbsoluteTime secondStartTime = 0;
+    __block BOOL thirdStarted = NO;
+    NSArray *strategies = @[
+                            [^(WPXMLRPCEndpointDiscovery *discovery, void (^found)(NSURL *), void (^failed)(NSError *)) {
+                                // Never answers, like a host that doesn't respond
+                                [discovery addOperation:slowOperation];
+                            } copy],
+                            [^(WPXMLRPCEndpointDiscovery *discovery, void (^found)(NSURL *), void (^failed)(NSError *)) {
+                                secondStartTime = CFAbsoluteTimeGetCurrent();
+                                found([NSURL URLWithString:@"https://mywordpresssite.com/xmlrpc.php"]);
+                            } copy],
+                            [^(WPXMLRPCEndpointDiscovery *discovery, void (^found)(NSURL *), void (^failed)(NSError *)) {
+                                thirdStarted = YES;
+                            } copy],
+                            ];
+    WPXMLRPCEndpointDiscovery *discovery = [[WPXMLRPCEndpointDiscovery alloc] initWithStrategies:strategies];
+    discovery.staggerInterval = 0.2;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Second strategy should win"];
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    [discovery startWithSuccess:^(NSURL *xmlrpcURL) {
+        XCTAssertEqualObjects(xmlrpcURL, [NSURL URLWithString:@"https://mywordpresssite.com/xmlrpc.php"]);
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Discovery should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertGreaterThanOrEqual(secondStartTime - startTime, 0.2, @"Expected the first strategy to get a head start");
+    XCTAssertTrue(slowOperation.isCancelled, @"Expected the losing strategy to be cancelled");
+    XCTAssertTrue(discovery.isFinished);
+    XCTAssertFalse(thirdStarted, @"Expected no strategy to start after the race was won");
+}
+
+- (void)testDiscoveryStartsTheNextStrategyWhenOneFails {
+    __block CFAbsoluteTime secondStartTime = 0;
+    NSArray *strategies = @[
+                            [^(WPXMLRPCEndpointDiscovery *discovery, void (^found)(NSURL *), void (^failed)(NSError *)) {
+                                failed([NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCannotConnectToHost userInfo:nil]);
+                            } copy],
+                            [^(WPXMLRPCEndpointDiscovery *discovery, void (^found)(NSURL *), void (^failed)(NSError *)) {
+                                secondStartTime = CFAbsoluteTimeGetCurrent();
+                                failed([NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:nil]);
+                            } copy],
+                            ];
+    WPXMLRPCEndpointDiscovery *discovery = [[WPXMLRPCEndpointDiscovery alloc] initWithStrategies:strategies];
+    discovery.staggerInterval = 1;
+    discovery.preferredErrorStrategyIndex = 0;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Discovery should fail"];
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    [discovery startWithSuccess:^(NSURL *xmlrpcURL) {
+        XCTFail(@"Discovery should not enter success block.");
+    } failure:^(NSError *error) {
+        XCTAssertEqual(error.code, NSURLErrorCannotConnectToHost, @"Expected the error of the preferred strategy");
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertLessThan(secondStartTime - startTime, 1, @"Expected the failure to start the next strategy without waiting");
+}
+
+- (void)testDiscoveredEndpointIsRememberedPerScheme {
+    NSMutableArray *requestedURLs = [NSMutableArray array];
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.host isEqualToString:@"mywordpresssite.com"];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        @synchronized(requestedURLs) {
+            [requestedURLs addObject:request.URL.absoluteString];
+        }
+        if (![request.URL.path isEqualToString:@"/xmlrpc.php"]) {
+            return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:404 headers:nil];
+        }
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data>"
+                              "<value><string>wp.getUsersBlogs</string></value></data></array></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    for (NSString *site in @[@"http://mywordpresssite.com", @"http://mywordpresssite.com", @"https://mywordpresssite.com"]) {
+        XCTestExpectation *expectation = [self expectationWithDescription:site];
+        [WordPressXMLRPCApi guessXMLRPCURLForSite:site success:^(NSURL *xmlrpcURL) {
+            XCTAssertEqualObjects(xmlrpcURL.scheme, [NSURL URLWithString:site].scheme, @"Expected an endpoint with the scheme asked for");
+            [expectation fulfill];
+        } failure:^(NSError *error) {
+            XCTFail(@"Discovery should not enter failure block.");
+        }];
+        [self waitForExpectationsWithTimeout:2 handler:nil];
+    }
+    // Discovery might have raced the page fetch, but the remembered endpoint is validated alone
+    NSUInteger rememberedLookups = 0;
+    for (NSString *URL in requestedURLs) {
+        if ([URL isEqualToString:@"http://mywordpresssite.com/xmlrpc.php"]) {
+            rememberedLookups++;
+        }
+    }
+    XCTAssertEqual(rememberedLookups, 2, @"Expected the second lookup to only validate the remembered endpoint");
+    XCTAssertEqualObjects([requestedURLs lastObject], @"https://mywordpresssite.com/xmlrpc.php");
+}
+
+- (void)testBatchedCallsAreSentAsSingleMulticall {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data>"
+                              "<value><array><data><value><string>first</string></value></data></array></value>"
+                              "<value><struct>"
+                              "<member><name>faultCode</name><value><int>403</int></value></member>"
+                              "<member><name>faultString</name><value><string>Forbidden</string></value></member>"
+                              "</struct></value>"
+                              "</data></array></value></param></params></methodResponse>";
+        return [[OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil]
+                responseTime:OHHTTPStubsDownloadSpeedWifi];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.batchingEnabled = YES;
+
+    XCTestExpectation *firstExpectation = [self expectationWithDescription:@"First call should succeed"];
+    XCTestExpectation *secondExpectation = [self expectationWithDescription:@"Second call should fail with its own fault"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTAssertEqualObjects(responseObject, @"first", @"Expected the first call to get the first multicall result");
+        [firstExpectation fulfill];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTFail(@"First call should not enter failure block.");
+    }];
+    [client callMethod:@"wp.getUsersBlogs" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTFail(@"Second call should not enter success block.");
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTAssertEqual(error.code, 403, @"Expected the second call to get its own fault code");
+        [secondExpectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertEqual(requestCount, 1, @"Expected both calls to be sent in a single request");
+    XCTAssertEqual(client.numberOfCoalescedCalls, 2, @"Expected both calls to be reported as coalesced");
+}
+
+- (void)testRejectedMulticallOnlyReplaysIdempotentCalls {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSMutableArray *bodies = [NSMutableArray array];
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *body = [[NSString alloc] initWithData:request.HTTPBody encoding:NSUTF8StringEncoding] ?: @"";
+        [bodies addObject:body];
+        if ([body containsString:@"system.multicall"]) {
+            return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:405 headers:nil];
+        }
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>options</string></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.batchingEnabled = YES;
+
+    XCTestExpectation *readExpectation = [self expectationWithDescription:@"Read call should be sent again"];
+    XCTestExpectation *writeExpectation = [self expectationWithDescription:@"Write call should fail"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTAssertEqualObjects(responseObject, @"options");
+        [readExpectation fulfill];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTFail(@"Read call should not enter failure block.");
+    }];
+    [client callMethod:@"wp.newPost" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTFail(@"Write call should not enter success block.");
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTAssertEqual(operation.response.statusCode, 405, @"Expected the multicall error");
+        [writeExpectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual([bodies count], 2, @"Expected the multicall and the read call only");
+    XCTAssertFalse([[bodies lastObject] containsString:@"wp.newPost"], @"Expected the write call not to be sent again");
+    XCTAssertTrue(client.multicallUnsupported);
+}
+
+- (void)testForbiddenMulticallIsNotTakenAsRejection {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:403 headers:nil];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.batchingEnabled = YES;
+
+    XCTestExpectation *firstExpectation = [self expectationWithDescription:@"First call should fail"];
+    XCTestExpectation *secondExpectation = [self expectationWithDescription:@"Second call should fail"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:nil failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        [firstExpectation fulfill];
+    }];
+    [client callMethod:@"wp.getPostTypes" parameters:@[] success:nil failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        [secondExpectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual(requestCount, 1, @"Expected no call to be sent again");
+    XCTAssertFalse(client.multicallUnsupported, @"Expected multicall to still be used");
+}
+
+- (void)stubXMLRPCEndpoint:(NSString *)endpoint requests:(NSMutableArray *)requests {
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *body = [[NSString alloc] initWithData:request.HTTPBody encoding:NSUTF8StringEncoding] ?: @"";
+        @synchronized(requests) {
+            [requests addObject:body];
+        }
+        NSString *value = [body containsString:@"wp.newPost"] ? @"<string>42</string>" : @"<array><data></data></array>";
+        NSString *response = [NSString stringWithFormat:@"<?xml version=\"1.0\"?><methodResponse><params><param><value>%@</value></param></params></methodResponse>", value];
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+}
+
+- (void)getOptionsWithApi:(WordPressXMLRPCApi *)api {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Options should be returned"];
+    [api getBlogOptionsWithSuccess:^(id options) {
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Call should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testPostsWithAndWithoutFieldsComeFromTheSameMethod {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSMutableArray *requests = [NSMutableArray array];
+    [self stubXMLRPCEndpoint:endpoint requests:requests];
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"user" password:@"pass"];
+    for (NSArray *fields in @[[NSNull null], @[@"post_title"]]) {
+        XCTestExpectation *expectation = [self expectationWithDescription:@"Posts should be returned"];
+        [api getPosts:10 fields:([fields isKindOfClass:[NSArray class]] ? fields : nil) success:^(NSArray *posts) {
+            [expectation fulfill];
+        } failure:^(NSError *error) {
+            XCTFail(@"Get posts should not enter failure block.");
+        }];
+        [self waitForExpectationsWithTimeout:2 handler:nil];
+    }
+
+    XCTAssertEqual([requests count], 2);
+    for (NSString *body in requests) {
+        XCTAssertTrue([body containsString:@"<methodName>wp.getPosts</methodName>"], @"Expected posts to have the same members with or without fields");
+    }
+}
+
+- (void)testCachedResponseIsUsedUntilItExpires {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSMutableArray *requests = [NSMutableArray array];
+    [self stubXMLRPCEndpoint:endpoint requests:requests];
+
+    WPResponseCache *cache = [[WPResponseCache alloc] initWithName:[[NSUUID UUID] UUIDString]];
+    [cache setTimeToLive:0.5 forMethod:@"wp.getOptions"];
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"username" password:@"password"];
+    api.responseCache = cache;
+
+    [self getOptionsWithApi:api];
+    [self getOptionsWithApi:api];
+    XCTAssertEqual([requests count], 1, @"Expected the fresh response to be used");
+
+    [NSThread sleepForTimeInterval:0.6];
+    [self getOptionsWithApi:api];
+    XCTAssertEqual([requests count], 2, @"Expected the expired response to be fetched again");
+    [cache removeAllObjects];
+}
+
+- (void)testPublishingOnlyInvalidatesTheCacheOfItsEndpoint {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSString *otherEndpoint = @"http://myothersite.com/xmlrpc.php";
+    NSMutableArray *requests = [NSMutableArray array];
+    NSMutableArray *otherRequests = [NSMutableArray array];
+    [self stubXMLRPCEndpoint:endpoint requests:requests];
+    [self stubXMLRPCEndpoint:otherEndpoint requests:otherRequests];
+
+    WPResponseCache *cache = [[WPResponseCache alloc] initWithName:[[NSUUID UUID] UUIDString]];
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"username" password:@"password"];
+    WordPressXMLRPCApi *otherApi = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:otherEndpoint] username:@"username" password:@"password"];
+    api.responseCache = cache;
+    otherApi.responseCache = cache;
+    [self getOptionsWithApi:api];
+    [self getOptionsWithApi:otherApi];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Post should be published"];
+    [api publishPostWithText:@"Content" title:@"Title" success:^(NSUInteger postId, NSURL *permalink) {
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Publishing should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    [self getOptionsWithApi:api];
+    [self getOptionsWithApi:otherApi];
+    XCTAssertEqual([requests count], 3, @"Expected the options to be fetched again after publishing");
+    XCTAssertEqual([otherRequests count], 1, @"Expected the other site to still be cached in memory");
+    [cache removeAllObjects];
+}
+
+- (void)testCachedResponsesAreReadBackFromDisk {
+    NSString *name = [[NSUUID UUID] UUIDString];
+    NSURL *endpoint = [NSURL URLWithString:@"http://mywordpresssite.com/xmlrpc.php"];
+    WPResponseCache *cache = [[WPResponseCache alloc] initWithName:name];
+    NSString *key = [cache keyForEndpoint:endpoint method:@"wp.getOptions" parameters:@[@1]];
+    [cache storeObject:@{@"blog_title": @"Title"} forKey:key method:@"wp.getOptions" ETag:@"\"1\"" lastModified:nil];
+
+    // A new cache only has the disk tier
+    WPResponseCache *reopenedCache = [[WPResponseCache alloc] initWithName:name];
+    [self expectationForPredicate:[NSPredicate predicateWithBlock:^BOOL(id evaluatedObject, NSDictionary *bindings) {
+        return [reopenedCache cachedResponseForKey:key] != nil;
+    }] evaluatedWithObject:reopenedCache handler:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    WPCachedResponse *response = [reopenedCache cachedResponseForKey:key];
+    XCTAssertEqualObjects(response.object, @{@"blog_title": @"Title"});
+    XCTAssertEqualObjects(response.ETag, @"\"1\"");
+    XCTAssertFalse([response isExpired]);
+    [reopenedCache removeAllObjects];
+}
+
+- (void)testCachedResponseIsACopyTheCallerCantChange {
+    WPResponseCache *cache = [[WPResponseCache alloc] initWithName:[[NSUUID UUID] UUIDString]];
+    NSString *key = [cache keyForEndpoint:[NSURL URLWithString:@"http://mywordpresssite.com/xmlrpc.php"] method:@"wp.getOptions" parameters:@[@1]];
+    NSMutableDictionary *title = [NSMutableDictionary dictionaryWithObject:@"Title" forKey:@"value"];
+    NSMutableDictionary *options = [NSMutableDictionary dictionaryWithObject:title forKey:@"blog_title"];
+    [cache storeObject:options forKey:key method:@"wp.getOptions" ETag:nil lastModified:nil];
+
+    // The first caller is handed the decoded response, and may change it
+    title[@"value"] = @"Changed";
+    options[@"time_zone"] = @"0";
+
+    id cachedOptions = [cache cachedResponseForKey:key].object;
+    XCTAssertEqualObjects(cachedOptions, @{@"blog_title": @{@"value": @"Title"}});
+    XCTAssertFalse([cachedOptions isKindOfClass:[NSMutableDictionary class]], @"Expected the cache to hand out an immutable copy");
+    XCTAssertFalse([cachedOptions[@"blog_title"] isKindOfClass:[NSMutableDictionary class]]);
+    [cache removeAllObjects];
+}
+
+- (void)testAuthenticationIsNeverAnsweredFromTheCache {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSMutableArray *requests = [NSMutableArray array];
+    [self stubXMLRPCEndpoint:endpoint requests:requests];
+
+    WPResponseCache *cache = [[WPResponseCache alloc] initWithName:[[NSUUID UUID] UUIDString]];
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"username" password:@"password"];
+    api.responseCache = cache;
+
+    XCTestExpectation *blogsExpectation = [self expectationWithDescription:@"Blogs should be fetched"];
+    [api getBlogsWithSuccess:^(NSArray *blogs) {
+        [blogsExpectation fulfill];
+    } failure:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTestExpectation *authenticationExpectation = [self expectationWithDescription:@"Credentials should be checked"];
+    [api authenticateWithSuccess:^{
+        [authenticationExpectation fulfill];
+    } failure:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertEqual([requests count], 2, @"Expected the credentials to be sent to the server");
+    [cache removeAllObjects];
+}
+
+- (void)testIdenticalReadCallsShareOneRequest {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><struct><member><name>blog_title</name><value><string>options</string></value></member></struct></value></param></params></methodResponse>";
+        return [[OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil]
+                requestTime:0.2 responseTime:0];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    XCTestExpectation *cancelledExpectation = [self expectationWithDescription:@"Cancelled call should fail with a cancellation error"];
+    WPRequestHandle *cancelledHandle = [client callMethod:@"wp.getOptions" parameters:@[@1] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTFail(@"Cancelled call should not enter success block.");
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTAssertEqual(error.code, NSURLErrorCancelled, @"Expected a cancellation error");
+        [cancelledExpectation fulfill];
+    }];
+    NSMutableArray *results = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 2; i++) {
+        XCTestExpectation *expectation = [self expectationWithDescription:@"Shared call should succeed"];
+        WPRequestHandle *handle = [client callMethod:@"wp.getOptions" parameters:@[@1] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+            [results addObject:responseObject];
+            [expectation fulfill];
+        } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+            XCTFail(@"Shared call should not enter failure block.");
+        }];
+        XCTAssertTrue(handle.shared, @"Expected the call to attach to the pending request");
+    }
+    [cancelledHandle cancel];
+
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertEqual(requestCount, 1, @"Expected a single request for identical calls");
+    XCTAssertEqual(client.inFlightRequests.numberOfSharedRequests, 2, @"Expected two calls to be shared");
+    XCTAssertEqualObjects(results[0], results[1], @"Expected every caller to get the same response");
+    XCTAssertEqualObjects(results[0], @{@"blog_title": @"options"});
+    XCTAssertFalse([results[0] isKindOfClass:[NSMutableDictionary class]], @"Expected attached callers to get an immutable copy");
+}
+
+- (void)testGalleryUploadsFinishingOnAConcurrentQueuePublishOnce {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger uploadCount = 0;
+    __block NSString *postBody = nil;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *body = [[NSString alloc] initWithData:request.HTTPBody encoding:NSUTF8StringEncoding];
+        NSString *response = nil;
+        @synchronized(self) {
+            if ([body containsString:@"wp.newPost"]) {
+                postBody = body;
+                response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>42</string></value></param></params></methodResponse>";
+            } else {
+                uploadCount++;
+                response = [NSString stringWithFormat:@"<?xml version=\"1.0\"?><methodResponse><params><param><value><struct>"
+                            "<member><name>id</name><value><string>%lu</string></value></member>"
+                            "<member><name>url</name><value><string>http://mywordpresssite.com/image.jpg</string></value></member>"
+                            "</struct></value></param></params></methodResponse>", (unsigned long)uploadCount];
+            }
+        }
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    UIGraphicsBeginImageContext(CGSizeMake(2, 2));
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    NSMutableArray *images = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 8; i++) {
+        [images addObject:image];
+    }
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"username" password:@"password"];
+    api.completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    __block NSUInteger successCount = 0;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Gallery should be published"];
+    [api publishPostWithGallery:images description:@"Content" title:@"Title" success:^(NSUInteger postId, NSURL *permalink) {
+        @synchronized(self) {
+            successCount++;
+        }
+        XCTAssertEqual(postId, 42);
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Gallery should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    XCTAssertEqual(uploadCount, 8, @"Expected every image to be uploaded");
+    XCTAssertEqual(successCount, 1, @"Expected the post to be published once");
+    NSRegularExpression *galleryIds = [NSRegularExpression regularExpressionWithPattern:@"ids=(?:&quot;|\")([0-9,]+)" options:0 error:nil];
+    NSTextCheckingResult *match = [galleryIds firstMatchInString:postBody ?: @"" options:0 range:NSMakeRange(0, [postBody length])];
+    XCTAssertNotNil(match, @"Expected a gallery in the post");
+    NSArray *ids = [[postBody substringWithRange:[match rangeAtIndex:1]] componentsSeparatedByString:@","];
+    XCTAssertEqual([[NSSet setWithArray:ids] count], 8, @"Expected every uploaded image in the gallery");
+}
+
+- (void)testGalleryFailsWithoutUploadingWhenAnImageCantBeEncoded {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:500 headers:nil];
+    }];
+
+    UIGraphicsBeginImageContext(CGSizeMake(2, 2));
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"username" password:@"password"];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Gallery should fail"];
+    // An image without bitmap has no JPEG representation
+    [api publishPostWithGallery:@[image, [[UIImage alloc] init]] description:@"Content" title:@"Title" success:^(NSUInteger postId, NSURL *permalink) {
+        XCTFail(@"A gallery missing an image should not be published.");
+    } failure:^(NSError *error) {
+        XCTAssertEqualObjects(error.domain, WordPressXMLRPCApiErrorDomain);
+        XCTAssertEqual(error.code, WordPressXMLRPCApiInvalid);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual(requestCount, 0, @"Expected nothing to be uploaded");
+}
+
+- (void)testCancelledBatchedCallIsTakenOutOfTheBatch {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSMutableArray *bodies = [NSMutableArray array];
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        [bodies addObject:[[NSString alloc] initWithData:request.HTTPBody encoding:NSUTF8StringEncoding] ?: @""];
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>ok</string></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.batchingEnabled = YES;
+    client.batchingInterval = 0.2;
+    XCTestExpectation *cancelledExpectation = [self expectationWithDescription:@"Cancelled call should fail with a cancellation error"];
+    WPRequestHandle *cancelledHandle = [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTFail(@"Cancelled call should not enter success block.");
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTAssertEqual(error.code, NSURLErrorCancelled, @"Expected a cancellation error");
+        [cancelledExpectation fulfill];
+    }];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Other call should succeed"];
+    [client callMethod:@"wp.getUsersBlogs" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        [expectation fulfill];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTFail(@"Call should not enter failure block.");
+    }];
+    [cancelledHandle cancel];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual([bodies count], 1, @"Expected a single request");
+    XCTAssertFalse([[bodies firstObject] containsString:@"wp.getOptions"], @"Expected the cancelled call not to be sent");
+    XCTAssertFalse([[bodies firstObject] containsString:@"system.multicall"], @"Expected the remaining call to be sent on its own");
+}
+
+- (void)testCallbacksAreDeliveredOnTheCompletionQueue {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>options</string></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    static void *completionQueueKey = &completionQueueKey;
+    dispatch_queue_t clientQueue = dispatch_queue_create("org.wordpress.tests.client", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(clientQueue, completionQueueKey, @"client", NULL);
+    dispatch_queue_t callQueue = dispatch_queue_create("org.wordpress.tests.call", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(callQueue, completionQueueKey, @"call", NULL);
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.decodeQueue = [WPXMLRPCClient sharedDecodeQueue];
+    client.completionQueue = clientQueue;
+    client.deduplicatesRequests = NO;
+
+    XCTestExpectation *clientExpectation = [self expectationWithDescription:@"Call should be delivered on the client's queue"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTAssertFalse([NSThread isMainThread], @"Expected the response not to go through the main thread");
+        XCTAssertEqualObjects((__bridge id)dispatch_get_specific(completionQueueKey), @"client", @"Expected the client's completion queue");
+        [clientExpectation fulfill];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTFail(@"Call should not enter failure block.");
+    }];
+    XCTestExpectation *callExpectation = [self expectationWithDescription:@"Call should be delivered on its own queue"];
+    [client callMethod:@"wp.getOptions" parameters:@[] decodeQueue:nil completionQueue:callQueue success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTAssertEqualObjects((__bridge id)dispatch_get_specific(completionQueueKey), @"call", @"Expected the call's completion queue");
+        [callExpectation fulfill];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTFail(@"Call should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testWarmUpOpensConnectionOnceWhileWarm {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger warmUpRequests = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        XCTAssertEqualObjects(request.HTTPMethod, @"HEAD");
+        warmUpRequests++;
+        // XML-RPC endpoints only accept POST, but any response means the connection is open
+        return [[OHHTTPStubsResponse responseWithData:[NSData data] statusCode:405 headers:nil] requestTime:0.2 responseTime:0];
+    }];
+
+    XCTAssertEqual([[WPConnectionPrewarmer alloc] init].warmConnectionLifetime, 5, @"Expected hosts to stay warm for about the keep-alive timeout of servers");
+    WPConnectionPrewarmer *prewarmer = [WPConnectionPrewarmer sharedPrewarmer];
+    [prewarmer removeWarmHosts];
+    // The warm-up waits for the scheduler before it's sent, which shouldn't count in its duration
+    [[WPRequestScheduler sharedScheduler] setOperationsSuspended:YES forOwner:prewarmer];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [[WPRequestScheduler sharedScheduler] setOperationsSuspended:NO forOwner:prewarmer];
+    });
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Warm-up should finish"];
+    [client warmUpConnectionWithCompletion:^(NSTimeInterval duration, NSError *error) {
+        XCTAssertNil(error);
+        XCTAssertGreaterThanOrEqual(duration, 0.2, @"Expected the duration to include the request");
+        XCTAssertLessThan(duration, 0.5, @"Expected the duration not to include the time waiting for the scheduler");
+        [client warmUpConnectionWithCompletion:^(NSTimeInterval duration, NSError *error) {
+            XCTAssertNil(error);
+            XCTAssertEqual(duration, 0, @"Expected a warm host not to be warmed up again");
+            XCTAssertEqual(warmUpRequests, 1u);
+            [expectation fulfill];
+        }];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+- (void)testPublishPostWithImageFailsWhenUploadHasNoURL {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><struct>"
+                              "<member><name>id</name><value><string>5</string></value></member>"
+                              "</struct></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    UIGraphicsBeginImageContext(CGSizeMake(1, 1));
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"username" password:@"password"];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Publishing should fail"];
+    [api publishPostWithImage:image description:@"Content" title:@"Title" success:^(NSUInteger postId, NSURL *permalink) {
+        XCTFail(@"A post without its image should not be published.");
+    } failure:^(NSError *error) {
+        XCTAssertEqualObjects(error.domain, WordPressXMLRPCApiErrorDomain);
+        XCTAssertEqual(error.code, WordPressXMLRPCApiInvalid);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertEqual(requestCount, 1, @"Expected wp.newPost not to be sent");
+}
+
+- (void)testPublishPostWithVideoFailsWhenUploadIsNotAStruct {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><boolean>1</boolean></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    NSString *videoPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[[NSUUID UUID] UUIDString] stringByAppendingPathExtension:@"mp4"]];
+    [[NSMutableData dataWithLength:1024] writeToFile:videoPath atomically:NO];
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"username" password:@"password"];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Publishing should fail"];
+    [api publishPostWithVideo:videoPath description:@"Content" title:@"Title" success:^(NSUInteger postId, NSURL *permalink) {
+        XCTFail(@"A post without its video should not be published.");
+    } failure:^(NSError *error) {
+        XCTAssertEqualObjects(error.domain, WordPressXMLRPCApiErrorDomain);
+        XCTAssertEqual(error.code, WordPressXMLRPCApiInvalid);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertEqual(requestCount, 1, @"Expected wp.newPost not to be sent");
+    [[NSFileManager defaultManager] removeItemAtPath:videoPath error:nil];
+}
+
+- (void)testMetricsAreReportedBeforeCompletion {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>ok</string></value></param></params></methodResponse>";
+        return [[OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil]
+                responseTime:OHHTTPStubsDownloadSpeedWifi];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    self.reportedMetrics = [NSMutableArray array];
+    client.metricsObserver = self;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Call should succeed"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTAssertEqual([self.reportedMetrics count], 1, @"Expected the metrics to be reported before the success block");
+        [expectation fulfill];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTFail(@"Call should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    WPRequestMetrics *metrics = [self.reportedMetrics firstObject];
+    XCTAssertEqualObjects(metrics.name, @"wp.getOptions", @"Expected the method name to be reported");
+    XCTAssertEqual(metrics.outcome, WPRequestOutcomeSuccess, @"Expected the call to be reported as successful");
+    XCTAssertEqual(metrics.statusCode, 200, @"Expected the status code to be reported");
+    XCTAssertTrue(metrics.requestBytes > 0 && metrics.responseBytes > 0, @"Expected the body sizes to be reported");
+    XCTAssertTrue(metrics.totalTime >= metrics.timeToFirstByte, @"Expected the total time to include the time to first byte");
+}
+
+- (void)testMetricsAreReportedPerBatchedAndCachedCall {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data>"
+                              "<value><array><data><value><string>options</string></value></data></array></value>"
+                              "<value><struct>"
+                              "<member><name>faultCode</name><value><int>403</int></value></member>"
+                              "<member><name>faultString</name><value><string>Forbidden</string></value></member>"
+                              "</struct></value>"
+                              "</data></array></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    WPResponseCache *cache = [[WPResponseCache alloc] initWithName:[[NSUUID UUID] UUIDString]];
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.batchingEnabled = YES;
+    client.responseCache = cache;
+    self.reportedMetrics = [NSMutableArray array];
+    client.metricsObserver = self;
+
+    XCTestExpectation *firstExpectation = [self expectationWithDescription:@"First call should finish"];
+    XCTestExpectation *secondExpectation = [self expectationWithDescription:@"Second call should finish"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        [firstExpectation fulfill];
+    } failure:nil];
+    [client callMethod:@"wp.getPostTypes" parameters:@[] success:nil failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        [secondExpectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual([self.reportedMetrics count], 2, @"Expected a metrics per call, not one for the multicall");
+    WPRequestMetrics *options = self.reportedMetrics[0];
+    WPRequestMetrics *postTypes = self.reportedMetrics[1];
+    XCTAssertEqualObjects(options.name, @"wp.getOptions");
+    XCTAssertTrue(options.batched);
+    XCTAssertEqual(options.outcome, WPRequestOutcomeSuccess);
+    XCTAssertEqualObjects(postTypes.name, @"wp.getPostTypes");
+    XCTAssertEqual(postTypes.outcome, WPRequestOutcomeFailure, @"Expected the fault of the call to be reported");
+    XCTAssertEqual(postTypes.statusCode, 200, @"Expected the status of the multicall");
+
+    XCTestExpectation *cachedExpectation = [self expectationWithDescription:@"Cached call should succeed"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        [cachedExpectation fulfill];
+    } failure:nil];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    WPRequestMetrics *cached = [self.reportedMetrics lastObject];
+    XCTAssertEqual([self.reportedMetrics count], 3);
+    XCTAssertTrue(cached.cached, @"Expected the cache hit to be reported");
+    XCTAssertFalse(cached.batched);
+    XCTAssertEqual(cached.responseBytes, 0);
+    [cache removeAllObjects];
+}
+
+- (void)testReadCallsAreRetriedAfterTransientErrors {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger requestCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        requestCount++;
+        if (requestCount == 1) {
+            return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:503 headers:nil];
+        }
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>ok</string></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    WPRetryPolicy *retryPolicy = [WPRetryPolicy defaultPolicy];
+    retryPolicy.baseDelay = 0.01;
+    client.retryPolicy = retryPolicy;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Call should succeed after a retry"];
+    [client callMethod:@"wp.getOptions" parameters:@[] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTAssertEqualObjects(responseObject, @"ok", @"Expected the response of the retry");
+        [expectation fulfill];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTFail(@"Call should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    XCTAssertEqual(requestCount, 2, @"Expected the call to be sent twice");
+    XCTAssertFalse([retryPolicy isIdempotentMethod:@"wp.newPost"], @"Expected wp.newPost not to be retried after a 503");
+}
+
+- (void)testPublishingIsNotRetriedAfterAServerError {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    __block NSUInteger publishCount = 0;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *body = [[NSString alloc] initWithData:request.HTTPBody encoding:NSUTF8StringEncoding] ?: @"";
+        if ([body containsString:@"<methodName>wp.newPost</methodName>"]) {
+            publishCount++;
+        }
+        return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:503 headers:nil];
+    }];
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"user" password:@"pass"];
+    WPRetryPolicy *retryPolicy = [WPRetryPolicy defaultPolicy];
+    retryPolicy.baseDelay = 0.01;
+    api.retryPolicy = retryPolicy;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Publishing should fail"];
+    [api publishPostWithText:@"Content" title:@"Title" success:^(NSUInteger postId, NSURL *permalink) {
+        XCTFail(@"Publishing should not enter success block.");
+    } failure:^(NSError *error) {
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    // Leaves time for a retry that shouldn't happen
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+
+    XCTAssertEqual(publishCount, 1, @"Expected wp.newPost to be sent exactly once after a 503");
+}
+
+- (void)testCompressedBodyIsResentUncompressedWhenRejected {
+    NSString *host = [NSString stringWithFormat:@"%@.example.com", [[[NSUUID UUID] UUIDString] lowercaseString]];
+    NSString *endpoint = [NSString stringWithFormat:@"http://%@/xmlrpc.php", host];
+    NSMutableArray *contentEncodings = [NSMutableArray array];
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *contentEncoding = [request valueForHTTPHeaderField:@"Content-Encoding"];
+        [contentEncodings addObject:contentEncoding ?: @"identity"];
+        if (contentEncoding) {
+            return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:415 headers:nil];
+        }
+        NSString *response = @"<?xml version=\"1.0\"?><methodResponse><params><param><value><string>ok</string></value></param></params></methodResponse>";
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.compressesRequestBodies = YES;
+    NSString *content = [@"" stringByPaddingToLength:4096 withString:@"<p>Hello world</p>" startingAtIndex:0];
+    NSURLRequest *request = [client requestWithMethod:@"wp.newPost" parameters:@[content]];
+    XCTAssertEqualObjects([request valueForHTTPHeaderField:@"Content-Encoding"], @"gzip", @"Expected a compressed body");
+    XCTAssertLessThan([[request HTTPBody] length], [content length], @"Expected the body to be smaller than the content");
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Call should succeed uncompressed"];
+    [client callMethod:@"wp.newPost" parameters:@[content] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTAssertEqualObjects(responseObject, @"ok", @"Expected the response of the uncompressed request");
+        [expectation fulfill];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        XCTFail(@"Call should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqualObjects(contentEncodings, (@[@"gzip", @"identity"]), @"Expected the call to be sent again uncompressed");
+    XCTAssertTrue([WPXMLRPCClient hostRejectsCompressedRequestBodies:host], @"Expected the host to be remembered");
+    XCTAssertNil([[client requestWithMethod:@"wp.newPost" parameters:@[content]] valueForHTTPHeaderField:@"Content-Encoding"], @"Expected later bodies not to be compressed");
+}
+
+- (void)testRetriedCompressedPublishFallsBackToUncompressedOnce {
+    NSString *host = [NSString stringWithFormat:@"%@.example.com", [[[NSUUID UUID] UUIDString] lowercaseString]];
+    NSString *endpoint = [NSString stringWithFormat:@"http://%@/xmlrpc.php", host];
+    NSMutableArray *contentEncodings = [NSMutableArray array];
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *contentEncoding = [request valueForHTTPHeaderField:@"Content-Encoding"];
+        [contentEncodings addObject:contentEncoding ?: @"identity"];
+        if ([contentEncodings count] == 1) {
+            // Never reached the server, so even wp.newPost is sent again
+            return [OHHTTPStubsResponse responseWithError:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCannotConnectToHost userInfo:nil]];
+        }
+        return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:(contentEncoding ? 415 : 400) headers:nil];
+    }];
+
+    WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:[NSURL URLWithString:endpoint]];
+    client.compressesRequestBodies = YES;
+    WPRetryPolicy *retryPolicy = [WPRetryPolicy defaultPolicy];
+    retryPolicy.baseDelay = 0.01;
+    client.retryPolicy = retryPolicy;
+    NSString *content = [@"" stringByPaddingToLength:4096 withString:@"<p>Hello world</p>" startingAtIndex:0];
+
+    __block NSUInteger failureCount = 0;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Call should fail"];
+    [client callMethod:@"wp.newPost" parameters:@[content] success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        XCTFail(@"Call should not enter success block.");
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        failureCount++;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    // Leaves time for another fallback that shouldn't happen
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+
+    XCTAssertEqualObjects(contentEncodings, (@[@"gzip", @"gzip", @"identity"]), @"Expected the retry to fall back to an uncompressed body once, and the failure of that body to be final");
+    XCTAssertEqual(failureCount, 1);
+}
+
+/**
+ Answers `wp.getPosts` with a page of posts, taken from `postIds` at the offset and number of the request. Post N was modified on day N of October 2026.
+ */
+- (void)stubPostsAtEndpoint:(NSString *)endpoint postIds:(NSMutableArray *)postIds requestCount:(NSUInteger *)requestCount {
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        (*requestCount)++;
+        NSString *body = [[NSString alloc] initWithData:request.HTTPBody encoding:NSUTF8StringEncoding] ?: @"";
+        NSInteger (^filterValue)(NSString *) = ^NSInteger(NSString *name) {
+            NSString *pattern = [NSString stringWithFormat:@"<name>%@</name>\\s*<value>\\s*<(?:int|i4)>(\\d+)<", name];
+            NSRegularExpression *expression = [NSRegularExpression regularExpressionWithPattern:pattern options:0 error:nil];
+            NSTextCheckingResult *match = [expression firstMatchInString:body options:0 range:NSMakeRange(0, [body length])];
+            return match ? [[body substringWithRange:[match rangeAtIndex:1]] integerValue] : 0;
+        };
+        NSInteger offset = filterValue(@"offset");
+        NSInteger number = filterValue(@"number");
+        NSMutableString *posts = [NSMutableString string];
+        @synchronized(postIds) {
+            for (NSInteger i = offset; i < MIN(offset + number, (NSInteger)[postIds count]); i++) {
+                [posts appendFormat:@"<value><struct><member><name>post_id</name><value><string>%@</string></value></member>"
+                                     "<member><name>post_modified_gmt</name><value><dateTime.iso8601>202610%02ldT10:00:00</dateTime.iso8601></value></member></struct></value>",
+                 postIds[i], (long)[postIds[i] integerValue]];
+            }
+        }
+        NSString *response = [NSString stringWithFormat:@"<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data>%@</data></array></value></param></params></methodResponse>", posts];
+        return [[OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil]
+                responseTime:OHHTTPStubsDownloadSpeedWifi];
+    }];
+}
+
+- (void)testSyncPostsPagesUntilShortPageAndStoresHighWaterMark {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSUInteger requestCount = 0;
+    [self stubPostsAtEndpoint:endpoint postIds:[NSMutableArray arrayWithArray:@[@"3", @"2", @"1"]] requestCount:&requestCount];
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"user" password:@"pass"];
+    [api resetPostsSync];
+
+    NSMutableArray *pageSizes = [NSMutableArray array];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Sync should succeed"];
+    [api syncPostsWithPageSize:2 pageHandler:^(NSArray *posts) {
+        [pageSizes addObject:@([posts count])];
+    } success:^(NSDate *highWaterMark) {
+        XCTAssertNotNil(highWaterMark, @"Expected the newest modification date to be reported");
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Sync should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqual(requestCount, 2, @"Expected paging to stop after the short page");
+    XCTAssertEqualObjects(pageSizes, (@[@2, @1]), @"Expected each page to be reported");
+    NSDate *highWaterMark = [WPPostSyncState highWaterMarkForSite:[NSString stringWithFormat:@"%@#user", endpoint]];
+    XCTAssertNotNil(highWaterMark, @"Expected the high-water mark to be stored after a complete sync");
+    [api resetPostsSync];
+}
+
+- (void)testSyncPostsDoesNotSkipPostsWhenOneIsDeletedDuringTheSync {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSUInteger requestCount = 0;
+    NSMutableArray *postIds = [NSMutableArray arrayWithArray:@[@"5", @"4", @"3", @"2", @"1"]];
+    [self stubPostsAtEndpoint:endpoint postIds:postIds requestCount:&requestCount];
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"user" password:@"pass"];
+    [api resetPostsSync];
+
+    NSMutableArray *syncedPostIds = [NSMutableArray array];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Sync should succeed"];
+    [api syncPostsWithPageSize:2 pageHandler:^(NSArray *posts) {
+        [syncedPostIds addObjectsFromArray:[posts valueForKey:@"post_id"]];
+        // Shifts the posts not synced yet by one, as offset paging would skip post 3
+        @synchronized(postIds) {
+            [postIds removeObject:@"5"];
+        }
+    } success:^(NSDate *highWaterMark) {
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Sync should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+
+    XCTAssertEqualObjects(syncedPostIds, (@[@"5", @"4", @"3", @"2", @"1"]), @"Expected every post to be synced once");
+    [api resetPostsSync];
+}
+
+- (void)testStreamedPostsOnAConcurrentQueueAreReportedOneAtATimeBeforeSuccess {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSUInteger postCount = 300;
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSMutableString *posts = [NSMutableString string];
+        for (NSUInteger i = 0; i < postCount; i++) {
+            [posts appendFormat:@"<value><struct><member><name>postid</name><value><string>%lu</string></value></member></struct></value>", (unsigned long)i];
+        }
+        NSString *response = [NSString stringWithFormat:@"<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data>%@</data></array></value></param></params></methodResponse>", posts];
+        return [[OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil]
+                responseTime:OHHTTPStubsDownloadSpeedWifi];
+    }];
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"user" password:@"pass"];
+    api.completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    // Deliberately unsynchronized, as a caller would write it for a serial queue
+    NSMutableArray *postIds = [NSMutableArray array];
+    __block NSUInteger runningHandlers = 0;
+    __block BOOL overlapped = NO;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Posts should be received"];
+    [api getPosts:postCount postHandler:^(NSDictionary *post) {
+        @synchronized(expectation) {
+            runningHandlers++;
+            overlapped = overlapped || runningHandlers > 1;
+        }
+        [postIds addObject:post[@"postid"]];
+        [NSThread sleepForTimeInterval:0.0005];
+        @synchronized(expectation) {
+            runningHandlers--;
+        }
+    } success:^{
+        XCTAssertEqual([postIds count], postCount, @"Expected every post to be reported before success");
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Get posts should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    XCTAssertFalse(overlapped, @"Expected posts to be reported one at a time");
+    for (NSUInteger i = 0; i < [postIds count]; i++) {
+        XCTAssertEqualObjects(postIds[i], [@(i) stringValue], @"Expected posts to be reported in order");
+    }
+}
+
+- (void)testSyncPostsOnAConcurrentQueueSyncsEveryPost {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    NSUInteger requestCount = 0;
+    NSMutableArray *postIds = [NSMutableArray array];
+    for (NSUInteger i = 30; i > 0; i--) {
+        [postIds addObject:[@(i) stringValue]];
+    }
+    [self stubPostsAtEndpoint:endpoint postIds:postIds requestCount:&requestCount];
+
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"user" password:@"pass"];
+    api.completionQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    [api resetPostsSync];
+
+    NSMutableArray *syncedPostIds = [NSMutableArray array];
+    __block NSDate *reportedHighWaterMark = nil;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Sync should succeed"];
+    [api syncPostsWithPageSize:10 pageHandler:^(NSArray *posts) {
+        [syncedPostIds addObjectsFromArray:[posts valueForKey:@"post_id"]];
+    } success:^(NSDate *highWaterMark) {
+        reportedHighWaterMark = highWaterMark;
+        [expectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Sync should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    XCTAssertEqualObjects(syncedPostIds, postIds, @"Expected every post to be synced once, in order");
+    NSDate *highWaterMark = [WPPostSyncState highWaterMarkForSite:[NSString stringWithFormat:@"%@#user", endpoint]];
+    XCTAssertNotNil(highWaterMark, @"Expected the high-water mark to be stored after a complete sync");
+    XCTAssertEqualObjects(highWaterMark, reportedHighWaterMark);
+    [api resetPostsSync];
+}
+
+- (void)testOnlyPostsWithTheMembersOfWPGetPostsAreStored {
+    NSString *endpoint = @"http://mywordpresssite.com/xmlrpc.php";
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        return [request.URL.absoluteString isEqualToString:endpoint];
+    } withStubResponse:^OHHTTPStubsResponse*(NSURLRequest *request) {
+        NSString *body = [[NSString alloc] initWithData:request.HTTPBody encoding:NSUTF8StringEncoding] ?: @"";
+        NSString *post = nil;
+        if ([body containsString:@"<methodName>wp.getPosts</methodName>"]) {
+            post = @"<member><name>post_id</name><value><string>1</string></value></member>"
+                    "<member><name>post_title</name><value><string>Title</string></value></member>"
+                    "<member><name>post_modified_gmt</name><value><dateTime.iso8601>20261001T10:00:00</dateTime.iso8601></value></member>";
+        } else {
+            post = @"<member><name>postid</name><value><string>1</string></value></member>"
+                    "<member><name>title</name><value><string>Title</string></value></member>"
+                    "<member><name>date_modified_gmt</name><value><dateTime.iso8601>20261001T10:00:00</dateTime.iso8601></value></member>";
+        }
+        NSString *response = [NSString stringWithFormat:@"<?xml version=\"1.0\"?><methodResponse><params><param><value><array><data><value><struct>%@</struct></value></data></array></value></param></params></methodResponse>", post];
+        return [OHHTTPStubsResponse responseWithData:[response dataUsingEncoding:NSUTF8StringEncoding] statusCode:200 headers:nil];
+    }];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    WPPostStore *store = [[WPPostStore alloc] initWithPath:path];
+    WordPressXMLRPCApi *api = [WordPressXMLRPCApi apiWithXMLRPCEndpoint:[NSURL URLWithString:endpoint] username:@"user" password:@"pass"];
+    api.postStore = store;
+
+    XCTestExpectation *recentPostsExpectation = [self expectationWithDescription:@"Recent posts should be fetched"];
+    [api getPosts:10 success:^(NSArray *posts) {
+        [recentPostsExpectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Get posts should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    [store waitUntilWritten];
+    XCTAssertEqual([[api storedPosts:0] count], 0, @"Expected metaWeblog.getRecentPosts structs not to be stored");
+
+    XCTestExpectation *postsExpectation = [self expectationWithDescription:@"Posts should be fetched"];
+    [api getPosts:10 fields:nil success:^(NSArray *posts) {
+        [postsExpectation fulfill];
+    } failure:^(NSError *error) {
+        XCTFail(@"Get posts should not enter failure block.");
+    }];
+    [self waitForExpectationsWithTimeout:2 handler:nil];
+    [store waitUntilWritten];
+
+    WPPostModel *storedPost = [[api storedPosts:0] firstObject];
+    XCTAssertEqualObjects([storedPost objectForKey:@"post_title"], @"Title", @"Expected the wp.getPosts struct to be stored");
+    XCTAssertNil([storedPost objectForKey:@"title"]);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)requestDidFinishWithMetrics:(WPRequestMetrics *)metrics {
+    [self.reportedMetrics addObject:metrics];
+}
+
 @end
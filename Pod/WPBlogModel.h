@@ -0,0 +1,33 @@
+#import "WPLazyModel.h"
+
+/**
+ `WPBlogModel` is a blog returned by `getBlogModelsWithSuccess:failure:`.
+ */
+@interface WPBlogModel : WPLazyModel
+
+/**
+ The blog ID.
+ */
+@property (readonly, nonatomic, strong) NSString *blogId;
+
+/**
+ The blog name.
+ */
+@property (readonly, nonatomic, strong) NSString *name;
+
+/**
+ The blog URL.
+ */
+@property (readonly, nonatomic, strong) NSURL *url;
+
+/**
+ The XML-RPC endpoint of the blog.
+ */
+@property (readonly, nonatomic, strong) NSURL *xmlrpc;
+
+/**
+ `YES` if the user is an administrator of the blog.
+ */
+@property (readonly, nonatomic, assign) BOOL isAdmin;
+
+@end
@@ -0,0 +1,27 @@
+#import "WPBlogModel.h"
+
+@implementation WPBlogModel
+
+- (NSString *)blogId {
+    return [self stringForFirstKeyIn:@[@"blogid"]];
+}
+
+- (NSString *)name {
+    return [self stringForFirstKeyIn:@[@"blogName"]];
+}
+
+- (NSURL *)url {
+    NSString *url = [self stringForFirstKeyIn:@[@"url"]];
+    return url ? [NSURL URLWithString:url] : nil;
+}
+
+- (NSURL *)xmlrpc {
+    NSString *xmlrpc = [self stringForFirstKeyIn:@[@"xmlrpc"]];
+    return xmlrpc ? [NSURL URLWithString:xmlrpc] : nil;
+}
+
+- (BOOL)isAdmin {
+    return [[self objectForFirstKeyIn:@[@"isAdmin"]] boolValue];
+}
+
+@end
@@ -17,6 +17,13 @@ typedef NS_ENUM(NSUInteger, WPComOAuthErrorCode) {
 - (void)setSecret:(NSString *)secret;
 - (void)setCompletionBlock:(void (^)(NSString *token, NSString *blogId, NSString *blogUrl, NSString *scope, NSError *error))completionBlock;
 
+/**
+ Opens a connection to the token endpoint ahead of signing in, e.g. when the login screen appears, so getting the token doesn't wait for DNS, TCP and TLS.
+
+ @param completion A block object to execute on the main queue when the connection is open or failed to open. This block has no return value and takes two arguments: how long the warm-up took, `0` if the host was already warm, and an error if it failed. Can be `nil`.
+ */
+- (void)warmUpConnectionWithCompletion:(void (^)(NSTimeInterval duration, NSError *error))completion;
+
 - (void)present;
 - (void)presentWithScope:(NSString *)scope blogId:(NSString *)blogId;
 - (void)getTokenWithCode:(NSString *)code secret:(NSString *)secret;
@@ -1,5 +1,6 @@
 #import <AFNetworking/AFNetworking.h>
 #import "WPComOAuthController.h"
+#import "WPConnectionPrewarmer.h"
 
 NSString *const WPComOAuthBaseUrl = @"https://public-api.wordpress.com/oauth2";
 NSString *const WPComOAuthLoginUrl = @"https://wordpress.com/wp-login.php";
@@ -32,6 +33,11 @@ NSString *const WPComOAuthErrorDomain = @"WPComOAuthError";
     return _sharedController;
 }
 
+- (void)warmUpConnectionWithCompletion:(void (^)(NSTimeInterval duration, NSError *error))completion {
+    NSString *tokenUrl = [NSString stringWithFormat:@"%@/token", WPComOAuthBaseUrl];
+    [[WPConnectionPrewarmer sharedPrewarmer] warmUpURL:[NSURL URLWithString:tokenUrl] sessionTransport:nil completion:completion];
+}
+
 - (void)present {
     [self presentWithScope:nil blogId:nil];
 }
@@ -0,0 +1,40 @@
+#import <Foundation/Foundation.h>
+
+@class WPURLSessionTransport;
+
+/**
+ `WPConnectionPrewarmer` opens connections to hosts before they're needed, so the DNS lookup, TCP connection and TLS handshake aren't paid by the first request the user is waiting for.
+
+ A host is warmed up by sending it a `HEAD` request with prefetch priority and keeping the connection alive. The request is scheduled by the shared `WPRequestScheduler`, with the prewarmer as its owner, whether it's sent as an operation or with a transport. Any HTTP response counts as a warm connection, whatever its status code. Warming up a host which is already being warmed up, or which was warmed up within `warmConnectionLifetime`, doesn't send another request.
+
+ Invalid certificates are never asked to the user while warming up; the host is just reported as failed.
+ */
+@interface WPConnectionPrewarmer : NSObject
+
+/**
+ The prewarmer used by the API clients.
+ */
++ (WPConnectionPrewarmer *)sharedPrewarmer;
+
+/**
+ How long a host is considered warm after a successful warm-up. Servers close idle connections after a while, so this should be about their keep-alive timeout. Defaults to `5` seconds, the keep-alive timeout of a default Apache configuration.
+ */
+@property (nonatomic, assign) NSTimeInterval warmConnectionLifetime;
+
+/**
+ Opens a connection to the host of a URL.
+
+ @param URL The URL that will be requested, e.g. a XML-RPC endpoint. Only its scheme, host and port matter, but the request goes to the full URL.
+ @param transport The transport the URL will be requested with, so the connection is opened in its session. Pass `nil` for requests sent as operations.
+ @param completion A block object to execute on the main queue when the host is warm or the warm-up failed. This block has no return value and takes two arguments: how long the warm-up took from when its request started, not counting the time it waited for the scheduler, `0` if the host was already warm, and an error if no response was received. Can be `nil`.
+ */
+- (void)warmUpURL:(NSURL *)URL
+  sessionTransport:(WPURLSessionTransport *)transport
+        completion:(void (^)(NSTimeInterval duration, NSError *error))completion;
+
+/**
+ Forgets which hosts are warm, e.g. after the network changed.
+ */
+- (void)removeWarmHosts;
+
+@end
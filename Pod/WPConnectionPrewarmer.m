@@ -0,0 +1,157 @@
+#import "WPConnectionPrewarmer.h"
+
+#import <AFNetworking/AFNetworking.h>
+#import "WPRequestMetrics.h"
+#import "WPRequestScheduler.h"
+#import "WPURLSessionTransport.h"
+
+// Apache closes idle connections after 5 seconds by default
+static NSTimeInterval const WPConnectionPrewarmerDefaultWarmConnectionLifetime = 5;
+// A warm-up slower than this wouldn't save the first request anything
+static NSTimeInterval const WPConnectionPrewarmerTimeout = 15;
+
+/**
+ A warm-up sent as an operation, telling its metrics when it starts.
+ */
+@interface WPConnectionPrewarmerOperation : AFHTTPRequestOperation
+@property (nonatomic, strong) WPRequestMetrics *metrics;
+@end
+
+@implementation WPConnectionPrewarmerOperation
+
+- (void)start {
+    [self.metrics operationDidStart];
+    [super start];
+}
+
+@end
+
+@interface WPConnectionPrewarmer ()
+// Completion blocks of the warm-ups in flight, by host key
+@property (nonatomic, strong) NSMutableDictionary *pendingCompletions;
+// When each host key was last warmed up
+@property (nonatomic, strong) NSMutableDictionary *warmHosts;
+@end
+
+@implementation WPConnectionPrewarmer
+
++ (WPConnectionPrewarmer *)sharedPrewarmer {
+    static WPConnectionPrewarmer *sharedPrewarmer;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedPrewarmer = [[self alloc] init];
+    });
+    return sharedPrewarmer;
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _warmConnectionLifetime = WPConnectionPrewarmerDefaultWarmConnectionLifetime;
+        _pendingCompletions = [NSMutableDictionary dictionary];
+        _warmHosts = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)warmUpURL:(NSURL *)URL sessionTransport:(WPURLSessionTransport *)transport completion:(void (^)(NSTimeInterval duration, NSError *error))completion {
+    NSString *key = [self keyForURL:URL sessionTransport:transport];
+    if (!key) {
+        if (completion) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(0, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadURL userInfo:nil]);
+            });
+        }
+        return;
+    }
+
+    void (^noop)(NSTimeInterval, NSError *) = ^(NSTimeInterval duration, NSError *error) {};
+    @synchronized(self) {
+        NSDate *warmedAt = self.warmHosts[key];
+        if (warmedAt && -[warmedAt timeIntervalSinceNow] < self.warmConnectionLifetime) {
+            if (completion) {
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    completion(0, nil);
+                });
+            }
+            return;
+        }
+        NSMutableArray *completions = self.pendingCompletions[key];
+        if (completions) {
+            [completions addObject:[completion copy] ?: noop];
+            return;
+        }
+        self.pendingCompletions[key] = [NSMutableArray arrayWithObject:[completion copy] ?: noop];
+    }
+
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:URL];
+    request.HTTPMethod = @"HEAD";
+    request.cachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+    request.timeoutInterval = WPConnectionPrewarmerTimeout;
+
+    // The warm-up is timed from when its operation starts, so the time spent waiting for the scheduler isn't counted
+    WPRequestMetrics *metrics = [[WPRequestMetrics alloc] initWithName:request.HTTPMethod request:request];
+    void (^finish)(NSHTTPURLResponse *, NSError *) = ^(NSHTTPURLResponse *response, NSError *error) {
+        [metrics finishWithError:error];
+        // Any response means the connection is open, even an error status
+        [self finishWarmUpForKey:key duration:metrics.totalTime - metrics.queueWaitTime error:(response ? nil : error)];
+    };
+
+    if (transport) {
+        WPURLSessionTaskOperation *operation = [transport dataTaskOperationWithRequest:request priority:NSURLSessionTaskPriorityLow completionHandler:^(NSHTTPURLResponse *response, NSData *data, NSError *error) {
+            finish(response, error);
+        }];
+        operation.metrics = metrics;
+        [[WPRequestScheduler sharedScheduler] addOperation:operation priority:WPRequestPriorityPrefetch tag:nil owner:self];
+        return;
+    }
+
+    WPConnectionPrewarmerOperation *operation = [[WPConnectionPrewarmerOperation alloc] initWithRequest:request];
+    operation.metrics = metrics;
+    operation.responseSerializer = [AFHTTPResponseSerializer serializer];
+    [operation setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
+        finish(operation.response, nil);
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        finish(operation.response, error);
+    }];
+    [[WPRequestScheduler sharedScheduler] addOperation:operation priority:WPRequestPriorityPrefetch tag:nil owner:self];
+}
+
+- (void)removeWarmHosts {
+    @synchronized(self) {
+        [self.warmHosts removeAllObjects];
+    }
+}
+
+#pragma mark - Private Methods
+
+/**
+ Returns the key identifying a connection: the transport it's opened with, the scheme, host and port.
+ */
+- (NSString *)keyForURL:(NSURL *)URL sessionTransport:(WPURLSessionTransport *)transport {
+    NSString *scheme = [[URL scheme] lowercaseString];
+    NSString *host = [[URL host] lowercaseString];
+    if (![scheme length] || ![host length]) {
+        return nil;
+    }
+    NSNumber *port = [URL port] ?: ([scheme isEqualToString:@"https"] ? @443 : @80);
+    return [NSString stringWithFormat:@"%p %@://%@:%@", transport, scheme, host, port];
+}
+
+- (void)finishWarmUpForKey:(NSString *)key duration:(NSTimeInterval)duration error:(NSError *)error {
+    NSArray *completions = nil;
+    @synchronized(self) {
+        completions = self.pendingCompletions[key];
+        [self.pendingCompletions removeObjectForKey:key];
+        if (!error) {
+            self.warmHosts[key] = [NSDate date];
+        }
+    }
+    dispatch_async(dispatch_get_main_queue(), ^{
+        for (void (^completion)(NSTimeInterval, NSError *) in completions) {
+            completion(duration, error);
+        }
+    });
+}
+
+@end
@@ -2,4 +2,5 @@
 
 @interface WPHTTPAuthenticationAlertController : UIAlertController
 + (void)presentWithChallenge:(NSURLAuthenticationChallenge *)challenge;
++ (void)presentWithChallenge:(NSURLAuthenticationChallenge *)challenge completionHandler:(void (^)(NSURLSessionAuthChallengeDisposition disposition, NSURLCredential *credential))completionHandler;
 @end
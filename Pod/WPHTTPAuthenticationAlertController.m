@@ -7,11 +7,25 @@
 @implementation WPHTTPAuthenticationAlertController
 
 + (void)presentWithChallenge:(NSURLAuthenticationChallenge *)challenge {
+    [self presentWithChallenge:challenge completionHandler:^(NSURLSessionAuthChallengeDisposition disposition, NSURLCredential *credential) {
+        if (disposition == NSURLSessionAuthChallengeUseCredential) {
+            [challenge.sender useCredential:credential forAuthenticationChallenge:challenge];
+        } else {
+            [challenge.sender cancelAuthenticationChallenge:challenge];
+        }
+    }];
+}
+
++ (void)presentWithChallenge:(NSURLAuthenticationChallenge *)challenge completionHandler:(void (^)(NSURLSessionAuthChallengeDisposition disposition, NSURLCredential *credential))completionHandler {
     UIAlertController *controller;
     if ([challenge.protectionSpace.authenticationMethod isEqualToString:NSURLAuthenticationMethodServerTrust]) {
-        controller = [self controllerForServerTrustChallenge:challenge];
+        if ([self isTrustedCertificateForChallenge:challenge]) {
+            completionHandler(NSURLSessionAuthChallengeUseCredential, [NSURLCredential credentialForTrust:challenge.protectionSpace.serverTrust]);
+            return;
+        }
+        controller = [self controllerForServerTrustChallenge:challenge completionHandler:completionHandler];
     } else {
-        controller = [self controllerForUserAuthenticationChallenge:challenge];
+        controller = [self controllerForUserAuthenticationChallenge:challenge completionHandler:completionHandler];
     }
     UIViewController *presentingController = [[[UIApplication sharedApplication] keyWindow] rootViewController];
     if (presentingController.presentedViewController) {
@@ -21,7 +35,7 @@
     [presentingController presentViewController:controller animated:YES completion:nil];
 }
 
-+ (UIAlertController *)controllerForServerTrustChallenge:(NSURLAuthenticationChallenge *)challenge {
++ (UIAlertController *)controllerForServerTrustChallenge:(NSURLAuthenticationChallenge *)challenge completionHandler:(void (^)(NSURLSessionAuthChallengeDisposition disposition, NSURLCredential *credential))completionHandler {
     NSString *title = NSLocalizedString(@"Certificate error", @"Popup title for wrong SSL certificate.");
     NSString *message = [NSString stringWithFormat:NSLocalizedString(@"The certificate for this server is invalid. You might be connecting to a server that is pretending to be “%@” which could put your confidential information at risk.\n\nWould you like to trust the certificate anyway?", @""), challenge.protectionSpace.host];
     UIAlertController *controller =  [UIAlertController alertControllerWithTitle:title
@@ -31,7 +45,7 @@
     UIAlertAction *cancelAction = [UIAlertAction actionWithTitle:NSLocalizedString(@"Cancel", @"Cancel button label")
                                                            style:UIAlertActionStyleDefault
                                                          handler:^(UIAlertAction * _Nonnull action) {
-                                                             [challenge.sender cancelAuthenticationChallenge:challenge];
+                                                             completionHandler(NSURLSessionAuthChallengeCancelAuthenticationChallenge, nil);
                                                          }];
     [controller addAction:cancelAction];
 
@@ -40,14 +54,62 @@
                                                         handler:^(UIAlertAction * _Nonnull action) {
                                                             NSURLCredential *credential = [NSURLCredential credentialForTrust:challenge.protectionSpace.serverTrust];
 
-                                                            [[NSURLCredentialStorage sharedCredentialStorage] setDefaultCredential:credential forProtectionSpace:challenge.protectionSpace];
-                                                            [challenge.sender useCredential:credential forAuthenticationChallenge:challenge];
+                                                            [self trustCertificateForChallenge:challenge];
+                                                            completionHandler(NSURLSessionAuthChallengeUseCredential, credential);
                                                         }];
     [controller addAction:trustAction];
     return controller;
 }
 
-+ (UIAlertController *)controllerForUserAuthenticationChallenge:(NSURLAuthenticationChallenge *)challenge {
+#pragma mark - Trusted Certificates
+
+/**
+ The trust exceptions of the certificates the user chose to trust, by host and port. An exception only matches the certificate it was made for, so a host presenting another certificate is asked about again.
+ */
++ (NSMutableDictionary *)trustExceptions {
+    static NSMutableDictionary *trustExceptions;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        trustExceptions = [NSMutableDictionary dictionary];
+    });
+    return trustExceptions;
+}
+
++ (NSString *)trustExceptionsKeyForProtectionSpace:(NSURLProtectionSpace *)protectionSpace {
+    return [NSString stringWithFormat:@"%@:%ld", [protectionSpace.host lowercaseString], (long)protectionSpace.port];
+}
+
++ (void)trustCertificateForChallenge:(NSURLAuthenticationChallenge *)challenge {
+    CFDataRef exceptions = SecTrustCopyExceptions(challenge.protectionSpace.serverTrust);
+    if (!exceptions) {
+        return;
+    }
+    NSMutableDictionary *trustExceptions = [self trustExceptions];
+    @synchronized(trustExceptions) {
+        trustExceptions[[self trustExceptionsKeyForProtectionSpace:challenge.protectionSpace]] = (__bridge_transfer NSData *)exceptions;
+    }
+}
+
++ (BOOL)isTrustedCertificateForChallenge:(NSURLAuthenticationChallenge *)challenge {
+    NSMutableDictionary *trustExceptions = [self trustExceptions];
+    NSData *exceptions = nil;
+    @synchronized(trustExceptions) {
+        exceptions = trustExceptions[[self trustExceptionsKeyForProtectionSpace:challenge.protectionSpace]];
+    }
+    SecTrustRef serverTrust = challenge.protectionSpace.serverTrust;
+    if (!exceptions || !SecTrustSetExceptions(serverTrust, (__bridge CFDataRef)exceptions)) {
+        return NO;
+    }
+    SecTrustResultType result;
+    if (SecTrustEvaluate(serverTrust, &result) != errSecSuccess) {
+        return NO;
+    }
+    return result == kSecTrustResultProceed || result == kSecTrustResultUnspecified;
+}
+
+#pragma mark - User Authentication
+
++ (UIAlertController *)controllerForUserAuthenticationChallenge:(NSURLAuthenticationChallenge *)challenge completionHandler:(void (^)(NSURLSessionAuthChallengeDisposition disposition, NSURLCredential *credential))completionHandler {
     NSString *title = NSLocalizedString(@"Authentication required", @"Popup title to ask for user credentials.");
     NSString *message = NSLocalizedString(@"Please enter your credentials", @"Popup message to ask for user credentials (fields shown below).");
     UIAlertController *controller =  [UIAlertController alertControllerWithTitle:title
@@ -66,7 +128,7 @@
     UIAlertAction *cancelAction = [UIAlertAction actionWithTitle:NSLocalizedString(@"Cancel", @"Cancel button label")
                                                            style:UIAlertActionStyleDefault
                                                          handler:^(UIAlertAction * _Nonnull action) {
-                                                             [challenge.sender cancelAuthenticationChallenge:challenge];
+                                                             completionHandler(NSURLSessionAuthChallengeCancelAuthenticationChallenge, nil);
                                                          }];
     [controller addAction:cancelAction];
 
@@ -78,7 +140,7 @@
                                                             NSURLCredential *credential = [NSURLCredential credentialWithUser:username password:password persistence:NSURLCredentialPersistencePermanent];
 
                                                             [[NSURLCredentialStorage sharedCredentialStorage] setDefaultCredential:credential forProtectionSpace:challenge.protectionSpace];
-                                                            [challenge.sender useCredential:credential forAuthenticationChallenge:challenge];
+                                                            completionHandler(NSURLSessionAuthChallengeUseCredential, credential);
                                                         }];
     [controller addAction:loginAction];
     return controller;
@@ -1,5 +1,33 @@
 #import <AFNetworking/AFHTTPRequestOperation.h>
 
+@class WPRequestMetrics;
+
 @interface WPHTTPRequestOperation : AFHTTPRequestOperation
 
+/**
+ A block called with each chunk of data as it's received from the connection, before the operation finishes.
+
+ The block is called on the network thread, so it should return quickly.
+ */
+@property (nonatomic, copy) void (^dataReceivedBlock)(NSData *data);
+
+/**
+ The queue the response is decoded on by the `WPXMLRPCClient` which created the operation, before its `completionQueue`. `nil` decodes on the global concurrent queue.
+ */
+@property (nonatomic, strong) NSOperationQueue *decodeQueue;
+
+/**
+ If set, the timing and sizes of the request are recorded here as it goes.
+ */
+@property (nonatomic, strong) WPRequestMetrics *metrics;
+
+/**
+ Hands over to an operation sending the same request again, after this one failed.
+
+ Cancelling this operation cancels the retry too, and the upload progress block is carried over to it.
+
+ @return `NO` if this operation was cancelled, in which case the retry shouldn't be enqueued.
+ */
+- (BOOL)continueWithRetryOperation:(AFHTTPRequestOperation *)retryOperation;
+
 @end
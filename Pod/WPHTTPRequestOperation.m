@@ -2,9 +2,79 @@
 
 #import <AFNetworking/AFNetworking.h>
 #import "WPHTTPAuthenticationAlertController.h"
+#import "WPRequestMetrics.h"
+#import "WPRetryHandover.h"
+
+@interface WPHTTPRequestOperation ()
+@property (nonatomic, strong) WPRetryHandover *retryHandover;
+@end
 
 @implementation WPHTTPRequestOperation
 
+- (instancetype)initWithRequest:(NSURLRequest *)urlRequest
+{
+    self = [super initWithRequest:urlRequest];
+    if (self) {
+        _retryHandover = [[WPRetryHandover alloc] init];
+    }
+    return self;
+}
+
+- (void)start
+{
+    [self.metrics operationDidStart];
+    [super start];
+}
+
+- (void)cancel
+{
+    [self.retryHandover cancel];
+    [super cancel];
+}
+
+- (void)setUploadProgressBlock:(void (^)(NSUInteger bytesWritten, long long totalBytesWritten, long long totalBytesExpectedToWrite))block
+{
+    [self.retryHandover setUploadProgressBlock:block];
+    [super setUploadProgressBlock:block];
+}
+
+- (BOOL)continueWithRetryOperation:(AFHTTPRequestOperation *)retryOperation
+{
+    return [self.retryHandover continueWithRetryOperation:retryOperation];
+}
+
+#pragma mark - NSURLConnectionDataDelegate
+
+- (void)connection:(NSURLConnection *)connection
+   didSendBodyData:(NSInteger)bytesWritten
+ totalBytesWritten:(NSInteger)totalBytesWritten
+totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite
+{
+    [self.metrics didSendBodyBytes:totalBytesWritten];
+    [super connection:connection didSendBodyData:bytesWritten totalBytesWritten:totalBytesWritten totalBytesExpectedToWrite:totalBytesExpectedToWrite];
+}
+
+- (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)response
+{
+    [self.metrics didReceiveResponse:response];
+    [super connection:connection didReceiveResponse:response];
+}
+
+- (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data
+{
+    [self.metrics didReceiveDataOfLength:[data length]];
+    if (self.dataReceivedBlock) {
+        self.dataReceivedBlock(data);
+    }
+    [super connection:connection didReceiveData:data];
+}
+
+- (void)connectionDidFinishLoading:(NSURLConnection *)connection
+{
+    [self.metrics didFinishLoading];
+    [super connectionDidFinishLoading:connection];
+}
+
 #pragma mark - NSURLConnectionDelegate
 
 - (void)connection:(NSURLConnection *)connection willSendRequestForAuthenticationChallenge:(NSURLAuthenticationChallenge *)challenge
@@ -0,0 +1,63 @@
+#import <Foundation/Foundation.h>
+#import <AFNetworking/AFHTTPRequestOperation.h>
+
+/**
+ Returns a copy of a response object where the arrays and dictionaries, and the values they hold, are immutable, so it can be handed to several callers.
+ */
+extern id WPImmutableResponseObject(id responseObject);
+
+/**
+ `WPRequestHandle` is a caller's interest in a request which can be shared with other callers.
+
+ Cancelling a handle only stops its own callbacks: its failure block is called with a `NSURLErrorCancelled` error, and the request goes on for the other callers. The request itself is cancelled once every handle sharing it has been cancelled.
+ */
+@interface WPRequestHandle : NSObject
+
+/**
+ `YES` once the handle has been cancelled.
+ */
+@property (readonly, nonatomic, assign, getter=isCancelled) BOOL cancelled;
+
+/**
+ `YES` if the caller was attached to a request already in flight, instead of sending a new one.
+ */
+@property (readonly, nonatomic, assign, getter=isShared) BOOL shared;
+
+/**
+ Stops the callbacks of the handle, and cancels the request if no other handle shares it.
+ */
+- (void)cancel;
+
+@end
+
+/**
+ `WPInFlightRequests` keeps track of the requests being sent, so identical ones can be shared (single-flight).
+
+ While a request with a key is pending, callers asking for the same key are attached to it instead of sending another one. The caller who sent the request gets the response object, and the callers attached to it an immutable deep copy of its arrays and dictionaries, shared between them, so no caller can change what the others see. Once the request finishes, the next caller for the key sends a new request.
+
+ A group is safe to use from any thread.
+ */
+@interface WPInFlightRequests : NSObject
+
+/**
+ The number of callers attached to a request already in flight since the group was created.
+ */
+@property (readonly, nonatomic, assign) NSUInteger numberOfSharedRequests;
+
+/**
+ Attaches a caller to the pending request with a key, or sends a new one.
+
+ @param key The key identifying the request, e.g. from `+[WPResponseCache keyForEndpoint:method:parameters:]`. Pass `nil` for requests which must never be shared; they're still cancelled through their handle.
+ @param completionQueue The queue `success` and `failure` are called on, `nil` for the main queue. `sender` must call back on the completion queue of the caller sending the request; callers attached to it with another queue are called back on their own.
+ @param success A block object to be executed when the request finishes successfully. This block has no return value and takes two arguments: the request operation, if any, and the response object.
+ @param failure A block object to be executed when the request fails, or when the handle is cancelled. This block has no return value and takes two arguments: the request operation, if any, and the error.
+ @param sender A block object sending the request, only executed when there's no pending request for the key. This block takes the blocks to call when the request finishes, and returns the object to cancel it, e.g. an `NSOperation` or `NSURLSessionTask`, or `nil` if it can't be cancelled.
+ @return A handle to cancel the caller's interest in the request.
+ */
+- (WPRequestHandle *)requestWithKey:(NSString *)key
+                    completionQueue:(dispatch_queue_t)completionQueue
+                            success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                            failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure
+                             sender:(id (^)(void (^success)(AFHTTPRequestOperation *operation, id responseObject), void (^failure)(AFHTTPRequestOperation *operation, NSError *error)))sender;
+
+@end
@@ -0,0 +1,223 @@
+#import "WPInFlightRequests.h"
+
+id WPImmutableResponseObject(id object) {
+    if ([object isKindOfClass:[NSArray class]]) {
+        NSMutableArray *array = [NSMutableArray arrayWithCapacity:[object count]];
+        for (id element in object) {
+            [array addObject:WPImmutableResponseObject(element)];
+        }
+        return [array copy];
+    }
+    if ([object isKindOfClass:[NSDictionary class]]) {
+        NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:[object count]];
+        [object enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+            dictionary[key] = WPImmutableResponseObject(value);
+        }];
+        return [dictionary copy];
+    }
+    if ([object conformsToProtocol:@protocol(NSCopying)]) {
+        return [object copy];
+    }
+    return object;
+}
+
+@interface WPInFlightRequest : NSObject
+@property (nonatomic, copy) NSString *key;
+@property (nonatomic, strong) NSMutableArray *handles;
+@property (nonatomic, strong) id cancellable;
+// The queue the request calls back on
+@property (nonatomic, strong) dispatch_queue_t completionQueue;
+@property (nonatomic, assign) BOOL finished;
+@end
+
+@implementation WPInFlightRequest
+@end
+
+@interface WPInFlightRequests ()
+@property (readwrite, nonatomic, assign) NSUInteger numberOfSharedRequests;
+@property (nonatomic, strong) NSMutableDictionary *requests;
+- (void)cancelHandle:(WPRequestHandle *)handle;
+@end
+
+@interface WPRequestHandle ()
+@property (readwrite, nonatomic, assign, getter=isCancelled) BOOL cancelled;
+@property (readwrite, nonatomic, assign, getter=isShared) BOOL shared;
+// Set once the callbacks have been called, so they're only called once
+@property (nonatomic, assign) BOOL completed;
+@property (nonatomic, strong) WPInFlightRequests *group;
+@property (nonatomic, strong) WPInFlightRequest *request;
+@property (nonatomic, strong) dispatch_queue_t completionQueue;
+@property (nonatomic, copy) void (^success)(AFHTTPRequestOperation *operation, id responseObject);
+@property (nonatomic, copy) void (^failure)(AFHTTPRequestOperation *operation, NSError *error);
+@end
+
+@implementation WPRequestHandle
+
+- (void)cancel {
+    [self.group cancelHandle:self];
+}
+
+@end
+
+@implementation WPInFlightRequests
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _requests = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (WPRequestHandle *)requestWithKey:(NSString *)key
+                    completionQueue:(dispatch_queue_t)completionQueue
+                            success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                            failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure
+                             sender:(id (^)(void (^success)(AFHTTPRequestOperation *operation, id responseObject), void (^failure)(AFHTTPRequestOperation *operation, NSError *error)))sender {
+    WPRequestHandle *handle = [[WPRequestHandle alloc] init];
+    handle.group = self;
+    handle.success = success;
+    handle.failure = failure;
+    handle.completionQueue = completionQueue;
+
+    WPInFlightRequest *request = nil;
+    @synchronized(self) {
+        request = key ? self.requests[key] : nil;
+        if (request) {
+            handle.shared = YES;
+            handle.request = request;
+            [request.handles addObject:handle];
+            self.numberOfSharedRequests++;
+            return handle;
+        }
+        request = [[WPInFlightRequest alloc] init];
+        request.key = key;
+        request.completionQueue = completionQueue;
+        request.handles = [NSMutableArray arrayWithObject:handle];
+        handle.request = request;
+        if (key) {
+            self.requests[key] = request;
+        }
+    }
+
+    id cancellable = sender(^(AFHTTPRequestOperation *operation, id responseObject) {
+        [self finishRequest:request operation:operation responseObject:responseObject error:nil];
+    }, ^(AFHTTPRequestOperation *operation, NSError *error) {
+        [self finishRequest:request operation:operation responseObject:nil error:error];
+    });
+
+    BOOL cancelledWhileSending = NO;
+    @synchronized(self) {
+        if (request.finished) {
+            cancelledWhileSending = [request.handles count] == 0;
+        } else {
+            request.cancellable = cancellable;
+        }
+    }
+    if (cancelledWhileSending && [cancellable respondsToSelector:@selector(cancel)]) {
+        [cancellable cancel];
+    }
+    return handle;
+}
+
+#pragma mark - Private Methods
+
+- (void)finishRequest:(WPInFlightRequest *)request operation:(AFHTTPRequestOperation *)operation responseObject:(id)responseObject error:(NSError *)error {
+    NSArray *handles = nil;
+    @synchronized(self) {
+        if (request.finished) {
+            return;
+        }
+        request.finished = YES;
+        request.cancellable = nil;
+        handles = [request.handles copy];
+        [request.handles removeAllObjects];
+        [self removeRequest:request];
+    }
+
+    // Made before any callback runs, so the sender can't change the response while it's copied
+    id sharedResponseObject = nil;
+    if (!error && [[handles valueForKey:@"shared"] containsObject:@YES]) {
+        sharedResponseObject = WPImmutableResponseObject(responseObject);
+    }
+
+    for (WPRequestHandle *handle in handles) {
+        @synchronized(self) {
+            if (handle.cancelled) {
+                continue;
+            }
+            handle.completed = YES;
+        }
+        id handleResponseObject = handle.shared ? sharedResponseObject : responseObject;
+        void (^success)(AFHTTPRequestOperation *, id) = handle.success;
+        void (^failure)(AFHTTPRequestOperation *, NSError *) = handle.failure;
+        [self releaseHandle:handle];
+        void (^callback)(void) = ^{
+            if (error) {
+                if (failure) {
+                    failure(operation, error);
+                }
+            } else if (success) {
+                success(operation, handleResponseObject);
+            }
+        };
+        // The request already calls back on the queue of the caller who sent it
+        if (handle.completionQueue == request.completionQueue) {
+            callback();
+        } else {
+            dispatch_async(handle.completionQueue ?: dispatch_get_main_queue(), callback);
+        }
+    }
+}
+
+- (void)cancelHandle:(WPRequestHandle *)handle {
+    id cancellable = nil;
+    @synchronized(self) {
+        if (handle.cancelled || handle.completed) {
+            return;
+        }
+        handle.cancelled = YES;
+        WPInFlightRequest *request = handle.request;
+        [request.handles removeObjectIdenticalTo:handle];
+        // The last one out cancels the request
+        if (request && !request.finished && [request.handles count] == 0) {
+            request.finished = YES;
+            cancellable = request.cancellable;
+            request.cancellable = nil;
+            [self removeRequest:request];
+        }
+    }
+    if ([cancellable respondsToSelector:@selector(cancel)]) {
+        [cancellable cancel];
+    }
+
+    void (^failure)(AFHTTPRequestOperation *, NSError *) = handle.failure;
+    [self releaseHandle:handle];
+    if (failure) {
+        dispatch_async(handle.completionQueue ?: dispatch_get_main_queue(), ^{
+            failure(nil, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]);
+        });
+    }
+}
+
+/**
+ Must be called with the lock held.
+ */
+- (void)removeRequest:(WPInFlightRequest *)request {
+    if (request.key && self.requests[request.key] == request) {
+        [self.requests removeObjectForKey:request.key];
+    }
+}
+
+/**
+ Breaks the cycles between a handle, its request and the group once the handle is done.
+ */
+- (void)releaseHandle:(WPRequestHandle *)handle {
+    @synchronized(self) {
+        handle.success = nil;
+        handle.failure = nil;
+        handle.request = nil;
+    }
+}
+
+@end
@@ -0,0 +1,61 @@
+#import <Foundation/Foundation.h>
+
+/**
+ `WPLazyModel` is a struct from an API response whose members are decoded the first time they're read.
+
+ Models created from a XML-RPC response keep a reference to the raw response, shared by every model in it, and the position of each member's value. Members that are never read are never decoded, so a list of posts costs a handful of objects per post instead of one per field. Each member is decoded once, and kept: strings, numbers and booleans are read straight from the response, other values are decoded by `WPXMLRPCDecoder`. Member names are interned, so models with the same members share their keys.
+
+ Models are safe to read from any thread.
+ */
+@interface WPLazyModel : NSObject
+
+/**
+ Creates a model for each struct in the top-level array of a XML-RPC response, without decoding their members.
+
+ @param data The raw XML-RPC response.
+ @param error If the response is a fault, or isn't an array of structs, on return an error describing why.
+ @return An array of models, or `nil` if there's an error.
+ */
++ (NSArray *)modelsWithXMLRPCResponseData:(NSData *)data error:(NSError **)error;
+
+/**
+ Initializes a model with members that are already decoded, e.g. from a JSON response.
+ */
+- (id)initWithDictionary:(NSDictionary *)dictionary;
+
+/**
+ Returns the value of a member, decoding it on first access, or `nil` if there's no such member.
+ */
+- (id)objectForKey:(NSString *)key;
+- (id)objectForKeyedSubscript:(NSString *)key;
+
+/**
+ The names of the members.
+ */
+@property (readonly, nonatomic, strong) NSArray *allKeys;
+
+/**
+ Every member, decoded. It matches the dictionaries returned by the methods returning `NSDictionary` objects.
+ */
+@property (readonly, nonatomic, strong) NSDictionary *dictionaryValue;
+
+///--------------------------
+/// @name Typed Accessors
+///--------------------------
+
+/**
+ Returns the value of the first of the given members present in the model. Subclasses use it to read fields named differently by each API.
+ */
+- (id)objectForFirstKeyIn:(NSArray *)keys;
+
+/**
+ Returns the member as a string, converting numbers.
+ */
+- (NSString *)stringForFirstKeyIn:(NSArray *)keys;
+
+/**
+ Returns the member as a date, parsing ISO 8601 strings.
+ */
+- (NSDate *)dateForFirstKeyIn:(NSArray *)keys;
+
+@end
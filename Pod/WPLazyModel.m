@@ -0,0 +1,539 @@
+#import "WPLazyModel.h"
+
+#import <WPXMLRPC/WPXMLRPC.h>
+
+// Distinct member lists kept for sharing; responses with more shapes than this just don't share them
+static NSUInteger const WPLazyModelMaximumInternedKeyLists = 64;
+
+#pragma mark - Scanning XML-RPC Responses
+
+typedef struct {
+    NSUInteger start; // Offset of the opening `<`
+    NSUInteger end; // Offset right after the closing `>`
+    const char *name;
+    NSUInteger nameLength;
+    BOOL closing;
+    BOOL selfClosing;
+} WPLazyModelTag;
+
+/**
+ Finds the next element tag from `offset`, skipping the XML declaration, comments and CDATA sections.
+ */
+static BOOL WPLazyModelNextTag(const char *bytes, NSUInteger length, NSUInteger *offset, WPLazyModelTag *tag) {
+    NSUInteger i = *offset;
+    while (i < length) {
+        const char *open = memchr(bytes + i, '<', length - i);
+        if (!open || open + 1 >= bytes + length) {
+            return NO;
+        }
+        i = open - bytes;
+        if (bytes[i + 1] == '?' || bytes[i + 1] == '!') {
+            const char *terminator = ">";
+            if (length - i >= 9 && memcmp(bytes + i, "<![CDATA[", 9) == 0) {
+                terminator = "]]>";
+            } else if (length - i >= 4 && memcmp(bytes + i, "<!--", 4) == 0) {
+                terminator = "-->";
+            }
+            const char *found = memmem(bytes + i, length - i, terminator, strlen(terminator));
+            if (!found) {
+                return NO;
+            }
+            i = (found - bytes) + strlen(terminator);
+            continue;
+        }
+
+        BOOL closing = bytes[i + 1] == '/';
+        NSUInteger nameStart = i + (closing ? 2 : 1);
+        NSUInteger nameEnd = nameStart;
+        while (nameEnd < length && !isspace(bytes[nameEnd]) && bytes[nameEnd] != '>' && bytes[nameEnd] != '/') {
+            nameEnd++;
+        }
+        const char *close = memchr(bytes + nameEnd, '>', length - nameEnd);
+        if (!close) {
+            return NO;
+        }
+        tag->start = i;
+        tag->end = (close - bytes) + 1;
+        tag->name = bytes + nameStart;
+        tag->nameLength = nameEnd - nameStart;
+        tag->closing = closing;
+        tag->selfClosing = !closing && *(close - 1) == '/';
+        *offset = tag->end;
+        return YES;
+    }
+    return NO;
+}
+
+static BOOL WPLazyModelTagIs(WPLazyModelTag *tag, const char *name) {
+    size_t nameLength = strlen(name);
+    return tag->nameLength == nameLength && memcmp(tag->name, name, nameLength) == 0;
+}
+
+static NSString *WPLazyModelInternedKey(const char *bytes, NSUInteger length) {
+    static NSMutableSet *internedKeys;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        internedKeys = [NSMutableSet set];
+    });
+    NSString *key = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    if (!key) {
+        return nil;
+    }
+    if ([key rangeOfString:@"&"].location != NSNotFound) {
+        key = [key stringByReplacingOccurrencesOfString:@"&lt;" withString:@"<"];
+        key = [key stringByReplacingOccurrencesOfString:@"&gt;" withString:@">"];
+        key = [key stringByReplacingOccurrencesOfString:@"&quot;" withString:@"\""];
+        key = [key stringByReplacingOccurrencesOfString:@"&apos;" withString:@"'"];
+        key = [key stringByReplacingOccurrencesOfString:@"&amp;" withString:@"&"];
+    }
+    @synchronized(internedKeys) {
+        NSString *internedKey = [internedKeys member:key];
+        if (internedKey) {
+            return internedKey;
+        }
+        [internedKeys addObject:key];
+        return key;
+    }
+}
+
+static NSArray *WPLazyModelInternedKeyList(NSArray *keys) {
+    static NSMutableSet *internedKeyLists;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        internedKeyLists = [NSMutableSet set];
+    });
+    @synchronized(internedKeyLists) {
+        NSArray *internedKeyList = [internedKeyLists member:keys];
+        if (internedKeyList) {
+            return internedKeyList;
+        }
+        NSArray *keyList = [keys copy];
+        if ([internedKeyLists count] < WPLazyModelMaximumInternedKeyLists) {
+            [internedKeyLists addObject:keyList];
+        }
+        return keyList;
+    }
+}
+
+#pragma mark - Decoding Scalars
+
+static void WPLazyModelAppendCodePoint(NSMutableData *data, uint32_t codePoint) {
+    uint8_t bytes[4];
+    NSUInteger length;
+    if (codePoint < 0x80) {
+        bytes[0] = codePoint;
+        length = 1;
+    } else if (codePoint < 0x800) {
+        bytes[0] = 0xC0 | (codePoint >> 6);
+        bytes[1] = 0x80 | (codePoint & 0x3F);
+        length = 2;
+    } else if (codePoint < 0x10000) {
+        bytes[0] = 0xE0 | (codePoint >> 12);
+        bytes[1] = 0x80 | ((codePoint >> 6) & 0x3F);
+        bytes[2] = 0x80 | (codePoint & 0x3F);
+        length = 3;
+    } else {
+        bytes[0] = 0xF0 | (codePoint >> 18);
+        bytes[1] = 0x80 | ((codePoint >> 12) & 0x3F);
+        bytes[2] = 0x80 | ((codePoint >> 6) & 0x3F);
+        bytes[3] = 0x80 | (codePoint & 0x3F);
+        length = 4;
+    }
+    [data appendBytes:bytes length:length];
+}
+
+/**
+ Returns XML character data as a string, replacing the predefined and numeric entities. Returns `nil` for text the XML parser could read differently: unknown entities, carriage returns, which it normalizes, and leading or trailing whitespace.
+ */
+static NSString *WPLazyModelUnescapedText(const char *bytes, NSUInteger length) {
+    if (length > 0 && (isspace(bytes[0]) || isspace(bytes[length - 1]))) {
+        return nil;
+    }
+    if (memchr(bytes, '\r', length)) {
+        return nil;
+    }
+    if (!memchr(bytes, '&', length)) {
+        return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    }
+
+    NSMutableData *unescaped = [NSMutableData dataWithCapacity:length];
+    NSUInteger i = 0;
+    while (i < length) {
+        const char *ampersand = memchr(bytes + i, '&', length - i);
+        NSUInteger textEnd = ampersand ? (NSUInteger)(ampersand - bytes) : length;
+        [unescaped appendBytes:bytes + i length:textEnd - i];
+        if (!ampersand) {
+            break;
+        }
+        const char *semicolon = memchr(ampersand, ';', MIN(length - textEnd, 12));
+        if (!semicolon) {
+            return nil;
+        }
+        const char *entity = ampersand + 1;
+        NSUInteger entityLength = semicolon - entity;
+        if (entityLength == 2 && memcmp(entity, "lt", 2) == 0) {
+            [unescaped appendBytes:"<" length:1];
+        } else if (entityLength == 2 && memcmp(entity, "gt", 2) == 0) {
+            [unescaped appendBytes:">" length:1];
+        } else if (entityLength == 3 && memcmp(entity, "amp", 3) == 0) {
+            [unescaped appendBytes:"&" length:1];
+        } else if (entityLength == 4 && memcmp(entity, "quot", 4) == 0) {
+            [unescaped appendBytes:"\"" length:1];
+        } else if (entityLength == 4 && memcmp(entity, "apos", 4) == 0) {
+            [unescaped appendBytes:"'" length:1];
+        } else if (entityLength > 1 && entity[0] == '#') {
+            BOOL hexadecimal = entity[1] == 'x';
+            NSUInteger digitsStart = hexadecimal ? 2 : 1;
+            if (entityLength <= digitsStart) {
+                return nil;
+            }
+            uint32_t codePoint = 0;
+            for (NSUInteger j = digitsStart; j < entityLength; j++) {
+                char c = entity[j];
+                if (hexadecimal && isxdigit(c)) {
+                    codePoint = codePoint * 16 + (isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10));
+                } else if (!hexadecimal && isdigit(c)) {
+                    codePoint = codePoint * 10 + (c - '0');
+                } else {
+                    return nil;
+                }
+                if (codePoint > 0x10FFFF) {
+                    return nil;
+                }
+            }
+            if (codePoint == 0 || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+                return nil;
+            }
+            WPLazyModelAppendCodePoint(unescaped, codePoint);
+        } else {
+            return nil;
+        }
+        i = (semicolon - bytes) + 1;
+    }
+    return [[NSString alloc] initWithData:unescaped encoding:NSUTF8StringEncoding];
+}
+
+/**
+ Parses a whole integer or double, without the whitespace or trailing characters `strtoll` and `strtod` would accept.
+ */
+static NSNumber *WPLazyModelNumber(const char *bytes, NSUInteger length, BOOL integer) {
+    char text[64];
+    if (length == 0 || length >= sizeof(text) || isspace(bytes[0])) {
+        return nil;
+    }
+    memcpy(text, bytes, length);
+    text[length] = '\0';
+    char *end = NULL;
+    errno = 0;
+    NSNumber *number = integer ? @(strtoll(text, &end, 10)) : @(strtod(text, &end));
+    if (errno != 0 || end != text + length) {
+        return nil;
+    }
+    return number;
+}
+
+/**
+ Decodes a string, integer, boolean or double value straight from the response. Returns `nil` for any other value, which is left to `WPXMLRPCDecoder`.
+ */
+static id WPLazyModelDecodeScalar(const char *bytes, NSUInteger length) {
+    if (!memchr(bytes, '<', length)) {
+        // A value without a type is a string
+        return WPLazyModelUnescapedText(bytes, length);
+    }
+
+    NSUInteger start = 0;
+    NSUInteger end = length;
+    while (start < end && isspace(bytes[start])) {
+        start++;
+    }
+    while (end > start && isspace(bytes[end - 1])) {
+        end--;
+    }
+    NSUInteger offset = start;
+    WPLazyModelTag open;
+    if (!WPLazyModelNextTag(bytes, end, &offset, &open) || open.start != start || open.closing) {
+        return nil;
+    }
+    if (open.end != (NSUInteger)(open.name - bytes) + open.nameLength + (open.selfClosing ? 2 : 1)) {
+        // Attributes, or whitespace in the tag
+        return nil;
+    }
+    if (open.selfClosing) {
+        return open.end == end && WPLazyModelTagIs(&open, "string") ? @"" : nil;
+    }
+
+    const char *textEnd = memchr(bytes + open.end, '<', end - open.end);
+    if (!textEnd) {
+        return nil;
+    }
+    WPLazyModelTag close;
+    if (!WPLazyModelNextTag(bytes, end, &offset, &close) || !close.closing || close.start != (NSUInteger)(textEnd - bytes) || close.end != end
+        || close.nameLength != open.nameLength || memcmp(close.name, open.name, open.nameLength) != 0) {
+        return nil;
+    }
+
+    const char *text = bytes + open.end;
+    NSUInteger textLength = close.start - open.end;
+    if (WPLazyModelTagIs(&open, "string")) {
+        return WPLazyModelUnescapedText(text, textLength);
+    }
+    if (WPLazyModelTagIs(&open, "int") || WPLazyModelTagIs(&open, "i4") || WPLazyModelTagIs(&open, "i8")) {
+        return WPLazyModelNumber(text, textLength, YES);
+    }
+    if (WPLazyModelTagIs(&open, "double")) {
+        return WPLazyModelNumber(text, textLength, NO);
+    }
+    if (WPLazyModelTagIs(&open, "boolean") && textLength == 1 && (text[0] == '0' || text[0] == '1')) {
+        return @(text[0] == '1');
+    }
+    return nil;
+}
+
+static NSError *WPLazyModelInvalidResponseError() {
+    return [NSError errorWithDomain:NSURLErrorDomain
+                               code:NSURLErrorCannotParseResponse
+                           userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"The server returned an empty or invalid response", @"")}];
+}
+
+#pragma mark - WPLazyModel
+
+@interface WPLazyModel ()
+@property (nonatomic, strong) NSData *buffer;
+@property (readwrite, nonatomic, strong) NSArray *allKeys;
+// The range of each member's value in `buffer`, in the order of `allKeys`
+@property (nonatomic, strong) NSData *valueRanges;
+@property (nonatomic, strong) NSMutableDictionary *decodedValues;
+@end
+
+@implementation WPLazyModel
+
++ (NSArray *)modelsWithXMLRPCResponseData:(NSData *)data error:(NSError **)error {
+    const char *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger offset = 0;
+    WPLazyModelTag tag;
+
+    // Some sites print notices before the response, so anything before `methodResponse` is skipped.
+    // Then the first element with content tells whether it's a list, a fault or something else.
+    BOOL inResponse = NO;
+    BOOL foundArray = NO;
+    while (WPLazyModelNextTag(bytes, length, &offset, &tag)) {
+        if (!inResponse) {
+            inResponse = !tag.closing && WPLazyModelTagIs(&tag, "methodResponse");
+            continue;
+        }
+        if (tag.closing || WPLazyModelTagIs(&tag, "params") || WPLazyModelTagIs(&tag, "param") || WPLazyModelTagIs(&tag, "value") || WPLazyModelTagIs(&tag, "array")) {
+            continue;
+        }
+        foundArray = WPLazyModelTagIs(&tag, "data") && !tag.selfClosing;
+        if (WPLazyModelTagIs(&tag, "data") && tag.selfClosing) {
+            return @[];
+        }
+        break;
+    }
+    if (!foundArray) {
+        WPXMLRPCDecoder *decoder = [[WPXMLRPCDecoder alloc] initWithData:data];
+        if (error) {
+            *error = [decoder isFault] ? [decoder error] : WPLazyModelInvalidResponseError();
+        }
+        return nil;
+    }
+
+    NSMutableArray *models = [NSMutableArray array];
+    NSMutableArray *keys = [NSMutableArray array];
+    NSMutableData *valueRanges = [NSMutableData data];
+    BOOL inStruct = NO;
+    BOOL finished = NO;
+    while (!finished && WPLazyModelNextTag(bytes, length, &offset, &tag)) {
+        if (!inStruct) {
+            if (tag.closing && WPLazyModelTagIs(&tag, "data")) {
+                finished = YES;
+            } else if (!tag.closing && WPLazyModelTagIs(&tag, "struct")) {
+                inStruct = YES;
+                [keys removeAllObjects];
+                [valueRanges setLength:0];
+            } else if (!WPLazyModelTagIs(&tag, "value")) {
+                // Elements of the list must be structs
+                break;
+            }
+            continue;
+        }
+
+        if (tag.closing && WPLazyModelTagIs(&tag, "struct")) {
+            inStruct = NO;
+            WPLazyModel *model = [[self alloc] init];
+            model.buffer = data;
+            model.allKeys = WPLazyModelInternedKeyList(keys);
+            model.valueRanges = [valueRanges copy];
+            [models addObject:model];
+            continue;
+        }
+        if (tag.closing || !WPLazyModelTagIs(&tag, "name")) {
+            continue;
+        }
+
+        NSUInteger nameStart = tag.end;
+        if (!WPLazyModelNextTag(bytes, length, &offset, &tag) || !tag.closing || !WPLazyModelTagIs(&tag, "name")) {
+            break;
+        }
+        NSString *key = WPLazyModelInternedKey(bytes + nameStart, tag.start - nameStart);
+        if (!WPLazyModelNextTag(bytes, length, &offset, &tag) || tag.closing || !WPLazyModelTagIs(&tag, "value")) {
+            break;
+        }
+        NSRange valueRange = NSMakeRange(tag.end, 0);
+        if (!tag.selfClosing) {
+            // Skip nested values, only the end of this one matters
+            NSUInteger depth = 1;
+            while (depth > 0 && WPLazyModelNextTag(bytes, length, &offset, &tag)) {
+                if (WPLazyModelTagIs(&tag, "value") && !tag.selfClosing) {
+                    depth += tag.closing ? -1 : 1;
+                }
+            }
+            if (depth > 0) {
+                break;
+            }
+            valueRange.length = tag.start - valueRange.location;
+        }
+        if (key) {
+            [keys addObject:key];
+            [valueRanges appendBytes:&valueRange length:sizeof(valueRange)];
+        }
+    }
+
+    if (!finished) {
+        if (error) {
+            *error = WPLazyModelInvalidResponseError();
+        }
+        return nil;
+    }
+    return models;
+}
+
+- (id)initWithDictionary:(NSDictionary *)dictionary {
+    self = [super init];
+    if (self) {
+        _allKeys = [dictionary allKeys];
+        _decodedValues = [dictionary mutableCopy];
+    }
+    return self;
+}
+
+- (id)objectForKey:(NSString *)key {
+    @synchronized(self) {
+        id decodedValue = self.decodedValues[key];
+        if (decodedValue) {
+            return decodedValue == [NSNull null] && self.buffer ? nil : decodedValue;
+        }
+    }
+    if (!self.buffer) {
+        return nil;
+    }
+
+    NSUInteger index = NSNotFound;
+    NSUInteger count = [self.allKeys count];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSString *candidate = self.allKeys[i];
+        if (candidate == key || [candidate isEqualToString:key]) {
+            index = i;
+            break;
+        }
+    }
+    if (index == NSNotFound) {
+        return nil;
+    }
+
+    NSRange valueRange = ((const NSRange *)[self.valueRanges bytes])[index];
+    id value = [self decodeValueInRange:valueRange];
+    @synchronized(self) {
+        if (!self.decodedValues) {
+            self.decodedValues = [NSMutableDictionary dictionary];
+        }
+        self.decodedValues[key] = value ?: [NSNull null];
+    }
+    return value;
+}
+
+- (id)objectForKeyedSubscript:(NSString *)key {
+    return [self objectForKey:key];
+}
+
+- (NSDictionary *)dictionaryValue {
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:[self.allKeys count]];
+    for (NSString *key in self.allKeys) {
+        [dictionary setValue:[self objectForKey:key] forKey:key];
+    }
+    return dictionary;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p; keys = %@>", NSStringFromClass([self class]), self, [self.allKeys componentsJoinedByString:@", "]];
+}
+
+#pragma mark - Typed Accessors
+
+- (id)objectForFirstKeyIn:(NSArray *)keys {
+    for (NSString *key in keys) {
+        id value = [self objectForKey:key];
+        if (value && value != [NSNull null]) {
+            return value;
+        }
+    }
+    return nil;
+}
+
+- (NSString *)stringForFirstKeyIn:(NSArray *)keys {
+    id value = [self objectForFirstKeyIn:keys];
+    if ([value isKindOfClass:[NSNumber class]]) {
+        return [value stringValue];
+    }
+    return [value isKindOfClass:[NSString class]] ? value : nil;
+}
+
+- (NSDate *)dateForFirstKeyIn:(NSArray *)keys {
+    id value = [self objectForFirstKeyIn:keys];
+    if ([value isKindOfClass:[NSDate class]]) {
+        return value;
+    }
+    if (![value isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+    static NSDateFormatter *formatter;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        formatter = [[NSDateFormatter alloc] init];
+        formatter.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+        formatter.dateFormat = @"yyyy-MM-dd'T'HH:mm:ssZZZZZ";
+    });
+    @synchronized(formatter) {
+        return [formatter dateFromString:value];
+    }
+}
+
+#pragma mark - Private Methods
+
+/**
+ Decodes a single value. Strings, numbers and booleans are read straight from the buffer, other values are decoded by wrapping them in a response of their own.
+ */
+- (id)decodeValueInRange:(NSRange)range {
+    if (range.length == 0) {
+        return @"";
+    }
+    id scalar = WPLazyModelDecodeScalar((const char *)[self.buffer bytes] + range.location, range.length);
+    if (scalar) {
+        return scalar;
+    }
+    static NSData *prefix, *suffix;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        prefix = [@"<?xml version=\"1.0\"?><methodResponse><params><param><value>" dataUsingEncoding:NSUTF8StringEncoding];
+        suffix = [@"</value></param></params></methodResponse>" dataUsingEncoding:NSUTF8StringEncoding];
+    });
+    NSMutableData *document = [NSMutableData dataWithCapacity:[prefix length] + range.length + [suffix length]];
+    [document appendData:prefix];
+    [document appendBytes:(const char *)[self.buffer bytes] + range.location length:range.length];
+    [document appendData:suffix];
+    WPXMLRPCDecoder *decoder = [[WPXMLRPCDecoder alloc] initWithData:document];
+    return [decoder object];
+}
+
+@end
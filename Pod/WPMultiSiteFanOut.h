@@ -0,0 +1,82 @@
+#import <Foundation/Foundation.h>
+#import "WordPressBaseApi.h"
+
+/**
+ A block running an operation for one site. It must call `completion` exactly once, with the result of the operation or an error.
+ */
+typedef void (^WPMultiSiteOperation)(id<WordPressBaseApi> api, void (^completion)(id result, NSError *error));
+
+/**
+ `WPMultiSiteFanOut` runs the same operation for many sites at once, e.g. to refresh every blog of an account.
+
+ Sites are run in parallel, so refreshing all of them takes about as long as the slowest one. The number of sites running at the same time is bounded across all the fan-outs, see `maximumConcurrentSites`; the connections to each host are still limited by the shared `WPRequestScheduler`.
+
+ Each site's result is reported as soon as it's known, then a final completion reports all of them. A site failing doesn't stop the others.
+ */
+@interface WPMultiSiteFanOut : NSObject
+
+/**
+ The maximum number of sites running at the same time, across all the fan-outs. Defaults to `6`.
+
+ A WordPress.com batch request counts as a single site.
+ */
++ (NSUInteger)maximumConcurrentSites;
+
+/**
+ Sets the maximum number of sites running at the same time. Sites already running are not affected.
+ */
++ (void)setMaximumConcurrentSites:(NSUInteger)maximumConcurrentSites;
+
+/**
+ Initializes a fan-out for some sites.
+
+ @param apis The API clients of the sites, as `WordPressXMLRPCApi` or `WordPressRestApi` objects. Results are reported by their index in this array.
+ */
+- (id)initWithApis:(NSArray *)apis;
+
+/**
+ The API clients of the sites.
+ */
+@property (readonly, nonatomic, copy) NSArray *apis;
+
+/**
+ The queue the site handler and completion blocks are called on. Defaults to `nil`, which uses the main queue. It must be a serial queue, so the completion block is called after every site has been reported.
+ */
+@property (nonatomic, strong) dispatch_queue_t completionQueue;
+
+///-----------------------------
+/// @name Running Operations
+///-----------------------------
+
+/**
+ Runs an operation for every site.
+
+ @param operation A block object running the operation for one site, e.g. calling `getBlogOptionsWithSuccess:failure:` on a `WordPressXMLRPCApi`. It's called on the main queue.
+ @param siteHandler A block object to execute as each site finishes. This block has no return value and takes three arguments: the index of the site, its result, and an error if it failed. Can be `nil`.
+ @param completion A block object to execute once every site has finished. This block has no return value and takes two arguments: an array with the result of each site, with `NSNull` for the sites which failed, and a dictionary from site index (as `NSNumber`) to the error of each site which failed.
+ */
+- (void)runOperation:(WPMultiSiteOperation)operation
+         siteHandler:(void (^)(NSUInteger siteIndex, id result, NSError *error))siteHandler
+          completion:(void (^)(NSArray *results, NSDictionary *errors))completion;
+
+/**
+ Gets the recent posts of every site.
+
+ WordPress.com sites sharing a token are fetched with batch requests instead of one request per site. The result of each site is an array with its latest posts.
+
+ @param count Number of recent posts to get for each site
+ @param siteHandler A block object to execute as each site finishes. This block has no return value and takes three arguments: the index of the site, its posts, and an error if it failed. Can be `nil`.
+ @param completion A block object to execute once every site has finished. This block has no return value and takes two arguments: an array with the posts of each site, with `NSNull` for the sites which failed, and a dictionary from site index (as `NSNumber`) to the error of each site which failed.
+ */
+- (void)getPosts:(NSUInteger)count
+     siteHandler:(void (^)(NSUInteger siteIndex, id posts, NSError *error))siteHandler
+      completion:(void (^)(NSArray *results, NSDictionary *errors))completion;
+
+/**
+ Stops every operation of the fan-out. Sites which haven't finished are reported with a `NSURLErrorCancelled` error, and sites which haven't started are never run.
+
+ Requests already sent are not cancelled, as the APIs give no way to cancel a single call, but their results are ignored. Their sites keep counting against `maximumConcurrentSites` until the requests finish, so other fan-outs don't start more requests than the limit allows.
+ */
+- (void)cancel;
+
+@end
@@ -0,0 +1,317 @@
+#import "WPMultiSiteFanOut.h"
+
+#import "WordPressRestApi.h"
+
+static NSUInteger const WPMultiSiteFanOutDefaultMaximumConcurrentSites = 6;
+// Keeps each batch request, and its response, reasonably small
+static NSUInteger const WPMultiSiteFanOutMaximumBatchSize = 20;
+
+static NSUInteger WPMultiSiteFanOutMaximumConcurrentSites = WPMultiSiteFanOutDefaultMaximumConcurrentSites;
+// The sites running and waiting across all the fan-outs, only used on the main queue
+static NSUInteger WPMultiSiteFanOutRunningSites = 0;
+static NSMutableArray *WPMultiSiteFanOutWaitingSites = nil;
+
+/**
+ A unit of work taking one slot: a single site, or a batch request for several sites. `start` must report each of its sites once.
+ */
+@interface WPMultiSiteFanOutTask : NSObject
+@property (nonatomic, strong) NSIndexSet *siteIndexes;
+@property (nonatomic, copy) void (^start)(void (^report)(NSUInteger siteIndex, id result, NSError *error));
+@end
+
+@implementation WPMultiSiteFanOutTask
+@end
+
+/**
+ The state of one call to the fan-out, guarded by synchronizing on it.
+ */
+@interface WPMultiSiteFanOutRun : NSObject
+@property (nonatomic, assign) NSUInteger siteCount;
+@property (nonatomic, strong) NSMutableArray *results;
+@property (nonatomic, strong) NSMutableDictionary *errors;
+@property (nonatomic, strong) NSMutableIndexSet *finishedSites;
+@property (nonatomic, assign, getter=isCancelled) BOOL cancelled;
+@property (nonatomic, strong) dispatch_queue_t completionQueue;
+@property (nonatomic, copy) void (^siteHandler)(NSUInteger siteIndex, id result, NSError *error);
+@property (nonatomic, copy) void (^completion)(NSArray *results, NSDictionary *errors);
+@end
+
+@implementation WPMultiSiteFanOutRun
+@end
+
+@interface WPMultiSiteFanOut ()
+@property (readwrite, nonatomic, copy) NSArray *apis;
+@property (nonatomic, strong) NSMutableArray *runs;
+@end
+
+@implementation WPMultiSiteFanOut
+
++ (NSUInteger)maximumConcurrentSites {
+    return WPMultiSiteFanOutMaximumConcurrentSites;
+}
+
++ (void)setMaximumConcurrentSites:(NSUInteger)maximumConcurrentSites {
+    WPMultiSiteFanOutMaximumConcurrentSites = MAX(maximumConcurrentSites, 1);
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self startWaitingSites];
+    });
+}
+
+- (id)initWithApis:(NSArray *)apis {
+    self = [super init];
+    if (self) {
+        _apis = [apis copy] ?: @[];
+        _runs = [NSMutableArray array];
+    }
+    return self;
+}
+
+#pragma mark - Running Operations
+
+- (void)runOperation:(WPMultiSiteOperation)operation siteHandler:(void (^)(NSUInteger siteIndex, id result, NSError *error))siteHandler completion:(void (^)(NSArray *results, NSDictionary *errors))completion {
+    NSMutableArray *tasks = [NSMutableArray arrayWithCapacity:[self.apis count]];
+    for (NSUInteger siteIndex = 0; siteIndex < [self.apis count]; siteIndex++) {
+        [tasks addObject:[self taskForSite:siteIndex operation:operation]];
+    }
+    [self runTasks:tasks siteHandler:siteHandler completion:completion];
+}
+
+- (void)getPosts:(NSUInteger)count siteHandler:(void (^)(NSUInteger siteIndex, id posts, NSError *error))siteHandler completion:(void (^)(NSArray *results, NSDictionary *errors))completion {
+    WPMultiSiteOperation operation = ^(id<WordPressBaseApi> api, void (^siteCompletion)(id result, NSError *error)) {
+        [api getPosts:count success:^(NSArray *posts) {
+            siteCompletion(posts, nil);
+        } failure:^(NSError *error) {
+            siteCompletion(nil, error);
+        }];
+    };
+
+    // WordPress.com sites are grouped by token, so they can share batch requests
+    NSMutableArray *tasks = [NSMutableArray array];
+    NSMutableDictionary *sitesByToken = [NSMutableDictionary dictionary];
+    NSMutableArray *tokens = [NSMutableArray array];
+    [self.apis enumerateObjectsUsingBlock:^(id<WordPressBaseApi> api, NSUInteger idx, BOOL *stop) {
+        NSString *token = [api isKindOfClass:[WordPressRestApi class]] && [(WordPressRestApi *)api siteId] ? [(WordPressRestApi *)api authToken] : nil;
+        if (!token) {
+            [tasks addObject:[self taskForSite:idx operation:operation]];
+            return;
+        }
+        if (!sitesByToken[token]) {
+            sitesByToken[token] = [NSMutableIndexSet indexSet];
+            [tokens addObject:token];
+        }
+        [sitesByToken[token] addIndex:idx];
+    }];
+
+    for (NSString *token in tokens) {
+        NSIndexSet *siteIndexes = sitesByToken[token];
+        if ([siteIndexes count] == 1) {
+            [tasks addObject:[self taskForSite:[siteIndexes firstIndex] operation:operation]];
+            continue;
+        }
+        __block NSMutableIndexSet *batch = [NSMutableIndexSet indexSet];
+        [siteIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+            [batch addIndex:idx];
+            if ([batch count] == WPMultiSiteFanOutMaximumBatchSize) {
+                [tasks addObject:[self taskForPostsOfSites:batch count:count]];
+                batch = [NSMutableIndexSet indexSet];
+            }
+        }];
+        if ([batch count]) {
+            [tasks addObject:[self taskForPostsOfSites:batch count:count]];
+        }
+    }
+    [self runTasks:tasks siteHandler:siteHandler completion:completion];
+}
+
+- (void)cancel {
+    NSArray *runs = nil;
+    @synchronized(self) {
+        runs = [self.runs copy];
+    }
+    for (WPMultiSiteFanOutRun *run in runs) {
+        NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+        NSMutableIndexSet *unfinishedSites = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, run.siteCount)];
+        @synchronized(run) {
+            [unfinishedSites removeIndexes:run.finishedSites];
+        }
+        [unfinishedSites enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+            [self run:run didFinishSite:idx result:nil error:error];
+        }];
+        @synchronized(run) {
+            run.cancelled = YES;
+        }
+    }
+}
+
+#pragma mark - Private Methods
+
+- (WPMultiSiteFanOutTask *)taskForSite:(NSUInteger)siteIndex operation:(WPMultiSiteOperation)operation {
+    id<WordPressBaseApi> api = self.apis[siteIndex];
+    WPMultiSiteFanOutTask *task = [[WPMultiSiteFanOutTask alloc] init];
+    task.siteIndexes = [NSIndexSet indexSetWithIndex:siteIndex];
+    task.start = ^(void (^report)(NSUInteger siteIndex, id result, NSError *error)) {
+        operation(api, ^(id result, NSError *error) {
+            report(siteIndex, result, error);
+        });
+    };
+    return task;
+}
+
+/**
+ Returns a task getting the posts of WordPress.com sites sharing a token with a single batch request.
+ */
+- (WPMultiSiteFanOutTask *)taskForPostsOfSites:(NSIndexSet *)siteIndexes count:(NSUInteger)count {
+    WordPressRestApi *api = self.apis[[siteIndexes firstIndex]];
+    NSArray *siteApis = [self.apis objectsAtIndexes:siteIndexes];
+    NSArray *siteIds = [siteApis valueForKey:@"siteId"];
+    WPMultiSiteFanOutTask *task = [[WPMultiSiteFanOutTask alloc] init];
+    task.siteIndexes = siteIndexes;
+    task.start = ^(void (^report)(NSUInteger siteIndex, id result, NSError *error)) {
+        [api getPosts:count forSites:siteIds success:^(NSDictionary *postsBySite, NSDictionary *errorsBySite) {
+            __block NSUInteger position = 0;
+            [siteIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+                NSString *siteId = siteIds[position++];
+                NSArray *posts = postsBySite[siteId];
+                NSError *error = posts ? nil : errorsBySite[siteId];
+                report(idx, posts, error);
+            }];
+        } failure:^(NSError *error) {
+            [siteIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+                report(idx, nil, error);
+            }];
+        }];
+    };
+    return task;
+}
+
+- (void)runTasks:(NSArray *)tasks siteHandler:(void (^)(NSUInteger siteIndex, id result, NSError *error))siteHandler completion:(void (^)(NSArray *results, NSDictionary *errors))completion {
+    WPMultiSiteFanOutRun *run = [[WPMultiSiteFanOutRun alloc] init];
+    run.siteCount = [self.apis count];
+    run.results = [NSMutableArray arrayWithCapacity:run.siteCount];
+    for (NSUInteger i = 0; i < run.siteCount; i++) {
+        [run.results addObject:[NSNull null]];
+    }
+    run.errors = [NSMutableDictionary dictionary];
+    run.finishedSites = [NSMutableIndexSet indexSet];
+    run.completionQueue = self.completionQueue ?: dispatch_get_main_queue();
+    run.siteHandler = siteHandler;
+    run.completion = completion;
+
+    if (run.siteCount == 0) {
+        dispatch_async(run.completionQueue, ^{
+            if (completion) {
+                completion(@[], @{});
+            }
+        });
+        return;
+    }
+    @synchronized(self) {
+        [self.runs addObject:run];
+    }
+
+    for (WPMultiSiteFanOutTask *task in tasks) {
+        [[self class] enqueueSite:^{
+            BOOL cancelled = NO;
+            @synchronized(run) {
+                cancelled = run.cancelled;
+            }
+            if (cancelled) {
+                [[self class] siteDidFinish];
+                return;
+            }
+            NSMutableIndexSet *pendingSites = [task.siteIndexes mutableCopy];
+            task.start(^(NSUInteger siteIndex, id result, NSError *error) {
+                BOOL taskFinished = NO;
+                @synchronized(pendingSites) {
+                    if (![pendingSites containsIndex:siteIndex]) {
+                        return;
+                    }
+                    [pendingSites removeIndex:siteIndex];
+                    taskFinished = [pendingSites count] == 0;
+                }
+                [self run:run didFinishSite:siteIndex result:result error:error];
+                if (taskFinished) {
+                    [[self class] siteDidFinish];
+                }
+            });
+        }];
+    }
+}
+
+/**
+ Records the outcome of a site and reports it. Sites are only reported once, and nothing is reported once the run is cancelled.
+ */
+- (void)run:(WPMultiSiteFanOutRun *)run didFinishSite:(NSUInteger)siteIndex result:(id)result error:(NSError *)error {
+    NSArray *results = nil;
+    NSDictionary *errors = nil;
+    @synchronized(run) {
+        if (run.cancelled || [run.finishedSites containsIndex:siteIndex]) {
+            return;
+        }
+        if (!error && !result) {
+            error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:nil];
+        }
+        [run.finishedSites addIndex:siteIndex];
+        if (error) {
+            run.errors[@(siteIndex)] = error;
+        } else {
+            run.results[siteIndex] = result;
+        }
+        if ([run.finishedSites count] == run.siteCount) {
+            results = [run.results copy];
+            errors = [run.errors copy];
+        }
+    }
+
+    void (^siteHandler)(NSUInteger, id, NSError *) = run.siteHandler;
+    void (^completion)(NSArray *, NSDictionary *) = run.completion;
+    if (results) {
+        @synchronized(self) {
+            [self.runs removeObjectIdenticalTo:run];
+        }
+    }
+    dispatch_async(run.completionQueue, ^{
+        if (siteHandler) {
+            siteHandler(siteIndex, result, error);
+        }
+        if (results && completion) {
+            completion(results, errors);
+        }
+    });
+}
+
+#pragma mark - Concurrency Limit
+
+/**
+ Runs a block on the main queue once a slot is free. It must call `siteDidFinish` when it's done.
+ */
++ (void)enqueueSite:(void (^)(void))block {
+    dispatch_async(dispatch_get_main_queue(), ^{
+        if (!WPMultiSiteFanOutWaitingSites) {
+            WPMultiSiteFanOutWaitingSites = [NSMutableArray array];
+        }
+        [WPMultiSiteFanOutWaitingSites addObject:[block copy]];
+        [self startWaitingSites];
+    });
+}
+
++ (void)siteDidFinish {
+    dispatch_async(dispatch_get_main_queue(), ^{
+        WPMultiSiteFanOutRunningSites--;
+        [self startWaitingSites];
+    });
+}
+
+/**
+ Must be called on the main queue.
+ */
++ (void)startWaitingSites {
+    while (WPMultiSiteFanOutRunningSites < WPMultiSiteFanOutMaximumConcurrentSites && [WPMultiSiteFanOutWaitingSites count]) {
+        void (^block)(void) = [WPMultiSiteFanOutWaitingSites firstObject];
+        [WPMultiSiteFanOutWaitingSites removeObjectAtIndex:0];
+        WPMultiSiteFanOutRunningSites++;
+        block();
+    }
+}
+
+@end
@@ -0,0 +1,50 @@
+#import "WPLazyModel.h"
+
+/**
+ `WPPostModel` is a post returned by `getPostModels:success:failure:`.
+
+ Each API names post fields differently, so the accessors read whichever name the response uses. Other fields can be read with `objectForKey:`.
+ */
+@interface WPPostModel : WPLazyModel
+
+/**
+ The post ID.
+ */
+@property (readonly, nonatomic, strong) NSString *postId;
+
+/**
+ The post title.
+ */
+@property (readonly, nonatomic, strong) NSString *title;
+
+/**
+ The post content/body, as HTML.
+ */
+@property (readonly, nonatomic, strong) NSString *content;
+
+/**
+ The post excerpt.
+ */
+@property (readonly, nonatomic, strong) NSString *excerpt;
+
+/**
+ The post status, e.g. `publish` or `draft`.
+ */
+@property (readonly, nonatomic, strong) NSString *status;
+
+/**
+ The date the post was published, or scheduled for.
+ */
+@property (readonly, nonatomic, strong) NSDate *date;
+
+/**
+ The date the post was last modified.
+ */
+@property (readonly, nonatomic, strong) NSDate *modifiedDate;
+
+/**
+ The permalink of the post.
+ */
+@property (readonly, nonatomic, strong) NSURL *link;
+
+@end
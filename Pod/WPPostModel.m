@@ -0,0 +1,38 @@
+#import "WPPostModel.h"
+
+@implementation WPPostModel
+
+- (NSString *)postId {
+    return [self stringForFirstKeyIn:@[@"postid", @"post_id", @"ID"]];
+}
+
+- (NSString *)title {
+    return [self stringForFirstKeyIn:@[@"title", @"post_title"]];
+}
+
+- (NSString *)content {
+    return [self stringForFirstKeyIn:@[@"description", @"post_content", @"content"]];
+}
+
+- (NSString *)excerpt {
+    return [self stringForFirstKeyIn:@[@"mt_excerpt", @"post_excerpt", @"excerpt"]];
+}
+
+- (NSString *)status {
+    return [self stringForFirstKeyIn:@[@"post_status", @"status"]];
+}
+
+- (NSDate *)date {
+    return [self dateForFirstKeyIn:@[@"date_created_gmt", @"dateCreated", @"post_date_gmt", @"date"]];
+}
+
+- (NSDate *)modifiedDate {
+    return [self dateForFirstKeyIn:@[@"date_modified_gmt", @"post_modified_gmt", @"modified"]];
+}
+
+- (NSURL *)link {
+    NSString *link = [self stringForFirstKeyIn:@[@"permaLink", @"link", @"URL"]];
+    return link ? [NSURL URLWithString:link] : nil;
+}
+
+@end
@@ -0,0 +1,92 @@
+#import <Foundation/Foundation.h>
+
+/**
+ `WPPostStore` keeps the posts received by the read APIs on disk, so an app can show them at launch, or offline, before the network answers.
+
+ Posts are kept in a single file, as a log of records. Each record starts with a small header giving its site, post ID and modified date, followed by the post as a binary property list. Opening a store maps the file in memory and only reads the headers to build the index, so its cost doesn't depend on the size of the posts. Posts are decoded when they're read.
+
+ Writing a post appends a record, unless the stored one has the same modified date, so syncing only writes what changed. The file is compacted once most of it is taken by records which have been replaced. A record cut short by the app being killed is dropped when the store is opened.
+
+ Values which can't be stored in a property list, like `NSNull`, are left out of the stored posts.
+
+ Stored posts are only replaced, never dropped: a post deleted, or moved to the trash, on the server stays in the store, since syncing only sees the posts which still exist. Use `removePostsForSite:` to clear a site before storing the full list of its posts again.
+
+ A store is safe to use from any thread. Writes are done in the background, in order. There's only one store open for a file: initializing a store with the path of one which is open returns the open store.
+ */
+@interface WPPostStore : NSObject
+
+/**
+ Returns the store of the file at a path.
+
+ @param path The path of the store file. Its directory is created if needed.
+ @see initWithPath:
+ */
++ (WPPostStore *)storeWithPath:(NSString *)path;
+
+/**
+ Initializes a store, reading the index of the file at a path if there's one.
+
+ If a store of the same file is already open, it's returned instead, so writes to the file are never interleaved.
+
+ @param path The path of the store file. Its directory is created if needed.
+ */
+- (id)initWithPath:(NSString *)path;
+
+/**
+ The path of the store file.
+ */
+@property (readonly, nonatomic, copy) NSString *path;
+
+///-----------------------
+/// @name Reading Posts
+///-----------------------
+
+/**
+ Returns the stored posts of a site, most recently modified first.
+
+ Only the posts returned are decoded.
+
+ @param site A key identifying the site and account, as used by `WPPostSyncState`.
+ @param limit The maximum number of posts to return, or `0` to return every post.
+ @return An array of `WPPostModel` objects.
+ */
+- (NSArray *)postsForSite:(NSString *)site limit:(NSUInteger)limit;
+
+/**
+ Returns the stored post of a site with an ID, or `nil` if there's none.
+ */
+- (id)postWithId:(NSString *)postId site:(NSString *)site;
+
+/**
+ Returns the number of stored posts of a site.
+ */
+- (NSUInteger)numberOfPostsForSite:(NSString *)site;
+
+///-----------------------
+/// @name Writing Posts
+///-----------------------
+
+/**
+ Stores posts of a site, replacing the stored posts with the same IDs. Posts without an ID are ignored.
+
+ @param posts The posts, as dictionaries returned by either API.
+ @param site A key identifying the site and account.
+ */
+- (void)storePosts:(NSArray *)posts forSite:(NSString *)site;
+
+/**
+ Removes the stored posts of a site.
+ */
+- (void)removePostsForSite:(NSString *)site;
+
+/**
+ Removes every stored post, and truncates the file.
+ */
+- (void)removeAllPosts;
+
+/**
+ Blocks until the writes already requested are done.
+ */
+- (void)waitUntilWritten;
+
+@end
@@ -0,0 +1,508 @@
+#import "WPPostStore.h"
+
+#import <fcntl.h>
+#import <libkern/OSByteOrder.h>
+#import <unistd.h>
+#import "WPPostModel.h"
+
+// Multi-byte fields are stored little-endian
+static uint32_t const WPPostStoreFileMagic = 0x57505053; // WPPS
+static uint32_t const WPPostStoreFileVersion = 1;
+static uint32_t const WPPostStoreRecordMagic = 0x57524543; // WREC
+// Small files aren't worth compacting
+static unsigned long long const WPPostStoreMinimumCompactionLength = 1 << 20;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+} WPPostStoreFileHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t siteLength;
+    uint32_t postIdLength;
+    // 0 for a record removing the post
+    uint32_t payloadLength;
+    // The bits of the modified date as seconds since 1970, NaN when unknown
+    uint64_t modified;
+} WPPostStoreRecordHeader;
+
+/**
+ Where the latest record of a post is in the file.
+ */
+@interface WPPostStoreEntry : NSObject
+@property (nonatomic, assign) unsigned long long offset;
+@property (nonatomic, assign) unsigned long long length;
+@property (nonatomic, assign) unsigned long long payloadOffset;
+@property (nonatomic, assign) NSUInteger payloadLength;
+@property (nonatomic, assign) double modified;
+@end
+
+@implementation WPPostStoreEntry
+@end
+
+@interface WPPostStore ()
+@property (readwrite, nonatomic, copy) NSString *path;
+// Everything below is only used on the store queue
+@property (nonatomic, strong) dispatch_queue_t storeQueue;
+// Entries by post ID, by site
+@property (nonatomic, strong) NSMutableDictionary *index;
+@property (nonatomic, strong) NSData *mappedData;
+@property (nonatomic, assign) int fileDescriptor;
+@property (nonatomic, assign) unsigned long long fileLength;
+// The bytes taken by the latest record of each post
+@property (nonatomic, assign) unsigned long long liveLength;
+@end
+
+@implementation WPPostStore
+
+/**
+ The open stores by standardized path. Stores aren't kept alive by it.
+ */
+static NSMapTable *WPPostStoreOpenStores() {
+    static NSMapTable *openStores;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        openStores = [NSMapTable strongToWeakObjectsMapTable];
+    });
+    return openStores;
+}
+
++ (WPPostStore *)storeWithPath:(NSString *)path {
+    return [[self alloc] initWithPath:path];
+}
+
+- (id)initWithPath:(NSString *)path {
+    // Each store appends at the length of the file it knows, so two stores writing the same file would overwrite each other's records
+    NSString *key = [path stringByStandardizingPath];
+    NSMapTable *openStores = WPPostStoreOpenStores();
+    @synchronized(openStores) {
+        WPPostStore *openStore = [openStores objectForKey:key];
+        if (openStore) {
+            // The instance being initialized is released, it mustn't close a descriptor on dealloc
+            _fileDescriptor = -1;
+            return openStore;
+        }
+        self = [super init];
+        if (self) {
+            _path = [path copy];
+            _storeQueue = dispatch_queue_create("org.wordpress.poststore", DISPATCH_QUEUE_SERIAL);
+            _index = [NSMutableDictionary dictionary];
+            _fileDescriptor = -1;
+            [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+            [self loadIndex];
+            [openStores setObject:self forKey:key];
+        }
+        return self;
+    }
+}
+
+- (void)dealloc {
+    if (_fileDescriptor >= 0) {
+        close(_fileDescriptor);
+    }
+}
+
+#pragma mark - Reading Posts
+
+- (NSArray *)postsForSite:(NSString *)site limit:(NSUInteger)limit {
+    if (!site) {
+        return @[];
+    }
+    __block NSArray *entries = nil;
+    __block NSData *data = nil;
+    dispatch_sync(self.storeQueue, ^{
+        entries = [[self.index[site] allValues] sortedArrayUsingComparator:^NSComparisonResult(WPPostStoreEntry *entry, WPPostStoreEntry *otherEntry) {
+            // Most recent first, posts without a date last
+            if (isnan(entry.modified) || isnan(otherEntry.modified)) {
+                return isnan(entry.modified) ? (isnan(otherEntry.modified) ? NSOrderedSame : NSOrderedDescending) : NSOrderedAscending;
+            }
+            if (entry.modified == otherEntry.modified) {
+                return NSOrderedSame;
+            }
+            return entry.modified > otherEntry.modified ? NSOrderedAscending : NSOrderedDescending;
+        }];
+        if (limit > 0 && [entries count] > limit) {
+            entries = [entries subarrayWithRange:NSMakeRange(0, limit)];
+        }
+        data = [self currentMappedData];
+    });
+
+    // Decoding happens off the store queue, the mapping stays valid while it's referenced
+    NSMutableArray *posts = [NSMutableArray arrayWithCapacity:[entries count]];
+    for (WPPostStoreEntry *entry in entries) {
+        WPPostModel *post = [self postForEntry:entry data:data];
+        if (post) {
+            [posts addObject:post];
+        }
+    }
+    return posts;
+}
+
+- (id)postWithId:(NSString *)postId site:(NSString *)site {
+    if (!postId || !site) {
+        return nil;
+    }
+    __block WPPostStoreEntry *entry = nil;
+    __block NSData *data = nil;
+    dispatch_sync(self.storeQueue, ^{
+        entry = self.index[site][postId];
+        data = entry ? [self currentMappedData] : nil;
+    });
+    return entry ? [self postForEntry:entry data:data] : nil;
+}
+
+- (NSUInteger)numberOfPostsForSite:(NSString *)site {
+    if (!site) {
+        return 0;
+    }
+    __block NSUInteger count = 0;
+    dispatch_sync(self.storeQueue, ^{
+        count = [self.index[site] count];
+    });
+    return count;
+}
+
+#pragma mark - Writing Posts
+
+- (void)storePosts:(NSArray *)posts forSite:(NSString *)site {
+    if (!site || ![posts count]) {
+        return;
+    }
+    posts = [posts copy];
+    dispatch_async(self.storeQueue, ^{
+        NSMutableData *records = [NSMutableData data];
+        for (NSDictionary *post in posts) {
+            if (![post isKindOfClass:[NSDictionary class]]) {
+                continue;
+            }
+            WPPostModel *model = [[WPPostModel alloc] initWithDictionary:post];
+            NSString *postId = model.postId;
+            if (![postId length]) {
+                continue;
+            }
+            NSDate *modifiedDate = model.modifiedDate;
+            double modified = modifiedDate ? [modifiedDate timeIntervalSince1970] : NAN;
+            WPPostStoreEntry *storedEntry = self.index[site][postId];
+            if (storedEntry && !isnan(modified) && storedEntry.modified == modified) {
+                continue;
+            }
+            NSData *payload = [NSPropertyListSerialization dataWithPropertyList:[[self class] propertyListFromObject:post]
+                                                                         format:NSPropertyListBinaryFormat_v1_0
+                                                                        options:0
+                                                                          error:nil];
+            if ([payload length]) {
+                [self appendRecordForSite:site postId:postId modified:modified payload:payload toData:records];
+            }
+        }
+        [self writeRecords:records];
+    });
+}
+
+- (void)removePostsForSite:(NSString *)site {
+    if (!site) {
+        return;
+    }
+    dispatch_async(self.storeQueue, ^{
+        NSMutableData *records = [NSMutableData data];
+        for (NSString *postId in [self.index[site] allKeys]) {
+            [self appendRecordForSite:site postId:postId modified:NAN payload:nil toData:records];
+        }
+        [self writeRecords:records];
+    });
+}
+
+- (void)removeAllPosts {
+    dispatch_async(self.storeQueue, ^{
+        [self resetFile];
+    });
+}
+
+- (void)waitUntilWritten {
+    dispatch_sync(self.storeQueue, ^{});
+}
+
+#pragma mark - Private Methods
+
+/**
+ Reads the record headers of the file to build the index. Payloads are skipped.
+ */
+- (void)loadIndex {
+    NSData *data = [NSData dataWithContentsOfFile:self.path options:NSDataReadingMappedAlways error:nil];
+    WPPostStoreFileHeader fileHeader;
+    if ([data length] < sizeof(fileHeader)) {
+        [self resetFile];
+        return;
+    }
+    memcpy(&fileHeader, [data bytes], sizeof(fileHeader));
+    if (OSSwapLittleToHostInt32(fileHeader.magic) != WPPostStoreFileMagic || OSSwapLittleToHostInt32(fileHeader.version) != WPPostStoreFileVersion) {
+        [self resetFile];
+        return;
+    }
+
+    const uint8_t *bytes = [data bytes];
+    unsigned long long length = [data length];
+    unsigned long long offset = sizeof(fileHeader);
+    while (offset < length) {
+        unsigned long long recordLength = [self indexRecordInBytes:bytes + offset length:length - offset fileOffset:offset];
+        if (!recordLength) {
+            break;
+        }
+        offset += recordLength;
+    }
+
+    self.fileDescriptor = open([self.path fileSystemRepresentation], O_WRONLY);
+    self.fileLength = offset;
+    if (offset < length) {
+        // The last record was cut short, it's written again by the next sync
+        ftruncate(self.fileDescriptor, (off_t)offset);
+    } else {
+        self.mappedData = data;
+    }
+}
+
+/**
+ Indexes the record at the start of a buffer, which is at `fileOffset` in the file. Returns the length of the record, or `0` if it's cut short or invalid.
+ */
+- (unsigned long long)indexRecordInBytes:(const uint8_t *)bytes length:(unsigned long long)length fileOffset:(unsigned long long)fileOffset {
+    WPPostStoreRecordHeader header;
+    if (length < sizeof(header)) {
+        return 0;
+    }
+    memcpy(&header, bytes, sizeof(header));
+    if (OSSwapLittleToHostInt32(header.magic) != WPPostStoreRecordMagic) {
+        return 0;
+    }
+    uint32_t siteLength = OSSwapLittleToHostInt32(header.siteLength);
+    uint32_t postIdLength = OSSwapLittleToHostInt32(header.postIdLength);
+    uint32_t payloadLength = OSSwapLittleToHostInt32(header.payloadLength);
+    unsigned long long recordLength = sizeof(header) + (unsigned long long)siteLength + postIdLength + payloadLength;
+    if (recordLength > length) {
+        return 0;
+    }
+    NSString *site = [[NSString alloc] initWithBytes:bytes + sizeof(header) length:siteLength encoding:NSUTF8StringEncoding];
+    NSString *postId = [[NSString alloc] initWithBytes:bytes + sizeof(header) + siteLength length:postIdLength encoding:NSUTF8StringEncoding];
+    if (!site || !postId) {
+        return 0;
+    }
+    union {
+        uint64_t bits;
+        double value;
+    } modified = { .bits = OSSwapLittleToHostInt64(header.modified) };
+
+    WPPostStoreEntry *entry = nil;
+    if (payloadLength > 0) {
+        entry = [[WPPostStoreEntry alloc] init];
+        entry.offset = fileOffset;
+        entry.length = recordLength;
+        entry.payloadOffset = fileOffset + sizeof(header) + siteLength + postIdLength;
+        entry.payloadLength = payloadLength;
+        entry.modified = modified.value;
+    }
+    [self indexEntry:entry site:site postId:postId];
+    return recordLength;
+}
+
+/**
+ Replaces the entry of a post, or removes it if `entry` is `nil`, keeping track of the live bytes.
+ */
+- (void)indexEntry:(WPPostStoreEntry *)entry site:(NSString *)site postId:(NSString *)postId {
+    NSMutableDictionary *entries = self.index[site];
+    WPPostStoreEntry *previousEntry = entries[postId];
+    if (previousEntry) {
+        self.liveLength -= previousEntry.length;
+    }
+    if (!entry) {
+        [entries removeObjectForKey:postId];
+        if (entries && ![entries count]) {
+            [self.index removeObjectForKey:site];
+        }
+        return;
+    }
+    if (!entries) {
+        entries = [NSMutableDictionary dictionary];
+        self.index[site] = entries;
+    }
+    entries[postId] = entry;
+    self.liveLength += entry.length;
+}
+
+/**
+ Appends a record to a buffer. A `nil` payload removes the post.
+ */
+- (void)appendRecordForSite:(NSString *)site postId:(NSString *)postId modified:(double)modified payload:(NSData *)payload toData:(NSMutableData *)data {
+    NSData *siteData = [site dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *postIdData = [postId dataUsingEncoding:NSUTF8StringEncoding];
+    union {
+        uint64_t bits;
+        double value;
+    } modifiedBits = { .value = modified };
+    WPPostStoreRecordHeader header = {
+        .magic = OSSwapHostToLittleInt32(WPPostStoreRecordMagic),
+        .siteLength = OSSwapHostToLittleInt32((uint32_t)[siteData length]),
+        .postIdLength = OSSwapHostToLittleInt32((uint32_t)[postIdData length]),
+        .payloadLength = OSSwapHostToLittleInt32((uint32_t)[payload length]),
+        .modified = OSSwapHostToLittleInt64(modifiedBits.bits),
+    };
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendData:siteData];
+    [data appendData:postIdData];
+    if (payload) {
+        [data appendData:payload];
+    }
+}
+
+/**
+ Appends records to the file and adds them to the index, then compacts the file if needed.
+ */
+- (void)writeRecords:(NSData *)records {
+    if (![records length] || self.fileDescriptor < 0) {
+        return;
+    }
+    const uint8_t *bytes = [records bytes];
+    NSUInteger written = 0;
+    while (written < [records length]) {
+        ssize_t result = pwrite(self.fileDescriptor, bytes + written, [records length] - written, (off_t)(self.fileLength + written));
+        if (result <= 0) {
+            // Leave the partial record out, the index still matches what's before it
+            ftruncate(self.fileDescriptor, (off_t)self.fileLength);
+            return;
+        }
+        written += result;
+    }
+
+    unsigned long long offset = 0;
+    while (offset < [records length]) {
+        offset += [self indexRecordInBytes:bytes + offset length:[records length] - offset fileOffset:self.fileLength + offset];
+    }
+    self.fileLength += [records length];
+    // The mapping doesn't cover the new records
+    self.mappedData = nil;
+
+    if (self.fileLength > WPPostStoreMinimumCompactionLength && self.fileLength > 2 * self.liveLength) {
+        [self compact];
+    }
+}
+
+/**
+ Rewrites the file with only the latest record of each post.
+
+ The new file replaces the old one atomically, so mappings of the old file handed to readers stay valid.
+ */
+- (void)compact {
+    NSData *data = [self currentMappedData];
+    if (!data) {
+        return;
+    }
+    WPPostStoreFileHeader fileHeader = {
+        .magic = OSSwapHostToLittleInt32(WPPostStoreFileMagic),
+        .version = OSSwapHostToLittleInt32(WPPostStoreFileVersion),
+    };
+    NSMutableData *compacted = [NSMutableData dataWithCapacity:(NSUInteger)(sizeof(fileHeader) + self.liveLength)];
+    [compacted appendBytes:&fileHeader length:sizeof(fileHeader)];
+    // Readers may still be using the old entries with the old mapping, so they're replaced rather than changed
+    NSMutableDictionary *index = [NSMutableDictionary dictionaryWithCapacity:[self.index count]];
+    for (NSString *site in self.index) {
+        NSDictionary *entries = self.index[site];
+        NSMutableDictionary *compactedEntries = [NSMutableDictionary dictionaryWithCapacity:[entries count]];
+        for (NSString *postId in entries) {
+            WPPostStoreEntry *entry = entries[postId];
+            if (entry.offset + entry.length > [data length]) {
+                return;
+            }
+            WPPostStoreEntry *compactedEntry = [[WPPostStoreEntry alloc] init];
+            compactedEntry.offset = [compacted length];
+            compactedEntry.length = entry.length;
+            compactedEntry.payloadOffset = compactedEntry.offset + (entry.payloadOffset - entry.offset);
+            compactedEntry.payloadLength = entry.payloadLength;
+            compactedEntry.modified = entry.modified;
+            compactedEntries[postId] = compactedEntry;
+            [compacted appendBytes:(const uint8_t *)[data bytes] + entry.offset length:(NSUInteger)entry.length];
+        }
+        index[site] = compactedEntries;
+    }
+    if (![compacted writeToFile:self.path atomically:YES]) {
+        return;
+    }
+
+    self.index = index;
+    self.liveLength = [compacted length] - sizeof(fileHeader);
+    [self reopenWithLength:[compacted length]];
+}
+
+/**
+ Replaces the file with an empty one, and empties the index.
+ */
+- (void)resetFile {
+    WPPostStoreFileHeader fileHeader = {
+        .magic = OSSwapHostToLittleInt32(WPPostStoreFileMagic),
+        .version = OSSwapHostToLittleInt32(WPPostStoreFileVersion),
+    };
+    [self.index removeAllObjects];
+    self.liveLength = 0;
+    [[NSData dataWithBytes:&fileHeader length:sizeof(fileHeader)] writeToFile:self.path atomically:YES];
+    [self reopenWithLength:sizeof(fileHeader)];
+}
+
+- (void)reopenWithLength:(unsigned long long)length {
+    if (self.fileDescriptor >= 0) {
+        close(self.fileDescriptor);
+    }
+    self.fileDescriptor = open([self.path fileSystemRepresentation], O_WRONLY);
+    self.fileLength = length;
+    self.mappedData = nil;
+}
+
+/**
+ Returns the file mapped in memory, mapping it again if it changed.
+ */
+- (NSData *)currentMappedData {
+    if (!self.mappedData) {
+        self.mappedData = [NSData dataWithContentsOfFile:self.path options:NSDataReadingMappedAlways error:nil];
+    }
+    return self.mappedData;
+}
+
+- (WPPostModel *)postForEntry:(WPPostStoreEntry *)entry data:(NSData *)data {
+    if (entry.payloadOffset + entry.payloadLength > [data length]) {
+        return nil;
+    }
+    NSData *payload = [NSData dataWithBytesNoCopy:(uint8_t *)[data bytes] + entry.payloadOffset length:entry.payloadLength freeWhenDone:NO];
+    NSDictionary *post = [NSPropertyListSerialization propertyListWithData:payload options:NSPropertyListImmutable format:NULL error:nil];
+    if (![post isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+    return [[WPPostModel alloc] initWithDictionary:post];
+}
+
+/**
+ Returns a copy of a decoded response without the values a property list can't hold, like `NSNull`.
+ */
++ (id)propertyListFromObject:(id)object {
+    if ([object isKindOfClass:[NSDictionary class]]) {
+        NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:[object count]];
+        [object enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+            id propertyList = [key isKindOfClass:[NSString class]] ? [self propertyListFromObject:value] : nil;
+            if (propertyList) {
+                dictionary[key] = propertyList;
+            }
+        }];
+        return dictionary;
+    }
+    if ([object isKindOfClass:[NSArray class]]) {
+        NSMutableArray *array = [NSMutableArray arrayWithCapacity:[object count]];
+        for (id value in object) {
+            id propertyList = [self propertyListFromObject:value];
+            if (propertyList) {
+                [array addObject:propertyList];
+            }
+        }
+        return array;
+    }
+    if ([object isKindOfClass:[NSString class]] || [object isKindOfClass:[NSNumber class]] || [object isKindOfClass:[NSDate class]] || [object isKindOfClass:[NSData class]]) {
+        return object;
+    }
+    return nil;
+}
+
+@end
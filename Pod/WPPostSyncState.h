@@ -0,0 +1,22 @@
+#import <Foundation/Foundation.h>
+
+/**
+ `WPPostSyncState` remembers, per site, the most recent modification date of the posts already synced, so the next sync only asks for what changed since then.
+
+ High-water marks are stored in the user defaults.
+ */
+@interface WPPostSyncState : NSObject
+
+/**
+ Returns the high-water mark for a site, or `nil` if it was never synced.
+
+ @param site A key identifying the site and account, e.g. the XML-RPC endpoint and username.
+ */
++ (NSDate *)highWaterMarkForSite:(NSString *)site;
+
+/**
+ Stores the high-water mark for a site. Passing `nil` forgets it, so the next sync fetches every post.
+ */
++ (void)setHighWaterMark:(NSDate *)highWaterMark forSite:(NSString *)site;
+
+@end
@@ -0,0 +1,32 @@
+#import "WPPostSyncState.h"
+
+static NSString *const WPPostSyncStateHighWaterMarksKey = @"WPPostSyncStateHighWaterMarks";
+
+@implementation WPPostSyncState
+
++ (NSDate *)highWaterMarkForSite:(NSString *)site {
+    if (!site) {
+        return nil;
+    }
+    NSDictionary *highWaterMarks = [[NSUserDefaults standardUserDefaults] dictionaryForKey:WPPostSyncStateHighWaterMarksKey];
+    NSDate *highWaterMark = highWaterMarks[site];
+    return [highWaterMark isKindOfClass:[NSDate class]] ? highWaterMark : nil;
+}
+
++ (void)setHighWaterMark:(NSDate *)highWaterMark forSite:(NSString *)site {
+    if (!site) {
+        return;
+    }
+    @synchronized(self) {
+        NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+        NSMutableDictionary *highWaterMarks = [[defaults dictionaryForKey:WPPostSyncStateHighWaterMarksKey] mutableCopy] ?: [NSMutableDictionary dictionary];
+        if (highWaterMark) {
+            highWaterMarks[site] = highWaterMark;
+        } else {
+            [highWaterMarks removeObjectForKey:site];
+        }
+        [defaults setObject:highWaterMarks forKey:WPPostSyncStateHighWaterMarksKey];
+    }
+}
+
+@end
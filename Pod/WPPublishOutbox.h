@@ -0,0 +1,129 @@
+#import <Foundation/Foundation.h>
+#import "WordPressBaseApi.h"
+
+@class WPPublishOutbox;
+
+typedef NS_ENUM(NSUInteger, WPPublishOutboxError) {
+    WPPublishOutboxErrorInterrupted, // The app was killed while the item was being sent
+    WPPublishOutboxErrorMissingImage, // An image of the item couldn't be read back from the journal
+};
+
+extern NSString *const WPPublishOutboxErrorDomain;
+
+/**
+ The delegate of a `WPPublishOutbox` is told how each queued item goes. Methods are called on the main queue.
+ */
+@protocol WPPublishOutboxDelegate <NSObject>
+@optional
+
+/**
+ Tells the delegate how much of an item has been sent, between `0` and `1`. Progress is only reported per byte for the media uploads of `WordPressXMLRPCApi`.
+ */
+- (void)publishOutbox:(WPPublishOutbox *)outbox item:(NSString *)identifier didUpdateProgress:(float)progress;
+
+/**
+ Tells the delegate an item was published. The item is removed from the outbox.
+ */
+- (void)publishOutbox:(WPPublishOutbox *)outbox item:(NSString *)identifier didPublishPostWithId:(NSUInteger)postId permalink:(NSURL *)permalink;
+
+/**
+ Tells the delegate an item failed. The item is removed from the outbox.
+
+ Items are only kept and sent again later when the failure shows the server never got them, like when the device is offline or the host can't be reached. Any other failure is reported, including timeouts and server errors, since the post may have been published anyway. An item which was being sent when the app was killed fails with `WPPublishOutboxErrorInterrupted` when the outbox is created again, for the same reason. An item whose images can't be read back from the journal fails with `WPPublishOutboxErrorMissingImage` without being sent.
+ */
+- (void)publishOutbox:(WPPublishOutbox *)outbox item:(NSString *)identifier didFailWithError:(NSError *)error;
+
+@end
+
+/**
+ `WPPublishOutbox` queues posts to publish, and sends them whenever the device is online.
+
+ Queued posts are written to a journal on disk before they're sent, so they survive the app being killed, and the journal is read back when an outbox is created with the same path. Items are sent one at a time, in order. When the network is unavailable, draining pauses until it's reachable again, or until `retryInterval` elapses. An item being sent when the app moves to the background is given time to finish.
+
+ Consecutive edits to the same draft are coalesced: queuing a post with the draft key of an item which hasn't started sending replaces its content, so only the last version is published. An edit queued while the item with its key is being sent is published separately, as the API has no way to update a published post.
+
+ Items are only sent again when the server can't have received them, so a post is never published twice. Failures are classified as by `WPRetryPolicy`.
+
+ The outbox must be used from the main queue.
+ */
+@interface WPPublishOutbox : NSObject
+
+/**
+ Initializes an outbox publishing to a site, with its journal in a directory.
+
+ @param api The API used to publish the posts.
+ @param journalPath The directory where queued items and their images are kept. It's created if needed.
+ */
+- (id)initWithApi:(id<WordPressBaseApi>)api journalPath:(NSString *)journalPath;
+
+/**
+ The object told how each queued item goes.
+ */
+@property (nonatomic, weak) id<WPPublishOutboxDelegate> delegate;
+
+/**
+ How long draining waits after a network failure before trying again, if the network doesn't come back before. Defaults to `60` seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval retryInterval;
+
+/**
+ The identifiers of the items waiting to be published, in the order they'll be sent, including the one being sent.
+ */
+@property (readonly, nonatomic, strong) NSArray *pendingItemIdentifiers;
+
+/**
+ `YES` while an item is being sent.
+ */
+@property (readonly, nonatomic, assign, getter=isDraining) BOOL draining;
+
+///-----------------------
+/// @name Queuing Posts
+///-----------------------
+
+/**
+ Queues a post for publishing, and starts draining the outbox.
+
+ All the parameters are optional, and can be `nil`.
+
+ @param content The post content/body.
+ @param title The post title.
+ @param images The images (as UIImage) to add to the post. A single image is published as with `publishPostWithImage:description:title:success:failure:`, more than one as a gallery.
+ @param draftKey A key identifying the draft the post comes from, so consecutive edits are coalesced.
+ @return The identifier of the item, which is the one of the coalesced item if there was one.
+ */
+- (NSString *)enqueuePostWithText:(NSString *)content
+                            title:(NSString *)title
+                           images:(NSArray *)images
+                         draftKey:(NSString *)draftKey;
+
+/**
+ Queues a post with a video for publishing, and starts draining the outbox. Only supported with `WordPressXMLRPCApi`.
+
+ The video isn't copied to the journal, so the file must be kept until the item is published or fails.
+
+ @param videoPath The path to the video file.
+ @param content The post content/body.
+ @param title The post title.
+ @param draftKey A key identifying the draft the post comes from, so consecutive edits are coalesced.
+ @return The identifier of the item.
+ */
+- (NSString *)enqueuePostWithVideo:(NSString *)videoPath
+                              text:(NSString *)content
+                             title:(NSString *)title
+                          draftKey:(NSString *)draftKey;
+
+/**
+ Removes an item which hasn't started sending. Returns `NO` if it's being sent or isn't in the outbox.
+ */
+- (BOOL)removeItemWithIdentifier:(NSString *)identifier;
+
+///-----------------------
+/// @name Draining
+///-----------------------
+
+/**
+ Starts sending the queued items, if it's not already doing it. Called automatically when items are queued and when the network becomes reachable.
+ */
+- (void)drain;
+
+@end
@@ -0,0 +1,465 @@
+#import "WPPublishOutbox.h"
+
+#import <UIKit/UIKit.h>
+#import <netinet/in.h>
+#import <AFNetworking/AFNetworking.h>
+#import "WordPressXMLRPCApi.h"
+#import "WPRetryPolicy.h"
+
+NSString *const WPPublishOutboxErrorDomain = @"WPPublishOutboxError";
+
+static NSString *const WPPublishOutboxJournalFileName = @"outbox.plist";
+static NSTimeInterval const WPPublishOutboxDefaultRetryInterval = 60;
+
+#pragma mark - WPPublishOutboxItem
+
+/**
+ A queued post, as kept in the journal. Images are written next to the journal before the item is sent.
+ */
+@interface WPPublishOutboxItem : NSObject
+@property (nonatomic, copy) NSString *identifier;
+@property (nonatomic, copy) NSString *draftKey;
+@property (nonatomic, copy) NSString *title;
+@property (nonatomic, copy) NSString *content;
+@property (nonatomic, copy) NSString *videoPath;
+@property (nonatomic, copy) NSArray *imageFileNames;
+// Images waiting to be written, and the edit they belong to, so a write for an older edit is discarded
+@property (nonatomic, copy) NSArray *unsavedImages;
+@property (nonatomic, assign) NSUInteger revision;
+// Set once the item may have reached the server, so it isn't sent again after a relaunch
+@property (nonatomic, assign) BOOL sendStarted;
+@end
+
+@implementation WPPublishOutboxItem
+
+- (id)initWithDictionary:(NSDictionary *)dictionary {
+    self = [super init];
+    if (self) {
+        _identifier = [dictionary[@"identifier"] copy];
+        _draftKey = [dictionary[@"draftKey"] copy];
+        _title = [dictionary[@"title"] copy];
+        _content = [dictionary[@"content"] copy];
+        _videoPath = [dictionary[@"videoPath"] copy];
+        _imageFileNames = [dictionary[@"imageFileNames"] copy] ?: @[];
+        _revision = [dictionary[@"revision"] unsignedIntegerValue];
+        _sendStarted = [dictionary[@"sendStarted"] boolValue];
+    }
+    return self;
+}
+
+- (NSDictionary *)dictionaryValue {
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+    [dictionary setValue:self.identifier forKey:@"identifier"];
+    [dictionary setValue:self.draftKey forKey:@"draftKey"];
+    [dictionary setValue:self.title forKey:@"title"];
+    [dictionary setValue:self.content forKey:@"content"];
+    [dictionary setValue:self.videoPath forKey:@"videoPath"];
+    [dictionary setValue:self.imageFileNames forKey:@"imageFileNames"];
+    [dictionary setValue:@(self.revision) forKey:@"revision"];
+    [dictionary setValue:@(self.sendStarted) forKey:@"sendStarted"];
+    return dictionary;
+}
+
+- (BOOL)isSaved {
+    return self.unsavedImages == nil;
+}
+
+@end
+
+#pragma mark - WPPublishOutbox
+
+@interface WPPublishOutbox ()
+@property (nonatomic, strong) id<WordPressBaseApi> api;
+@property (nonatomic, copy) NSString *journalPath;
+@property (nonatomic, strong) NSMutableArray *items;
+@property (nonatomic, strong) WPPublishOutboxItem *sendingItem;
+@property (readwrite, nonatomic, assign, getter=isDraining) BOOL draining;
+@property (nonatomic, assign) BOOL waitingForNetwork;
+@property (nonatomic, assign) NSUInteger networkFailureCount;
+@property (nonatomic, strong) dispatch_queue_t journalQueue;
+// Only used to classify failures
+@property (nonatomic, strong) WPRetryPolicy *retryPolicy;
+@property (nonatomic, strong) AFNetworkReachabilityManager *reachabilityManager;
+@property (nonatomic, assign) UIBackgroundTaskIdentifier backgroundTask;
+@end
+
+@implementation WPPublishOutbox
+
+- (id)initWithApi:(id<WordPressBaseApi>)api journalPath:(NSString *)journalPath {
+    self = [super init];
+    if (self) {
+        _api = api;
+        _journalPath = [journalPath copy];
+        _retryInterval = WPPublishOutboxDefaultRetryInterval;
+        _journalQueue = dispatch_queue_create("org.wordpress.outbox.journal", DISPATCH_QUEUE_SERIAL);
+        _backgroundTask = UIBackgroundTaskInvalid;
+        _items = [NSMutableArray array];
+        _retryPolicy = [WPRetryPolicy defaultPolicy];
+
+        [[NSFileManager defaultManager] createDirectoryAtPath:journalPath withIntermediateDirectories:YES attributes:nil error:nil];
+        NSArray *journal = [NSArray arrayWithContentsOfFile:[self journalFilePath]];
+        for (NSDictionary *dictionary in journal) {
+            WPPublishOutboxItem *item = [[WPPublishOutboxItem alloc] initWithDictionary:dictionary];
+            if (item.identifier) {
+                [_items addObject:item];
+            }
+        }
+
+        struct sockaddr_in address;
+        bzero(&address, sizeof(address));
+        address.sin_len = sizeof(address);
+        address.sin_family = AF_INET;
+        _reachabilityManager = [AFNetworkReachabilityManager managerForAddress:&address];
+        __weak __typeof(self) weakSelf = self;
+        [_reachabilityManager setReachabilityStatusChangeBlock:^(AFNetworkReachabilityStatus status) {
+            if (status == AFNetworkReachabilityStatusReachableViaWWAN || status == AFNetworkReachabilityStatusReachableViaWiFi) {
+                weakSelf.waitingForNetwork = NO;
+                [weakSelf drain];
+            }
+        }];
+        [_reachabilityManager startMonitoring];
+
+        if ([_items count] > 0) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [weakSelf drain];
+            });
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [_reachabilityManager stopMonitoring];
+}
+
+- (NSArray *)pendingItemIdentifiers {
+    return [self.items valueForKey:@"identifier"];
+}
+
+#pragma mark - Queuing Posts
+
+- (NSString *)enqueuePostWithText:(NSString *)content
+                            title:(NSString *)title
+                           images:(NSArray *)images
+                         draftKey:(NSString *)draftKey {
+    WPPublishOutboxItem *item = [self itemForDraftKey:draftKey];
+    item.title = title;
+    item.content = content;
+    item.videoPath = nil;
+    [self item:item replaceImages:images];
+    return item.identifier;
+}
+
+- (NSString *)enqueuePostWithVideo:(NSString *)videoPath
+                              text:(NSString *)content
+                             title:(NSString *)title
+                          draftKey:(NSString *)draftKey {
+    WPPublishOutboxItem *item = [self itemForDraftKey:draftKey];
+    item.title = title;
+    item.content = content;
+    item.videoPath = videoPath;
+    [self item:item replaceImages:nil];
+    return item.identifier;
+}
+
+- (BOOL)removeItemWithIdentifier:(NSString *)identifier {
+    for (WPPublishOutboxItem *item in self.items) {
+        if ([item.identifier isEqualToString:identifier] && item != self.sendingItem) {
+            [self removeItem:item];
+            return YES;
+        }
+    }
+    return NO;
+}
+
+#pragma mark - Draining
+
+- (void)drain {
+    if (self.draining || self.waitingForNetwork) {
+        return;
+    }
+    WPPublishOutboxItem *item = [self.items firstObject];
+    if (!item || ![item isSaved]) {
+        // Items are sent in order, the next one starts once its images are written
+        return;
+    }
+
+    self.draining = YES;
+    self.sendingItem = item;
+    [self beginBackgroundTask];
+
+    if (item.sendStarted) {
+        // The app was killed while the item was being sent, and the server may have published it
+        NSError *error = [NSError errorWithDomain:WPPublishOutboxErrorDomain
+                                             code:WPPublishOutboxErrorInterrupted
+                                         userInfo:@{NSLocalizedDescriptionKey: NSLocalizedStringFromTable(@"The post may have been published before the app was closed", @"WordPressApi", nil)}];
+        [self failSendingItem:item error:error];
+        return;
+    }
+
+    [self reportProgress:0 forItem:item];
+    item.sendStarted = YES;
+    // The item is marked in the journal before anything is sent
+    [self saveJournalWithCompletion:^{
+        [self publishItem:item success:^(NSUInteger postId, NSURL *permalink) {
+            self.networkFailureCount = 0;
+            [self reportProgress:1 forItem:item];
+            [self finishSendingItem:item];
+            if ([self.delegate respondsToSelector:@selector(publishOutbox:item:didPublishPostWithId:permalink:)]) {
+                [self.delegate publishOutbox:self item:item.identifier didPublishPostWithId:postId permalink:permalink];
+            }
+            [self drain];
+        } failure:^(NSError *error) {
+            NSHTTPURLResponse *response = error.userInfo[AFNetworkingOperationFailingURLResponseErrorKey];
+            if ([self.retryPolicy isUnsentRequestError:error response:response]) {
+                // The server never got the post, so it's safe to send again
+                item.sendStarted = NO;
+                [self saveJournal];
+                self.sendingItem = nil;
+                self.draining = NO;
+                [self endBackgroundTask];
+                [self waitForNetwork];
+                return;
+            }
+            [self failSendingItem:item error:error];
+        }];
+    }];
+}
+
+#pragma mark - Private Methods
+
+- (NSString *)journalFilePath {
+    return [self.journalPath stringByAppendingPathComponent:WPPublishOutboxJournalFileName];
+}
+
+/**
+ Returns the pending item to coalesce an edit of the draft into, or a new item at the end of the outbox.
+ */
+- (WPPublishOutboxItem *)itemForDraftKey:(NSString *)draftKey {
+    if (draftKey) {
+        for (WPPublishOutboxItem *item in self.items) {
+            if ([item.draftKey isEqualToString:draftKey] && item != self.sendingItem) {
+                return item;
+            }
+        }
+    }
+    WPPublishOutboxItem *item = [[WPPublishOutboxItem alloc] init];
+    item.identifier = [[NSUUID UUID] UUIDString];
+    item.draftKey = draftKey;
+    item.imageFileNames = @[];
+    [self.items addObject:item];
+    return item;
+}
+
+/**
+ Writes the images of an edit next to the journal, then saves the journal and starts draining.
+ */
+- (void)item:(WPPublishOutboxItem *)item replaceImages:(NSArray *)images {
+    NSArray *previousFileNames = item.imageFileNames;
+    item.revision++;
+    item.imageFileNames = @[];
+    item.unsavedImages = images ?: @[];
+
+    NSUInteger revision = item.revision;
+    NSString *journalPath = self.journalPath;
+    dispatch_queue_t journalQueue = self.journalQueue;
+    __weak __typeof(self) weakSelf = self;
+    dispatch_async(journalQueue, ^{
+        for (NSString *fileName in previousFileNames) {
+            [[NSFileManager defaultManager] removeItemAtPath:[journalPath stringByAppendingPathComponent:fileName] error:nil];
+        }
+        NSMutableArray *fileNames = [NSMutableArray arrayWithCapacity:[images count]];
+        [images enumerateObjectsUsingBlock:^(UIImage *image, NSUInteger idx, BOOL *stop) {
+            NSString *fileName = [NSString stringWithFormat:@"%@-%lu-%lu.jpg", item.identifier, (unsigned long)revision, (unsigned long)idx];
+            [UIImageJPEGRepresentation(image, 0.9f) writeToFile:[journalPath stringByAppendingPathComponent:fileName] atomically:YES];
+            [fileNames addObject:fileName];
+        }];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (item.revision != revision) {
+                // A newer edit replaced these images, or the item was removed
+                dispatch_async(journalQueue, ^{
+                    for (NSString *fileName in fileNames) {
+                        [[NSFileManager defaultManager] removeItemAtPath:[journalPath stringByAppendingPathComponent:fileName] error:nil];
+                    }
+                });
+                return;
+            }
+            item.imageFileNames = fileNames;
+            item.unsavedImages = nil;
+            [weakSelf saveJournal];
+            [weakSelf drain];
+        });
+    });
+}
+
+- (void)saveJournal {
+    [self saveJournalWithCompletion:nil];
+}
+
+/**
+ Saves the journal, then calls `completion` on the main queue once it's written.
+ */
+- (void)saveJournalWithCompletion:(void (^)(void))completion {
+    NSMutableArray *journal = [NSMutableArray arrayWithCapacity:[self.items count]];
+    for (WPPublishOutboxItem *item in self.items) {
+        if ([item isSaved]) {
+            [journal addObject:[item dictionaryValue]];
+        }
+    }
+    NSString *journalFilePath = [self journalFilePath];
+    dispatch_async(self.journalQueue, ^{
+        [journal writeToFile:journalFilePath atomically:YES];
+        if (completion) {
+            dispatch_async(dispatch_get_main_queue(), completion);
+        }
+    });
+}
+
+- (void)removeItem:(WPPublishOutboxItem *)item {
+    [self.items removeObject:item];
+    // Drops any image write still pending for the item
+    item.revision++;
+    NSArray *fileNames = item.imageFileNames;
+    NSString *journalPath = self.journalPath;
+    dispatch_async(self.journalQueue, ^{
+        for (NSString *fileName in fileNames) {
+            [[NSFileManager defaultManager] removeItemAtPath:[journalPath stringByAppendingPathComponent:fileName] error:nil];
+        }
+    });
+    [self saveJournal];
+}
+
+- (void)finishSendingItem:(WPPublishOutboxItem *)item {
+    [self removeItem:item];
+    self.sendingItem = nil;
+    self.draining = NO;
+    [self endBackgroundTask];
+}
+
+- (void)failSendingItem:(WPPublishOutboxItem *)item error:(NSError *)error {
+    [self finishSendingItem:item];
+    if ([self.delegate respondsToSelector:@selector(publishOutbox:item:didFailWithError:)]) {
+        [self.delegate publishOutbox:self item:item.identifier didFailWithError:error];
+    }
+    [self drain];
+}
+
+- (void)publishItem:(WPPublishOutboxItem *)item
+            success:(void (^)(NSUInteger postId, NSURL *permalink))success
+            failure:(void (^)(NSError *error))failure {
+    // The API can call back on a completion queue of its own, and the outbox lives on the main queue
+    void (^publishSuccess)(NSUInteger, NSURL *) = success;
+    void (^publishFailure)(NSError *) = failure;
+    success = ^(NSUInteger postId, NSURL *permalink) {
+        [self performOnMainQueue:^{
+            publishSuccess(postId, permalink);
+        }];
+    };
+    failure = ^(NSError *error) {
+        [self performOnMainQueue:^{
+            publishFailure(error);
+        }];
+    };
+
+    NSMutableArray *images = [NSMutableArray arrayWithCapacity:[item.imageFileNames count]];
+    for (NSString *fileName in item.imageFileNames) {
+        UIImage *image = [UIImage imageWithContentsOfFile:[self.journalPath stringByAppendingPathComponent:fileName]];
+        if (!image) {
+            // Publishing without it would leave the post with a missing image, or no image at all
+            failure([NSError errorWithDomain:WPPublishOutboxErrorDomain
+                                        code:WPPublishOutboxErrorMissingImage
+                                    userInfo:@{NSLocalizedDescriptionKey: NSLocalizedStringFromTable(@"An image of the post couldn't be read", @"WordPressApi", nil)}]);
+            return;
+        }
+        [images addObject:image];
+    }
+
+    if (![self.api isKindOfClass:[WordPressXMLRPCApi class]]) {
+        if (item.videoPath) {
+            failure([NSError errorWithDomain:WordPressXMLRPCApiErrorDomain
+                                        code:WordPressXMLRPCApiInvalid
+                                    userInfo:@{NSLocalizedDescriptionKey: NSLocalizedStringFromTable(@"Videos can only be published with XML-RPC", @"WordPressApi", nil)}]);
+        } else if ([images count] > 1) {
+            [self.api publishPostWithGallery:images description:item.content title:item.title success:success failure:failure];
+        } else if ([images count] == 1) {
+            [self.api publishPostWithImage:[images firstObject] description:item.content title:item.title success:success failure:failure];
+        } else {
+            [self.api publishPostWithText:item.content title:item.title success:success failure:failure];
+        }
+        return;
+    }
+
+    WordPressXMLRPCApi *api = (WordPressXMLRPCApi *)self.api;
+    NSUInteger assetCount = MAX([images count], 1);
+    NSMutableArray *assetProgress = [NSMutableArray arrayWithCapacity:assetCount];
+    for (NSUInteger i = 0; i < assetCount; i++) {
+        [assetProgress addObject:@0];
+    }
+    WordPressXMLRPCApiMediaProgressBlock progress = ^(NSUInteger assetIndex, long long totalBytesWritten, long long totalBytesExpectedToWrite) {
+        if (assetIndex >= assetCount || totalBytesExpectedToWrite <= 0) {
+            return;
+        }
+        assetProgress[assetIndex] = @((double)totalBytesWritten / totalBytesExpectedToWrite);
+        // The post itself is sent after the media, so uploads only get the outbox item to 90%
+        float uploaded = [[assetProgress valueForKeyPath:@"@avg.doubleValue"] floatValue];
+        [self reportProgress:uploaded * 0.9f forItem:item];
+    };
+    if (item.videoPath) {
+        [api publishPostWithVideo:item.videoPath description:item.content title:item.title progress:progress success:success failure:failure];
+    } else if ([images count] > 1) {
+        [api publishPostWithGallery:images description:item.content title:item.title progress:progress success:success failure:failure];
+    } else if ([images count] == 1) {
+        [api publishPostWithImage:[images firstObject] description:item.content title:item.title progress:progress success:success failure:failure];
+    } else {
+        [api publishPostWithText:item.content title:item.title success:success failure:failure];
+    }
+}
+
+- (void)performOnMainQueue:(void (^)(void))block {
+    if ([NSThread isMainThread]) {
+        block();
+    } else {
+        dispatch_async(dispatch_get_main_queue(), block);
+    }
+}
+
+- (void)reportProgress:(float)progress forItem:(WPPublishOutboxItem *)item {
+    if ([self.delegate respondsToSelector:@selector(publishOutbox:item:didUpdateProgress:)]) {
+        [self.delegate publishOutbox:self item:item.identifier didUpdateProgress:progress];
+    }
+}
+
+- (void)waitForNetwork {
+    self.waitingForNetwork = YES;
+    self.networkFailureCount++;
+    NSUInteger failureCount = self.networkFailureCount;
+    __weak __typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.retryInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        // Only the wait for the last failure ends this way
+        if (weakSelf.waitingForNetwork && weakSelf.networkFailureCount == failureCount) {
+            weakSelf.waitingForNetwork = NO;
+            [weakSelf drain];
+        }
+    });
+}
+
+- (void)beginBackgroundTask {
+    if (self.backgroundTask != UIBackgroundTaskInvalid) {
+        return;
+    }
+    __weak __typeof(self) weakSelf = self;
+    self.backgroundTask = [[UIApplication sharedApplication] beginBackgroundTaskWithExpirationHandler:^{
+        // The item stays in the journal marked as sent, so if the app is killed before it finishes, the next launch fails it as interrupted
+        [weakSelf endBackgroundTask];
+    }];
+}
+
+- (void)endBackgroundTask {
+    if (self.backgroundTask == UIBackgroundTaskInvalid) {
+        return;
+    }
+    [[UIApplication sharedApplication] endBackgroundTask:self.backgroundTask];
+    self.backgroundTask = UIBackgroundTaskInvalid;
+}
+
+@end
@@ -0,0 +1,29 @@
+#import <Foundation/Foundation.h>
+
+/**
+ `WPRSDLinkScanner` looks for the `EditURI` link in the `<head>` of a HTML page, while the page is being downloaded.
+
+ Link attributes can be in any order. Scanning finishes as soon as the link is found, or the `</head>` or `<body>` tags are reached, so the rest of the page doesn't need to be downloaded.
+
+ A scanner isn't thread safe, but it can be fed from any single thread.
+ */
+@interface WPRSDLinkScanner : NSObject
+
+/**
+ The `href` of the `EditURI` link, once found.
+ */
+@property (nonatomic, readonly) NSString *rsdURL;
+
+/**
+ `YES` when the link was found or the end of the `<head>` was reached. Further data is ignored.
+ */
+@property (nonatomic, readonly, getter=isFinished) BOOL finished;
+
+/**
+ Scans the next chunk of the page.
+
+ @return `YES` if the scanner is finished.
+ */
+- (BOOL)appendData:(NSData *)data;
+
+@end
@@ -0,0 +1,209 @@
+#import "WPRSDLinkScanner.h"
+
+// Pages that don't close their head in the first 512KB aren't worth scanning any further
+static NSUInteger const WPRSDLinkScannerMaximumLength = 512 * 1024;
+
+static NSString *WPRSDLinkScannerString(const char *bytes, NSUInteger length) {
+    NSString *string = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    if (!string) {
+        string = [[NSString alloc] initWithBytes:bytes length:length encoding:NSISOLatin1StringEncoding];
+    }
+    return string;
+}
+
+static BOOL WPRSDLinkScannerHasPrefix(const char *bytes, NSUInteger length, const char *prefix) {
+    size_t prefixLength = strlen(prefix);
+    return length >= prefixLength && strncasecmp(bytes, prefix, prefixLength) == 0;
+}
+
+static NSUInteger WPRSDLinkScannerFind(const char *bytes, NSUInteger start, NSUInteger length, const char *needle) {
+    size_t needleLength = strlen(needle);
+    for (NSUInteger i = start; i + needleLength <= length; i++) {
+        if (strncasecmp(bytes + i, needle, needleLength) == 0) {
+            return i;
+        }
+    }
+    return NSNotFound;
+}
+
+@interface WPRSDLinkScanner ()
+@property (nonatomic, readwrite) NSString *rsdURL;
+@property (nonatomic, readwrite, getter=isFinished) BOOL finished;
+@end
+
+@implementation WPRSDLinkScanner {
+    NSMutableData *_buffer;
+    NSUInteger _scannedLength;
+    BOOL _inComment;
+    const char *_rawTextEndTag;
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _buffer = [NSMutableData data];
+    }
+    return self;
+}
+
+- (BOOL)appendData:(NSData *)data {
+    if (self.finished) {
+        return YES;
+    }
+    [_buffer appendData:data];
+    _scannedLength += [data length];
+
+    const char *bytes = [_buffer bytes];
+    NSUInteger length = [_buffer length];
+    NSUInteger position = 0;
+    while (!self.finished && position < length) {
+        if (_inComment) {
+            NSUInteger end = WPRSDLinkScannerFind(bytes, position, length, "-->");
+            if (end == NSNotFound) {
+                // Keep enough to match a terminator split across chunks
+                position = MAX(position, length > 2 ? length - 2 : 0);
+                break;
+            }
+            _inComment = NO;
+            position = end + 3;
+            continue;
+        }
+        if (_rawTextEndTag) {
+            NSUInteger end = WPRSDLinkScannerFind(bytes, position, length, _rawTextEndTag);
+            if (end == NSNotFound) {
+                size_t keep = strlen(_rawTextEndTag) - 1;
+                position = MAX(position, length > keep ? length - keep : 0);
+                break;
+            }
+            _rawTextEndTag = NULL;
+            position = end;
+            continue;
+        }
+
+        const char *tagStart = memchr(bytes + position, '<', length - position);
+        if (!tagStart) {
+            position = length;
+            break;
+        }
+        position = tagStart - bytes;
+        if (length - position < 4) {
+            // Not enough to tell a comment from a tag yet
+            break;
+        }
+        if (strncmp(tagStart, "<!--", 4) == 0) {
+            _inComment = YES;
+            position += 4;
+            continue;
+        }
+
+        NSUInteger tagEnd = [self endOfTagInBytes:bytes start:position length:length];
+        if (tagEnd == NSNotFound) {
+            break;
+        }
+        [self scanTag:tagStart length:tagEnd - position];
+        position = tagEnd + 1;
+    }
+
+    [_buffer replaceBytesInRange:NSMakeRange(0, position) withBytes:NULL length:0];
+    if (_scannedLength > WPRSDLinkScannerMaximumLength) {
+        self.finished = YES;
+    }
+    if (self.finished) {
+        _buffer = nil;
+    }
+    return self.finished;
+}
+
+#pragma mark - Private
+
+- (NSUInteger)endOfTagInBytes:(const char *)bytes start:(NSUInteger)start length:(NSUInteger)length {
+    char quote = 0;
+    for (NSUInteger i = start + 1; i < length; i++) {
+        char c = bytes[i];
+        if (quote) {
+            if (c == quote) {
+                quote = 0;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            return i;
+        }
+    }
+    return NSNotFound;
+}
+
+/**
+ Looks at a tag, from the `<` up to (but not including) the `>`.
+ */
+- (void)scanTag:(const char *)tag length:(NSUInteger)length {
+    const char *name = tag + 1;
+    NSUInteger nameLength = length - 1;
+    if (WPRSDLinkScannerHasPrefix(name, nameLength, "/head") || WPRSDLinkScannerHasPrefix(name, nameLength, "body")) {
+        self.finished = YES;
+    } else if (WPRSDLinkScannerHasPrefix(name, nameLength, "script")) {
+        _rawTextEndTag = "</script";
+    } else if (WPRSDLinkScannerHasPrefix(name, nameLength, "style")) {
+        _rawTextEndTag = "</style";
+    } else if (WPRSDLinkScannerHasPrefix(name, nameLength, "link") && nameLength > 4 && isspace((unsigned char)name[4])) {
+        NSDictionary *attributes = [self attributesInTag:name + 4 length:nameLength - 4];
+        NSString *href = attributes[@"href"];
+        NSArray *relations = [[attributes[@"rel"] lowercaseString] componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+        if ([href length] > 0 && [relations containsObject:@"edituri"]) {
+            self.rsdURL = [href stringByReplacingOccurrencesOfString:@"&amp;" withString:@"&"];
+            self.finished = YES;
+        }
+    }
+}
+
+- (NSDictionary *)attributesInTag:(const char *)bytes length:(NSUInteger)length {
+    NSMutableDictionary *attributes = [NSMutableDictionary dictionary];
+    NSUInteger i = 0;
+    while (i < length) {
+        while (i < length && (isspace((unsigned char)bytes[i]) || bytes[i] == '/')) {
+            i++;
+        }
+        NSUInteger nameStart = i;
+        while (i < length && !isspace((unsigned char)bytes[i]) && bytes[i] != '=' && bytes[i] != '/') {
+            i++;
+        }
+        if (i == nameStart) {
+            break;
+        }
+        NSString *name = [WPRSDLinkScannerString(bytes + nameStart, i - nameStart) lowercaseString];
+        while (i < length && isspace((unsigned char)bytes[i])) {
+            i++;
+        }
+        NSString *value = @"";
+        if (i < length && bytes[i] == '=') {
+            i++;
+            while (i < length && isspace((unsigned char)bytes[i])) {
+                i++;
+            }
+            NSUInteger valueStart;
+            NSUInteger valueEnd;
+            if (i < length && (bytes[i] == '"' || bytes[i] == '\'')) {
+                char quote = bytes[i++];
+                valueStart = i;
+                while (i < length && bytes[i] != quote) {
+                    i++;
+                }
+                valueEnd = i;
+                i++;
+            } else {
+                valueStart = i;
+                while (i < length && !isspace((unsigned char)bytes[i])) {
+                    i++;
+                }
+                valueEnd = i;
+            }
+            value = WPRSDLinkScannerString(bytes + valueStart, valueEnd - valueStart) ?: @"";
+        }
+        if (name && !attributes[name]) {
+            attributes[name] = value;
+        }
+    }
+    return attributes;
+}
+
+@end
@@ -2,5 +2,15 @@
 
 @interface WPRSDParser : NSObject<NSXMLParserDelegate>
 - (id)initWithXmlString:(NSString *)string;
+/**
+ Initializes a parser with the raw bytes of a RSD document, without decoding them to a string first.
+ */
+- (id)initWithData:(NSData *)data;
+/**
+ Parses the document until the `apiLink` of the WordPress API is found.
+ 
+ @param error Set to the parsing error if the endpoint couldn't be found.
+ @return The WordPress XML-RPC endpoint, or `nil`.
+ */
 - (NSString *)parsedEndpointWithError:(NSError **)error;
 @end
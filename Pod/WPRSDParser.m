@@ -7,9 +7,13 @@
 }
 
 - (id)initWithXmlString:(NSString *)string {
+    return [self initWithData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (id)initWithData:(NSData *)data {
     self = [super init];
     if (self) {
-        _parser = [[NSXMLParser alloc] initWithData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+        _parser = [[NSXMLParser alloc] initWithData:data];
         [_parser setDelegate:self];
     }
     return self;
@@ -17,7 +21,8 @@
 
 - (NSString *)parsedEndpointWithError:(NSError **)error {
     [_parser parse];
-    if (error) *error = _error;
+    // Aborting once the endpoint is found is reported as an error too
+    if (error) *error = _endpoint ? nil : _error;
     return _endpoint;
 }
 
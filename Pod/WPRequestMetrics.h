@@ -0,0 +1,138 @@
+#import <Foundation/Foundation.h>
+
+typedef NS_ENUM(NSInteger, WPRequestOutcome) {
+    WPRequestOutcomeSuccess, // The response was received and decoded
+    WPRequestOutcomeFailure, // The request failed, or the response was an error or a fault
+    WPRequestOutcomeCancelled, // The request was cancelled before finishing
+};
+
+/**
+ `WPRequestMetrics` describes how a single request went, from the moment it was created until its response was decoded.
+
+ Metrics are only collected when the client has a `metricsObserver`. Times are in seconds, and are `0` when the request didn't get to that stage.
+ */
+@interface WPRequestMetrics : NSObject
+
+/**
+ The XML-RPC method, or the REST path relative to the base URL.
+ */
+@property (nonatomic, copy, readonly) NSString *name;
+
+/**
+ The URL the request was sent to.
+ */
+@property (nonatomic, strong, readonly) NSURL *URL;
+
+/**
+ The number of bytes of the request body that were sent.
+ */
+@property (nonatomic, assign, readonly) long long requestBytes;
+
+/**
+ The number of bytes of the response body that were received.
+ */
+@property (nonatomic, assign, readonly) long long responseBytes;
+
+/**
+ The HTTP status code of the response, or `0` if there was no response.
+ */
+@property (nonatomic, assign, readonly) NSInteger statusCode;
+
+/**
+ How long the request waited in the operation queue before starting.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval queueWaitTime;
+
+/**
+ How long it took from starting the request until the response headers arrived.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval timeToFirstByte;
+
+/**
+ How long it took from the response headers until the last byte arrived.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval transferTime;
+
+/**
+ How long was spent decoding the response.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval decodeTime;
+
+/**
+ How long it took from creating the request until it finished.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval totalTime;
+
+/**
+ How the request ended.
+ */
+@property (nonatomic, assign, readonly) WPRequestOutcome outcome;
+
+/**
+ The error, if the request didn't succeed.
+ */
+@property (nonatomic, strong, readonly) NSError *error;
+
+/**
+ `YES` if the call was answered from the response cache, so no request was sent. Only `name`, `URL`, `totalTime` and `outcome` are set.
+ */
+@property (nonatomic, assign, readonly, getter=isCached) BOOL cached;
+
+/**
+ `YES` if the call was sent in a `system.multicall` with other calls. Each call gets its own metrics, with its own outcome and error, but the stages, sizes and status code are those of the whole multicall.
+ */
+@property (nonatomic, assign, readonly, getter=isBatched) BOOL batched;
+
+/**
+ Initializes the metrics for a request, and starts counting the time it waits in the queue.
+
+ @param name The XML-RPC method or REST path.
+ @param request The request being sent.
+ */
+- (id)initWithName:(NSString *)name request:(NSURLRequest *)request;
+
+/**
+ Initializes the metrics for a call answered from the response cache. They're finished right away.
+
+ @param name The XML-RPC method or REST path.
+ @param URL The URL the request would have been sent to.
+ */
+- (id)initWithCachedResponseForName:(NSString *)name URL:(NSURL *)URL;
+
+/**
+ Returns the metrics of a call sent in this multicall request, which has finished.
+
+ @param name The XML-RPC method of the call.
+ @param error The fault returned for the call, or the error of the multicall.
+ */
+- (WPRequestMetrics *)metricsForBatchedCallWithName:(NSString *)name error:(NSError *)error;
+
+///------------------------------------------
+/// @name Recording Events
+///------------------------------------------
+
+/**
+ These are called by the request operations and the clients as the request goes through its stages. They must be called in order, but can be called from any thread.
+ */
+- (void)operationDidStart;
+- (void)didSendBodyBytes:(long long)totalBytesWritten;
+- (void)didReceiveResponse:(NSURLResponse *)response;
+- (void)didReceiveDataOfLength:(NSUInteger)length;
+- (void)didFinishLoading;
+- (void)decodingDidStart;
+- (void)decodingDidFinish;
+- (void)finishWithError:(NSError *)error;
+
+@end
+
+/**
+ The `WPRequestMetricsObserver` protocol is adopted by objects that want to know how every request of a client went.
+ */
+@protocol WPRequestMetricsObserver <NSObject>
+
+/**
+ Called on the completion queue of the request (the main queue by default) once it has finished, before its success or failure block.
+ */
+- (void)requestDidFinishWithMetrics:(WPRequestMetrics *)metrics;
+
+@end
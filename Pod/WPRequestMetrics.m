@@ -0,0 +1,147 @@
+#import "WPRequestMetrics.h"
+
+@interface WPRequestMetrics ()
+@property (nonatomic, copy, readwrite) NSString *name;
+@property (nonatomic, strong, readwrite) NSURL *URL;
+@property (nonatomic, assign, readwrite) long long requestBytes;
+@property (nonatomic, assign, readwrite) long long responseBytes;
+@property (nonatomic, assign, readwrite) NSInteger statusCode;
+@property (nonatomic, assign, readwrite) NSTimeInterval decodeTime;
+@property (nonatomic, assign, readwrite) WPRequestOutcome outcome;
+@property (nonatomic, strong, readwrite) NSError *error;
+@property (nonatomic, assign, readwrite, getter=isCached) BOOL cached;
+@property (nonatomic, assign, readwrite, getter=isBatched) BOOL batched;
+@end
+
+@implementation WPRequestMetrics {
+    CFAbsoluteTime _createdTime;
+    CFAbsoluteTime _startTime;
+    CFAbsoluteTime _responseTime;
+    CFAbsoluteTime _loadedTime;
+    CFAbsoluteTime _decodeStartTime;
+    CFAbsoluteTime _finishedTime;
+}
+
+- (id)initWithName:(NSString *)name request:(NSURLRequest *)request {
+    self = [super init];
+    if (self) {
+        _createdTime = CFAbsoluteTimeGetCurrent();
+        _name = [name copy];
+        _URL = request.URL;
+        // Updated with the bytes actually sent, if the body gets sent
+        NSString *contentLength = [request valueForHTTPHeaderField:@"Content-Length"];
+        _requestBytes = contentLength ? [contentLength longLongValue] : (long long)[request.HTTPBody length];
+    }
+    return self;
+}
+
+- (id)initWithCachedResponseForName:(NSString *)name URL:(NSURL *)URL {
+    self = [super init];
+    if (self) {
+        _createdTime = CFAbsoluteTimeGetCurrent();
+        _name = [name copy];
+        _URL = URL;
+        _cached = YES;
+        [self finishWithError:nil];
+    }
+    return self;
+}
+
+- (WPRequestMetrics *)metricsForBatchedCallWithName:(NSString *)name error:(NSError *)error {
+    WPRequestMetrics *metrics = [[WPRequestMetrics alloc] init];
+    metrics->_createdTime = _createdTime;
+    metrics->_startTime = _startTime;
+    metrics->_responseTime = _responseTime;
+    metrics->_loadedTime = _loadedTime;
+    metrics.name = name;
+    metrics.URL = self.URL;
+    metrics.requestBytes = self.requestBytes;
+    metrics.responseBytes = self.responseBytes;
+    metrics.statusCode = self.statusCode;
+    metrics.decodeTime = self.decodeTime;
+    metrics.batched = YES;
+    [metrics finishWithError:error];
+    // The calls finish together with the multicall
+    metrics->_finishedTime = _finishedTime;
+    return metrics;
+}
+
+#pragma mark - Durations
+
+static NSTimeInterval WPRequestMetricsInterval(CFAbsoluteTime start, CFAbsoluteTime end) {
+    return (start > 0 && end > start) ? end - start : 0;
+}
+
+- (NSTimeInterval)queueWaitTime {
+    return WPRequestMetricsInterval(_createdTime, _startTime);
+}
+
+- (NSTimeInterval)timeToFirstByte {
+    return WPRequestMetricsInterval(_startTime, _responseTime);
+}
+
+- (NSTimeInterval)transferTime {
+    return WPRequestMetricsInterval(_responseTime, _loadedTime);
+}
+
+- (NSTimeInterval)totalTime {
+    return WPRequestMetricsInterval(_createdTime, _finishedTime);
+}
+
+#pragma mark - Recording Events
+
+- (void)operationDidStart {
+    _startTime = CFAbsoluteTimeGetCurrent();
+}
+
+- (void)didSendBodyBytes:(long long)totalBytesWritten {
+    self.requestBytes = totalBytesWritten;
+}
+
+- (void)didReceiveResponse:(NSURLResponse *)response {
+    _responseTime = CFAbsoluteTimeGetCurrent();
+    if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
+        self.statusCode = [(NSHTTPURLResponse *)response statusCode];
+    }
+    // Redirects might have changed where the request ended up
+    self.URL = response.URL ?: self.URL;
+}
+
+- (void)didReceiveDataOfLength:(NSUInteger)length {
+    self.responseBytes += length;
+}
+
+- (void)didFinishLoading {
+    _loadedTime = CFAbsoluteTimeGetCurrent();
+}
+
+- (void)decodingDidStart {
+    _decodeStartTime = CFAbsoluteTimeGetCurrent();
+}
+
+- (void)decodingDidFinish {
+    // Streaming responses are decoded in several steps
+    self.decodeTime += WPRequestMetricsInterval(_decodeStartTime, CFAbsoluteTimeGetCurrent());
+    _decodeStartTime = 0;
+}
+
+- (void)finishWithError:(NSError *)error {
+    _finishedTime = CFAbsoluteTimeGetCurrent();
+    self.error = error;
+    if (!error) {
+        self.outcome = WPRequestOutcomeSuccess;
+    } else if ([error.domain isEqualToString:NSURLErrorDomain] && error.code == NSURLErrorCancelled) {
+        self.outcome = WPRequestOutcomeCancelled;
+    } else {
+        self.outcome = WPRequestOutcomeFailure;
+    }
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %@ %@%@ outcome=%ld status=%ld sent=%lld received=%lld queue=%.3fs ttfb=%.3fs transfer=%.3fs decode=%.3fs total=%.3fs>",
+            NSStringFromClass([self class]), self.name, self.URL.host, (self.cached ? @" cached" : (self.batched ? @" batched" : @"")), (long)self.outcome, (long)self.statusCode,
+            self.requestBytes, self.responseBytes, self.queueWaitTime, self.timeToFirstByte,
+            self.transferTime, self.decodeTime, self.totalTime];
+}
+
+@end
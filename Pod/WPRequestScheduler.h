@@ -0,0 +1,121 @@
+#import <Foundation/Foundation.h>
+
+typedef NS_ENUM(NSInteger, WPRequestPriority) {
+    WPRequestPriorityInteractive, // Requests the user is waiting for, like publishing or signing in
+    WPRequestPriorityBackgroundSync, // Keeping content up to date
+    WPRequestPriorityPrefetch, // Content that might be needed later
+};
+
+/**
+ `WPRequestScheduler` runs the requests of all the API clients, so they share the connections to each host.
+
+ Operations are started in priority order. Lower priority operations always leave one slot free for interactive ones, both per host and overall.
+
+ The number of concurrent operations per host adapts to how the host is doing: it's halved when requests time out, fail to connect, or get a `429` or `5xx` response, and grows back by one after a full round of healthy requests.
+
+ Operations that aren't `AFURLConnectionOperation` or `WPURLSessionTaskOperation` only count towards the overall limit.
+ */
+@interface WPRequestScheduler : NSObject
+
+/**
+ The scheduler used by default by `WPXMLRPCClient` and `WordPressRestApi`.
+ */
++ (WPRequestScheduler *)sharedScheduler;
+
+/**
+ The maximum number of operations running at the same time, across all hosts. Defaults to `16`.
+ */
+@property (nonatomic, assign) NSUInteger maximumConcurrentOperationCount;
+
+/**
+ The maximum number of operations running at the same time for a single host. Defaults to `4`.
+ */
+@property (nonatomic, assign) NSUInteger maximumConcurrentOperationsPerHost;
+
+/**
+ Schedules an operation.
+
+ @param operation The operation to run.
+ @param priority The priority class of the operation.
+ @param tag An optional tag, to cancel related operations together.
+ @param owner An optional object the operation belongs to, usually the queue or client that added it. It's not retained.
+ */
+- (void)addOperation:(NSOperation *)operation priority:(WPRequestPriority)priority tag:(NSString *)tag owner:(id)owner;
+
+/**
+ Returns the operations for an owner that haven't finished yet.
+ */
+- (NSArray *)operationsForOwner:(id)owner;
+
+/**
+ Returns the current concurrency limit for a host.
+ */
+- (NSUInteger)concurrencyLimitForHost:(NSString *)host;
+
+/**
+ Holds back the operations of an owner that haven't started yet, or lets them start again. Operations already running aren't affected.
+
+ @param suspended Whether the operations of the owner should be held back.
+ @param owner The owner, as given to `addOperation:priority:tag:owner:`.
+ */
+- (void)setOperationsSuspended:(BOOL)suspended forOwner:(id)owner;
+
+/**
+ Returns whether the operations of an owner are held back.
+ */
+- (BOOL)operationsSuspendedForOwner:(id)owner;
+
+///------------------------------------------
+/// @name Cancelling Operations
+///------------------------------------------
+
+/**
+ Cancels all the operations with a priority class. Operations that haven't started yet still run, to report the cancellation.
+ */
+- (void)cancelOperationsWithPriority:(WPRequestPriority)priority;
+
+/**
+ Cancels all the operations with a tag.
+ */
+- (void)cancelOperationsWithTag:(NSString *)tag;
+
+/**
+ Cancels the operations with a tag that belong to an owner.
+ */
+- (void)cancelOperationsWithTag:(NSString *)tag owner:(id)owner;
+
+/**
+ Cancels all the operations of an owner.
+ */
+- (void)cancelOperationsForOwner:(id)owner;
+
+@end
+
+/**
+ `WPRequestSchedulerQueue` is an operation queue that hands its operations to a `WPRequestScheduler`, with its priority and tag.
+
+ Its `operations` are the ones added through it that haven't finished yet. Setting `suspended` holds back the operations that haven't started yet, like for a regular queue. `maxConcurrentOperationCount` has no effect, as the scheduler decides how many operations run.
+ */
+@interface WPRequestSchedulerQueue : NSOperationQueue
+
+/**
+ Initializes a queue for a scheduler, with interactive priority.
+ */
+- (id)initWithScheduler:(WPRequestScheduler *)scheduler;
+
+/**
+ The scheduler running the operations.
+ */
+@property (nonatomic, strong, readonly) WPRequestScheduler *scheduler;
+
+/**
+ The priority class of the operations added to the queue. Defaults to `WPRequestPriorityInteractive`.
+ */
+@property (nonatomic, assign) WPRequestPriority priority;
+
+/**
+ The tag of the operations added to the queue. Defaults to `nil`.
+ */
+@property (nonatomic, copy) NSString *tag;
+
+@end
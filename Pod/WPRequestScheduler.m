@@ -0,0 +1,421 @@
+#import "WPRequestScheduler.h"
+
+#import <AFNetworking/AFURLConnectionOperation.h>
+#import "WPURLSessionTransport.h"
+
+static NSUInteger const WPRequestSchedulerDefaultMaxConcurrentOperationCount = 16;
+static NSUInteger const WPRequestSchedulerDefaultMaxConcurrentOperationsPerHost = 4;
+// Idle hosts whose limit was lowered are forgotten after this, as what made them struggle has likely passed
+static NSTimeInterval const WPRequestSchedulerHostStateLifetime = 60;
+static NSUInteger const WPRequestSchedulerPriorityCount = WPRequestPriorityPrefetch + 1;
+
+@interface WPScheduledOperation : NSObject
+@property (nonatomic, strong) NSOperation *operation;
+@property (nonatomic, copy) NSString *host;
+@property (nonatomic, assign) WPRequestPriority priority;
+@property (nonatomic, copy) NSString *tag;
+@property (nonatomic, weak) id owner;
+@end
+
+@implementation WPScheduledOperation
+@end
+
+@interface WPSchedulerHostState : NSObject
+@property (nonatomic, assign) NSUInteger runningCount;
+@property (nonatomic, assign) NSUInteger limit;
+@property (nonatomic, assign) NSUInteger healthyCount;
+@property (nonatomic, assign) CFAbsoluteTime lastFinishTime;
+@end
+
+@implementation WPSchedulerHostState
+@end
+
+@interface WPRequestScheduler ()
+@property (nonatomic, strong) dispatch_queue_t stateQueue;
+@property (nonatomic, strong) NSOperationQueue *executionQueue;
+@property (nonatomic, strong) NSArray *pendingOperations;
+@property (nonatomic, strong) NSMutableArray *runningOperations;
+@property (nonatomic, strong) NSMutableDictionary *hosts;
+// Owners whose pending operations are held back
+@property (nonatomic, strong) NSHashTable *suspendedOwners;
+@end
+
+@implementation WPRequestScheduler
+
++ (WPRequestScheduler *)sharedScheduler {
+    static WPRequestScheduler *sharedScheduler;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedScheduler = [[self alloc] init];
+    });
+    return sharedScheduler;
+}
+
+- (id)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+
+    _maximumConcurrentOperationCount = WPRequestSchedulerDefaultMaxConcurrentOperationCount;
+    _maximumConcurrentOperationsPerHost = WPRequestSchedulerDefaultMaxConcurrentOperationsPerHost;
+
+    self.stateQueue = dispatch_queue_create("org.wordpress.requestscheduler", DISPATCH_QUEUE_SERIAL);
+    // Concurrency is limited by the scheduler, operations are only added here when they can run
+    self.executionQueue = [[NSOperationQueue alloc] init];
+    self.executionQueue.name = @"org.wordpress.requestscheduler.execution";
+
+    NSMutableArray *pendingOperations = [NSMutableArray array];
+    for (NSUInteger i = 0; i < WPRequestSchedulerPriorityCount; i++) {
+        [pendingOperations addObject:[NSMutableArray array]];
+    }
+    self.pendingOperations = pendingOperations;
+    self.runningOperations = [NSMutableArray array];
+    self.hosts = [NSMutableDictionary dictionary];
+    self.suspendedOwners = [NSHashTable weakObjectsHashTable];
+
+    return self;
+}
+
+#pragma mark - Configuration
+
+- (void)setMaximumConcurrentOperationCount:(NSUInteger)maximumConcurrentOperationCount {
+    dispatch_async(self.stateQueue, ^{
+        _maximumConcurrentOperationCount = MAX(maximumConcurrentOperationCount, 1);
+        [self startPendingOperations];
+    });
+}
+
+- (void)setMaximumConcurrentOperationsPerHost:(NSUInteger)maximumConcurrentOperationsPerHost {
+    dispatch_async(self.stateQueue, ^{
+        _maximumConcurrentOperationsPerHost = MAX(maximumConcurrentOperationsPerHost, 1);
+        for (WPSchedulerHostState *host in [self.hosts allValues]) {
+            host.limit = MIN(host.limit, _maximumConcurrentOperationsPerHost);
+        }
+        [self startPendingOperations];
+    });
+}
+
+- (NSUInteger)concurrencyLimitForHost:(NSString *)host {
+    __block NSUInteger limit = 0;
+    dispatch_sync(self.stateQueue, ^{
+        limit = [self stateForHost:host].limit;
+    });
+    return limit;
+}
+
+#pragma mark - Scheduling Operations
+
+- (void)addOperation:(NSOperation *)operation priority:(WPRequestPriority)priority tag:(NSString *)tag owner:(id)owner {
+    WPScheduledOperation *scheduledOperation = [[WPScheduledOperation alloc] init];
+    scheduledOperation.operation = operation;
+    scheduledOperation.priority = MIN(MAX(priority, WPRequestPriorityInteractive), WPRequestPriorityPrefetch);
+    scheduledOperation.tag = tag;
+    scheduledOperation.owner = owner;
+    if ([operation isKindOfClass:[AFURLConnectionOperation class]]) {
+        scheduledOperation.host = [[[(AFURLConnectionOperation *)operation request].URL host] lowercaseString];
+    } else if ([operation isKindOfClass:[WPURLSessionTaskOperation class]]) {
+        scheduledOperation.host = [[[(WPURLSessionTaskOperation *)operation request].URL host] lowercaseString];
+    }
+
+    dispatch_async(self.stateQueue, ^{
+        [self.pendingOperations[scheduledOperation.priority] addObject:scheduledOperation];
+        [self startPendingOperations];
+    });
+}
+
+- (NSArray *)operationsForOwner:(id)owner {
+    NSMutableArray *operations = [NSMutableArray array];
+    dispatch_sync(self.stateQueue, ^{
+        [self enumerateScheduledOperationsUsingBlock:^(WPScheduledOperation *scheduledOperation) {
+            if (scheduledOperation.owner == owner) {
+                [operations addObject:scheduledOperation.operation];
+            }
+        }];
+    });
+    return operations;
+}
+
+- (void)setOperationsSuspended:(BOOL)suspended forOwner:(id)owner {
+    if (!owner) {
+        return;
+    }
+    dispatch_async(self.stateQueue, ^{
+        if (suspended) {
+            [self.suspendedOwners addObject:owner];
+        } else {
+            [self.suspendedOwners removeObject:owner];
+            [self startPendingOperations];
+        }
+    });
+}
+
+- (BOOL)operationsSuspendedForOwner:(id)owner {
+    __block BOOL suspended = NO;
+    dispatch_sync(self.stateQueue, ^{
+        suspended = owner && [self.suspendedOwners containsObject:owner];
+    });
+    return suspended;
+}
+
+#pragma mark - Cancelling Operations
+
+- (void)cancelOperationsWithPriority:(WPRequestPriority)priority {
+    [self cancelOperationsPassingTest:^BOOL(WPScheduledOperation *scheduledOperation) {
+        return scheduledOperation.priority == priority;
+    }];
+}
+
+- (void)cancelOperationsWithTag:(NSString *)tag {
+    [self cancelOperationsPassingTest:^BOOL(WPScheduledOperation *scheduledOperation) {
+        return [scheduledOperation.tag isEqualToString:tag];
+    }];
+}
+
+- (void)cancelOperationsWithTag:(NSString *)tag owner:(id)owner {
+    [self cancelOperationsPassingTest:^BOOL(WPScheduledOperation *scheduledOperation) {
+        return scheduledOperation.owner == owner && [scheduledOperation.tag isEqualToString:tag];
+    }];
+}
+
+- (void)cancelOperationsForOwner:(id)owner {
+    [self cancelOperationsPassingTest:^BOOL(WPScheduledOperation *scheduledOperation) {
+        return scheduledOperation.owner == owner;
+    }];
+}
+
+- (void)cancelOperationsPassingTest:(BOOL (^)(WPScheduledOperation *scheduledOperation))test {
+    dispatch_sync(self.stateQueue, ^{
+        for (NSMutableArray *pending in self.pendingOperations) {
+            for (WPScheduledOperation *scheduledOperation in [pending copy]) {
+                if (test(scheduledOperation)) {
+                    [pending removeObject:scheduledOperation];
+                    [scheduledOperation.operation cancel];
+                    // Cancelled operations finish right away, and report the cancellation from there
+                    [self.executionQueue addOperation:scheduledOperation.operation];
+                }
+            }
+        }
+        for (WPScheduledOperation *scheduledOperation in self.runningOperations) {
+            if (test(scheduledOperation)) {
+                [scheduledOperation.operation cancel];
+            }
+        }
+    });
+}
+
+#pragma mark - Private
+
+/**
+ Must be called on `stateQueue`.
+ */
+- (void)enumerateScheduledOperationsUsingBlock:(void (^)(WPScheduledOperation *scheduledOperation))block {
+    for (NSArray *pending in self.pendingOperations) {
+        for (WPScheduledOperation *scheduledOperation in pending) {
+            block(scheduledOperation);
+        }
+    }
+    for (WPScheduledOperation *scheduledOperation in self.runningOperations) {
+        block(scheduledOperation);
+    }
+}
+
+/**
+ Must be called on `stateQueue`.
+ */
+- (WPSchedulerHostState *)stateForHost:(NSString *)host {
+    NSString *key = host ?: @"";
+    WPSchedulerHostState *state = self.hosts[key];
+    if (!state) {
+        state = [[WPSchedulerHostState alloc] init];
+        state.limit = host ? self.maximumConcurrentOperationsPerHost : NSUIntegerMax;
+        self.hosts[key] = state;
+    }
+    return state;
+}
+
+/**
+ Must be called on `stateQueue`.
+ */
+- (void)startPendingOperations {
+    for (NSUInteger i = 0; i < WPRequestSchedulerPriorityCount; i++) {
+        WPRequestPriority priority = (WPRequestPriority)i;
+        NSMutableArray *pending = self.pendingOperations[i];
+        NSUInteger globalLimit = self.maximumConcurrentOperationCount;
+        if (priority != WPRequestPriorityInteractive && globalLimit > 1) {
+            globalLimit--;
+        }
+        for (WPScheduledOperation *scheduledOperation in [pending copy]) {
+            if ([self.runningOperations count] >= globalLimit) {
+                break;
+            }
+            id owner = scheduledOperation.owner;
+            if (owner && [self.suspendedOwners containsObject:owner]) {
+                continue;
+            }
+            WPSchedulerHostState *host = [self stateForHost:scheduledOperation.host];
+            NSUInteger hostLimit = host.limit;
+            if (priority != WPRequestPriorityInteractive && hostLimit > 1) {
+                hostLimit--;
+            }
+            if (host.runningCount >= hostLimit) {
+                continue;
+            }
+            [pending removeObject:scheduledOperation];
+            [self startScheduledOperation:scheduledOperation host:host];
+        }
+    }
+}
+
+/**
+ Must be called on `stateQueue`.
+ */
+- (void)startScheduledOperation:(WPScheduledOperation *)scheduledOperation host:(WPSchedulerHostState *)host {
+    host.runningCount++;
+    [self.runningOperations addObject:scheduledOperation];
+
+    // Runs once the operation finishes, whatever the outcome
+    NSBlockOperation *completionOperation = [NSBlockOperation blockOperationWithBlock:^{
+        dispatch_async(self.stateQueue, ^{
+            [self scheduledOperationDidFinish:scheduledOperation];
+        });
+    }];
+    [completionOperation addDependency:scheduledOperation.operation];
+    [self.executionQueue addOperation:scheduledOperation.operation];
+    [self.executionQueue addOperation:completionOperation];
+}
+
+/**
+ Must be called on `stateQueue`.
+ */
+- (void)scheduledOperationDidFinish:(WPScheduledOperation *)scheduledOperation {
+    [self.runningOperations removeObject:scheduledOperation];
+    WPSchedulerHostState *host = [self stateForHost:scheduledOperation.host];
+    host.runningCount--;
+    if (scheduledOperation.host && !scheduledOperation.operation.isCancelled) {
+        [self adaptHost:host toScheduledOperation:scheduledOperation];
+    }
+    host.lastFinishTime = CFAbsoluteTimeGetCurrent();
+    [self pruneHosts];
+    [self startPendingOperations];
+}
+
+/**
+ Forgets the hosts with nothing running, once their limit is back to the maximum or they've been idle for a while.
+
+ Must be called on `stateQueue`.
+ */
+- (void)pruneHosts {
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    for (NSString *key in [self.hosts allKeys]) {
+        WPSchedulerHostState *host = self.hosts[key];
+        if (host.runningCount > 0) {
+            continue;
+        }
+        if (host.limit >= self.maximumConcurrentOperationsPerHost || now - host.lastFinishTime > WPRequestSchedulerHostStateLifetime) {
+            [self.hosts removeObjectForKey:key];
+        }
+    }
+}
+
+/**
+ Additive increase, multiplicative decrease: halve the limit when the host struggles, and grow it by one after a full round of healthy requests.
+
+ Only the outcome is considered, not how long the request took, as that mostly depends on the size of the request and response, and on the network.
+ */
+- (void)adaptHost:(WPSchedulerHostState *)host toScheduledOperation:(WPScheduledOperation *)scheduledOperation {
+    NSError *error = nil;
+    NSURLResponse *response = nil;
+    if ([scheduledOperation.operation isKindOfClass:[AFURLConnectionOperation class]]) {
+        AFURLConnectionOperation *operation = (AFURLConnectionOperation *)scheduledOperation.operation;
+        error = operation.error;
+        response = operation.response;
+    } else {
+        WPURLSessionTaskOperation *operation = (WPURLSessionTaskOperation *)scheduledOperation.operation;
+        error = operation.error;
+        response = operation.response;
+    }
+    NSInteger statusCode = [response isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse *)response statusCode] : 0;
+
+    BOOL struggling = statusCode == 429 || statusCode >= 500;
+    if ([error.domain isEqualToString:NSURLErrorDomain]) {
+        struggling = struggling
+            || error.code == NSURLErrorTimedOut
+            || error.code == NSURLErrorCannotConnectToHost
+            || error.code == NSURLErrorNetworkConnectionLost;
+    }
+
+    if (struggling) {
+        host.limit = MAX(host.limit / 2, 1);
+        host.healthyCount = 0;
+    } else if (++host.healthyCount >= host.limit) {
+        host.limit = MIN(host.limit + 1, self.maximumConcurrentOperationsPerHost);
+        host.healthyCount = 0;
+    }
+}
+
+@end
+
+@implementation WPRequestSchedulerQueue
+
+- (id)init {
+    return [self initWithScheduler:[WPRequestScheduler sharedScheduler]];
+}
+
+- (id)initWithScheduler:(WPRequestScheduler *)scheduler {
+    self = [super init];
+    if (self) {
+        _scheduler = scheduler;
+        _priority = WPRequestPriorityInteractive;
+    }
+    return self;
+}
+
+- (void)addOperation:(NSOperation *)operation {
+    [self.scheduler addOperation:operation priority:self.priority tag:self.tag owner:self];
+}
+
+- (void)addOperations:(NSArray *)operations waitUntilFinished:(BOOL)wait {
+    for (NSOperation *operation in operations) {
+        [self addOperation:operation];
+    }
+    if (wait) {
+        for (NSOperation *operation in operations) {
+            [operation waitUntilFinished];
+        }
+    }
+}
+
+- (void)addOperationWithBlock:(void (^)(void))block {
+    [self addOperation:[NSBlockOperation blockOperationWithBlock:block]];
+}
+
+- (BOOL)isSuspended {
+    return [self.scheduler operationsSuspendedForOwner:self];
+}
+
+- (void)setSuspended:(BOOL)suspended {
+    [self willChangeValueForKey:@"isSuspended"];
+    [self.scheduler setOperationsSuspended:suspended forOwner:self];
+    [self didChangeValueForKey:@"isSuspended"];
+}
+
+- (NSArray *)operations {
+    return [self.scheduler operationsForOwner:self];
+}
+
+- (NSUInteger)operationCount {
+    return [[self operations] count];
+}
+
+- (void)cancelAllOperations {
+    [self.scheduler cancelOperationsForOwner:self];
+}
+
+- (void)waitUntilAllOperationsAreFinished {
+    for (NSOperation *operation in [self operations]) {
+        [operation waitUntilFinished];
+    }
+}
+
+@end
@@ -0,0 +1,108 @@
+#import <Foundation/Foundation.h>
+
+/**
+ `WPCachedResponse` is a decoded response stored in a `WPResponseCache`, along with the validators needed to revalidate it.
+ */
+@interface WPCachedResponse : NSObject <NSCoding>
+
+/**
+ The decoded response object.
+ */
+@property (nonatomic, strong, readonly) id object;
+
+/**
+ When the response stops being fresh. Expired responses can still be revalidated.
+ */
+@property (nonatomic, strong, readonly) NSDate *expirationDate;
+
+/**
+ The value of the `ETag` header of the response, if any.
+ */
+@property (nonatomic, copy, readonly) NSString *ETag;
+
+/**
+ The value of the `Last-Modified` header of the response, if any.
+ */
+@property (nonatomic, copy, readonly) NSString *lastModified;
+
+/**
+ `YES` if the response is past its expiration date.
+ */
+- (BOOL)isExpired;
+
+@end
+
+/**
+ `WPResponseCache` keeps decoded responses from read calls, so they can be returned without going to the network.
+
+ Responses are kept in memory and on disk, keyed by endpoint, method and parameters. Only methods with a time to live are cached.
+ The cache keeps an immutable deep copy of each response, shared by every caller it's returned to, so a caller changing the object it got from the network can't change what the cache returns.
+ */
+@interface WPResponseCache : NSObject
+
+/**
+ A cache shared by all the API clients, stored in the application's Caches directory.
+ */
++ (WPResponseCache *)sharedCache;
+
+/**
+ Initializes a cache stored in a directory with the specified name inside the application's Caches directory.
+
+ By default, the following methods are cached: `wp.getOptions` and `wp.getUsersBlogs` for an hour, `metaWeblog.getRecentPosts`, `wp.getPosts` and the REST `posts` path for 5 minutes.
+
+ @param name The name of the cache.
+
+ @return The newly-initialized cache
+ */
+- (id)initWithName:(NSString *)name;
+
+/**
+ Sets how long responses for a method are considered fresh. A time to live of `0` disables caching for the method.
+
+ @param timeToLive The time to live, in seconds.
+ @param method The XML-RPC method name, or the REST path relative to the site (e.g. `posts`).
+ */
+- (void)setTimeToLive:(NSTimeInterval)timeToLive forMethod:(NSString *)method;
+
+/**
+ Returns how long responses for a method are considered fresh, or `0` if the method is not cached.
+ */
+- (NSTimeInterval)timeToLiveForMethod:(NSString *)method;
+
+/**
+ Returns the key identifying a call. Keys don't depend on the cache, so the class method can be used to identify calls without one.
+
+ @param endpoint The XML-RPC endpoint or REST base URL.
+ @param method The XML-RPC method name, or the REST path.
+ @param parameters The call parameters.
+ */
+- (NSString *)keyForEndpoint:(NSURL *)endpoint method:(NSString *)method parameters:(id)parameters;
++ (NSString *)keyForEndpoint:(NSURL *)endpoint method:(NSString *)method parameters:(id)parameters;
+
+/**
+ Returns the cached response for a key, from memory or disk, or `nil`. The response might be expired.
+ */
+- (WPCachedResponse *)cachedResponseForKey:(NSString *)key;
+
+/**
+ Stores an immutable deep copy of a decoded response.
+
+ @param object The decoded response object. It isn't kept, so the caller can still change it.
+ @param key The key for the call, from `keyForEndpoint:method:parameters:`.
+ @param method The method, used to look up the time to live.
+ @param ETag The `ETag` of the response, if any.
+ @param lastModified The `Last-Modified` date of the response, if any.
+ */
+- (void)storeObject:(id)object forKey:(NSString *)key method:(NSString *)method ETag:(NSString *)ETag lastModified:(NSString *)lastModified;
+
+/**
+ Removes all the cached responses for an endpoint, e.g. after publishing a post.
+ */
+- (void)removeObjectsForEndpoint:(NSURL *)endpoint;
+
+/**
+ Removes all the cached responses.
+ */
+- (void)removeAllObjects;
+
+@end
@@ -0,0 +1,257 @@
+#import "WPResponseCache.h"
+
+#import <CommonCrypto/CommonDigest.h>
+#import "WPInFlightRequests.h"
+
+static NSTimeInterval const WPResponseCacheOptionsTimeToLive = 60 * 60;
+static NSTimeInterval const WPResponseCachePostsTimeToLive = 5 * 60;
+
+@interface WPCachedResponse ()
+@property (nonatomic, strong, readwrite) id object;
+@property (nonatomic, strong, readwrite) NSDate *expirationDate;
+@property (nonatomic, copy, readwrite) NSString *ETag;
+@property (nonatomic, copy, readwrite) NSString *lastModified;
+@end
+
+@implementation WPCachedResponse
+
+- (BOOL)isExpired {
+    return [self.expirationDate timeIntervalSinceNow] <= 0;
+}
+
+#pragma mark - NSCoding
+
+- (id)initWithCoder:(NSCoder *)aDecoder {
+    self = [super init];
+    if (self) {
+        _object = [aDecoder decodeObjectForKey:@"object"];
+        _expirationDate = [aDecoder decodeObjectForKey:@"expirationDate"];
+        _ETag = [aDecoder decodeObjectForKey:@"ETag"];
+        _lastModified = [aDecoder decodeObjectForKey:@"lastModified"];
+    }
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+    [aCoder encodeObject:self.object forKey:@"object"];
+    [aCoder encodeObject:self.expirationDate forKey:@"expirationDate"];
+    [aCoder encodeObject:self.ETag forKey:@"ETag"];
+    [aCoder encodeObject:self.lastModified forKey:@"lastModified"];
+}
+
+@end
+
+@interface WPResponseCache ()
+@property (nonatomic, strong) NSCache *memoryCache;
+// Keys of the responses put in memory, by endpoint hash, since NSCache can't be enumerated
+@property (nonatomic, strong) NSMutableDictionary *memoryKeysByEndpoint;
+@property (nonatomic, strong) NSMutableDictionary *timesToLive;
+@property (nonatomic, copy) NSString *directoryPath;
+@property (nonatomic, strong) dispatch_queue_t diskQueue;
+@end
+
+@implementation WPResponseCache
+
++ (WPResponseCache *)sharedCache {
+    static WPResponseCache *sharedCache;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedCache = [[self alloc] initWithName:@"WPResponseCache"];
+    });
+    return sharedCache;
+}
+
+- (id)initWithName:(NSString *)name {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+
+    NSString *cachesPath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+    self.directoryPath = [cachesPath stringByAppendingPathComponent:name];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directoryPath withIntermediateDirectories:YES attributes:nil error:nil];
+
+    self.memoryCache = [[NSCache alloc] init];
+    self.memoryCache.name = name;
+    self.memoryKeysByEndpoint = [NSMutableDictionary dictionary];
+    self.diskQueue = dispatch_queue_create("org.wordpress.responsecache.disk", DISPATCH_QUEUE_SERIAL);
+
+    self.timesToLive = [NSMutableDictionary dictionary];
+    [self setTimeToLive:WPResponseCacheOptionsTimeToLive forMethod:@"wp.getOptions"];
+    [self setTimeToLive:WPResponseCacheOptionsTimeToLive forMethod:@"wp.getUsersBlogs"];
+    [self setTimeToLive:WPResponseCachePostsTimeToLive forMethod:@"metaWeblog.getRecentPosts"];
+    [self setTimeToLive:WPResponseCachePostsTimeToLive forMethod:@"wp.getPosts"];
+    [self setTimeToLive:WPResponseCachePostsTimeToLive forMethod:@"posts"];
+
+    return self;
+}
+
+#pragma mark - Configuration
+
+- (void)setTimeToLive:(NSTimeInterval)timeToLive forMethod:(NSString *)method {
+    @synchronized(self.timesToLive) {
+        if (timeToLive > 0) {
+            self.timesToLive[method] = @(timeToLive);
+        } else {
+            [self.timesToLive removeObjectForKey:method];
+        }
+    }
+}
+
+- (NSTimeInterval)timeToLiveForMethod:(NSString *)method {
+    if (!method) {
+        return 0;
+    }
+    @synchronized(self.timesToLive) {
+        return [self.timesToLive[method] doubleValue];
+    }
+}
+
+#pragma mark - Keys
+
+- (NSString *)keyForEndpoint:(NSURL *)endpoint method:(NSString *)method parameters:(id)parameters {
+    return [[self class] keyForEndpoint:endpoint method:method parameters:parameters];
+}
+
++ (NSString *)keyForEndpoint:(NSURL *)endpoint method:(NSString *)method parameters:(id)parameters {
+    NSMutableString *call = [NSMutableString stringWithString:method ?: @""];
+    [self appendCanonicalDescriptionOfObject:parameters toString:call];
+    // The endpoint is hashed separately, so all the responses for an endpoint can be found by prefix
+    return [NSString stringWithFormat:@"%@-%@", [self hashForString:[endpoint absoluteString]], [self hashForString:call]];
+}
+
++ (void)appendCanonicalDescriptionOfObject:(id)object toString:(NSMutableString *)string {
+    if ([object isKindOfClass:[NSDictionary class]]) {
+        [string appendString:@"{"];
+        for (id key in [[object allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+            [string appendFormat:@"%@=", key];
+            [self appendCanonicalDescriptionOfObject:[object objectForKey:key] toString:string];
+            [string appendString:@";"];
+        }
+        [string appendString:@"}"];
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        [string appendString:@"["];
+        for (id element in object) {
+            [self appendCanonicalDescriptionOfObject:element toString:string];
+            [string appendString:@","];
+        }
+        [string appendString:@"]"];
+    } else if (object) {
+        [string appendFormat:@"%@:%@", NSStringFromClass([object class]), object];
+    }
+}
+
++ (NSString *)hashForString:(NSString *)string {
+    NSData *data = [string ?: @"" dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+    CC_SHA1([data bytes], (CC_LONG)[data length], digest);
+    NSMutableString *hash = [NSMutableString stringWithCapacity:CC_SHA1_DIGEST_LENGTH * 2];
+    for (NSUInteger i = 0; i < CC_SHA1_DIGEST_LENGTH; i++) {
+        [hash appendFormat:@"%02x", digest[i]];
+    }
+    return hash;
+}
+
+#pragma mark - Reading and writing
+
+- (WPCachedResponse *)cachedResponseForKey:(NSString *)key {
+    WPCachedResponse *response = [self.memoryCache objectForKey:key];
+    if (response) {
+        return response;
+    }
+
+    __block NSData *data = nil;
+    dispatch_sync(self.diskQueue, ^{
+        data = [NSData dataWithContentsOfFile:[self pathForKey:key]];
+    });
+    if (!data) {
+        return nil;
+    }
+    @try {
+        response = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+    }
+    @catch (NSException *exception) {
+        response = nil;
+    }
+    if (![response isKindOfClass:[WPCachedResponse class]]) {
+        return nil;
+    }
+    [self setMemoryObject:response forKey:key];
+    return response;
+}
+
+- (void)storeObject:(id)object forKey:(NSString *)key method:(NSString *)method ETag:(NSString *)ETag lastModified:(NSString *)lastModified {
+    NSTimeInterval timeToLive = [self timeToLiveForMethod:method];
+    if (!object || !key || timeToLive <= 0) {
+        return;
+    }
+
+    WPCachedResponse *response = [[WPCachedResponse alloc] init];
+    // The caller keeps the object it was given, which it may change
+    response.object = WPImmutableResponseObject(object);
+    response.expirationDate = [NSDate dateWithTimeIntervalSinceNow:timeToLive];
+    response.ETag = ETag;
+    response.lastModified = lastModified;
+    [self setMemoryObject:response forKey:key];
+
+    dispatch_async(self.diskQueue, ^{
+        NSData *data = [NSKeyedArchiver archivedDataWithRootObject:response];
+        [data writeToFile:[self pathForKey:key] options:NSDataWritingAtomic error:nil];
+    });
+}
+
+- (void)removeObjectsForEndpoint:(NSURL *)endpoint {
+    NSString *endpointHash = [[self class] hashForString:[endpoint absoluteString]];
+    NSString *prefix = [endpointHash stringByAppendingString:@"-"];
+    NSSet *memoryKeys = nil;
+    @synchronized(self.memoryKeysByEndpoint) {
+        memoryKeys = self.memoryKeysByEndpoint[endpointHash];
+        [self.memoryKeysByEndpoint removeObjectForKey:endpointHash];
+    }
+    for (NSString *key in memoryKeys) {
+        [self.memoryCache removeObjectForKey:key];
+    }
+    dispatch_async(self.diskQueue, ^{
+        NSFileManager *fileManager = [NSFileManager defaultManager];
+        for (NSString *fileName in [fileManager contentsOfDirectoryAtPath:self.directoryPath error:nil]) {
+            if ([fileName hasPrefix:prefix]) {
+                [fileManager removeItemAtPath:[self.directoryPath stringByAppendingPathComponent:fileName] error:nil];
+            }
+        }
+    });
+}
+
+- (void)removeAllObjects {
+    @synchronized(self.memoryKeysByEndpoint) {
+        [self.memoryKeysByEndpoint removeAllObjects];
+    }
+    [self.memoryCache removeAllObjects];
+    dispatch_async(self.diskQueue, ^{
+        NSFileManager *fileManager = [NSFileManager defaultManager];
+        for (NSString *fileName in [fileManager contentsOfDirectoryAtPath:self.directoryPath error:nil]) {
+            [fileManager removeItemAtPath:[self.directoryPath stringByAppendingPathComponent:fileName] error:nil];
+        }
+    });
+}
+
+- (void)setMemoryObject:(WPCachedResponse *)response forKey:(NSString *)key {
+    NSRange separator = [key rangeOfString:@"-"];
+    if (separator.location != NSNotFound) {
+        NSString *endpointHash = [key substringToIndex:separator.location];
+        @synchronized(self.memoryKeysByEndpoint) {
+            NSMutableSet *keys = self.memoryKeysByEndpoint[endpointHash];
+            if (!keys) {
+                keys = [NSMutableSet set];
+                self.memoryKeysByEndpoint[endpointHash] = keys;
+            }
+            [keys addObject:key];
+        }
+    }
+    [self.memoryCache setObject:response forKey:key];
+}
+
+- (NSString *)pathForKey:(NSString *)key {
+    return [self.directoryPath stringByAppendingPathComponent:key];
+}
+
+@end
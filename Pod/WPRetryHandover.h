@@ -0,0 +1,27 @@
+#import <Foundation/Foundation.h>
+
+/**
+ `WPRetryHandover` keeps what an operation hands over to the operation retrying its request: a cancellation, and the upload progress block.
+
+ Operations which can be retried own one, and forward their `cancel`, `setUploadProgressBlock:` and `continueWithRetryOperation:` to it. It's safe to use from any thread.
+ */
+@interface WPRetryHandover : NSObject
+
+/**
+ Remembers the upload progress block of the operation, to set it on the retry if it's an `AFURLConnectionOperation`.
+ */
+- (void)setUploadProgressBlock:(void (^)(NSUInteger bytesWritten, long long totalBytesWritten, long long totalBytesExpectedToWrite))block;
+
+/**
+ Cancels the retry, if there's one already, or remembers the cancellation for the one to come.
+ */
+- (void)cancel;
+
+/**
+ Hands over to an operation sending the same request again.
+
+ @return `NO` if the operation was cancelled, in which case the retry shouldn't be enqueued.
+ */
+- (BOOL)continueWithRetryOperation:(NSOperation *)retryOperation;
+
+@end
@@ -0,0 +1,44 @@
+#import "WPRetryHandover.h"
+
+#import <AFNetworking/AFURLConnectionOperation.h>
+
+@interface WPRetryHandover ()
+@property (nonatomic, copy) void (^uploadProgressBlock)(NSUInteger bytes, long long totalBytes, long long totalBytesExpected);
+@property (nonatomic, strong) NSOperation *retryOperation;
+@property (nonatomic, assign) BOOL cancelRequested;
+@end
+
+@implementation WPRetryHandover
+
+- (void)setUploadProgressBlock:(void (^)(NSUInteger bytesWritten, long long totalBytesWritten, long long totalBytesExpectedToWrite))block {
+    @synchronized(self) {
+        _uploadProgressBlock = [block copy];
+    }
+}
+
+- (void)cancel {
+    NSOperation *retryOperation = nil;
+    @synchronized(self) {
+        // Finished operations ignore cancel, so it's remembered for a retry that hasn't been handed over yet
+        self.cancelRequested = YES;
+        retryOperation = self.retryOperation;
+    }
+    [retryOperation cancel];
+}
+
+- (BOOL)continueWithRetryOperation:(NSOperation *)retryOperation {
+    void (^uploadProgressBlock)(NSUInteger, long long, long long) = nil;
+    @synchronized(self) {
+        if (self.cancelRequested) {
+            return NO;
+        }
+        self.retryOperation = retryOperation;
+        uploadProgressBlock = self.uploadProgressBlock;
+    }
+    if (uploadProgressBlock && [retryOperation isKindOfClass:[AFURLConnectionOperation class]]) {
+        [(AFURLConnectionOperation *)retryOperation setUploadProgressBlock:uploadProgressBlock];
+    }
+    return YES;
+}
+
+@end
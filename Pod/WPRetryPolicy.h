@@ -0,0 +1,109 @@
+#import <Foundation/Foundation.h>
+
+/**
+ `WPRetryPolicy` decides when a failed request is sent again, and how long to wait before doing it.
+
+ Only transient failures are retried: timeouts, lost or refused connections, and `408`, `429`, `500`, `502`, `503` and `504` responses. Requests that aren't idempotent, like `wp.newPost`, are only retried when the failure shows the server never got them: the host couldn't be found or reached, or it answered `429`.
+
+ Delays grow exponentially from `baseDelay` up to `maximumDelay`, with full jitter, so clients that failed together don't retry together. A `Retry-After` header takes precedence.
+
+ Retries are limited by a budget shared by every request using the policy: each retry spends one token, each success earns back a fraction of one. When a host is down, this stops retries from multiplying the load once the budget is spent.
+
+ A policy is safe to use from any thread.
+ */
+@interface WPRetryPolicy : NSObject
+
+/**
+ A policy with the default settings.
+ */
++ (WPRetryPolicy *)defaultPolicy;
+
+/**
+ The maximum number of times a request is sent again after the first attempt. Defaults to `3`.
+ */
+@property (nonatomic, assign) NSUInteger maximumRetryCount;
+
+/**
+ The delay before the first retry, before jitter. Defaults to `1` second.
+ */
+@property (nonatomic, assign) NSTimeInterval baseDelay;
+
+/**
+ The longest delay before a retry, including the one asked for with `Retry-After`. Defaults to `30` seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval maximumDelay;
+
+/**
+ The maximum number of retry tokens. The budget starts full. Defaults to `10`.
+ */
+@property (nonatomic, assign) double retryBudget;
+
+/**
+ The fraction of a token earned back by each successful request. Defaults to `0.1`, so one retry is allowed for every ten successes once the budget is spent.
+ */
+@property (nonatomic, assign) double successRefill;
+
+///-------------------------------------
+/// @name Classifying XML-RPC Methods
+///-------------------------------------
+
+/**
+ Returns whether sending a XML-RPC call twice has the same effect as sending it once.
+
+ By default, methods starting with `wp.get`, `metaWeblog.get`, `blogger.get` and `mt.get`, and `system.listMethods`, are idempotent.
+ */
+- (BOOL)isIdempotentMethod:(NSString *)method;
+
+/**
+ Overrides whether a XML-RPC method is idempotent, e.g. for a plugin method which is safe to send again.
+ */
+- (void)setIdempotent:(BOOL)idempotent forMethod:(NSString *)method;
+
+///-------------------------------------
+/// @name Classifying Failures
+///-------------------------------------
+
+/**
+ Returns whether a failure is transient, so the same request could succeed later: timeouts, lost or refused connections, and `408`, `429`, `500`, `502`, `503` and `504` responses.
+
+ @param error The error the request failed with.
+ @param response The response received, if any.
+ */
+- (BOOL)isTransientError:(NSError *)error response:(NSHTTPURLResponse *)response;
+
+/**
+ Returns whether a failure shows the server never processed the request: the host couldn't be found or reached, or it answered `429`. Requests failing this way are safe to send again even if they aren't idempotent.
+
+ @param error The error the request failed with.
+ @param response The response received, if any.
+ */
+- (BOOL)isUnsentRequestError:(NSError *)error response:(NSHTTPURLResponse *)response;
+
+///-------------------------------------
+/// @name Deciding on Retries
+///-------------------------------------
+
+/**
+ Returns whether a failed request should be sent again. If it should, a token is taken from the budget.
+
+ @param idempotent Whether the request can be sent twice safely.
+ @param response The response received, if any.
+ @param error The error the request failed with.
+ @param attempt The number of retries already made for the request, `0` after the first failure.
+ */
+- (BOOL)shouldRetryIdempotent:(BOOL)idempotent response:(NSHTTPURLResponse *)response error:(NSError *)error attempt:(NSUInteger)attempt;
+
+/**
+ Returns how long to wait before a retry.
+
+ @param attempt The number of retries already made for the request.
+ @param response The response received, if any. Its `Retry-After` header is honoured, up to `maximumDelay`.
+ */
+- (NSTimeInterval)delayBeforeRetryAttempt:(NSUInteger)attempt response:(NSHTTPURLResponse *)response;
+
+/**
+ Tells the policy a request succeeded, earning back part of a token.
+ */
+- (void)requestDidSucceed;
+
+@end
@@ -0,0 +1,170 @@
+#import "WPRetryPolicy.h"
+
+static NSUInteger const WPRetryPolicyDefaultMaximumRetryCount = 3;
+static NSTimeInterval const WPRetryPolicyDefaultBaseDelay = 1;
+static NSTimeInterval const WPRetryPolicyDefaultMaximumDelay = 30;
+static double const WPRetryPolicyDefaultRetryBudget = 10;
+static double const WPRetryPolicyDefaultSuccessRefill = 0.1;
+
+@interface WPRetryPolicy ()
+@property (nonatomic, assign) double availableTokens;
+@property (nonatomic, strong) NSMutableDictionary *idempotencyOverrides;
+@end
+
+@implementation WPRetryPolicy
+
++ (WPRetryPolicy *)defaultPolicy {
+    return [[self alloc] init];
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _maximumRetryCount = WPRetryPolicyDefaultMaximumRetryCount;
+        _baseDelay = WPRetryPolicyDefaultBaseDelay;
+        _maximumDelay = WPRetryPolicyDefaultMaximumDelay;
+        _retryBudget = WPRetryPolicyDefaultRetryBudget;
+        _successRefill = WPRetryPolicyDefaultSuccessRefill;
+        _availableTokens = WPRetryPolicyDefaultRetryBudget;
+        _idempotencyOverrides = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)setRetryBudget:(double)retryBudget {
+    @synchronized(self) {
+        _retryBudget = retryBudget;
+        self.availableTokens = MIN(self.availableTokens, retryBudget);
+    }
+}
+
+#pragma mark - Classifying XML-RPC Methods
+
+- (BOOL)isIdempotentMethod:(NSString *)method {
+    if (!method) {
+        return NO;
+    }
+    @synchronized(self) {
+        NSNumber *idempotent = self.idempotencyOverrides[method];
+        if (idempotent) {
+            return [idempotent boolValue];
+        }
+    }
+    for (NSString *prefix in @[@"wp.get", @"metaWeblog.get", @"blogger.get", @"mt.get"]) {
+        if ([method hasPrefix:prefix]) {
+            return YES;
+        }
+    }
+    return [method isEqualToString:@"system.listMethods"];
+}
+
+- (void)setIdempotent:(BOOL)idempotent forMethod:(NSString *)method {
+    @synchronized(self) {
+        self.idempotencyOverrides[method] = @(idempotent);
+    }
+}
+
+#pragma mark - Deciding on Retries
+
+- (BOOL)shouldRetryIdempotent:(BOOL)idempotent response:(NSHTTPURLResponse *)response error:(NSError *)error attempt:(NSUInteger)attempt {
+    if (attempt >= self.maximumRetryCount) {
+        return NO;
+    }
+    BOOL retryable = idempotent ? [self isTransientError:error response:response] : [self isUnsentRequestError:error response:response];
+    if (!retryable) {
+        return NO;
+    }
+    @synchronized(self) {
+        if (self.availableTokens < 1) {
+            return NO;
+        }
+        self.availableTokens -= 1;
+    }
+    return YES;
+}
+
+- (NSTimeInterval)delayBeforeRetryAttempt:(NSUInteger)attempt response:(NSHTTPURLResponse *)response {
+    NSTimeInterval retryAfter = [self retryAfterIntervalForResponse:response];
+    if (retryAfter > 0) {
+        return MIN(retryAfter, self.maximumDelay);
+    }
+    // Full jitter: anywhere between no delay and the exponential backoff
+    NSTimeInterval backoff = MIN(self.baseDelay * pow(2, MIN(attempt, 16)), self.maximumDelay);
+    return backoff * ((double)arc4random_uniform(1001) / 1000.0);
+}
+
+- (void)requestDidSucceed {
+    @synchronized(self) {
+        self.availableTokens = MIN(self.availableTokens + self.successRefill, self.retryBudget);
+    }
+}
+
+#pragma mark - Classifying Failures
+
+- (BOOL)isTransientError:(NSError *)error response:(NSHTTPURLResponse *)response {
+    if ([self isUnsentRequestError:error response:response]) {
+        return YES;
+    }
+    if ([error.domain isEqualToString:NSURLErrorDomain]) {
+        switch (error.code) {
+            case NSURLErrorTimedOut:
+            case NSURLErrorNetworkConnectionLost:
+                return YES;
+        }
+    }
+    switch (response.statusCode) {
+        case 408:
+        case 500:
+        case 502:
+        case 503:
+        case 504:
+            return YES;
+    }
+    return NO;
+}
+
+- (BOOL)isUnsentRequestError:(NSError *)error response:(NSHTTPURLResponse *)response {
+    if (response.statusCode == 429) {
+        return YES;
+    }
+    if (response == nil && [error.domain isEqualToString:NSURLErrorDomain]) {
+        switch (error.code) {
+            case NSURLErrorCannotFindHost:
+            case NSURLErrorCannotConnectToHost:
+            case NSURLErrorDNSLookupFailed:
+            case NSURLErrorNotConnectedToInternet:
+                return YES;
+        }
+    }
+    return NO;
+}
+
+#pragma mark - Private Methods
+
+- (NSTimeInterval)retryAfterIntervalForResponse:(NSHTTPURLResponse *)response {
+    NSString *retryAfter = [[response allHeaderFields] objectForKey:@"Retry-After"];
+    if ([retryAfter length] == 0) {
+        return 0;
+    }
+    NSScanner *scanner = [NSScanner scannerWithString:retryAfter];
+    NSInteger seconds = 0;
+    if ([scanner scanInteger:&seconds] && [scanner isAtEnd]) {
+        return MAX(seconds, 0);
+    }
+
+    static NSDateFormatter *formatter;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        formatter = [[NSDateFormatter alloc] init];
+        formatter.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+        formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+        formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss zzz";
+    });
+    NSDate *date = nil;
+    @synchronized(formatter) {
+        date = [formatter dateFromString:retryAfter];
+    }
+    return MAX([date timeIntervalSinceNow], 0);
+}
+
+@end
@@ -0,0 +1,128 @@
+#import <Foundation/Foundation.h>
+
+@class AFURLSessionManager, WPURLSessionTaskOperation, WPRequestMetrics;
+
+/**
+ `WPURLSessionTransport` sends requests with `NSURLSession` instead of `NSURLConnection` operations.
+
+ Hosts are grouped in families by their registrable domain (e.g. every `*.wordpress.com` site, or every `*.example.co.uk` site), and each family shares a session, so connections are kept alive and reused between clients, and multiplexed over HTTP/2 when the server supports it.
+
+ Uploads from a file can be handed to a background session, which keeps transferring while the app is suspended. Apps using it must forward `application:handleEventsForBackgroundURLSession:completionHandler:` to `handleEventsForBackgroundURLSession:completionHandler:`.
+
+ Server trust and credential challenges are handled as `WPHTTPRequestOperation` does, through `WPHTTPAuthenticationAlertController`: invalid certificates are asked to the user unless they already trusted that same certificate, unknown credentials are asked to the user, and stored credentials are used otherwise.
+ */
+@interface WPURLSessionTransport : NSObject
+
+/**
+ The transport used by clients unless another one is set.
+ */
++ (WPURLSessionTransport *)sharedTransport;
+
+/**
+ Returns the family a host belongs to, which decides the session used for it.
+
+ The family is the registrable domain: the last two labels, or three under a country code second-level domain like `co.uk`, `com.au` or `co.jp`, so unrelated sites under those don't share a session. IP addresses and single-label hosts are their own family.
+ */
++ (NSString *)hostFamilyForURL:(NSURL *)URL;
+
+/**
+ The maximum number of connections open at the same time to a single host. Only applies to sessions created after it's set. Defaults to `4`.
+ */
+@property (nonatomic, assign) NSUInteger maximumConnectionsPerHost;
+
+/**
+ The identifier of the background session. It must be set before the first background upload. Defaults to `org.wordpress.api.background`.
+ */
+@property (nonatomic, copy) NSString *backgroundSessionIdentifier;
+
+/**
+ A block called when a background upload started in a previous launch of the app finishes, identified by its task description. Called on the main queue.
+ */
+@property (nonatomic, copy) void (^backgroundTaskDidCompleteBlock)(NSURLSessionTask *task, NSError *error);
+
+/**
+ Returns the session manager shared by the hosts in the same family as `URL`.
+ */
+- (AFURLSessionManager *)sessionManagerForURL:(NSURL *)URL;
+
+/**
+ Creates and resumes a data task.
+
+ @param request The request to send.
+ @param priority The priority of the task, between `NSURLSessionTaskPriorityLow` and `NSURLSessionTaskPriorityHigh`.
+ @param completionHandler A block called on the main queue when the task finishes, with the response, the response body and any error. Responses with a status code outside `2xx` finish with an error.
+ */
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
+                                     priority:(float)priority
+                            completionHandler:(void (^)(NSHTTPURLResponse *response, NSData *data, NSError *error))completionHandler;
+
+/**
+ Creates an operation sending a request with a data task once it's started, to be scheduled with the other operations.
+
+ @param request The request to send.
+ @param priority The priority of the task, between `NSURLSessionTaskPriorityLow` and `NSURLSessionTaskPriorityHigh`.
+ @param completionHandler A block called on the main queue when the task finishes, or when the operation is cancelled before it started, with the response, the response body and any error. Responses with a status code outside `2xx` finish with an error.
+ */
+- (WPURLSessionTaskOperation *)dataTaskOperationWithRequest:(NSURLRequest *)request
+                                                   priority:(float)priority
+                                          completionHandler:(void (^)(NSHTTPURLResponse *response, NSData *data, NSError *error))completionHandler;
+
+/**
+ Creates and resumes an upload task in the background session, with the body read from a file.
+
+ The file must not be removed until the task finishes. If the app is relaunched before that, `completionHandler` and `progress` are lost and `backgroundTaskDidCompleteBlock` is called instead.
+
+ @param request The request to send. Its body is ignored.
+ @param fileURL The file with the request body.
+ @param progress A block called on the main queue as the body is sent, with the bytes sent so far and the total. Can be `nil`.
+ @param completionHandler A block called on the main queue when the task finishes, with the response, the response body and any error.
+ */
+- (NSURLSessionUploadTask *)backgroundUploadTaskWithRequest:(NSURLRequest *)request
+                                                   fromFile:(NSURL *)fileURL
+                                                   progress:(void (^)(int64_t totalBytesSent, int64_t totalBytesExpectedToSend))progress
+                                          completionHandler:(void (^)(NSHTTPURLResponse *response, NSData *data, NSError *error))completionHandler;
+
+/**
+ Reconnects to the background session when the system relaunches the app for it.
+
+ @return `YES` if the identifier belongs to this transport, in which case `completionHandler` is called once all the events have been delivered.
+ */
+- (BOOL)handleEventsForBackgroundURLSession:(NSString *)identifier completionHandler:(void (^)())completionHandler;
+
+@end
+
+/**
+ `WPURLSessionTaskOperation` sends a request with a data task of a `WPURLSessionTransport` when it's started, so session requests are scheduled, limited per host, tagged and cancelled like the other operations.
+
+ The operation finishes when the task does. Cancelling it cancels the task.
+ */
+@interface WPURLSessionTaskOperation : NSOperation
+
+/**
+ The request sent.
+ */
+@property (readonly, nonatomic, strong) NSURLRequest *request;
+
+/**
+ If set, told when the operation starts, so the time spent waiting for the scheduler isn't counted.
+ */
+@property (nonatomic, strong) WPRequestMetrics *metrics;
+
+/**
+ The response received, once the operation is finished.
+ */
+@property (readonly, nonatomic, strong) NSHTTPURLResponse *response;
+
+/**
+ The error the task failed with, once the operation is finished.
+ */
+@property (readonly, nonatomic, strong) NSError *error;
+
+/**
+ Hands over to an operation sending the same request again, after this one failed. Cancelling this operation cancels the retry too.
+
+ @return `NO` if this operation was cancelled, in which case the retry shouldn't be enqueued.
+ */
+- (BOOL)continueWithRetryOperation:(NSOperation *)retryOperation;
+
+@end
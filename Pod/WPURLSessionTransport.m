@@ -0,0 +1,392 @@
+#import "WPURLSessionTransport.h"
+
+#import <AFNetworking/AFNetworking.h>
+#import "WPHTTPAuthenticationAlertController.h"
+#import "WPRetryHandover.h"
+#import "WPRequestMetrics.h"
+
+static NSUInteger const WPURLSessionTransportDefaultMaximumConnectionsPerHost = 4;
+static NSString *const WPURLSessionTransportDefaultBackgroundSessionIdentifier = @"org.wordpress.api.background";
+
+typedef void (^WPURLSessionTaskCompletionHandler)(NSHTTPURLResponse *response, NSData *data, NSError *error);
+typedef void (^WPURLSessionChallengeCompletionHandler)(NSURLSessionAuthChallengeDisposition disposition, NSURLCredential *credential);
+
+#pragma mark - WPURLSessionManager
+
+/**
+ A session manager answering authentication challenges the way `WPHTTPRequestOperation` does.
+ */
+@interface WPURLSessionManager : AFURLSessionManager
+@end
+
+@implementation WPURLSessionManager
+
+- (void)URLSession:(NSURLSession *)session
+didReceiveChallenge:(NSURLAuthenticationChallenge *)challenge
+ completionHandler:(WPURLSessionChallengeCompletionHandler)completionHandler
+{
+    [self handleChallenge:challenge completionHandler:completionHandler];
+}
+
+- (void)URLSession:(NSURLSession *)session
+              task:(NSURLSessionTask *)task
+didReceiveChallenge:(NSURLAuthenticationChallenge *)challenge
+ completionHandler:(WPURLSessionChallengeCompletionHandler)completionHandler
+{
+    [self handleChallenge:challenge completionHandler:completionHandler];
+}
+
+- (void)handleChallenge:(NSURLAuthenticationChallenge *)challenge completionHandler:(WPURLSessionChallengeCompletionHandler)completionHandler
+{
+	if ([challenge.protectionSpace.authenticationMethod isEqualToString:NSURLAuthenticationMethodServerTrust]) {
+		// Handle invalid certificates
+		SecTrustResultType result;
+		OSStatus certificateStatus = SecTrustEvaluate(challenge.protectionSpace.serverTrust, &result);
+		if (certificateStatus == 0 && result == kSecTrustResultRecoverableTrustFailure) {
+			dispatch_async(dispatch_get_main_queue(), ^(void) {
+                [WPHTTPAuthenticationAlertController presentWithChallenge:challenge completionHandler:completionHandler];
+			});
+		} else {
+			completionHandler(NSURLSessionAuthChallengePerformDefaultHandling, nil);
+		}
+    } else if ([challenge.protectionSpace.authenticationMethod isEqualToString:NSURLAuthenticationMethodClientCertificate]) {
+        completionHandler(NSURLSessionAuthChallengePerformDefaultHandling, nil);
+	} else {
+		NSURLCredential *credential = [[NSURLCredentialStorage sharedCredentialStorage] defaultCredentialForProtectionSpace:[challenge protectionSpace]];
+
+		if ([challenge previousFailureCount] == 0 && credential) {
+			completionHandler(NSURLSessionAuthChallengeUseCredential, credential);
+		} else {
+			dispatch_async(dispatch_get_main_queue(), ^(void) {
+                [WPHTTPAuthenticationAlertController presentWithChallenge:challenge completionHandler:completionHandler];
+			});
+		}
+	}
+}
+
+@end
+
+#pragma mark - WPURLSessionTaskOperation
+
+@interface WPURLSessionTaskOperation ()
+@property (nonatomic, weak) WPURLSessionTransport *transport;
+@property (nonatomic, assign) float priority;
+@property (nonatomic, copy) WPURLSessionTaskCompletionHandler completionHandler;
+@property (readwrite, nonatomic, strong) NSURLRequest *request;
+@property (readwrite, nonatomic, strong) NSHTTPURLResponse *response;
+@property (readwrite, nonatomic, strong) NSError *error;
+@property (nonatomic, strong) NSURLSessionDataTask *task;
+@property (nonatomic, strong) WPRetryHandover *retryHandover;
+@property (nonatomic, assign, getter=isExecuting) BOOL executing;
+@property (nonatomic, assign, getter=isFinished) BOOL finished;
+@end
+
+@implementation WPURLSessionTaskOperation
+
+@synthesize executing = _executing;
+@synthesize finished = _finished;
+
+- (id)initWithTransport:(WPURLSessionTransport *)transport request:(NSURLRequest *)request priority:(float)priority completionHandler:(WPURLSessionTaskCompletionHandler)completionHandler
+{
+    self = [super init];
+    if (self) {
+        _transport = transport;
+        _request = request;
+        _priority = priority;
+        _completionHandler = [completionHandler copy];
+        _retryHandover = [[WPRetryHandover alloc] init];
+    }
+    return self;
+}
+
+- (BOOL)isAsynchronous
+{
+    return YES;
+}
+
+- (BOOL)isConcurrent
+{
+    return YES;
+}
+
+- (void)start
+{
+    @synchronized(self) {
+        if (self.finished || self.executing) {
+            return;
+        }
+        [self willChangeValueForKey:@"isExecuting"];
+        _executing = YES;
+        [self didChangeValueForKey:@"isExecuting"];
+    }
+    [self.metrics operationDidStart];
+    if (self.isCancelled || !self.transport) {
+        NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self finishWithResponse:nil data:nil error:error];
+        });
+        return;
+    }
+
+    AFURLSessionManager *manager = [self.transport sessionManagerForURL:self.request.URL];
+    NSURLSessionDataTask *task = [manager dataTaskWithRequest:self.request completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+        [self finishWithResponse:(NSHTTPURLResponse *)response data:responseObject error:error];
+    }];
+    if ([task respondsToSelector:@selector(setPriority:)]) {
+        task.priority = self.priority;
+    }
+    @synchronized(self) {
+        self.task = task;
+    }
+    [task resume];
+    // Cancelled while the task was being created
+    if (self.isCancelled) {
+        [task cancel];
+    }
+}
+
+- (void)cancel
+{
+    [self.retryHandover cancel];
+    [super cancel];
+    NSURLSessionDataTask *task = nil;
+    @synchronized(self) {
+        task = self.task;
+    }
+    [task cancel];
+}
+
+- (BOOL)continueWithRetryOperation:(NSOperation *)retryOperation
+{
+    return [self.retryHandover continueWithRetryOperation:retryOperation];
+}
+
+/**
+ Called on the main queue.
+ */
+- (void)finishWithResponse:(NSHTTPURLResponse *)response data:(NSData *)data error:(NSError *)error
+{
+    self.response = response;
+    self.error = error;
+    WPURLSessionTaskCompletionHandler completionHandler = self.completionHandler;
+    self.completionHandler = nil;
+    if (completionHandler) {
+        completionHandler(response, data, error);
+    }
+    @synchronized(self) {
+        [self willChangeValueForKey:@"isExecuting"];
+        [self willChangeValueForKey:@"isFinished"];
+        _executing = NO;
+        _finished = YES;
+        [self didChangeValueForKey:@"isExecuting"];
+        [self didChangeValueForKey:@"isFinished"];
+    }
+}
+
+@end
+
+#pragma mark - WPURLSessionTransport
+
+@interface WPURLSessionTransport ()
+@property (nonatomic, strong) NSMutableDictionary *sessionManagers;
+@property (nonatomic, strong) WPURLSessionManager *backgroundSessionManager;
+@property (nonatomic, strong) NSMutableDictionary *uploadProgressBlocks;
+@property (nonatomic, strong) NSMutableSet *uploadTaskIdentifiers;
+@end
+
+@implementation WPURLSessionTransport
+
++ (WPURLSessionTransport *)sharedTransport {
+    static WPURLSessionTransport *_sharedTransport;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        _sharedTransport = [[self alloc] init];
+    });
+    return _sharedTransport;
+}
+
++ (NSString *)hostFamilyForURL:(NSURL *)URL {
+    NSString *host = [[URL host] lowercaseString];
+    if (!host) {
+        return @"";
+    }
+    NSArray *labels = [host componentsSeparatedByString:@"."];
+    // IP addresses and short names are their own family
+    BOOL isAddress = [host rangeOfCharacterFromSet:[NSCharacterSet letterCharacterSet]].location == NSNotFound;
+    if (isAddress || [labels count] <= 2) {
+        return host;
+    }
+    NSUInteger familyLength = 2;
+    NSString *topLevelDomain = [labels lastObject];
+    NSString *secondLevelDomain = labels[[labels count] - 2];
+    // Country codes with registrations under a second level, like co.uk or com.au
+    if ([topLevelDomain length] == 2 && [[self countryCodeSecondLevelDomains] containsObject:secondLevelDomain]) {
+        familyLength = 3;
+    }
+    if ([labels count] <= familyLength) {
+        return host;
+    }
+    return [[labels subarrayWithRange:NSMakeRange([labels count] - familyLength, familyLength)] componentsJoinedByString:@"."];
+}
+
++ (NSSet *)countryCodeSecondLevelDomains {
+    static NSSet *domains;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        domains = [NSSet setWithObjects:@"ac", @"co", @"com", @"edu", @"gen", @"go", @"gob", @"gov", @"gv", @"id", @"info", @"lg", @"ltd", @"me", @"mil", @"ne", @"net", @"nhs", @"nic", @"nom", @"or", @"org", @"plc", @"sch", nil];
+    });
+    return domains;
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _maximumConnectionsPerHost = WPURLSessionTransportDefaultMaximumConnectionsPerHost;
+        _backgroundSessionIdentifier = [WPURLSessionTransportDefaultBackgroundSessionIdentifier copy];
+        _sessionManagers = [NSMutableDictionary dictionary];
+        _uploadProgressBlocks = [NSMutableDictionary dictionary];
+        _uploadTaskIdentifiers = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (AFURLSessionManager *)sessionManagerForURL:(NSURL *)URL {
+    NSString *family = [[self class] hostFamilyForURL:URL];
+    @synchronized(self) {
+        WPURLSessionManager *manager = self.sessionManagers[family];
+        if (!manager) {
+            NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
+            configuration.HTTPMaximumConnectionsPerHost = self.maximumConnectionsPerHost;
+            // Responses are cached by WPResponseCache where it's safe to
+            configuration.URLCache = nil;
+            manager = [[WPURLSessionManager alloc] initWithSessionConfiguration:configuration];
+            manager.responseSerializer = [AFHTTPResponseSerializer serializer];
+            self.sessionManagers[family] = manager;
+        }
+        return manager;
+    }
+}
+
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
+                                     priority:(float)priority
+                            completionHandler:(void (^)(NSHTTPURLResponse *response, NSData *data, NSError *error))completionHandler
+{
+    AFURLSessionManager *manager = [self sessionManagerForURL:request.URL];
+    NSURLSessionDataTask *task = [manager dataTaskWithRequest:request completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+        if (completionHandler) {
+            completionHandler((NSHTTPURLResponse *)response, responseObject, error);
+        }
+    }];
+    if ([task respondsToSelector:@selector(setPriority:)]) {
+        task.priority = priority;
+    }
+    [task resume];
+    return task;
+}
+
+- (WPURLSessionTaskOperation *)dataTaskOperationWithRequest:(NSURLRequest *)request
+                                                   priority:(float)priority
+                                          completionHandler:(void (^)(NSHTTPURLResponse *response, NSData *data, NSError *error))completionHandler
+{
+    return [[WPURLSessionTaskOperation alloc] initWithTransport:self request:request priority:priority completionHandler:completionHandler];
+}
+
+#pragma mark - Background Uploads
+
+- (NSURLSessionUploadTask *)backgroundUploadTaskWithRequest:(NSURLRequest *)request
+                                                   fromFile:(NSURL *)fileURL
+                                                   progress:(void (^)(int64_t totalBytesSent, int64_t totalBytesExpectedToSend))progress
+                                          completionHandler:(void (^)(NSHTTPURLResponse *response, NSData *data, NSError *error))completionHandler
+{
+    NSMutableURLRequest *uploadRequest = [request mutableCopy];
+    // Background sessions only upload from files
+    uploadRequest.HTTPBody = nil;
+    uploadRequest.HTTPBodyStream = nil;
+
+    AFURLSessionManager *manager = [self backgroundManager];
+    NSURLSessionUploadTask *task = [manager uploadTaskWithRequest:uploadRequest fromFile:fileURL progress:nil completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+        if (completionHandler) {
+            completionHandler((NSHTTPURLResponse *)response, responseObject, error);
+        }
+    }];
+    @synchronized(self) {
+        [self.uploadTaskIdentifiers addObject:@(task.taskIdentifier)];
+        if (progress) {
+            self.uploadProgressBlocks[@(task.taskIdentifier)] = [progress copy];
+        }
+    }
+    [task resume];
+    return task;
+}
+
+- (BOOL)handleEventsForBackgroundURLSession:(NSString *)identifier completionHandler:(void (^)())completionHandler {
+    if (![identifier isEqualToString:self.backgroundSessionIdentifier]) {
+        return NO;
+    }
+    AFURLSessionManager *manager = [self backgroundManager];
+    [manager setDidFinishEventsForBackgroundURLSessionBlock:^(NSURLSession *session) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (completionHandler) {
+                completionHandler();
+            }
+        });
+    }];
+    return YES;
+}
+
+#pragma mark - Private Methods
+
+- (WPURLSessionManager *)backgroundManager {
+    @synchronized(self) {
+        if (self.backgroundSessionManager) {
+            return self.backgroundSessionManager;
+        }
+        NSURLSessionConfiguration *configuration;
+        if ([NSURLSessionConfiguration respondsToSelector:@selector(backgroundSessionConfigurationWithIdentifier:)]) {
+            configuration = [NSURLSessionConfiguration backgroundSessionConfigurationWithIdentifier:self.backgroundSessionIdentifier];
+        } else {
+            configuration = [NSURLSessionConfiguration backgroundSessionConfiguration:self.backgroundSessionIdentifier];
+        }
+        configuration.HTTPMaximumConnectionsPerHost = self.maximumConnectionsPerHost;
+        configuration.sessionSendsLaunchEvents = YES;
+        configuration.discretionary = NO;
+
+        WPURLSessionManager *manager = [[WPURLSessionManager alloc] initWithSessionConfiguration:configuration];
+        manager.responseSerializer = [AFHTTPResponseSerializer serializer];
+        manager.attemptsToRecreateUploadTasksForBackgroundSessions = YES;
+
+        __weak __typeof(self) weakSelf = self;
+        [manager setTaskDidSendBodyDataBlock:^(NSURLSession *session, NSURLSessionTask *task, int64_t bytesSent, int64_t totalBytesSent, int64_t totalBytesExpectedToSend) {
+            void (^progress)(int64_t, int64_t) = nil;
+            __strong __typeof(weakSelf) strongSelf = weakSelf;
+            @synchronized(strongSelf) {
+                progress = strongSelf.uploadProgressBlocks[@(task.taskIdentifier)];
+            }
+            if (progress) {
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    progress(totalBytesSent, totalBytesExpectedToSend);
+                });
+            }
+        }];
+        [manager setTaskDidCompleteBlock:^(NSURLSession *session, NSURLSessionTask *task, NSError *error) {
+            __strong __typeof(weakSelf) strongSelf = weakSelf;
+            void (^didComplete)(NSURLSessionTask *, NSError *) = strongSelf.backgroundTaskDidCompleteBlock;
+            BOOL startedInThisLaunch = NO;
+            @synchronized(strongSelf) {
+                startedInThisLaunch = [strongSelf.uploadTaskIdentifiers containsObject:@(task.taskIdentifier)];
+                [strongSelf.uploadTaskIdentifiers removeObject:@(task.taskIdentifier)];
+                [strongSelf.uploadProgressBlocks removeObjectForKey:@(task.taskIdentifier)];
+            }
+            // Tasks from this launch report through their own completion handler
+            if (didComplete && !startedInThisLaunch) {
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    didComplete(task, error);
+                });
+            }
+        }];
+        self.backgroundSessionManager = manager;
+        return manager;
+    }
+}
+
+@end
@@ -1,10 +1,17 @@
 #import <Foundation/Foundation.h>
 #import <AFNetworking/AFNetworking.h>
+#import "WPRequestMetrics.h"
+#import "WPRequestScheduler.h"
 
-@class WPXMLRPCRequestOperation, WPXMLRPCRequest;
+@class WPXMLRPCRequestOperation, WPXMLRPCRequest, WPResponseCache, WPRetryPolicy, WPURLSessionTransport, WPInFlightRequests, WPRequestHandle;
 
 extern NSString *const WPXMLRPCClientErrorDomain;
 
+/**
+ A block turning the raw body of a XML-RPC response into the object passed to `success`. It's called on a background queue, and returns `nil` and sets `error` if the response is a fault or can't be parsed.
+ */
+typedef id (^WPXMLRPCResponseParser)(NSData *responseData, NSError **error);
+
 /**
  `AFXMLRPCClient` binds together AFNetworking and eczarny's XML-RPC library to interact with XML-RPC based APIs
  */
@@ -21,9 +28,151 @@ extern NSString *const WPXMLRPCClientErrorDomain;
 
 /**
  The operation queue which manages operations enqueued by the HTTP client.
+
+ Operations are run by the shared `WPRequestScheduler`, which limits the connections to each host across all clients.
  */
 @property (readonly, nonatomic, strong) NSOperationQueue *operationQueue;
 
+/**
+ The priority class of the requests made by the client. Defaults to `WPRequestPriorityInteractive`.
+ */
+@property (nonatomic, assign) WPRequestPriority priority;
+
+/**
+ The cache used by `callMethod:parameters:success:failure:` for read methods.
+
+ Calls to methods with a time to live in the cache return the cached response while it's fresh, without going to the network. Defaults to `nil`, which disables caching.
+ */
+@property (nonatomic, strong) WPResponseCache *responseCache;
+
+/**
+ An object told how every request made by the client went: sizes, timings and outcome.
+
+ Calls answered from the `responseCache` are reported with `cached` set, and each call of a `system.multicall` is reported on its own with `batched` set.
+
+ Metrics are only collected while there's an observer. Defaults to `nil`.
+ */
+@property (nonatomic, weak) id<WPRequestMetricsObserver> metricsObserver;
+
+/**
+ The policy deciding when failed requests are sent again. Defaults to `nil`, which disables retries.
+
+ Retries apply to the operations created by the client, and are enqueued on its operation queue after the backoff delay. The success or failure block is only called once, with the outcome of the last attempt. Streamed request bodies are rebuilt for each attempt, so uploads are sent again from the start. Streaming reads are only retried if no response was received, so elements are never reported twice.
+ */
+@property (nonatomic, strong) WPRetryPolicy *retryPolicy;
+
+/**
+ The transport sending the calls made with `callMethod:parameters:success:failure:`, `enqueueXMLRPCRequestOperation:` and `callMethod:parameters:usingFilePathForCache:progress:success:failure:` over `NSURLSession`.
+
+ Clients sharing a transport share its connections, and calls are multiplexed over HTTP/2 when the server supports it. Each call is sent by a `WPURLSessionTaskOperation` added to `operationQueue`, so it's scheduled with the queue's priority and tag, counts against the scheduler's limits, is cancelled by `cancelAllHTTPOperations` and `cancelHTTPOperationsWithTag:`, and is retried by `retryPolicy`. Streaming calls and the operations created by the client still run as `AFHTTPRequestOperation`.
+
+ The operation passed to the success and failure blocks of calls sent by the transport is `nil`, as it isn't an `AFHTTPRequestOperation`.
+
+ Background uploads are left to the background session, which keeps them going across suspension and relaunch: they don't count against the scheduler's limits, and aren't retried by `retryPolicy`. `cancelAllHTTPOperations` still cancels them.
+
+ Defaults to `nil`, which sends every call as an operation.
+ */
+@property (nonatomic, strong) WPURLSessionTransport *sessionTransport;
+
+///-------------------------------------------
+/// @name Choosing Callback Queues
+///-------------------------------------------
+
+/**
+ The queue responses are decoded on. Defaults to `nil`, which decodes on the global concurrent queue.
+
+ Use `sharedDecodeQueue`, or a queue of your own, to bound how many responses are decoded at the same time. A queue with a `maxConcurrentOperationCount` of `1` decodes them one at a time. Streaming operations decode the response as it arrives, on a serial queue of their own.
+ */
+@property (nonatomic, strong) NSOperationQueue *decodeQueue;
+
+/**
+ The queue the success, failure and element blocks are called on, and the `metricsObserver` is told about requests. Defaults to `nil`, which uses the main queue.
+
+ Background work that doesn't touch the UI can use a queue of its own so responses never go through the main thread. Calls sent with the `sessionTransport` are still received on the main queue before they're decoded. The queue can be concurrent, in which case the callbacks of different calls can run at the same time. The element blocks of a streaming operation, and then its success or failure block, are still called one at a time and in order.
+
+ Operations created by the client take it as their `completionQueue`, and `decodeQueue` as their `decodeQueue`. Both can be changed on an operation before it's enqueued, and are kept when the request is sent again.
+ */
+@property (nonatomic, strong) dispatch_queue_t completionQueue;
+
+/**
+ A decode queue shared by all the clients, running as many decodes at the same time as there are active processors.
+ */
++ (NSOperationQueue *)sharedDecodeQueue;
+
+///-------------------------------------------
+/// @name Compressing Request Bodies
+///-------------------------------------------
+
+/**
+ Whether the bodies of requests created with `requestWithMethod:parameters:` are sent gzip compressed, with `Content-Encoding: gzip`.
+
+ Most servers don't decompress request bodies, so hosts are assumed to support it until one rejects a compressed body, with a `400`, `411`, `415` or `501` response, or a XML-RPC parse error. The call is then sent again uncompressed, and the host is remembered so it's never sent compressed bodies again. Streamed request bodies are never compressed.
+
+ Defaults to `NO`.
+ */
+@property (nonatomic, assign) BOOL compressesRequestBodies;
+
+/**
+ The smallest body compressed when `compressesRequestBodies` is enabled. Defaults to `1024` bytes.
+ */
+@property (nonatomic, assign) NSUInteger minimumCompressedBodyLength;
+
+/**
+ Returns whether a host rejected a compressed request body before.
+ */
++ (BOOL)hostRejectsCompressedRequestBodies:(NSString *)host;
+
+///-------------------------------------------
+/// @name Sharing In-Flight Calls
+///-------------------------------------------
+
+/**
+ Whether identical read calls made with `callMethod:parameters:success:failure:` share a single request while it's pending.
+
+ Calls are identical when they have the same endpoint, method and parameters, and read methods are the ones the `retryPolicy` (or the default policy) considers idempotent. The caller who sent the request gets the response object, and the callers attached to it an immutable copy, so a caller changing its response doesn't change the others'.
+
+ Defaults to `YES`.
+ */
+@property (nonatomic, assign) BOOL deduplicatesRequests;
+
+/**
+ The calls pending for the client, used to share identical ones.
+ */
+@property (readonly, nonatomic, strong) WPInFlightRequests *inFlightRequests;
+
+///-------------------------------------------
+/// @name Coalescing Calls with system.multicall
+///-------------------------------------------
+
+/**
+ Whether calls made with `callMethod:parameters:success:failure:` or `enqueueXMLRPCRequestOperation:` are collected and sent together as a single `system.multicall` request.
+
+ Each call still gets its own success or failure callback, including per-call faults. Cancelling the handle of a call which is still waiting for the batch takes it out, so it isn't sent. If the server rejects `system.multicall`, with a `-32601` fault naming it or a `405` or `501` status, future calls are sent individually. The calls of the rejected batch that the `retryPolicy` considers idempotent are sent again individually; the others fail with the rejection error, since they may have been run already.
+
+ Defaults to `NO`.
+ */
+@property (nonatomic, assign, getter=isBatchingEnabled) BOOL batchingEnabled;
+
+/**
+ The time window, in seconds, during which calls are collected before the batch is sent. Defaults to `0.05`.
+ */
+@property (nonatomic, assign) NSTimeInterval batchingInterval;
+
+/**
+ The maximum number of calls sent in a single `system.multicall`. A batch is sent as soon as it reaches this size. Defaults to `20`.
+ */
+@property (nonatomic, assign) NSUInteger maximumBatchSize;
+
+/**
+ The number of calls that have been sent as part of a `system.multicall` request by this client.
+ */
+@property (readonly, nonatomic, assign) NSUInteger numberOfCoalescedCalls;
+
+/**
+ `YES` if the server rejected a `system.multicall` request. Batched calls are then sent one by one.
+ */
+@property (readonly, nonatomic, assign) BOOL multicallUnsupported;
+
 ///------------------------------------------------
 /// @name Creating and Initializing XML-RPC Clients
 ///------------------------------------------------
@@ -94,9 +243,23 @@ extern NSString *const WPXMLRPCClientErrorDomain;
 - (NSMutableURLRequest *)requestWithMethod:(NSString *)method
                                 parameters:(NSArray *)parameters;
 
+/**
+ Creates a `NSMutableURLRequest` object with the specified XML-RPC method and parameters, whose body is encoded while it's being sent.
+
+ Binary parameters (`NSData` or a `NSFileHandle` for a regular file) are base64 encoded in chunks as the upload progresses, so memory use stays flat regardless of the size of the payload, and no temporary file is needed. The `Content-Length` is computed up front from the parameter sizes.
+
+ @param method The XML-RPC method for the request.
+ @param parameters The XML-RPC parameters to be set as the request body.
+ @return A `NSMutableURLRequest` object, or `nil` if the parameters can't be encoded.
+ */
+- (NSMutableURLRequest *)streamingRequestWithMethod:(NSString *)method
+                                         parameters:(NSArray *)parameters;
+
 /**
  Creates a `NSMutableURLRequest` object with the specified XML-RPC method and parameters, but uses streaming to encode and send the XML-RPC request.
 
+ The whole request is encoded to `filePath` before the request is returned. `streamingRequestWithMethod:parameters:` avoids that extra write and read.
+
  @param method The XML-RPC method for the request.
  @param parameters The XML-RPC parameters to be set as the request body.
  @param filePathForCache The path wehere the streaming request will be cached. This file can only be delete after 
@@ -132,6 +295,51 @@ extern NSString *const WPXMLRPCClientErrorDomain;
                                                     success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
                                                     failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure;
 
+/**
+ Creates an `AFHTTPRequestOperation` which turns the response into an object with a custom parser, instead of decoding the whole response.
+
+ @param request The request object to be loaded asynchronously during execution of the operation.
+ @param responseParser A block object turning the raw response body into the object passed to `success`. Pass `nil` to decode the response with `WPXMLRPCDecoder`.
+ @param success A block object to be executed when the request operation finishes successfully. This block has no return value and takes two arguments: the created request operation and the object returned by `responseParser`.
+ @param failure A block object to be executed when the request operation finishes unsuccessfully, or that finishes successfully, but encountered an error while parsing the resonse data. This block has no return value and takes two arguments:, the created request operation and the `NSError` object describing the network or parsing error that occurred.
+ */
+- (AFHTTPRequestOperation *)HTTPRequestOperationWithRequest:(NSURLRequest *)request
+                                             responseParser:(WPXMLRPCResponseParser)responseParser
+                                                    success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                                                    failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure;
+
+/**
+ Creates an `AFHTTPRequestOperation` which decodes the XML-RPC response incrementally, as it's received.
+
+ The raw response is not buffered, so `responseData` and `responseString` are not available on the operation.
+
+ @param request The request object to be loaded asynchronously during execution of the operation.
+ @param element A block object to be executed for each element of the top-level array in the response, as soon as it's decoded. This block has no return value and takes two arguments: the decoded element and its index. Elements passed to this block are not included in the object passed to `success`. Can be `nil` to get the whole response in `success`.
+ @param success A block object to be executed when the request operation finishes successfully. This block has no return value and takes two arguments: the created request operation and the object created from the response data of request.
+ @param failure A block object to be executed when the request operation finishes unsuccessfully, or that finishes successfully, but encountered an error while parsing the resonse data. This block has no return value and takes two arguments:, the created request operation and the `NSError` object describing the network or parsing error that occurred.
+ */
+- (AFHTTPRequestOperation *)streamingHTTPRequestOperationWithRequest:(NSURLRequest *)request
+                                                             element:(void (^)(id element, NSUInteger index))element
+                                                             success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                                                             failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure;
+
+/**
+ Creates an `AFHTTPRequestOperation` which decodes the XML-RPC response incrementally, as it's received, and only decodes some of the struct members.
+
+ @param request The request object to be loaded asynchronously during execution of the operation.
+ @param memberFilter The names of the members to decode in the top-level struct, or in the structs of the top-level array. Other members are skipped. Pass `nil` to decode every member.
+ @param element A block object to be executed for each element of the top-level array in the response, as soon as it's decoded. Can be `nil`.
+ @param success A block object to be executed when the request operation finishes successfully. This block has no return value and takes two arguments: the created request operation and the object created from the response data of request.
+ @param failure A block object to be executed when the request operation finishes unsuccessfully, or that finishes successfully, but encountered an error while parsing the resonse data. This block has no return value and takes two arguments:, the created request operation and the `NSError` object describing the network or parsing error that occurred.
+
+ @see streamingHTTPRequestOperationWithRequest:element:success:failure:
+ */
+- (AFHTTPRequestOperation *)streamingHTTPRequestOperationWithRequest:(NSURLRequest *)request
+                                                        memberFilter:(NSSet *)memberFilter
+                                                             element:(void (^)(id element, NSUInteger index))element
+                                                             success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                                                             failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure;
+
 /**
  Creates an `AFXMLRPCRequestOperation`
 
@@ -165,6 +373,15 @@ extern NSString *const WPXMLRPCClientErrorDomain;
  */
 - (void)enqueueHTTPRequestOperation:(AFHTTPRequestOperation *)operation;
 
+/**
+ Enqueues an `AFHTTPRequestOperation` with its own priority class and tag.
+
+ @param operation The XML-RPC request operation to be enqueued.
+ @param priority The priority class of the operation.
+ @param tag An optional tag, to cancel it with `cancelHTTPOperationsWithTag:`.
+ */
+- (void)enqueueHTTPRequestOperation:(AFHTTPRequestOperation *)operation priority:(WPRequestPriority)priority tag:(NSString *)tag;
+
 /**
  Enqueues an `AFXMLRPCRequestOperation` to the XML-RPC client's operation queue.
 
@@ -177,6 +394,29 @@ extern NSString *const WPXMLRPCClientErrorDomain;
  */
 - (void)cancelAllHTTPOperations;
 
+/**
+ Cancels the operations enqueued with a tag.
+ */
+- (void)cancelHTTPOperationsWithTag:(NSString *)tag;
+
+/**
+ Sends any calls waiting to be coalesced right away, without waiting for `batchingInterval` to elapse.
+ */
+- (void)flushBatchedCalls;
+
+///-----------------------------------
+/// @name Warming Up Connections
+///-----------------------------------
+
+/**
+ Opens a connection to the XML-RPC endpoint ahead of the first call, e.g. on launch for saved sites, so the call doesn't wait for DNS, TCP and TLS.
+
+ The connection is opened with the `sessionTransport` if there's one, so calls sent by it reuse the connection. See `WPConnectionPrewarmer`.
+
+ @param completion A block object to execute on the main queue when the connection is open or failed to open. This block has no return value and takes two arguments: how long the warm-up took, `0` if the endpoint was already warm, and an error if it failed. Can be `nil`.
+ */
+- (void)warmUpConnectionWithCompletion:(void (^)(NSTimeInterval duration, NSError *error))completion;
+
 
 ///------------------------------
 /// @name Making XML-RPC requests
@@ -187,13 +427,89 @@ extern NSString *const WPXMLRPCClientErrorDomain;
 
  @param method The XML-RPC method.
  @param parameters The XML-RPC parameters to be set as the request body.
- @param success A block object to be executed when the request operation finishes successfully. This block has no return value and takes two arguments: the created request operation and the object created from the response data of request.
- @param failure A block object to be executed when the request operation finishes unsuccessfully, or that finishes successfully, but encountered an error while parsing the resonse data. This block has no return value and takes two arguments:, the created request operation and the `NSError` object describing the network or parsing error that occurred.
+ @param success A block object to be executed when the request operation finishes successfully. This block has no return value and takes two arguments: the created request operation, or `nil` if the call was sent by the `sessionTransport` or answered from the `responseCache`, and the object created from the response data of request.
+ @param failure A block object to be executed when the request operation finishes unsuccessfully, or that finishes successfully, but encountered an error while parsing the resonse data. This block has no return value and takes two arguments:, the created request operation, or `nil` if the call was sent by the `sessionTransport`, and the `NSError` object describing the network or parsing error that occurred.
+ @return A handle to cancel the call. Cancelling it doesn't cancel a request shared with other callers, see `deduplicatesRequests`.
 
  @see HTTPRequestOperationWithRequest:success:failure
  */
+- (WPRequestHandle *)callMethod:(NSString *)method
+                     parameters:(NSArray *)parameters
+                        success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                        failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure;
+
+/**
+ Creates an `AFHTTPRequestOperation` with a `XML-RPC` request, and enqueues it to the HTTP client's operation queue, with its own decode and completion queues.
+
+ Batched calls are decoded with the rest of the batch, on the client's `decodeQueue`.
+
+ @param method The XML-RPC method.
+ @param parameters The XML-RPC parameters to be set as the request body.
+ @param decodeQueue The queue the response is decoded on, or `nil` for the client's `decodeQueue`.
+ @param completionQueue The queue `success` and `failure` are called on, or `nil` for the client's `completionQueue`.
+ @param success A block object to be executed when the request operation finishes successfully. This block has no return value and takes two arguments: the created request operation, or `nil` if the call was sent by the `sessionTransport` or answered from the `responseCache`, and the object created from the response data of request.
+ @param failure A block object to be executed when the request operation finishes unsuccessfully, or that finishes successfully, but encountered an error while parsing the resonse data. This block has no return value and takes two arguments:, the created request operation, or `nil` if the call was sent by the `sessionTransport`, and the `NSError` object describing the network or parsing error that occurred.
+ @return A handle to cancel the call. Cancelling it doesn't cancel a request shared with other callers, see `deduplicatesRequests`.
+ */
+- (WPRequestHandle *)callMethod:(NSString *)method
+                     parameters:(NSArray *)parameters
+                    decodeQueue:(NSOperationQueue *)decodeQueue
+                completionQueue:(dispatch_queue_t)completionQueue
+                        success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                        failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure;
+
+/**
+ Creates an `AFHTTPRequestOperation` with a `XML-RPC` request which decodes the response as it's received, and enqueues it to the HTTP client's operation queue.
+
+ @param method The XML-RPC method.
+ @param parameters The XML-RPC parameters to be set as the request body.
+ @param element A block object to be executed for each element of the top-level array in the response, as soon as it's decoded. This block has no return value and takes two arguments: the decoded element and its index.
+ @param success A block object to be executed when the request operation finishes successfully. This block has no return value and takes two arguments: the created request operation and the object created from the response data of request, without the elements already passed to `element`.
+ @param failure A block object to be executed when the request operation finishes unsuccessfully, or that finishes successfully, but encountered an error while parsing the resonse data. This block has no return value and takes two arguments:, the created request operation and the `NSError` object describing the network or parsing error that occurred.
+
+ @see streamingHTTPRequestOperationWithRequest:element:success:failure:
+ */
+- (void)callMethod:(NSString *)method
+        parameters:(NSArray *)parameters
+           element:(void (^)(id element, NSUInteger index))element
+           success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+           failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure;
+
+/**
+ Creates an `AFHTTPRequestOperation` with a `XML-RPC` request which decodes the response as it's received, skipping the struct members that weren't asked for, and enqueues it to the HTTP client's operation queue.
+
+ @param method The XML-RPC method.
+ @param parameters The XML-RPC parameters to be set as the request body.
+ @param memberFilter The names of the members to decode in the top-level struct, or in the structs of the top-level array. Pass `nil` to decode every member.
+ @param element A block object to be executed for each element of the top-level array in the response, as soon as it's decoded. Can be `nil`.
+ @param success A block object to be executed when the request operation finishes successfully. This block has no return value and takes two arguments: the created request operation and the object created from the response data of request, without the elements already passed to `element`.
+ @param failure A block object to be executed when the request operation finishes unsuccessfully, or that finishes successfully, but encountered an error while parsing the resonse data. This block has no return value and takes two arguments:, the created request operation and the `NSError` object describing the network or parsing error that occurred.
+
+ @see streamingHTTPRequestOperationWithRequest:memberFilter:element:success:failure:
+ */
+- (void)callMethod:(NSString *)method
+        parameters:(NSArray *)parameters
+      memberFilter:(NSSet *)memberFilter
+           element:(void (^)(id element, NSUInteger index))element
+           success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+           failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure;
+
+/**
+ Encodes a `XML-RPC` request to a file, and uploads it.
+
+ With a `sessionTransport`, the file is uploaded by its background session, so the upload goes on while the app is suspended. Otherwise, it's uploaded by an operation enqueued to the HTTP client's operation queue.
+
+ @param method The XML-RPC method.
+ @param parameters The XML-RPC parameters to be set as the request body.
+ @param filePath The path where the request is encoded. The file can be removed once `success` or `failure` is called.
+ @param progress A block object to be executed as the request body is sent. This block has no return value and takes two arguments: the bytes sent so far and the size of the body. Can be `nil`.
+ @param success A block object to be executed when the request finishes successfully. This block has no return value and takes two arguments: the request operation, or `nil` if it was sent by the `sessionTransport`, and the object created from the response data of request.
+ @param failure A block object to be executed when the request finishes unsuccessfully. This block has no return value and takes two arguments: the request operation, or `nil` if it was sent by the `sessionTransport`, and the `NSError` object describing the network or parsing error that occurred.
+ */
 - (void)callMethod:(NSString *)method
         parameters:(NSArray *)parameters
+usingFilePathForCache:(NSString *)filePath
+          progress:(void (^)(int64_t totalBytesSent, int64_t totalBytesExpectedToSend))progress
            success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
            failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure;
 
@@ -1,24 +1,139 @@
 #import <UIKit/UIKit.h>
 #import <WPXMLRPC/WPXMLRPC.h>
 #import <AFNetworking/AFNetworking.h>
+#import <zlib.h>
 
 #import "WPXMLRPCClient.h"
 
 #import "WPXMLRPCRequest.h"
 #import "WPXMLRPCRequestOperation.h"
 #import "WPHTTPRequestOperation.h"
+#import "WPXMLRPCStreamingDecoder.h"
+#import "WPXMLRPCRequestBodyStream.h"
+#import "WPResponseCache.h"
+#import "WPRetryPolicy.h"
+#import "WPURLSessionTransport.h"
+#import "WPInFlightRequests.h"
+#import "WPConnectionPrewarmer.h"
 
 #ifndef WPFLog
 #define WPFLog(...) NSLog(__VA_ARGS__)
 #endif
 
 NSString *const WPXMLRPCClientErrorDomain = @"XMLRPC";
-static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
+static NSTimeInterval const WPXMLRPCClientDefaultBatchingInterval = 0.05;
+static NSUInteger const WPXMLRPCClientDefaultMaximumBatchSize = 20;
+static NSString *const WPXMLRPCClientMulticallMethod = @"system.multicall";
+static NSInteger const WPXMLRPCClientMethodNotFoundFaultCode = -32601;
+static NSInteger const WPXMLRPCClientParseErrorFaultCode = -32700;
+static NSUInteger const WPXMLRPCClientDefaultMinimumCompressedBodyLength = 1024;
+static NSString *const WPXMLRPCClientCompressionRejectingHostsKey = @"WPXMLRPCClientCompressionRejectingHosts";
+// Only the start of bodies is logged, so debugging large uploads doesn't copy them whole
+static NSUInteger const WPXMLRPCClientMaximumLoggedBodyLength = 2048;
+// Where the method name is kept on requests, so it doesn't need to be parsed back from the body
+static NSString *const WPXMLRPCClientMethodNamePropertyKey = @"WPXMLRPCClientMethodName";
+// What's needed to send a request again: how many retries were made, the file backing its body, and the calls in a multicall
+static NSString *const WPXMLRPCClientRetryAttemptPropertyKey = @"WPXMLRPCClientRetryAttempt";
+static NSString *const WPXMLRPCClientBodyFilePathPropertyKey = @"WPXMLRPCClientBodyFilePath";
+static NSString *const WPXMLRPCClientMulticallMethodsPropertyKey = @"WPXMLRPCClientMulticallMethods";
+// Set on requests whose body was gzip compressed by the client
+static NSString *const WPXMLRPCClientCompressedBodyPropertyKey = @"WPXMLRPCClientCompressedBody";
+
+static NSData *WPXMLRPCClientGzipData(NSData *data) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // 16 added to the window bits asks zlib for a gzip header instead of a zlib one
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nil;
+    }
+    NSMutableData *compressed = [NSMutableData dataWithLength:deflateBound(&stream, (uLong)[data length])];
+    stream.next_in = (Bytef *)[data bytes];
+    stream.avail_in = (uInt)[data length];
+    stream.next_out = [compressed mutableBytes];
+    stream.avail_out = (uInt)[compressed length];
+    int status = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        return nil;
+    }
+    [compressed setLength:stream.total_out];
+    return compressed;
+}
+
+static NSData *WPXMLRPCClientGunzipData(NSData *data) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, MAX_WBITS + 16) != Z_OK) {
+        return nil;
+    }
+    NSMutableData *decompressed = [NSMutableData dataWithLength:[data length] * 4];
+    stream.next_in = (Bytef *)[data bytes];
+    stream.avail_in = (uInt)[data length];
+    int status = Z_OK;
+    while (status == Z_OK) {
+        if (stream.total_out >= [decompressed length]) {
+            [decompressed increaseLengthBy:[data length] * 2];
+        }
+        stream.next_out = (Bytef *)[decompressed mutableBytes] + stream.total_out;
+        stream.avail_out = (uInt)([decompressed length] - stream.total_out);
+        status = inflate(&stream, Z_NO_FLUSH);
+    }
+    inflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        return nil;
+    }
+    [decompressed setLength:stream.total_out];
+    return decompressed;
+}
+
+/**
+ Returns the start of a body for logging, without converting the rest of it.
+ */
+static NSString *WPXMLRPCClientLoggableBody(NSData *data) {
+    NSUInteger length = MIN([data length], WPXMLRPCClientMaximumLoggedBodyLength);
+    NSString *string = nil;
+    // Trimming up to 3 bytes drops a UTF-8 sequence cut in half
+    for (NSUInteger trimmed = 0; !string && trimmed <= MIN(length, 3); trimmed++) {
+        string = [[NSString alloc] initWithBytes:[data bytes] length:length - trimmed encoding:NSUTF8StringEncoding];
+    }
+    if (!string) {
+        return [NSString stringWithFormat:@"(%lu bytes of binary data)", (unsigned long)[data length]];
+    }
+    if (length < [data length]) {
+        return [NSString stringWithFormat:@"%@… (%lu bytes)", string, (unsigned long)[data length]];
+    }
+    return string;
+}
 
 @interface WPXMLRPCClient ()
 @property (readwrite, nonatomic, strong) NSURL *xmlrpcEndpoint;
 @property (readwrite, nonatomic, strong) NSMutableDictionary *defaultHeaders;
-@property (readwrite, nonatomic, strong) NSOperationQueue *operationQueue;
+@property (readwrite, nonatomic, strong) WPRequestSchedulerQueue *operationQueue;
+@property (readwrite, nonatomic, assign) NSUInteger numberOfCoalescedCalls;
+@property (readwrite, nonatomic, assign) BOOL multicallUnsupported;
+@property (readwrite, nonatomic, strong) WPInFlightRequests *inFlightRequests;
+@property (nonatomic, strong) NSMutableArray *batchedOperations;
+@property (nonatomic, strong) dispatch_queue_t batchingQueue;
+@property (nonatomic, strong) dispatch_source_t batchingTimer;
+@property (nonatomic, strong) NSHashTable *sessionTasks;
+- (void)cancelBatchedOperation:(WPXMLRPCRequestOperation *)operation;
+@end
+
+/**
+ The object cancelling a call waiting to be batched. Once the multicall is sent, it goes on for the other calls in it.
+ */
+@interface WPXMLRPCBatchedCall : NSObject
+@property (nonatomic, weak) WPXMLRPCClient *client;
+@property (nonatomic, strong) WPXMLRPCRequestOperation *operation;
+- (void)cancel;
+@end
+
+@implementation WPXMLRPCBatchedCall
+
+- (void)cancel {
+    [self.client cancelBatchedOperation:self.operation];
+}
+
 @end
 
 @implementation WPXMLRPCClient
@@ -57,12 +172,27 @@ static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
         [self setDefaultHeader:@"User-Agent" value:[NSString stringWithFormat:@"%@/%@ (%@, %@ %@, %@, Scale/%f)", [[[NSBundle mainBundle] infoDictionary] objectForKey:(NSString *)kCFBundleIdentifierKey], [[[NSBundle mainBundle] infoDictionary] objectForKey:(NSString *)kCFBundleVersionKey], @"unknown", [[UIDevice currentDevice] systemName], [[UIDevice currentDevice] systemVersion], [[UIDevice currentDevice] model], ([[UIScreen mainScreen] respondsToSelector:@selector(scale)] ? [[UIScreen mainScreen] scale] : 1.0)]];
     }
 
-    self.operationQueue = [[NSOperationQueue alloc] init];
-	[self.operationQueue setMaxConcurrentOperationCount:WPXMLRPCClientDefaultMaxConcurrentOperationCount];
+    self.operationQueue = [[WPRequestSchedulerQueue alloc] initWithScheduler:[WPRequestScheduler sharedScheduler]];
+
+    self.batchingInterval = WPXMLRPCClientDefaultBatchingInterval;
+    self.maximumBatchSize = WPXMLRPCClientDefaultMaximumBatchSize;
+    self.batchedOperations = [NSMutableArray array];
+    self.batchingQueue = dispatch_queue_create("org.wordpress.xmlrpc.batching", DISPATCH_QUEUE_SERIAL);
+    // Running tasks are retained by their session
+    self.sessionTasks = [NSHashTable weakObjectsHashTable];
+    self.minimumCompressedBodyLength = WPXMLRPCClientDefaultMinimumCompressedBodyLength;
+    self.inFlightRequests = [[WPInFlightRequests alloc] init];
+    self.deduplicatesRequests = YES;
 
     return self;
 }
 
+- (void)dealloc {
+    if (_batchingTimer) {
+        dispatch_source_cancel(_batchingTimer);
+    }
+}
+
 
 #pragma mark - Managing HTTP Header Values
 
@@ -90,8 +220,32 @@ static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
     [request setHTTPMethod:@"POST"];
     [request setAllHTTPHeaderFields:self.defaultHeaders];
 
+    [NSURLProtocol setProperty:method forKey:WPXMLRPCClientMethodNamePropertyKey inRequest:request];
+
     WPXMLRPCEncoder *encoder = [[WPXMLRPCEncoder alloc] initWithMethod:method andParameters:parameters];
     [request setHTTPBody:[encoder dataEncodedWithError:nil]];
+    if (self.compressesRequestBodies) {
+        [self compressBodyOfRequest:request];
+    }
+
+    return request;
+}
+
+- (NSMutableURLRequest *)streamingRequestWithMethod:(NSString *)method
+                                         parameters:(NSArray *)parameters
+{
+    WPXMLRPCRequestBodyStream *bodyStream = [[WPXMLRPCRequestBodyStream alloc] initWithMethod:method parameters:parameters];
+    if (!bodyStream) {
+        WPFLog(@"Error encoding request to stream: unsupported parameters for %@", method);
+        return nil;
+    }
+
+    NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:self.xmlrpcEndpoint];
+    [request setHTTPMethod:@"POST"];
+    [request setAllHTTPHeaderFields:self.defaultHeaders];
+    [NSURLProtocol setProperty:method forKey:WPXMLRPCClientMethodNamePropertyKey inRequest:request];
+    [request setHTTPBodyStream:bodyStream];
+    [request setValue:[NSString stringWithFormat:@"%llu", bodyStream.contentLength] forHTTPHeaderField:@"Content-Length"];
 
     return request;
 }
@@ -103,6 +257,7 @@ static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
     NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:self.xmlrpcEndpoint];
     [request setHTTPMethod:@"POST"];
     [request setAllHTTPHeaderFields:self.defaultHeaders];
+    [NSURLProtocol setProperty:method forKey:WPXMLRPCClientMethodNamePropertyKey inRequest:request];
 
     WPXMLRPCEncoder *encoder = [[WPXMLRPCEncoder alloc] initWithMethod:method andParameters:parameters];
     NSError *error = nil;
@@ -120,6 +275,7 @@ static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
 
     NSInputStream * inputStream = [NSInputStream inputStreamWithFileAtPath:filePath];
     [request setHTTPBodyStream:inputStream];
+    [NSURLProtocol setProperty:filePath forKey:WPXMLRPCClientBodyFilePathPropertyKey inRequest:request];
     [request setValue:[NSString stringWithFormat:@"%llu", contentLength] forHTTPHeaderField:@"Content-Length"];
 
     return request;
@@ -135,7 +291,24 @@ static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
 - (AFHTTPRequestOperation *)HTTPRequestOperationWithRequest:(NSURLRequest *)request
                                                     success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
                                                     failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    return [self HTTPRequestOperationWithRequest:request responseParser:nil success:success failure:failure];
+}
+
+- (AFHTTPRequestOperation *)HTTPRequestOperationWithRequest:(NSURLRequest *)request
+                                             responseParser:(WPXMLRPCResponseParser)responseParser
+                                                    success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                                                    failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    // Retries build their own operation, which falls back on its own, so they're given the caller's block
+    void (^callerFailure)(AFHTTPRequestOperation *, NSError *) = failure;
+    if ([self isCompressedRequest:request]) {
+        failure = [self failureFallingBackToUncompressedRequest:request responseParser:responseParser decodeQueue:nil completionQueue:nil success:success failure:failure];
+    }
+
     WPHTTPRequestOperation *operation = [[WPHTTPRequestOperation alloc] initWithRequest:request];
+    WPRequestMetrics *metrics = [self metricsForRequest:request];
+    operation.metrics = metrics;
+    operation.decodeQueue = self.decodeQueue;
+    operation.completionQueue = self.completionQueue;
 
     BOOL extra_debug_on = getenv("WPDebugXMLRPC") ? YES : NO;
 #ifndef DEBUG
@@ -144,24 +317,33 @@ static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
 #endif
 
     void (^xmlrpcSuccess)(AFHTTPRequestOperation *, id) = ^(AFHTTPRequestOperation *operation, id responseObject) {
-        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(void) {
-            WPXMLRPCDecoder *decoder = [[WPXMLRPCDecoder alloc] initWithData:responseObject];
+        [self.retryPolicy requestDidSucceed];
+        [self decodeOnQueue:[(WPHTTPRequestOperation *)operation decodeQueue] block:^(void) {
+            [metrics decodingDidStart];
             NSError *err = nil;
             if ( extra_debug_on == YES ) {
-                WPFLog(@"[XML-RPC] < %@", operation.responseString);
+                WPFLog(@"[XML-RPC] < %@", WPXMLRPCClientLoggableBody(responseObject));
             }
 
-            if ([decoder isFault] || [decoder object] == nil) {
-                err = [decoder error];
+            id object = nil;
+            if (responseParser) {
+                object = responseParser(responseObject, &err);
+            } else {
+                WPXMLRPCDecoder *decoder = [[WPXMLRPCDecoder alloc] initWithData:responseObject];
+                if ([decoder isFault] || [decoder object] == nil) {
+                    err = [decoder error];
+                }
+                // The decoder is discarded right after this, no need to copy its result
+                object = [decoder object];
             }
 
-            if ([decoder object] == nil && extra_debug_on) {
-                WPFLog(@"Blog returned invalid data (URL: %@)\n%@", request.URL.absoluteString, operation.responseString);
+            if (object == nil && extra_debug_on) {
+                WPFLog(@"Blog returned invalid data (URL: %@)\n%@", request.URL.absoluteString, WPXMLRPCClientLoggableBody(responseObject));
             }
+            [metrics decodingDidFinish];
 
-            id object = [[decoder object] copy];
-
-            dispatch_async(dispatch_get_main_queue(), ^(void) {
+            dispatch_async(operation.completionQueue ?: dispatch_get_main_queue(), ^(void) {
+                [self reportMetrics:metrics request:request error:err responseObject:object];
                 if (err) {
                     if (failure) {
                         failure(operation, err);
@@ -172,35 +354,30 @@ static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
                     }
                 }
             });
-        });
+        }];
     };
     void (^xmlrpcFailure)(AFHTTPRequestOperation *, NSError *) = ^(AFHTTPRequestOperation *operation, NSError *error) {
         if ( extra_debug_on == YES ) {
             WPFLog(@"[XML-RPC] ! %@", [error localizedDescription]);
         }
 
-        if (failure) {
+        [self reportMetrics:metrics request:request error:error responseObject:nil];
+        BOOL retrying = [self retryFailedOperation:operation error:error operationBuilder:^AFHTTPRequestOperation *(NSURLRequest *retryRequest) {
+            return [self HTTPRequestOperationWithRequest:retryRequest responseParser:responseParser success:success failure:callerFailure];
+        } failure:callerFailure];
+        if (!retrying && failure) {
             failure(operation, error);
         }
     };
     [operation setCompletionBlockWithSuccess:xmlrpcSuccess failure:xmlrpcFailure];
 
     if ( extra_debug_on == YES ) {
-        NSString *requestString = [[NSString alloc] initWithData:[request HTTPBody] encoding:NSUTF8StringEncoding];
-        if (getenv("WPDebugXMLRPC")) {
-            WPFLog(@"[XML-RPC] > %@", requestString);
+        if (getenv("WPDebugXMLRPC") && [self isCompressedRequest:request]) {
+            WPFLog(@"[XML-RPC] > %@ (gzip, %lu bytes)", [NSURLProtocol propertyForKey:WPXMLRPCClientMethodNamePropertyKey inRequest:request], (unsigned long)[[request HTTPBody] length]);
+        } else if (getenv("WPDebugXMLRPC")) {
+            WPFLog(@"[XML-RPC] > %@", WPXMLRPCClientLoggableBody([request HTTPBody]));
         } else {
-            NSError *error = NULL;
-            NSRegularExpression *method = [NSRegularExpression regularExpressionWithPattern:@"<methodName>(.*)</methodName>" options:NSRegularExpressionCaseInsensitive error:&error];
-            NSArray *matches = [method matchesInString:requestString options:0 range:NSMakeRange(0, [requestString length])];
-            NSString *methodName = nil;
-            if (matches.count > 0) {
-                NSRange methodRange = [[matches objectAtIndex:0] rangeAtIndex:1];
-                if(methodRange.location != NSNotFound)
-                    methodName = [requestString substringWithRange:methodRange];
-            } else if ([request HTTPBodyStream] != nil) {
-                methodName = @"streaming request, unknown method";
-            }
+            NSString *methodName = [NSURLProtocol propertyForKey:WPXMLRPCClientMethodNamePropertyKey inRequest:request] ?: @"unknown method";
             WPFLog(@"[XML-RPC] > %@", methodName);
         }
     }
@@ -208,6 +385,397 @@ static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
     return operation;
 }
 
+- (AFHTTPRequestOperation *)streamingHTTPRequestOperationWithRequest:(NSURLRequest *)request
+                                                             element:(void (^)(id element, NSUInteger index))element
+                                                             success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                                                             failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    return [self streamingHTTPRequestOperationWithRequest:request memberFilter:nil element:element success:success failure:failure];
+}
+
+- (AFHTTPRequestOperation *)streamingHTTPRequestOperationWithRequest:(NSURLRequest *)request
+                                                        memberFilter:(NSSet *)memberFilter
+                                                             element:(void (^)(id element, NSUInteger index))element
+                                                             success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                                                             failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    WPHTTPRequestOperation *operation = [[WPHTTPRequestOperation alloc] initWithRequest:request];
+    WPRequestMetrics *metrics = [self metricsForRequest:request];
+    operation.metrics = metrics;
+    // The response is decoded as it arrives, so there's no need to keep the raw bytes around
+    operation.outputStream = [NSOutputStream outputStreamToFileAtPath:@"/dev/null" append:NO];
+    operation.completionQueue = self.completionQueue;
+
+    // Chunks must be decoded in order, so streaming operations don't use the decode queue
+    dispatch_queue_t decodeQueue = dispatch_queue_create("org.wordpress.xmlrpc.decoding", DISPATCH_QUEUE_SERIAL);
+    // Elements and the final callback go through a serial queue running on the completion queue, so they're called one at a time and in order even if it's concurrent
+    dispatch_queue_t callbackQueue = dispatch_queue_create("org.wordpress.xmlrpc.streaming-callbacks", DISPATCH_QUEUE_SERIAL);
+    __weak AFHTTPRequestOperation *weakOperation = operation;
+    __block BOOL callbackQueueTargeted = NO;
+    // Only called on the decode queue. The completion queue can be changed until the operation is enqueued, so it's read with the first callback
+    void (^deliver)(dispatch_block_t) = ^(dispatch_block_t block) {
+        if (!callbackQueueTargeted) {
+            dispatch_set_target_queue(callbackQueue, weakOperation.completionQueue ?: dispatch_get_main_queue());
+            callbackQueueTargeted = YES;
+        }
+        dispatch_async(callbackQueue, block);
+    };
+    void (^elementHandler)(id, NSUInteger) = nil;
+    if (element) {
+        elementHandler = ^(id object, NSUInteger index) {
+            deliver(^{
+                element(object, index);
+            });
+        };
+    }
+    WPXMLRPCStreamingDecoder *decoder = [[WPXMLRPCStreamingDecoder alloc] initWithElementHandler:elementHandler];
+    decoder.memberFilter = memberFilter;
+    operation.dataReceivedBlock = ^(NSData *data) {
+        dispatch_async(decodeQueue, ^{
+            [metrics decodingDidStart];
+            [decoder appendData:data];
+            [metrics decodingDidFinish];
+        });
+    };
+
+    [operation setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
+        [self.retryPolicy requestDidSucceed];
+        dispatch_async(decodeQueue, ^{
+            [metrics decodingDidStart];
+            [decoder finish];
+            [metrics decodingDidFinish];
+            NSError *error = [decoder error];
+            id object = [decoder object];
+            deliver(^{
+                [self reportMetrics:metrics request:request error:error responseObject:object];
+                if (error) {
+                    if (failure) {
+                        failure(operation, error);
+                    }
+                } else {
+                    if (success) {
+                        success(operation, object);
+                    }
+                }
+            });
+        });
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        [self reportMetrics:metrics request:request error:error responseObject:nil];
+        // Once there's a response, elements may have been reported already
+        BOOL retrying = operation.response == nil && [self retryFailedOperation:operation error:error operationBuilder:^AFHTTPRequestOperation *(NSURLRequest *retryRequest) {
+            return [self streamingHTTPRequestOperationWithRequest:retryRequest memberFilter:memberFilter element:element success:success failure:failure];
+        } failure:failure];
+        if (!retrying && failure) {
+            // After the elements already decoded
+            dispatch_async(decodeQueue, ^{
+                deliver(^{
+                    failure(operation, error);
+                });
+            });
+        }
+    }];
+
+    return operation;
+}
+
+#pragma mark - Decoding and Delivering Responses
+
++ (NSOperationQueue *)sharedDecodeQueue {
+    static NSOperationQueue *sharedDecodeQueue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedDecodeQueue = [[NSOperationQueue alloc] init];
+        sharedDecodeQueue.name = @"org.wordpress.xmlrpc.decoding";
+        sharedDecodeQueue.maxConcurrentOperationCount = MAX([[NSProcessInfo processInfo] activeProcessorCount], 1);
+    });
+    return sharedDecodeQueue;
+}
+
+/**
+ Runs a decoding block on a decode queue, or on the global concurrent queue if there's none.
+ */
+- (void)decodeOnQueue:(NSOperationQueue *)decodeQueue block:(void (^)(void))block {
+    if (decodeQueue) {
+        [decodeQueue addOperationWithBlock:block];
+    } else {
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), block);
+    }
+}
+
+/**
+ Gives an operation sending a request again the queues chosen for the original one.
+ */
+- (void)copyQueuesFromOperation:(AFHTTPRequestOperation *)operation toOperation:(AFHTTPRequestOperation *)otherOperation {
+    otherOperation.completionQueue = operation.completionQueue;
+    if ([operation isKindOfClass:[WPHTTPRequestOperation class]] && [otherOperation isKindOfClass:[WPHTTPRequestOperation class]]) {
+        [(WPHTTPRequestOperation *)otherOperation setDecodeQueue:[(WPHTTPRequestOperation *)operation decodeQueue]];
+    }
+}
+
+#pragma mark - Compressing Request Bodies
+
++ (NSMutableSet *)compressionRejectingHosts {
+    static NSMutableSet *_hosts;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSArray *storedHosts = [[NSUserDefaults standardUserDefaults] arrayForKey:WPXMLRPCClientCompressionRejectingHostsKey];
+        _hosts = [NSMutableSet setWithArray:storedHosts ?: @[]];
+    });
+    return _hosts;
+}
+
++ (BOOL)hostRejectsCompressedRequestBodies:(NSString *)host {
+    if (!host) {
+        return NO;
+    }
+    NSMutableSet *hosts = [self compressionRejectingHosts];
+    @synchronized(hosts) {
+        return [hosts containsObject:[host lowercaseString]];
+    }
+}
+
++ (void)rememberHostRejectingCompressedRequestBodies:(NSString *)host {
+    if (!host) {
+        return;
+    }
+    NSMutableSet *hosts = [self compressionRejectingHosts];
+    NSArray *storedHosts = nil;
+    @synchronized(hosts) {
+        [hosts addObject:[host lowercaseString]];
+        storedHosts = [hosts allObjects];
+    }
+    [[NSUserDefaults standardUserDefaults] setObject:storedHosts forKey:WPXMLRPCClientCompressionRejectingHostsKey];
+}
+
+- (void)compressBodyOfRequest:(NSMutableURLRequest *)request {
+    NSData *body = [request HTTPBody];
+    if ([body length] < self.minimumCompressedBodyLength || [[self class] hostRejectsCompressedRequestBodies:request.URL.host]) {
+        return;
+    }
+    NSData *compressedBody = WPXMLRPCClientGzipData(body);
+    if (!compressedBody || [compressedBody length] >= [body length]) {
+        return;
+    }
+    [request setHTTPBody:compressedBody];
+    [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+    [NSURLProtocol setProperty:@YES forKey:WPXMLRPCClientCompressedBodyPropertyKey inRequest:request];
+}
+
+- (BOOL)isCompressedRequest:(NSURLRequest *)request {
+    return [[NSURLProtocol propertyForKey:WPXMLRPCClientCompressedBodyPropertyKey inRequest:request] boolValue];
+}
+
+- (NSMutableURLRequest *)uncompressedRequestForRequest:(NSURLRequest *)request {
+    NSData *body = WPXMLRPCClientGunzipData([request HTTPBody]);
+    if (!body) {
+        return nil;
+    }
+    NSMutableURLRequest *uncompressedRequest = [request mutableCopy];
+    [uncompressedRequest setHTTPBody:body];
+    [uncompressedRequest setValue:nil forHTTPHeaderField:@"Content-Encoding"];
+    [NSURLProtocol removePropertyForKey:WPXMLRPCClientCompressedBodyPropertyKey inRequest:uncompressedRequest];
+    return uncompressedRequest;
+}
+
+- (BOOL)isCompressionRejectionError:(NSError *)error operation:(AFHTTPRequestOperation *)operation {
+    if (error.code == WPXMLRPCClientParseErrorFaultCode) {
+        return YES;
+    }
+    NSHTTPURLResponse *response = operation.response ?: error.userInfo[AFNetworkingOperationFailingURLResponseErrorKey];
+    NSInteger statusCode = response.statusCode;
+    return statusCode == 400 || statusCode == 411 || statusCode == 415 || statusCode == 501;
+}
+
+/**
+ Wraps the failure block of a compressed request, so the request is sent again uncompressed if the host rejects the compressed body.
+ */
+- (void (^)(AFHTTPRequestOperation *, NSError *))failureFallingBackToUncompressedRequest:(NSURLRequest *)request
+                                                                          responseParser:(WPXMLRPCResponseParser)responseParser
+                                                                             decodeQueue:(NSOperationQueue *)decodeQueue
+                                                                         completionQueue:(dispatch_queue_t)completionQueue
+                                                                                 success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                                                                                 failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    return ^(AFHTTPRequestOperation *operation, NSError *error) {
+        NSMutableURLRequest *uncompressedRequest = nil;
+        if (![operation isCancelled] && [self isCompressionRejectionError:error operation:operation]) {
+            uncompressedRequest = [self uncompressedRequestForRequest:request];
+        }
+        if (!uncompressedRequest) {
+            if (failure) {
+                failure(operation, error);
+            }
+            return;
+        }
+
+        WPFLog(@"[XML-RPC] %@ rejected a compressed request body, sending it uncompressed", request.URL.host);
+        [[self class] rememberHostRejectingCompressedRequestBodies:request.URL.host];
+        if (!operation) {
+            [self sendRequest:uncompressedRequest decodeQueue:decodeQueue completionQueue:completionQueue success:success failure:failure];
+            return;
+        }
+        AFHTTPRequestOperation *fallbackOperation = [self HTTPRequestOperationWithRequest:uncompressedRequest responseParser:responseParser success:success failure:failure];
+        [self copyQueuesFromOperation:operation toOperation:fallbackOperation];
+        if ([operation isKindOfClass:[WPHTTPRequestOperation class]] && ![(WPHTTPRequestOperation *)operation continueWithRetryOperation:fallbackOperation]) {
+            if (failure) {
+                failure(operation, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]);
+            }
+            return;
+        }
+        [self enqueueHTTPRequestOperation:fallbackOperation];
+    };
+}
+
+#pragma mark - Retrying Failed Requests
+
+/**
+ Sends a failed request again if the retry policy allows it. The new operation is built with `operationBuilder` and enqueued after the backoff delay.
+
+ Must be called on the completion queue of the operation. Returns `YES` if the request will be retried, in which case the failure must not be reported yet. If the operation is cancelled while waiting for the retry, `failure` is called with a cancellation error.
+ */
+- (BOOL)retryFailedOperation:(AFHTTPRequestOperation *)operation
+                       error:(NSError *)error
+            operationBuilder:(AFHTTPRequestOperation *(^)(NSURLRequest *retryRequest))operationBuilder
+                     failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    if ([operation isCancelled] || ![operation isKindOfClass:[WPHTTPRequestOperation class]]) {
+        return NO;
+    }
+    return [self retryRequest:operation.request response:operation.response error:error queue:operation.completionQueue resend:^(NSURLRequest *retryRequest) {
+        AFHTTPRequestOperation *retryOperation = operationBuilder(retryRequest);
+        [self copyQueuesFromOperation:operation toOperation:retryOperation];
+        if ([(WPHTTPRequestOperation *)operation continueWithRetryOperation:retryOperation]) {
+            [self enqueueHTTPRequestOperation:retryOperation];
+        } else if (failure) {
+            failure(operation, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]);
+        }
+    }];
+}
+
+/**
+ Sends a request failed by a session task operation again if the retry policy allows it, with a new operation enqueued after the backoff delay. Behaves like `retryFailedOperation:error:operationBuilder:failure:`.
+ */
+- (BOOL)retryFailedSessionTaskOperation:(WPURLSessionTaskOperation *)operation
+                                  error:(NSError *)error
+                            decodeQueue:(NSOperationQueue *)decodeQueue
+                        completionQueue:(dispatch_queue_t)completionQueue
+                                success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                                failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    if (!operation || [operation isCancelled]) {
+        return NO;
+    }
+    return [self retryRequest:operation.request response:operation.response error:error queue:completionQueue resend:^(NSURLRequest *retryRequest) {
+        WPURLSessionTaskOperation *retryOperation = [self sessionTaskOperationWithRequest:retryRequest decodeQueue:decodeQueue completionQueue:completionQueue success:success failure:failure];
+        if ([operation continueWithRetryOperation:retryOperation]) {
+            [self.operationQueue addOperation:retryOperation];
+        } else if (failure) {
+            failure(nil, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]);
+        }
+    }];
+}
+
+/**
+ Asks the retry policy whether a failed request should be sent again, and if so calls `resend` on `queue` after the backoff delay, with a copy of the request counting the attempt. Returns `YES` if the request will be retried.
+ */
+- (BOOL)retryRequest:(NSURLRequest *)request
+            response:(NSHTTPURLResponse *)response
+               error:(NSError *)error
+               queue:(dispatch_queue_t)queue
+              resend:(void (^)(NSURLRequest *retryRequest))resend {
+    WPRetryPolicy *retryPolicy = self.retryPolicy;
+    if (!retryPolicy) {
+        return NO;
+    }
+    NSMutableURLRequest *retryRequest = [self requestForRetryingRequest:request];
+    if (!retryRequest) {
+        return NO;
+    }
+    NSUInteger attempt = [[NSURLProtocol propertyForKey:WPXMLRPCClientRetryAttemptPropertyKey inRequest:request] unsignedIntegerValue];
+    if (![retryPolicy shouldRetryIdempotent:[self isIdempotentRequest:request] response:response error:error attempt:attempt]) {
+        return NO;
+    }
+    [NSURLProtocol setProperty:@(attempt + 1) forKey:WPXMLRPCClientRetryAttemptPropertyKey inRequest:retryRequest];
+
+    NSTimeInterval delay = [retryPolicy delayBeforeRetryAttempt:attempt response:response];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), queue ?: dispatch_get_main_queue(), ^{
+        resend(retryRequest);
+    });
+    return YES;
+}
+
+/**
+ Returns a copy of the request with a fresh body stream, or `nil` if the body can't be produced again.
+ */
+- (NSMutableURLRequest *)requestForRetryingRequest:(NSURLRequest *)request {
+    NSMutableURLRequest *retryRequest = [request mutableCopy];
+    NSInputStream *bodyStream = request.HTTPBodyStream;
+    if (bodyStream) {
+        NSString *filePath = [NSURLProtocol propertyForKey:WPXMLRPCClientBodyFilePathPropertyKey inRequest:request];
+        if ([bodyStream conformsToProtocol:@protocol(NSCopying)]) {
+            retryRequest.HTTPBodyStream = [(id<NSCopying>)bodyStream copyWithZone:nil];
+        } else if (filePath && [[NSFileManager defaultManager] fileExistsAtPath:filePath]) {
+            retryRequest.HTTPBodyStream = [NSInputStream inputStreamWithFileAtPath:filePath];
+        } else {
+            return nil;
+        }
+    }
+    return retryRequest;
+}
+
+- (BOOL)isIdempotentRequest:(NSURLRequest *)request {
+    NSString *method = [NSURLProtocol propertyForKey:WPXMLRPCClientMethodNamePropertyKey inRequest:request];
+    if (![method isEqualToString:WPXMLRPCClientMulticallMethod]) {
+        return [self.retryPolicy isIdempotentMethod:method];
+    }
+    NSArray *methods = [NSURLProtocol propertyForKey:WPXMLRPCClientMulticallMethodsPropertyKey inRequest:request];
+    if ([methods count] == 0) {
+        return NO;
+    }
+    for (NSString *batchedMethod in methods) {
+        if (![self.retryPolicy isIdempotentMethod:batchedMethod]) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (WPRequestMetrics *)metricsForRequest:(NSURLRequest *)request {
+    if (!self.metricsObserver) {
+        return nil;
+    }
+    NSString *methodName = [NSURLProtocol propertyForKey:WPXMLRPCClientMethodNamePropertyKey inRequest:request];
+    return [[WPRequestMetrics alloc] initWithName:methodName request:request];
+}
+
+/**
+ Must be called on the completion queue of the request. A multicall is reported as one metrics per call, with the outcome of each call.
+ */
+- (void)reportMetrics:(WPRequestMetrics *)metrics request:(NSURLRequest *)request error:(NSError *)error responseObject:(id)responseObject {
+    if (!metrics) {
+        return;
+    }
+    [metrics finishWithError:error];
+    NSArray *methods = [NSURLProtocol propertyForKey:WPXMLRPCClientMulticallMethodsPropertyKey inRequest:request];
+    if ([methods count] == 0) {
+        [self.metricsObserver requestDidFinishWithMetrics:metrics];
+        return;
+    }
+    BOOL hasResponses = [responseObject isKindOfClass:[NSArray class]] && [responseObject count] == [methods count];
+    [methods enumerateObjectsUsingBlock:^(NSString *method, NSUInteger idx, BOOL *stop) {
+        NSError *callError = error;
+        if (!callError) {
+            callError = hasResponses ? [self errorForMulticallResponse:responseObject[idx]] : [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:nil];
+        }
+        [self.metricsObserver requestDidFinishWithMetrics:[metrics metricsForBatchedCallWithName:method error:callError]];
+    }];
+}
+
+/**
+ Must be called on the completion queue of the call.
+ */
+- (void)reportCachedResponseForMethod:(NSString *)method {
+    if (!self.metricsObserver) {
+        return;
+    }
+    [self.metricsObserver requestDidFinishWithMetrics:[[WPRequestMetrics alloc] initWithCachedResponseForName:method URL:self.xmlrpcEndpoint]];
+}
+
 - (WPXMLRPCRequestOperation *)XMLRPCRequestOperationWithRequest:(WPXMLRPCRequest *)request
                                                         success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
                                                         failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
@@ -220,42 +788,9 @@ static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
 }
 
 - (AFHTTPRequestOperation *)combinedHTTPRequestOperationWithOperations:(NSArray *)operations success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
-    NSMutableArray *parameters = [NSMutableArray array];
-
-    for (WPXMLRPCRequestOperation *operation in operations) {
-        NSDictionary *param = [NSDictionary dictionaryWithObjectsAndKeys:
-                               operation.XMLRPCRequest.method, @"methodName",
-                               operation.XMLRPCRequest.parameters, @"params",
-                               nil];
-        [parameters addObject:param];
-    }
-
-    NSURLRequest *request = [self requestWithMethod:@"system.multicall" parameters:parameters];
+    NSURLRequest *request = [self multicallRequestWithOperations:operations];
     void (^_success)(AFHTTPRequestOperation *operation, id responseObject) = ^(AFHTTPRequestOperation *multicallOperation, id responseObject) {
-        NSArray *responses = (NSArray *)responseObject;
-        for (int i = 0; i < [responses count]; i++) {
-            WPXMLRPCRequestOperation *operation = [operations objectAtIndex:i];
-            id object = [responses objectAtIndex:i];
-
-            NSError *error = nil;
-            if ([object isKindOfClass:[NSDictionary class]] && [object objectForKey:@"faultCode"] && [object objectForKey:@"faultString"]) {
-                NSDictionary *usrInfo = [NSDictionary dictionaryWithObjectsAndKeys:[object objectForKey:@"faultString"], NSLocalizedDescriptionKey, nil];
-                error = [NSError errorWithDomain:WPXMLRPCClientErrorDomain code:[[object objectForKey:@"faultCode"] intValue] userInfo:usrInfo];
-            } else if ([object isKindOfClass:[NSArray class]] && [object count] == 1) {
-                object = [object objectAtIndex:0];
-            }
-
-
-            if (error) {
-                if (operation.failure) {
-                    operation.failure(multicallOperation, error);
-                }
-            } else {
-                if (operation.success) {
-                    operation.success(multicallOperation, object);
-                }
-            }
-        }
+        [self dispatchMulticallResponses:responseObject toOperations:operations multicallOperation:multicallOperation];
         if (success) {
             success(multicallOperation, responseObject);
         }
@@ -276,35 +811,550 @@ static NSUInteger const WPXMLRPCClientDefaultMaxConcurrentOperationCount = 4;
     return operation;
 }
 
+- (NSURLRequest *)multicallRequestWithOperations:(NSArray *)operations {
+    NSMutableArray *parameters = [NSMutableArray array];
+    NSMutableArray *methods = [NSMutableArray array];
+
+    for (WPXMLRPCRequestOperation *operation in operations) {
+        NSDictionary *param = [NSDictionary dictionaryWithObjectsAndKeys:
+                               operation.XMLRPCRequest.method, @"methodName",
+                               operation.XMLRPCRequest.parameters, @"params",
+                               nil];
+        [parameters addObject:param];
+        [methods addObject:operation.XMLRPCRequest.method ?: @""];
+    }
+
+    NSMutableURLRequest *request = [self requestWithMethod:WPXMLRPCClientMulticallMethod parameters:parameters];
+    [NSURLProtocol setProperty:methods forKey:WPXMLRPCClientMulticallMethodsPropertyKey inRequest:request];
+    return request;
+}
+
+/**
+ Returns the fault of a call in a multicall response, or `nil` if the call succeeded.
+ */
+- (NSError *)errorForMulticallResponse:(id)object {
+    if ([object isKindOfClass:[NSDictionary class]] && [object objectForKey:@"faultCode"] && [object objectForKey:@"faultString"]) {
+        NSDictionary *usrInfo = [NSDictionary dictionaryWithObjectsAndKeys:[object objectForKey:@"faultString"], NSLocalizedDescriptionKey, nil];
+        return [NSError errorWithDomain:WPXMLRPCClientErrorDomain code:[[object objectForKey:@"faultCode"] intValue] userInfo:usrInfo];
+    }
+    return nil;
+}
+
+- (void)dispatchMulticallResponses:(NSArray *)responses toOperations:(NSArray *)operations multicallOperation:(AFHTTPRequestOperation *)multicallOperation {
+    for (NSUInteger i = 0; i < [responses count] && i < [operations count]; i++) {
+        WPXMLRPCRequestOperation *operation = [operations objectAtIndex:i];
+        id object = [responses objectAtIndex:i];
+
+        NSError *error = [self errorForMulticallResponse:object];
+        if (!error && [object isKindOfClass:[NSArray class]] && [object count] == 1) {
+            object = [object objectAtIndex:0];
+        }
+
+        if (error) {
+            if (operation.failure) {
+                operation.failure(multicallOperation, error);
+            }
+        } else {
+            if (operation.success) {
+                operation.success(multicallOperation, object);
+            }
+        }
+    }
+}
+
 #pragma mark - Managing Enqueued HTTP Operations
 
+- (WPRequestPriority)priority {
+    return self.operationQueue.priority;
+}
+
+- (void)setPriority:(WPRequestPriority)priority {
+    self.operationQueue.priority = priority;
+}
+
 - (void)enqueueHTTPRequestOperation:(AFHTTPRequestOperation *)operation {
     [self.operationQueue addOperation:operation];
 }
 
+- (void)enqueueHTTPRequestOperation:(AFHTTPRequestOperation *)operation priority:(WPRequestPriority)priority tag:(NSString *)tag {
+    [self.operationQueue.scheduler addOperation:operation priority:priority tag:tag owner:self.operationQueue];
+}
+
+- (void)cancelHTTPOperationsWithTag:(NSString *)tag {
+    [self.operationQueue.scheduler cancelOperationsWithTag:tag owner:self.operationQueue];
+}
+
 - (void)enqueueXMLRPCRequestOperation:(WPXMLRPCRequestOperation *)operation {
+    if ([self shouldBatchXMLRPCRequest:operation.XMLRPCRequest]) {
+        [self addBatchedOperation:operation];
+        return;
+    }
+    [self enqueueSingleXMLRPCRequestOperation:operation];
+}
+
+- (void)enqueueSingleXMLRPCRequestOperation:(WPXMLRPCRequestOperation *)operation {
     NSURLRequest *request = [self requestWithMethod:operation.XMLRPCRequest.method parameters:operation.XMLRPCRequest.parameters];
-    AFHTTPRequestOperation *op = [self HTTPRequestOperationWithRequest:request success:operation.success failure:operation.failure];
-    [self enqueueHTTPRequestOperation:op];
+    [self sendRequest:request success:operation.success failure:operation.failure];
 }
 
 - (void)cancelAllHTTPOperations {
+    __block NSArray *pendingOperations = nil;
+    dispatch_sync(self.batchingQueue, ^{
+        pendingOperations = [self.batchedOperations copy];
+        [self.batchedOperations removeAllObjects];
+        [self cancelBatchingTimer];
+    });
+    if ([pendingOperations count] > 0) {
+        NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil];
+        dispatch_async(self.completionQueue ?: dispatch_get_main_queue(), ^{
+            for (WPXMLRPCRequestOperation *operation in pendingOperations) {
+                if (operation.failure) {
+                    operation.failure(nil, error);
+                }
+            }
+        });
+    }
+
     for (AFHTTPRequestOperation *operation in [self.operationQueue operations]) {
         [operation cancel];
     }
+
+    NSArray *tasks = nil;
+    @synchronized(self.sessionTasks) {
+        tasks = [self.sessionTasks allObjects];
+    }
+    for (NSURLSessionTask *task in tasks) {
+        [task cancel];
+    }
+}
+
+#pragma mark - Warming Up Connections
+
+- (void)warmUpConnectionWithCompletion:(void (^)(NSTimeInterval duration, NSError *error))completion {
+    [[WPConnectionPrewarmer sharedPrewarmer] warmUpURL:self.xmlrpcEndpoint sessionTransport:self.sessionTransport completion:completion];
+}
+
+#pragma mark - Sending Requests over NSURLSession
+
+- (id)sendRequest:(NSURLRequest *)request
+          success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+          failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    return [self sendRequest:request decodeQueue:self.decodeQueue completionQueue:self.completionQueue success:success failure:failure];
+}
+
+/**
+ Sends a buffered request with the `sessionTransport`, or as an operation if there's none. Returns the task or operation sending it.
+ */
+- (id)sendRequest:(NSURLRequest *)request
+      decodeQueue:(NSOperationQueue *)decodeQueue
+  completionQueue:(dispatch_queue_t)completionQueue
+          success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+          failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    if (!self.sessionTransport) {
+        WPHTTPRequestOperation *operation = (WPHTTPRequestOperation *)[self HTTPRequestOperationWithRequest:request success:success failure:failure];
+        operation.decodeQueue = decodeQueue;
+        operation.completionQueue = completionQueue;
+        [self enqueueHTTPRequestOperation:operation];
+        return operation;
+    }
+
+    WPURLSessionTaskOperation *operation = [self sessionTaskOperationWithRequest:request decodeQueue:decodeQueue completionQueue:completionQueue success:success failure:failure];
+    // Scheduled like the other operations, so it counts against the host limits and has the queue's priority and tag
+    [self.operationQueue addOperation:operation];
+    return operation;
+}
+
+/**
+ Creates an operation sending a buffered request with the `sessionTransport`, retried by the `retryPolicy` and falling back to an uncompressed body like operations do.
+ */
+- (WPURLSessionTaskOperation *)sessionTaskOperationWithRequest:(NSURLRequest *)request
+                                                   decodeQueue:(NSOperationQueue *)decodeQueue
+                                               completionQueue:(dispatch_queue_t)completionQueue
+                                                       success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                                                       failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    void (^sessionFailure)(AFHTTPRequestOperation *, NSError *) = failure;
+    if ([self isCompressedRequest:request]) {
+        sessionFailure = [self failureFallingBackToUncompressedRequest:request responseParser:nil decodeQueue:decodeQueue completionQueue:completionQueue success:success failure:failure];
+    }
+    WPRequestMetrics *metrics = [self metricsForRequest:request];
+    // Released once the failure is handled, which breaks the cycle with the operation's completion handler
+    __block WPURLSessionTaskOperation *failedOperation = nil;
+    void (^retryingFailure)(AFHTTPRequestOperation *, NSError *) = ^(AFHTTPRequestOperation *unused, NSError *error) {
+        WPURLSessionTaskOperation *operation = failedOperation;
+        failedOperation = nil;
+        if ([self retryFailedSessionTaskOperation:operation error:error decodeQueue:decodeQueue completionQueue:completionQueue success:success failure:failure]) {
+            return;
+        }
+        if (sessionFailure) {
+            sessionFailure(nil, error);
+        }
+    };
+    WPURLSessionTaskOperation *operation = [self.sessionTransport dataTaskOperationWithRequest:request
+                                                                                      priority:[self sessionTaskPriority]
+                                                                             completionHandler:[self sessionCompletionHandlerWithMetrics:metrics request:request decodeQueue:decodeQueue completionQueue:completionQueue success:success failure:retryingFailure]];
+    operation.metrics = metrics;
+    failedOperation = operation;
+    return operation;
+}
+
+- (void (^)(NSHTTPURLResponse *, NSData *, NSError *))sessionCompletionHandlerWithMetrics:(WPRequestMetrics *)metrics
+                                                                                  request:(NSURLRequest *)request
+                                                                              decodeQueue:(NSOperationQueue *)decodeQueue
+                                                                          completionQueue:(dispatch_queue_t)completionQueue
+                                                                                  success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                                                                                  failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    return ^(NSHTTPURLResponse *response, NSData *data, NSError *error) {
+        // Sessions don't report progress per request, so timings are only known at the end
+        [metrics didReceiveResponse:response];
+        [metrics didReceiveDataOfLength:[data length]];
+        [metrics didFinishLoading];
+        if (error) {
+            dispatch_async(completionQueue ?: dispatch_get_main_queue(), ^(void) {
+                [self reportMetrics:metrics request:request error:error responseObject:nil];
+                if (failure) {
+                    failure(nil, error);
+                }
+            });
+            return;
+        }
+        [self decodeOnQueue:decodeQueue block:^(void) {
+            [metrics decodingDidStart];
+            WPXMLRPCDecoder *decoder = [[WPXMLRPCDecoder alloc] initWithData:data];
+            NSError *err = nil;
+            if ([decoder isFault] || [decoder object] == nil) {
+                err = [decoder error];
+            }
+            id object = [decoder object];
+            [metrics decodingDidFinish];
+
+            dispatch_async(completionQueue ?: dispatch_get_main_queue(), ^(void) {
+                [self reportMetrics:metrics request:request error:err responseObject:object];
+                if (err) {
+                    if (failure) {
+                        failure(nil, err);
+                    }
+                } else {
+                    [self.retryPolicy requestDidSucceed];
+                    if (success) {
+                        success(nil, object);
+                    }
+                }
+            });
+        }];
+    };
+}
+
+- (float)sessionTaskPriority {
+    switch (self.priority) {
+        case WPRequestPriorityInteractive:
+            return NSURLSessionTaskPriorityHigh;
+        case WPRequestPriorityBackgroundSync:
+            return NSURLSessionTaskPriorityDefault;
+        case WPRequestPriorityPrefetch:
+            return NSURLSessionTaskPriorityLow;
+    }
+    return NSURLSessionTaskPriorityDefault;
+}
+
+- (void)trackSessionTask:(NSURLSessionTask *)task {
+    if (!task) {
+        return;
+    }
+    @synchronized(self.sessionTasks) {
+        [self.sessionTasks addObject:task];
+    }
+}
+
+#pragma mark - Coalescing Calls
+
+- (BOOL)shouldBatchXMLRPCRequest:(WPXMLRPCRequest *)request {
+    return self.batchingEnabled
+        && !self.multicallUnsupported
+        && ![request.method isEqualToString:WPXMLRPCClientMulticallMethod];
+}
+
+- (void)addBatchedOperation:(WPXMLRPCRequestOperation *)operation {
+    dispatch_async(self.batchingQueue, ^{
+        [self.batchedOperations addObject:operation];
+        if ([self.batchedOperations count] >= MAX(self.maximumBatchSize, 1)) {
+            [self sendBatchedOperations];
+        } else if (!self.batchingTimer) {
+            [self startBatchingTimer];
+        }
+    });
+}
+
+/**
+ Takes a call out of the batch, if it hasn't been sent yet. Its callbacks aren't called.
+ */
+- (void)cancelBatchedOperation:(WPXMLRPCRequestOperation *)operation {
+    dispatch_async(self.batchingQueue, ^{
+        [self.batchedOperations removeObjectIdenticalTo:operation];
+        if ([self.batchedOperations count] == 0) {
+            [self cancelBatchingTimer];
+        }
+    });
+}
+
+- (void)flushBatchedCalls {
+    dispatch_async(self.batchingQueue, ^{
+        [self sendBatchedOperations];
+    });
+}
+
+- (void)startBatchingTimer {
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.batchingQueue);
+    int64_t interval = (int64_t)(self.batchingInterval * NSEC_PER_SEC);
+    dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, interval), DISPATCH_TIME_FOREVER, interval / 10);
+    __weak __typeof(self) weakSelf = self;
+    dispatch_source_set_event_handler(timer, ^{
+        [weakSelf sendBatchedOperations];
+    });
+    self.batchingTimer = timer;
+    dispatch_resume(timer);
+}
+
+- (void)cancelBatchingTimer {
+    if (self.batchingTimer) {
+        dispatch_source_cancel(self.batchingTimer);
+        self.batchingTimer = nil;
+    }
+}
+
+/**
+ Must be called on `batchingQueue`.
+ */
+- (void)sendBatchedOperations {
+    [self cancelBatchingTimer];
+
+    NSArray *operations = [self.batchedOperations copy];
+    [self.batchedOperations removeAllObjects];
+    if ([operations count] == 0) {
+        return;
+    }
+
+    if ([operations count] == 1 || self.multicallUnsupported) {
+        for (WPXMLRPCRequestOperation *operation in operations) {
+            [self enqueueSingleXMLRPCRequestOperation:operation];
+        }
+        return;
+    }
+
+    self.numberOfCoalescedCalls += [operations count];
+
+    NSURLRequest *request = [self multicallRequestWithOperations:operations];
+    [self sendRequest:request success:^(AFHTTPRequestOperation *operation, id responseObject) {
+        if (![responseObject isKindOfClass:[NSArray class]] || [responseObject count] != [operations count]) {
+            // The server may have run some of the calls, so only the ones safe to send twice are sent again
+            NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorBadServerResponse userInfo:nil];
+            [self fallBackToSingleCallsForOperations:operations multicallOperation:operation error:error];
+            return;
+        }
+        [self dispatchMulticallResponses:responseObject toOperations:operations multicallOperation:operation];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        if ([self isMulticallRejectionError:error operation:operation]) {
+            [self fallBackToSingleCallsForOperations:operations multicallOperation:operation error:error];
+            return;
+        }
+        for (WPXMLRPCRequestOperation *batchedOperation in operations) {
+            if (batchedOperation.failure) {
+                batchedOperation.failure(operation, error);
+            }
+        }
+    }];
+}
+
+/**
+ Returns whether a multicall failed because the server doesn't support `system.multicall`, rather than because of the calls in it.
+ */
+- (BOOL)isMulticallRejectionError:(NSError *)error operation:(AFHTTPRequestOperation *)operation {
+    BOOL isFault = [error.domain isEqualToString:WPXMLRPCClientErrorDomain] || [error.domain isEqualToString:WPXMLRPCFaultErrorDomain];
+    if (isFault) {
+        NSString *faultString = error.userInfo[NSLocalizedDescriptionKey];
+        return error.code == WPXMLRPCClientMethodNotFoundFaultCode && [faultString rangeOfString:WPXMLRPCClientMulticallMethod].location != NSNotFound;
+    }
+    // Requests sent by the session transport have no operation, the response is in the error
+    NSHTTPURLResponse *response = operation.response ?: error.userInfo[AFNetworkingOperationFailingURLResponseErrorKey];
+    NSInteger statusCode = response.statusCode;
+    return statusCode == 405 || statusCode == 501;
+}
+
+/**
+ Sends the calls of a failed multicall one by one. Calls which aren't idempotent fail with the multicall error instead, as the server may have run them already.
+ */
+- (void)fallBackToSingleCallsForOperations:(NSArray *)operations multicallOperation:(AFHTTPRequestOperation *)multicallOperation error:(NSError *)error {
+    WPFLog(@"[XML-RPC] system.multicall rejected by %@, sending %lu calls individually", self.xmlrpcEndpoint, (unsigned long)[operations count]);
+    NSMutableArray *replayedOperations = [NSMutableArray arrayWithCapacity:[operations count]];
+    for (WPXMLRPCRequestOperation *operation in operations) {
+        if ([self isReadMethod:operation.XMLRPCRequest.method]) {
+            [replayedOperations addObject:operation];
+        } else if (operation.failure) {
+            operation.failure(multicallOperation, error);
+        }
+    }
+    dispatch_async(self.batchingQueue, ^{
+        self.multicallUnsupported = YES;
+        self.numberOfCoalescedCalls -= MIN(self.numberOfCoalescedCalls, [operations count]);
+        for (WPXMLRPCRequestOperation *operation in replayedOperations) {
+            [self enqueueSingleXMLRPCRequestOperation:operation];
+        }
+        // Anything queued in the meantime can't be sent as multicall either
+        [self sendBatchedOperations];
+    });
 }
 
 #pragma mark - Making XML-RPC Requests
 
 - (void)callMethod:(NSString *)method
         parameters:(NSArray *)parameters
+           element:(void (^)(id element, NSUInteger index))element
+           success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+           failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    [self callMethod:method parameters:parameters memberFilter:nil element:element success:success failure:failure];
+}
+
+- (void)callMethod:(NSString *)method
+        parameters:(NSArray *)parameters
+      memberFilter:(NSSet *)memberFilter
+           element:(void (^)(id element, NSUInteger index))element
            success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
            failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
     NSURLRequest *request = [self requestWithMethod:method parameters:parameters];
-    AFHTTPRequestOperation *operation = [self HTTPRequestOperationWithRequest:request success:success failure:failure];
+    AFHTTPRequestOperation *operation = [self streamingHTTPRequestOperationWithRequest:request memberFilter:memberFilter element:element success:success failure:failure];
 
     [self enqueueHTTPRequestOperation:operation];
 }
 
+- (WPRequestHandle *)callMethod:(NSString *)method
+                     parameters:(NSArray *)parameters
+                        success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                        failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    return [self callMethod:method parameters:parameters decodeQueue:nil completionQueue:nil success:success failure:failure];
+}
+
+- (WPRequestHandle *)callMethod:(NSString *)method
+                     parameters:(NSArray *)parameters
+                    decodeQueue:(NSOperationQueue *)decodeQueue
+                completionQueue:(dispatch_queue_t)completionQueue
+                        success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+                        failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    decodeQueue = decodeQueue ?: self.decodeQueue;
+    completionQueue = completionQueue ?: self.completionQueue;
+    NSString *key = nil;
+    if (self.deduplicatesRequests && [self isReadMethod:method]) {
+        key = [WPResponseCache keyForEndpoint:self.xmlrpcEndpoint method:method parameters:parameters];
+    }
+    return [self.inFlightRequests requestWithKey:key completionQueue:completionQueue success:success failure:failure sender:^id(void (^success)(AFHTTPRequestOperation *, id), void (^failure)(AFHTTPRequestOperation *, NSError *)) {
+        return [self sendMethod:method parameters:parameters decodeQueue:decodeQueue completionQueue:completionQueue success:success failure:failure];
+    }];
+}
+
+/**
+ Sends a call, from the cache, batched or on its own, and calls back on `completionQueue`. Returns the task or operation sending it, if it can be cancelled.
+ */
+- (id)sendMethod:(NSString *)method
+      parameters:(NSArray *)parameters
+     decodeQueue:(NSOperationQueue *)decodeQueue
+ completionQueue:(dispatch_queue_t)completionQueue
+         success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+         failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    WPResponseCache *responseCache = self.responseCache;
+    if ([responseCache timeToLiveForMethod:method] > 0) {
+        NSString *cacheKey = [responseCache keyForEndpoint:self.xmlrpcEndpoint method:method parameters:parameters];
+        WPCachedResponse *cachedResponse = [responseCache cachedResponseForKey:cacheKey];
+        if (cachedResponse && ![cachedResponse isExpired]) {
+            dispatch_async(completionQueue ?: dispatch_get_main_queue(), ^{
+                [self reportCachedResponseForMethod:method];
+                if (success) {
+                    success(nil, cachedResponse.object);
+                }
+            });
+            return nil;
+        }
+        void (^networkSuccess)(AFHTTPRequestOperation *, id) = success;
+        success = ^(AFHTTPRequestOperation *operation, id responseObject) {
+            [responseCache storeObject:responseObject forKey:cacheKey method:method ETag:nil lastModified:nil];
+            if (networkSuccess) {
+                networkSuccess(operation, responseObject);
+            }
+        };
+    }
+
+    if (self.batchingEnabled) {
+        // Batched calls are decoded and called back with the multicall, on the client's queues
+        if (completionQueue != self.completionQueue) {
+            void (^batchedSuccess)(AFHTTPRequestOperation *, id) = success;
+            void (^batchedFailure)(AFHTTPRequestOperation *, NSError *) = failure;
+            success = ^(AFHTTPRequestOperation *operation, id responseObject) {
+                dispatch_async(completionQueue ?: dispatch_get_main_queue(), ^{
+                    if (batchedSuccess) {
+                        batchedSuccess(operation, responseObject);
+                    }
+                });
+            };
+            failure = ^(AFHTTPRequestOperation *operation, NSError *error) {
+                dispatch_async(completionQueue ?: dispatch_get_main_queue(), ^{
+                    if (batchedFailure) {
+                        batchedFailure(operation, error);
+                    }
+                });
+            };
+        }
+        WPXMLRPCRequest *request = [self XMLRPCRequestWithMethod:method parameters:parameters];
+        WPXMLRPCRequestOperation *operation = [self XMLRPCRequestOperationWithRequest:request success:success failure:failure];
+        [self enqueueXMLRPCRequestOperation:operation];
+        WPXMLRPCBatchedCall *batchedCall = [[WPXMLRPCBatchedCall alloc] init];
+        batchedCall.client = self;
+        batchedCall.operation = operation;
+        return batchedCall;
+    }
+
+    NSURLRequest *request = [self requestWithMethod:method parameters:parameters];
+    return [self sendRequest:request decodeQueue:decodeQueue completionQueue:completionQueue success:success failure:failure];
+}
+
+- (BOOL)isReadMethod:(NSString *)method {
+    static WPRetryPolicy *defaultPolicy;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        defaultPolicy = [WPRetryPolicy defaultPolicy];
+    });
+    return [(self.retryPolicy ?: defaultPolicy) isIdempotentMethod:method];
+}
+
+- (void)callMethod:(NSString *)method
+        parameters:(NSArray *)parameters
+usingFilePathForCache:(NSString *)filePath
+          progress:(void (^)(int64_t totalBytesSent, int64_t totalBytesExpectedToSend))progress
+           success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+           failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure {
+    NSURLRequest *request = [self streamingRequestWithMethod:method parameters:parameters usingFilePathForCache:filePath];
+
+    if (!self.sessionTransport) {
+        AFHTTPRequestOperation *operation = [self HTTPRequestOperationWithRequest:request success:success failure:failure];
+        if (progress) {
+            [operation setUploadProgressBlock:^(NSUInteger bytesWritten, long long totalBytesWritten, long long totalBytesExpectedToWrite) {
+                progress(totalBytesWritten, totalBytesExpectedToWrite);
+            }];
+        }
+        [self enqueueHTTPRequestOperation:operation];
+        return;
+    }
+
+    WPRequestMetrics *metrics = [self metricsForRequest:request];
+    [metrics operationDidStart];
+    NSURLSessionTask *task = [self.sessionTransport backgroundUploadTaskWithRequest:request
+                                                                           fromFile:[NSURL fileURLWithPath:filePath]
+                                                                           progress:^(int64_t totalBytesSent, int64_t totalBytesExpectedToSend) {
+                                                                               [metrics didSendBodyBytes:totalBytesSent];
+                                                                               if (progress) {
+                                                                                   progress(totalBytesSent, totalBytesExpectedToSend);
+                                                                               }
+                                                                           }
+                                                                  completionHandler:[self sessionCompletionHandlerWithMetrics:metrics request:request decodeQueue:self.decodeQueue completionQueue:self.completionQueue success:success failure:failure]];
+    task.taskDescription = method;
+    [self trackSessionTask:task];
+}
+
 
 @end
@@ -0,0 +1,62 @@
+#import <Foundation/Foundation.h>
+
+@class WPXMLRPCEndpointDiscovery;
+
+/**
+ A way of finding the XML-RPC endpoint. It must call exactly one of `success` or `failure`, on the main queue, and register any operation it enqueues with `addOperation:` so it can be cancelled.
+ */
+typedef void (^WPXMLRPCDiscoveryStrategy)(WPXMLRPCEndpointDiscovery *discovery, void (^success)(NSURL *xmlrpcURL), void (^failure)(NSError *error));
+
+/**
+ `WPXMLRPCEndpointDiscovery` races several strategies to find a XML-RPC endpoint, and finishes with the first one that succeeds.
+
+ Strategies are started in order. Each one gets a head start of `staggerInterval` before the next one starts, but a failure starts the next one right away. As soon as a strategy succeeds, all the operations of the others are cancelled.
+
+ A discovery must be started and used from the main queue.
+ */
+@interface WPXMLRPCEndpointDiscovery : NSObject
+
+/**
+ Initializes a discovery with the strategies to race, in order of preference.
+ */
+- (id)initWithStrategies:(NSArray *)strategies;
+
+/**
+ How long a strategy runs alone before the next one is started. Defaults to `0.75` seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval staggerInterval;
+
+/**
+ The index of the strategy whose error is reported if all of them fail. If it's out of bounds, the last error is reported.
+ */
+@property (nonatomic, assign) NSUInteger preferredErrorStrategyIndex;
+
+/**
+ A block deciding if an error should stop the discovery right away, instead of waiting for the other strategies.
+ */
+@property (nonatomic, copy) BOOL (^isFatalError)(NSError *error);
+
+/**
+ `YES` once the discovery has succeeded, failed or been cancelled.
+ */
+@property (nonatomic, readonly, getter=isFinished) BOOL finished;
+
+/**
+ Registers an operation started by a strategy, so it's cancelled when the discovery finishes. If the discovery has already finished, the operation is cancelled right away.
+ */
+- (void)addOperation:(NSOperation *)operation;
+
+/**
+ Starts racing the strategies.
+
+ @param success A block called with the first endpoint found.
+ @param failure A block called if every strategy fails, or one fails with a fatal error.
+ */
+- (void)startWithSuccess:(void (^)(NSURL *xmlrpcURL))success failure:(void (^)(NSError *error))failure;
+
+/**
+ Stops the discovery and cancels every pending operation. Neither callback is called.
+ */
+- (void)cancel;
+
+@end
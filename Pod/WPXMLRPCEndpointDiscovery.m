@@ -0,0 +1,128 @@
+#import "WPXMLRPCEndpointDiscovery.h"
+
+static NSTimeInterval const WPXMLRPCEndpointDiscoveryDefaultStaggerInterval = 0.75;
+
+@interface WPXMLRPCEndpointDiscovery ()
+@property (nonatomic, copy) NSArray *strategies;
+@property (nonatomic, strong) NSMutableArray *operations;
+@property (nonatomic, readwrite, getter=isFinished) BOOL finished;
+@property (nonatomic, copy) void (^success)(NSURL *xmlrpcURL);
+@property (nonatomic, copy) void (^failure)(NSError *error);
+@end
+
+@implementation WPXMLRPCEndpointDiscovery {
+    NSUInteger _nextStrategyIndex;
+    NSUInteger _pendingStrategies;
+    NSError *_preferredError;
+    NSError *_lastError;
+}
+
+- (id)initWithStrategies:(NSArray *)strategies {
+    self = [super init];
+    if (self) {
+        _strategies = [strategies copy];
+        _operations = [NSMutableArray array];
+        _staggerInterval = WPXMLRPCEndpointDiscoveryDefaultStaggerInterval;
+        _preferredErrorStrategyIndex = NSNotFound;
+    }
+    return self;
+}
+
+- (void)addOperation:(NSOperation *)operation {
+    if (self.finished) {
+        [operation cancel];
+        return;
+    }
+    [self.operations addObject:operation];
+}
+
+- (void)startWithSuccess:(void (^)(NSURL *xmlrpcURL))success failure:(void (^)(NSError *error))failure {
+    self.success = success;
+    self.failure = failure;
+    _pendingStrategies = [self.strategies count];
+    [self startNextStrategy];
+}
+
+- (void)cancel {
+    [self finish];
+}
+
+#pragma mark - Private
+
+- (void)startNextStrategy {
+    if (self.finished || _nextStrategyIndex >= [self.strategies count]) {
+        return;
+    }
+
+    NSUInteger index = _nextStrategyIndex++;
+    WPXMLRPCDiscoveryStrategy strategy = self.strategies[index];
+    strategy(self, ^(NSURL *xmlrpcURL) {
+        [self strategyAtIndex:index didSucceedWithURL:xmlrpcURL];
+    }, ^(NSError *error) {
+        [self strategyAtIndex:index didFailWithError:error];
+    });
+
+    if (_nextStrategyIndex < [self.strategies count]) {
+        NSUInteger expectedIndex = _nextStrategyIndex;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.staggerInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            // Only if a failure didn't start it already
+            if (_nextStrategyIndex == expectedIndex) {
+                [self startNextStrategy];
+            }
+        });
+    }
+}
+
+- (void)strategyAtIndex:(NSUInteger)index didSucceedWithURL:(NSURL *)xmlrpcURL {
+    if (self.finished) {
+        return;
+    }
+    void (^success)(NSURL *) = self.success;
+    [self finish];
+    if (success) {
+        success(xmlrpcURL);
+    }
+}
+
+- (void)strategyAtIndex:(NSUInteger)index didFailWithError:(NSError *)error {
+    if (self.finished) {
+        return;
+    }
+
+    if (self.isFatalError && self.isFatalError(error)) {
+        [self failWithError:error];
+        return;
+    }
+
+    _lastError = error;
+    if (index == self.preferredErrorStrategyIndex) {
+        _preferredError = error;
+    }
+    _pendingStrategies--;
+    if (_pendingStrategies == 0) {
+        [self failWithError:_preferredError ?: _lastError];
+        return;
+    }
+    [self startNextStrategy];
+}
+
+- (void)failWithError:(NSError *)error {
+    void (^failure)(NSError *) = self.failure;
+    [self finish];
+    if (failure) {
+        failure(error);
+    }
+}
+
+- (void)finish {
+    self.finished = YES;
+    self.success = nil;
+    self.failure = nil;
+    NSArray *operations = [self.operations copy];
+    [self.operations removeAllObjects];
+    for (NSOperation *operation in operations) {
+        [operation cancel];
+    }
+}
+
+@end
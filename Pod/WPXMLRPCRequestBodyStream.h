@@ -0,0 +1,27 @@
+#import <Foundation/Foundation.h>
+
+/**
+ `WPXMLRPCRequestBodyStream` produces the body of a XML-RPC request while it's being read by the connection.
+
+ Binary parameters (`NSData` or `NSFileHandle`) are base64 encoded in fixed-size chunks as the upload progresses, so the memory used doesn't depend on the size of the payload, and nothing is written to disk.
+
+ The total length of the body is known before the upload starts, so it can be used as `Content-Length`. If a file gets shorter while it's read, the stream fails with an error rather than sending a body shorter than announced.
+ */
+@interface WPXMLRPCRequestBodyStream : NSInputStream <NSCopying>
+
+/**
+ Initializes a body stream for the specified XML-RPC method and parameters.
+
+ @param method The XML-RPC method for the request.
+ @param parameters The XML-RPC parameters. Binary data can be passed as `NSData`, or as a `NSFileHandle` opened for reading a regular file. `NSInputStream` parameters are not supported, as their length can't be known in advance.
+
+ @return The newly-initialized body stream, or `nil` if some of the parameters can't be encoded.
+ */
+- (id)initWithMethod:(NSString *)method parameters:(NSArray *)parameters;
+
+/**
+ The total number of bytes this stream produces.
+ */
+@property (nonatomic, readonly) unsigned long long contentLength;
+
+@end
@@ -0,0 +1,402 @@
+#import "WPXMLRPCRequestBodyStream.h"
+
+// Must be a multiple of 3, so each chunk encodes to base64 without padding
+static NSUInteger const WPXMLRPCBase64ChunkLength = 3 * 16 * 1024;
+
+#pragma mark - Segments
+
+@interface WPXMLRPCBodySegment : NSObject
+@property (nonatomic, readonly) unsigned long long length;
+// Set when the segment couldn't produce all of its bytes
+@property (nonatomic, readonly) NSError *error;
+- (void)reset;
+- (NSData *)nextChunk;
+@end
+
+@implementation WPXMLRPCBodySegment
+- (unsigned long long)length { return 0; }
+- (NSError *)error { return nil; }
+- (void)reset {}
+- (NSData *)nextChunk { return nil; }
+@end
+
+@interface WPXMLRPCTextSegment : WPXMLRPCBodySegment
+- (id)initWithData:(NSData *)data;
+@end
+
+@implementation WPXMLRPCTextSegment {
+    NSData *_data;
+    BOOL _consumed;
+}
+
+- (id)initWithData:(NSData *)data {
+    self = [super init];
+    if (self) {
+        _data = data;
+    }
+    return self;
+}
+
+- (unsigned long long)length {
+    return [_data length];
+}
+
+- (void)reset {
+    _consumed = NO;
+}
+
+- (NSData *)nextChunk {
+    if (_consumed) {
+        return nil;
+    }
+    _consumed = YES;
+    return _data;
+}
+
+@end
+
+@interface WPXMLRPCBase64Segment : WPXMLRPCBodySegment
+- (id)initWithData:(NSData *)data;
+- (id)initWithFileHandle:(NSFileHandle *)fileHandle;
+@end
+
+@implementation WPXMLRPCBase64Segment {
+    NSData *_data;
+    NSFileHandle *_fileHandle;
+    unsigned long long _sourceLength;
+    unsigned long long _offset;
+    NSError *_error;
+}
+
+- (id)initWithData:(NSData *)data {
+    self = [super init];
+    if (self) {
+        _data = data;
+        _sourceLength = [data length];
+    }
+    return self;
+}
+
+- (id)initWithFileHandle:(NSFileHandle *)fileHandle {
+    self = [super init];
+    if (self) {
+        _fileHandle = fileHandle;
+        @try {
+            _sourceLength = [fileHandle seekToEndOfFile];
+            [fileHandle seekToFileOffset:0];
+        }
+        @catch (NSException *exception) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (unsigned long long)length {
+    return ((_sourceLength + 2) / 3) * 4;
+}
+
+- (NSError *)error {
+    return _error;
+}
+
+- (void)reset {
+    _offset = 0;
+    _error = nil;
+    [_fileHandle seekToFileOffset:0];
+}
+
+- (NSData *)nextChunk {
+    if (_offset >= _sourceLength || _error) {
+        return nil;
+    }
+    NSUInteger chunkLength = (NSUInteger)MIN((unsigned long long)WPXMLRPCBase64ChunkLength, _sourceLength - _offset);
+    NSData *chunk = nil;
+    if (_data) {
+        chunk = [_data subdataWithRange:NSMakeRange((NSUInteger)_offset, chunkLength)];
+    } else {
+        @try {
+            chunk = [_fileHandle readDataOfLength:chunkLength];
+        }
+        @catch (NSException *exception) {
+            chunk = nil;
+        }
+        if ([chunk length] != chunkLength) {
+            // The file changed under us, the Content-Length we sent is now wrong
+            _error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadUnknownError userInfo:nil];
+            return nil;
+        }
+    }
+    _offset += chunkLength;
+    return [chunk base64EncodedDataWithOptions:0];
+}
+
+@end
+
+#pragma mark - Body stream
+
+@interface WPXMLRPCRequestBodyStream ()
+@property (readwrite) NSStreamStatus streamStatus;
+@property (readwrite, copy) NSError *streamError;
+@property (nonatomic, copy) NSString *method;
+@property (nonatomic, copy) NSArray *parameters;
+@property (nonatomic, strong) NSArray *segments;
+@property (nonatomic, readwrite) unsigned long long contentLength;
+@end
+
+@implementation WPXMLRPCRequestBodyStream {
+    NSUInteger _segmentIndex;
+    NSData *_chunk;
+    NSUInteger _chunkOffset;
+    NSMutableData *_pendingText;
+    NSMutableArray *_builtSegments;
+}
+@synthesize streamStatus;
+@synthesize streamError;
+@synthesize delegate;
+
+- (id)initWithMethod:(NSString *)method parameters:(NSArray *)parameters {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+
+    self.method = method;
+    self.parameters = parameters;
+
+    _builtSegments = [NSMutableArray array];
+    _pendingText = [NSMutableData data];
+    [self appendText:@"<?xml version=\"1.0\"?><methodCall><methodName>"];
+    [self appendText:[self escapedString:method]];
+    [self appendText:@"</methodName><params>"];
+    for (id parameter in parameters) {
+        [self appendText:@"<param><value>"];
+        if (![self appendValue:parameter]) {
+            return nil;
+        }
+        [self appendText:@"</value></param>"];
+    }
+    [self appendText:@"</params></methodCall>"];
+    [self flushText];
+
+    self.segments = _builtSegments;
+    _builtSegments = nil;
+    _pendingText = nil;
+
+    unsigned long long contentLength = 0;
+    for (WPXMLRPCBodySegment *segment in self.segments) {
+        contentLength += segment.length;
+    }
+    self.contentLength = contentLength;
+
+    return self;
+}
+
+#pragma mark - Encoding
+
+- (void)appendText:(NSString *)text {
+    [_pendingText appendData:[text dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (void)flushText {
+    if ([_pendingText length] > 0) {
+        [_builtSegments addObject:[[WPXMLRPCTextSegment alloc] initWithData:[_pendingText copy]]];
+        [_pendingText setLength:0];
+    }
+}
+
+- (BOOL)appendValue:(id)value {
+    if ([value isKindOfClass:[NSString class]]) {
+        [self appendText:[NSString stringWithFormat:@"<string>%@</string>", [self escapedString:value]]];
+    } else if ([value isKindOfClass:[NSNumber class]]) {
+        [self appendNumber:value];
+    } else if ([value isKindOfClass:[NSDate class]]) {
+        [self appendText:[NSString stringWithFormat:@"<dateTime.iso8601>%@</dateTime.iso8601>", [[[self class] dateFormatter] stringFromDate:value]]];
+    } else if ([value isKindOfClass:[NSArray class]]) {
+        [self appendText:@"<array><data>"];
+        for (id element in value) {
+            [self appendText:@"<value>"];
+            if (![self appendValue:element]) {
+                return NO;
+            }
+            [self appendText:@"</value>"];
+        }
+        [self appendText:@"</data></array>"];
+    } else if ([value isKindOfClass:[NSDictionary class]]) {
+        [self appendText:@"<struct>"];
+        for (id key in value) {
+            [self appendText:[NSString stringWithFormat:@"<member><name>%@</name><value>", [self escapedString:[key description]]]];
+            if (![self appendValue:[value objectForKey:key]]) {
+                return NO;
+            }
+            [self appendText:@"</value></member>"];
+        }
+        [self appendText:@"</struct>"];
+    } else if ([value isKindOfClass:[NSData class]]) {
+        [self appendText:@"<base64>"];
+        [self flushText];
+        [_builtSegments addObject:[[WPXMLRPCBase64Segment alloc] initWithData:value]];
+        [self appendText:@"</base64>"];
+    } else if ([value isKindOfClass:[NSFileHandle class]]) {
+        WPXMLRPCBase64Segment *segment = [[WPXMLRPCBase64Segment alloc] initWithFileHandle:value];
+        if (!segment) {
+            return NO;
+        }
+        [self appendText:@"<base64>"];
+        [self flushText];
+        [_builtSegments addObject:segment];
+        [self appendText:@"</base64>"];
+    } else if ([value isKindOfClass:[NSNull class]]) {
+        [self appendText:@"<string></string>"];
+    } else {
+        return NO;
+    }
+    return YES;
+}
+
+- (void)appendNumber:(NSNumber *)number {
+    if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+        [self appendText:[NSString stringWithFormat:@"<boolean>%d</boolean>", [number boolValue] ? 1 : 0]];
+        return;
+    }
+    const char *type = [number objCType];
+    if (strcmp(type, @encode(float)) == 0 || strcmp(type, @encode(double)) == 0) {
+        [self appendText:[NSString stringWithFormat:@"<double>%@</double>", [number stringValue]]];
+    } else {
+        [self appendText:[NSString stringWithFormat:@"<int>%lld</int>", [number longLongValue]]];
+    }
+}
+
+- (NSString *)escapedString:(NSString *)string {
+    if ([string rangeOfCharacterFromSet:[NSCharacterSet characterSetWithCharactersInString:@"&<>"]].location == NSNotFound) {
+        return string;
+    }
+    NSMutableString *escaped = [string mutableCopy];
+    [escaped replaceOccurrencesOfString:@"&" withString:@"&amp;" options:NSLiteralSearch range:NSMakeRange(0, [escaped length])];
+    [escaped replaceOccurrencesOfString:@"<" withString:@"&lt;" options:NSLiteralSearch range:NSMakeRange(0, [escaped length])];
+    [escaped replaceOccurrencesOfString:@">" withString:@"&gt;" options:NSLiteralSearch range:NSMakeRange(0, [escaped length])];
+    return escaped;
+}
+
++ (NSDateFormatter *)dateFormatter {
+    static NSDateFormatter *formatter;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        formatter = [[NSDateFormatter alloc] init];
+        formatter.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+        formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+        formatter.dateFormat = @"yyyyMMdd'T'HH:mm:ss";
+    });
+    return formatter;
+}
+
+#pragma mark - NSInputStream
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length {
+    if ([self streamStatus] == NSStreamStatusClosed) {
+        return 0;
+    }
+    if ([self streamStatus] == NSStreamStatusError) {
+        return -1;
+    }
+
+    NSInteger totalNumberOfBytesRead = 0;
+    while ((NSUInteger)totalNumberOfBytesRead < length) {
+        if (_chunkOffset >= [_chunk length]) {
+            _chunk = [self nextChunk];
+            _chunkOffset = 0;
+            if (self.streamError) {
+                return -1;
+            }
+            if (!_chunk) {
+                break;
+            }
+        }
+        NSUInteger available = MIN([_chunk length] - _chunkOffset, length - (NSUInteger)totalNumberOfBytesRead);
+        [_chunk getBytes:buffer + totalNumberOfBytesRead range:NSMakeRange(_chunkOffset, available)];
+        _chunkOffset += available;
+        totalNumberOfBytesRead += available;
+    }
+
+    if (totalNumberOfBytesRead == 0 && !_chunk) {
+        self.streamStatus = NSStreamStatusAtEnd;
+    }
+    return totalNumberOfBytesRead;
+}
+
+- (NSData *)nextChunk {
+    while (_segmentIndex < [self.segments count]) {
+        WPXMLRPCBodySegment *segment = [self.segments objectAtIndex:_segmentIndex];
+        NSData *chunk = [segment nextChunk];
+        if (chunk) {
+            return chunk;
+        }
+        if (segment.error) {
+            // Ending the body early would send less than its Content-Length, so the request fails instead
+            self.streamError = segment.error;
+            self.streamStatus = NSStreamStatusError;
+            return nil;
+        }
+        _segmentIndex++;
+    }
+    return nil;
+}
+
+- (BOOL)getBuffer:(__unused uint8_t **)buffer length:(__unused NSUInteger *)len {
+    return NO;
+}
+
+- (BOOL)hasBytesAvailable {
+    return [self streamStatus] == NSStreamStatusOpen;
+}
+
+- (void)open {
+    if (self.streamStatus == NSStreamStatusOpen) {
+        return;
+    }
+    for (WPXMLRPCBodySegment *segment in self.segments) {
+        [segment reset];
+    }
+    _segmentIndex = 0;
+    _chunk = nil;
+    _chunkOffset = 0;
+    self.streamError = nil;
+    self.streamStatus = NSStreamStatusOpen;
+}
+
+- (void)close {
+    self.streamStatus = NSStreamStatusClosed;
+}
+
+- (id)propertyForKey:(__unused NSString *)key {
+    return nil;
+}
+
+- (BOOL)setProperty:(__unused id)property forKey:(__unused NSString *)key {
+    return NO;
+}
+
+- (void)scheduleInRunLoop:(__unused NSRunLoop *)aRunLoop forMode:(__unused NSString *)mode {}
+
+- (void)removeFromRunLoop:(__unused NSRunLoop *)aRunLoop forMode:(__unused NSString *)mode {}
+
+#pragma mark - Undocumented CFReadStream Bridged Methods
+
+- (void)_scheduleInCFRunLoop:(__unused CFRunLoopRef)aRunLoop forMode:(__unused CFStringRef)aMode {}
+
+- (void)_unscheduleFromCFRunLoop:(__unused CFRunLoopRef)aRunLoop forMode:(__unused CFStringRef)aMode {}
+
+- (BOOL)_setCFClientFlags:(__unused CFOptionFlags)inFlags
+                 callback:(__unused CFReadStreamClientCallBack)inCallback
+                  context:(__unused CFStreamClientContext *)inContext {
+    return NO;
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone {
+    // Used when the connection needs a new body stream, e.g. after an authentication challenge
+    return [[[self class] allocWithZone:zone] initWithMethod:self.method parameters:self.parameters];
+}
+
+@end
@@ -0,0 +1,64 @@
+#import <Foundation/Foundation.h>
+
+extern NSString *const WPXMLRPCStreamingDecoderErrorDomain;
+
+/**
+ `WPXMLRPCStreamingDecoder` decodes a XML-RPC response incrementally, as bytes arrive from the connection.
+
+ Unlike `WPXMLRPCDecoder`, it doesn't need the whole response in memory. If the response is an array (e.g. the result of `metaWeblog.getRecentPosts`), each element is handed to the element handler as soon as it's complete.
+
+ A decoder is not thread safe: all the calls to `appendData:` and `finish` must be made from the same serial queue.
+ */
+@interface WPXMLRPCStreamingDecoder : NSObject
+
+/**
+ Initializes a decoder without an element handler. The decoded response is available in `object` after calling `finish`.
+ */
+- (id)init;
+
+/**
+ Initializes a decoder which reports elements of a top-level array as they are decoded.
+
+ @param elementHandler A block called for each element of the top-level array, as soon as it's complete. It takes two arguments: the decoded element and its index in the array. Elements passed to this block are not kept by the decoder, so they won't be part of `object`.
+
+ @return The newly-initialized decoder
+ */
+- (id)initWithElementHandler:(void (^)(id element, NSUInteger index))elementHandler;
+
+/**
+ If set, only the members with these names are decoded in the structs that make up the response: the top-level struct, or the structs in the top-level array. Other members are skipped without decoding their values. Fault structs are always decoded whole.
+
+ Must be set before the first call to `appendData:`.
+ */
+@property (nonatomic, copy) NSSet *memberFilter;
+
+/**
+ Parses a new chunk of the response.
+
+ @param data The bytes received since the last call.
+ */
+- (void)appendData:(NSData *)data;
+
+/**
+ Tells the decoder there is no more data, and completes decoding.
+ */
+- (void)finish;
+
+/**
+ The decoded response, or `nil` if the response couldn't be decoded. If the response was a fault, this is the fault struct.
+
+ When an element handler is set, the elements of the top-level array are not included.
+ */
+@property (nonatomic, readonly) id object;
+
+/**
+ `YES` if the response was a XML-RPC fault.
+ */
+@property (nonatomic, readonly) BOOL isFault;
+
+/**
+ The fault or parsing error, or `nil` if the response was decoded successfully.
+ */
+@property (nonatomic, readonly) NSError *error;
+
+@end
@@ -0,0 +1,413 @@
+#import "WPXMLRPCStreamingDecoder.h"
+#import "WPXMLRPCClient.h"
+
+#import <libxml/parser.h>
+
+NSString *const WPXMLRPCStreamingDecoderErrorDomain = @"WPXMLRPCStreamingDecoderError";
+
+typedef NS_ENUM(NSUInteger, WPXMLRPCElement) {
+    WPXMLRPCElementOther,
+    WPXMLRPCElementValue,
+    WPXMLRPCElementStruct,
+    WPXMLRPCElementArray,
+    WPXMLRPCElementMember,
+    WPXMLRPCElementName,
+    WPXMLRPCElementFault,
+    WPXMLRPCElementString,
+    WPXMLRPCElementInteger,
+    WPXMLRPCElementBoolean,
+    WPXMLRPCElementDouble,
+    WPXMLRPCElementDate,
+    WPXMLRPCElementBase64,
+    WPXMLRPCElementNil,
+};
+
+static WPXMLRPCElement WPXMLRPCElementForName(const xmlChar *name) {
+    const char *n = (const char *)name;
+    switch (n[0]) {
+        case 'v': if (strcmp(n, "value") == 0) return WPXMLRPCElementValue; break;
+        case 's':
+            if (strcmp(n, "string") == 0) return WPXMLRPCElementString;
+            if (strcmp(n, "struct") == 0) return WPXMLRPCElementStruct;
+            break;
+        case 'a': if (strcmp(n, "array") == 0) return WPXMLRPCElementArray; break;
+        case 'm': if (strcmp(n, "member") == 0) return WPXMLRPCElementMember; break;
+        case 'n':
+            if (strcmp(n, "name") == 0) return WPXMLRPCElementName;
+            if (strcmp(n, "nil") == 0) return WPXMLRPCElementNil;
+            break;
+        case 'f': if (strcmp(n, "fault") == 0) return WPXMLRPCElementFault; break;
+        case 'i':
+            if (strcmp(n, "int") == 0 || strcmp(n, "i4") == 0 || strcmp(n, "i8") == 0) return WPXMLRPCElementInteger;
+            break;
+        case 'b':
+            if (strcmp(n, "boolean") == 0) return WPXMLRPCElementBoolean;
+            if (strcmp(n, "base64") == 0) return WPXMLRPCElementBase64;
+            break;
+        case 'd':
+            if (strcmp(n, "double") == 0) return WPXMLRPCElementDouble;
+            if (strcmp(n, "dateTime.iso8601") == 0) return WPXMLRPCElementDate;
+            break;
+    }
+    return WPXMLRPCElementOther;
+}
+
+static void WPXMLRPCStartElement(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI, int nb_namespaces, const xmlChar **namespaces, int nb_attributes, int nb_defaulted, const xmlChar **attributes);
+static void WPXMLRPCEndElement(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI);
+static void WPXMLRPCCharacters(void *ctx, const xmlChar *ch, int len);
+
+@interface WPXMLRPCStreamingDecoder ()
+- (void)didStartElement:(WPXMLRPCElement)element;
+- (void)didEndElement:(WPXMLRPCElement)element;
+- (void)foundCharacters:(const char *)characters length:(NSUInteger)length;
+@end
+
+@implementation WPXMLRPCStreamingDecoder {
+    xmlParserCtxtPtr _context;
+    NSMutableData *_prefix;
+    void (^_elementHandler)(id element, NSUInteger index);
+    NSUInteger _elementCount;
+
+    NSMutableArray *_containers;
+    NSMutableArray *_memberNames;
+    NSMutableData *_text;
+    BOOL _capturingText;
+    id _scalar;
+    WPXMLRPCElement _scalarType;
+    BOOL _hasTypedValue;
+    BOOL _finished;
+    BOOL _skippingMember;
+    NSUInteger _skippedDepth;
+
+    id _object;
+    BOOL _isFault;
+    NSError *_error;
+}
+
+- (id)init {
+    return [self initWithElementHandler:nil];
+}
+
+- (id)initWithElementHandler:(void (^)(id element, NSUInteger index))elementHandler {
+    self = [super init];
+    if (self) {
+        _elementHandler = [elementHandler copy];
+        _prefix = [NSMutableData data];
+        _containers = [NSMutableArray array];
+        _memberNames = [NSMutableArray array];
+        _text = [NSMutableData data];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_context) {
+        xmlFreeParserCtxt(_context);
+    }
+}
+
+#pragma mark - Feeding data
+
+- (void)appendData:(NSData *)data {
+    if (_finished || _error || [data length] == 0) {
+        return;
+    }
+
+    if (!_context) {
+        // Some plugins print PHP warnings before the actual response, skip anything before the XML starts
+        [_prefix appendData:data];
+        NSRange start = [self rangeOfDocumentStartInData:_prefix];
+        if (start.location == NSNotFound) {
+            return;
+        }
+        [self createParserContext];
+        NSData *document = [_prefix subdataWithRange:NSMakeRange(start.location, [_prefix length] - start.location)];
+        _prefix = nil;
+        [self parseBytes:[document bytes] length:[document length] terminate:NO];
+        return;
+    }
+
+    [self parseBytes:[data bytes] length:[data length] terminate:NO];
+}
+
+- (void)finish {
+    if (_finished) {
+        return;
+    }
+    if (!_context && !_error) {
+        _error = [NSError errorWithDomain:WPXMLRPCStreamingDecoderErrorDomain
+                                     code:XML_ERR_DOCUMENT_EMPTY
+                                 userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"The server returned an empty or invalid response", @"")}];
+    }
+    if (_context && !_error) {
+        [self parseBytes:NULL length:0 terminate:YES];
+    }
+    _finished = YES;
+
+    if (!_error && _object == nil) {
+        _error = [NSError errorWithDomain:WPXMLRPCStreamingDecoderErrorDomain
+                                     code:XML_ERR_DOCUMENT_END
+                                 userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"The server returned an empty or invalid response", @"")}];
+    }
+    if (!_error && _isFault) {
+        NSString *faultString = [_object isKindOfClass:[NSDictionary class]] ? [_object objectForKey:@"faultString"] : nil;
+        NSInteger faultCode = [_object isKindOfClass:[NSDictionary class]] ? [[_object objectForKey:@"faultCode"] integerValue] : 0;
+        _error = [NSError errorWithDomain:WPXMLRPCClientErrorDomain
+                                     code:faultCode
+                                 userInfo:faultString ? @{NSLocalizedDescriptionKey: faultString} : nil];
+    }
+}
+
+- (id)object {
+    return _object;
+}
+
+- (BOOL)isFault {
+    return _isFault;
+}
+
+- (NSError *)error {
+    return _error;
+}
+
+#pragma mark - libxml2
+
+- (NSRange)rangeOfDocumentStartInData:(NSData *)data {
+    NSRange range = [data rangeOfData:[@"<?xml" dataUsingEncoding:NSUTF8StringEncoding] options:0 range:NSMakeRange(0, [data length])];
+    if (range.location == NSNotFound) {
+        range = [data rangeOfData:[@"<methodResponse" dataUsingEncoding:NSUTF8StringEncoding] options:0 range:NSMakeRange(0, [data length])];
+    }
+    return range;
+}
+
+- (void)createParserContext {
+    static xmlSAXHandler handler;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        memset(&handler, 0, sizeof(xmlSAXHandler));
+        handler.initialized = XML_SAX2_MAGIC;
+        handler.startElementNs = WPXMLRPCStartElement;
+        handler.endElementNs = WPXMLRPCEndElement;
+        handler.characters = WPXMLRPCCharacters;
+        handler.cdataBlock = WPXMLRPCCharacters;
+    });
+    _context = xmlCreatePushParserCtxt(&handler, (__bridge void *)self, NULL, 0, NULL);
+    xmlCtxtUseOptions(_context, XML_PARSE_NONET | XML_PARSE_NOWARNING | XML_PARSE_NOERROR);
+}
+
+- (void)parseBytes:(const void *)bytes length:(NSUInteger)length terminate:(BOOL)terminate {
+    int result = xmlParseChunk(_context, (const char *)bytes, (int)length, terminate ? 1 : 0);
+    if (result != XML_ERR_OK && !_error) {
+        _error = [NSError errorWithDomain:WPXMLRPCStreamingDecoderErrorDomain
+                                     code:result
+                                 userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"The server returned an invalid XML-RPC response", @"")}];
+    }
+}
+
+#pragma mark - Building objects
+
+- (void)didStartElement:(WPXMLRPCElement)element {
+    if (_skippingMember) {
+        _skippedDepth++;
+        return;
+    }
+    switch (element) {
+        case WPXMLRPCElementValue:
+            _hasTypedValue = NO;
+            _scalar = nil;
+            [_text setLength:0];
+            _capturingText = YES;
+            break;
+        case WPXMLRPCElementStruct:
+            [_containers addObject:[NSMutableDictionary dictionary]];
+            _hasTypedValue = YES;
+            _capturingText = NO;
+            break;
+        case WPXMLRPCElementArray:
+            [_containers addObject:[NSMutableArray array]];
+            _hasTypedValue = YES;
+            _capturingText = NO;
+            break;
+        case WPXMLRPCElementMember:
+            [_memberNames addObject:@""];
+            break;
+        case WPXMLRPCElementName:
+            [_text setLength:0];
+            _capturingText = YES;
+            break;
+        case WPXMLRPCElementFault:
+            _isFault = YES;
+            break;
+        case WPXMLRPCElementString:
+        case WPXMLRPCElementInteger:
+        case WPXMLRPCElementBoolean:
+        case WPXMLRPCElementDouble:
+        case WPXMLRPCElementDate:
+        case WPXMLRPCElementBase64:
+        case WPXMLRPCElementNil:
+            _hasTypedValue = YES;
+            _scalarType = element;
+            [_text setLength:0];
+            _capturingText = YES;
+            break;
+        case WPXMLRPCElementOther:
+            break;
+    }
+}
+
+- (void)didEndElement:(WPXMLRPCElement)element {
+    if (_skippingMember) {
+        if (_skippedDepth > 0) {
+            _skippedDepth--;
+            return;
+        }
+        // Back at the closing </member> of the skipped member
+        _skippingMember = NO;
+    }
+    switch (element) {
+        case WPXMLRPCElementValue: {
+            id value = _hasTypedValue ? _scalar : [self textString];
+            _scalar = nil;
+            _hasTypedValue = NO;
+            _capturingText = NO;
+            [self addValue:value ?: [NSNull null]];
+            break;
+        }
+        case WPXMLRPCElementStruct:
+        case WPXMLRPCElementArray:
+            _scalar = [_containers lastObject];
+            [_containers removeLastObject];
+            _hasTypedValue = YES;
+            break;
+        case WPXMLRPCElementMember:
+            [_memberNames removeLastObject];
+            break;
+        case WPXMLRPCElementName:
+            if ([_memberNames count] > 0) {
+                NSString *name = [self textString];
+                [_memberNames replaceObjectAtIndex:[_memberNames count] - 1 withObject:name];
+                if ([self shouldSkipMemberWithName:name]) {
+                    _skippingMember = YES;
+                    _skippedDepth = 0;
+                }
+            }
+            _capturingText = NO;
+            break;
+        case WPXMLRPCElementString:
+        case WPXMLRPCElementInteger:
+        case WPXMLRPCElementBoolean:
+        case WPXMLRPCElementDouble:
+        case WPXMLRPCElementDate:
+        case WPXMLRPCElementBase64:
+        case WPXMLRPCElementNil:
+            _scalar = [self scalarOfType:_scalarType];
+            _capturingText = NO;
+            break;
+        case WPXMLRPCElementFault:
+        case WPXMLRPCElementOther:
+            break;
+    }
+}
+
+- (void)foundCharacters:(const char *)characters length:(NSUInteger)length {
+    if (_capturingText) {
+        [_text appendBytes:characters length:length];
+    }
+}
+
+- (void)addValue:(id)value {
+    id container = [_containers lastObject];
+    if (container == nil) {
+        _object = value;
+    } else if ([container isKindOfClass:[NSMutableDictionary class]]) {
+        NSString *name = [_memberNames lastObject];
+        if (name) {
+            [container setObject:value forKey:name];
+        }
+    } else if ([_containers count] == 1 && _elementHandler && !_isFault) {
+        _elementHandler(value, _elementCount++);
+    } else {
+        [container addObject:value];
+    }
+}
+
+- (BOOL)shouldSkipMemberWithName:(NSString *)name {
+    if (!_memberFilter || _isFault || [_memberFilter containsObject:name]) {
+        return NO;
+    }
+    // Only members of the top-level struct, or of the structs in the top-level array, are filtered
+    NSUInteger depth = [_containers count];
+    return depth == 1 || (depth == 2 && [_containers[0] isKindOfClass:[NSMutableArray class]]);
+}
+
+- (NSString *)textString {
+    return [[NSString alloc] initWithData:_text encoding:NSUTF8StringEncoding] ?: @"";
+}
+
+- (id)scalarOfType:(WPXMLRPCElement)type {
+    switch (type) {
+        case WPXMLRPCElementString:
+            return [self textString];
+        case WPXMLRPCElementInteger:
+            return @([[self trimmedTextString] longLongValue]);
+        case WPXMLRPCElementBoolean:
+            return @([[self trimmedTextString] boolValue]);
+        case WPXMLRPCElementDouble:
+            return @([[self trimmedTextString] doubleValue]);
+        case WPXMLRPCElementDate:
+            return [[self class] dateFromString:[self trimmedTextString]];
+        case WPXMLRPCElementBase64:
+            return [[NSData alloc] initWithBase64EncodedData:_text options:NSDataBase64DecodingIgnoreUnknownCharacters];
+        case WPXMLRPCElementNil:
+            return [NSNull null];
+        default:
+            return [self textString];
+    }
+}
+
+- (NSString *)trimmedTextString {
+    return [[self textString] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+}
+
++ (NSDate *)dateFromString:(NSString *)string {
+    static NSArray *formatters;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSMutableArray *result = [NSMutableArray array];
+        for (NSString *format in @[@"yyyyMMdd'T'HH:mm:ss", @"yyyyMMdd'T'HH:mm:ssZ", @"yyyy-MM-dd'T'HH:mm:ss", @"yyyy-MM-dd'T'HH:mm:ssZ"]) {
+            NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+            formatter.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+            formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+            formatter.dateFormat = format;
+            [result addObject:formatter];
+        }
+        formatters = result;
+    });
+
+    for (NSDateFormatter *formatter in formatters) {
+        NSDate *date = [formatter dateFromString:string];
+        if (date) {
+            return date;
+        }
+    }
+    return nil;
+}
+
+@end
+
+#pragma mark - SAX callbacks
+
+static void WPXMLRPCStartElement(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI, int nb_namespaces, const xmlChar **namespaces, int nb_attributes, int nb_defaulted, const xmlChar **attributes) {
+    WPXMLRPCStreamingDecoder *decoder = (__bridge WPXMLRPCStreamingDecoder *)ctx;
+    [decoder didStartElement:WPXMLRPCElementForName(localname)];
+}
+
+static void WPXMLRPCEndElement(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI) {
+    WPXMLRPCStreamingDecoder *decoder = (__bridge WPXMLRPCStreamingDecoder *)ctx;
+    [decoder didEndElement:WPXMLRPCElementForName(localname)];
+}
+
+static void WPXMLRPCCharacters(void *ctx, const xmlChar *ch, int len) {
+    WPXMLRPCStreamingDecoder *decoder = (__bridge WPXMLRPCStreamingDecoder *)ctx;
+    [decoder foundCharacters:(const char *)ch length:(NSUInteger)len];
+}
@@ -8,6 +8,8 @@
 #import "WordPressRestApi.h"
 #import "WordPressXMLRPCApi.h"
 #import "WPComOAuthController.h"
+#import "WPMultiSiteFanOut.h"
+#import "WPPostStore.h"
 #endif /* _WORDPRESSAPI */
 
 @interface WordPressApi : NSObject
@@ -27,7 +27,6 @@
 
  All the parameters are optional, and can be set to `nil`
 
- @warning **Not implemented yet**. It just calls publishPostWIthText:title:success:failure: ignoring the image
  @param image An image to add to the post. The image will be embedded **before** the content.
  @param content The post content/body. It can be text only or HTML, but be aware that some HTML might be stripped in WordPress. [What's allowed in WordPress.com?](http://en.support.wordpress.com/code/)
  @param title The post title.
@@ -45,7 +44,6 @@
 
  All the parameters are optional, and can be set to `nil`
 
- @warning **Not implemented yet**. It just calls publishPostWIthText:title:success:failure: ignoring the images
  @param images An array containing images (as UIImage) to add to the post. The gallery will be embedded **before** the content using the [[gallery]](http://en.support.wordpress.com/images/gallery/) shortcode.
  @param content The post content/body. It can be text only or HTML, but be aware that some HTML might be stripped in WordPress. [What's allowed in WordPress.com?](http://en.support.wordpress.com/code/)
  @param title The post title.
@@ -74,4 +72,56 @@
          success:(void (^)(NSArray *posts))success
          failure:(void (^)(NSError *error))failure;
 
+/**
+ Get a list of the recent posts, with only some of their fields
+
+ Asking only for the fields a list needs (e.g. ID, title, date and status) avoids downloading and decoding the post content. Field names are the ones used by each API: `post_title` on XML-RPC, `title` on the REST API. The post ID is always included on XML-RPC.
+
+ Posts have the same members whether `fields` is `nil` or not: the ones of `wp.getPosts` on XML-RPC (`post_id`, `post_title`, `post_content`, `post_modified_gmt`…), and of the `posts` endpoint on the REST API (`ID`, `title`, `content`, `modified`…). They differ from the posts returned by `getPosts:success:failure:` on XML-RPC, which come from `metaWeblog.getRecentPosts` (`postid`, `title`, `description`…).
+
+ @param count Number of recent posts to get
+ @param fields The names of the fields to get, or `nil` to get every field.
+ @param success A block object to execute when the posts are received. This block has no return value and takes one argument: an array with the latest posts.
+ @param failure A block object to execute when the posts can't be fetched. This block has no return value and takes one argument: a NSError object with details on the error.
+ */
+- (void)getPosts:(NSUInteger)count
+          fields:(NSArray *)fields
+         success:(void (^)(NSArray *posts))success
+         failure:(void (^)(NSError *error))failure;
+
+/**
+ Get a list of the recent posts as `WPPostModel` objects
+
+ On XML-RPC, the response is only scanned for the position of each field, and fields are decoded when they're first read. A list showing titles and dates never decodes the post content. These requests bypass the response cache.
+
+ @param count Number of recent posts to get
+ @param success A block object to execute when the posts are received. This block has no return value and takes one argument: an array of `WPPostModel` objects.
+ @param failure A block object to execute when the posts can't be fetched. This block has no return value and takes one argument: a NSError object with details on the error.
+ */
+- (void)getPostModels:(NSUInteger)count
+              success:(void (^)(NSArray *posts))success
+              failure:(void (^)(NSError *error))failure;
+
+/**
+ Fetch the posts modified since the last sync, a page at a time.
+
+ Posts are requested most recently modified first. Paging stops as soon as it reaches posts older than the high-water mark of the previous sync. The first sync for a site pages through all its posts.
+
+ The new high-water mark is only stored once every page has been received, so a failed sync is retried from the same point. Posts modified at the exact time of the high-water mark can be received again.
+
+ @param pageSize Number of posts to request per page
+ @param pageHandler A block object to execute for each page received. This block has no return value and takes one argument: an array with the posts in the page.
+ @param success A block object to execute when the sync finishes. This block has no return value and takes one argument: the new high-water mark, or `nil` if the site has no posts.
+ @param failure A block object to execute when a page can't be fetched. This block has no return value and takes one argument: a NSError object with details on the error.
+ */
+- (void)syncPostsWithPageSize:(NSUInteger)pageSize
+                  pageHandler:(void (^)(NSArray *posts))pageHandler
+                      success:(void (^)(NSDate *highWaterMark))success
+                      failure:(void (^)(NSError *error))failure;
+
+/**
+ Forget the high-water mark of the site, so the next sync fetches every post again.
+ */
+- (void)resetPostsSync;
+
 @end
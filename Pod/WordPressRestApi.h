@@ -1,6 +1,9 @@
 #import <Foundation/Foundation.h>
 
 #import "WordPressBaseApi.h"
+#import "WPRequestMetrics.h"
+
+@class WPResponseCache, WPRetryPolicy, WPPostStore;
 
 typedef NS_ENUM(NSUInteger, WordPressRestApiError) {
     WordPressRestApiErrorJSON,
@@ -8,6 +11,7 @@ typedef NS_ENUM(NSUInteger, WordPressRestApiError) {
     WordPressRestApiErrorLoginFailed,
     WordPressRestApiErrorInvalidToken,
     WordPressRestApiErrorAuthorizationRequired,
+    WordPressRestApiErrorInvalidImage,
 };
 
 extern NSString *const WordPressRestApiEndpointURL;
@@ -16,11 +20,90 @@ extern NSString *const WordPressRestApiErrorCodeKey;
 
 @interface WordPressRestApi : NSObject <WordPressBaseApi>
 
+/**
+ The OAuth token the client was initialized with.
+ */
+@property (readonly, nonatomic, copy) NSString *authToken;
+
+/**
+ The ID of the site the client publishes to.
+ */
+@property (readonly, nonatomic, copy) NSString *siteId;
+
+/**
+ The maximum width or height, in points, of images uploaded by `publishPostWithGallery:description:title:success:failure:`. Larger images are scaled down before being encoded. Set to `0` to upload images at their original size, which is the default.
+ */
+@property (nonatomic, assign) CGFloat galleryMaximumDimension;
+
+/**
+ The cache used for `getPosts:success:failure:`. Expired responses are revalidated with `ETag` and `Last-Modified`. Defaults to `nil`, which disables caching.
+
+ Cached responses are discarded after publishing a post.
+ */
+@property (nonatomic, strong) WPResponseCache *responseCache;
+
+/**
+ The store the posts received are written to, so they can be read with `storedPosts:` before the network answers. Defaults to `nil`, which disables storing posts.
+
+ Posts are stored by `getPosts:success:failure:`, `getPosts:fields:success:failure:` without fields, `getPostModels:success:failure:` and `syncPostsWithPageSize:pageHandler:success:failure:`. Posts with only some fields aren't stored.
+ */
+@property (nonatomic, strong) WPPostStore *postStore;
+
+/**
+ An object told how every request made by this API went: sizes, timings and outcome. Defaults to `nil`, which disables collecting metrics.
+ */
+@property (nonatomic, weak) id<WPRequestMetricsObserver> metricsObserver;
+
+/**
+ The policy deciding when failed requests are sent again. Defaults to `nil`, which disables retries.
+ */
+@property (nonatomic, strong) WPRetryPolicy *retryPolicy;
+
+/**
+ The queue the success and failure blocks are called on. Defaults to `nil`, which uses the main queue. Responses are always parsed off the main queue.
+ */
+@property (nonatomic, strong) dispatch_queue_t completionQueue;
+
+/**
+ The JPEG quality used to encode gallery images, between `0.0` and `1.0`. Defaults to `1.0`.
+ */
+@property (nonatomic, assign) CGFloat galleryJPEGQuality;
+
 + (void)signInWithOauthWithSuccess:(void (^)(NSString *authToken, NSString *siteId))success failure:(void (^)(NSError *error))failure;
 + (void)signInWithJetpackUsername:(NSString *)username password:(NSString *)password success:(void (^)(NSString *authToken))success failure:(void (^)(NSError *error))failure;
 
+/**
+ Opens a connection to the WordPress.com REST API ahead of the first request, e.g. on launch when there's a saved account. See `WPConnectionPrewarmer`.
+
+ @param completion A block object to execute on the main queue when the connection is open or failed to open. This block has no return value and takes two arguments: how long the warm-up took, `0` if the host was already warm, and an error if it failed. Can be `nil`.
+ */
++ (void)warmUpConnectionWithCompletion:(void (^)(NSTimeInterval duration, NSError *error))completion;
+
 - (id<WordPressBaseApi>)initWithOauthToken:(NSString *)authToken siteId:(NSString *)siteId;
 
+/**
+ Get the recent posts of several sites with a single batch request.
+
+ WordPress.com answers for each site separately, so a site failing doesn't fail the others. The sites must be accessible with the client's token. Batch requests bypass the response cache.
+
+ @param count Number of recent posts to get for each site
+ @param siteIds The IDs of the sites.
+ @param success A block object to execute when the batch request finishes. This block has no return value and takes two arguments: a dictionary from site ID to an array with its latest posts, and a dictionary from site ID to a NSError for the sites which failed.
+ @param failure A block object to execute when the batch request fails. This block has no return value and takes one argument: a NSError object with details on the error.
+ */
+- (void)getPosts:(NSUInteger)count
+        forSites:(NSArray *)siteIds
+         success:(void (^)(NSDictionary *postsBySite, NSDictionary *errorsBySite))success
+         failure:(void (^)(NSError *error))failure;
+
+/**
+ Returns the posts of the site kept in the `postStore` for this account, most recently modified first, without going to the network.
+
+ @param count Maximum number of posts to return, or `0` to return every stored post.
+ @return An array of `WPPostModel` objects, empty if there's no `postStore`.
+ */
+- (NSArray *)storedPosts:(NSUInteger)count;
+
 /**
  Helper function for [UIApplicationDelegate application:handleOpenURL:] to process the authentication callback from the WordPress app
 
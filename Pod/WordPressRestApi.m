@@ -1,19 +1,28 @@
 #import <UIKit/UIKit.h>
+#import <CommonCrypto/CommonDigest.h>
 #import <AFNetworking/AFNetworking.h>
 
 #import "WordPressRestApi.h"
 #import "WordPressRestApiJSONRequestOperation.h"
 #import "WordPressRestApiJSONRequestOperationManager.h"
 #import "WPComOAuthController.h"
+#import "WPResponseCache.h"
+#import "WPPostSyncState.h"
+#import "WPPostModel.h"
+#import "WPConnectionPrewarmer.h"
+#import "WPPostStore.h"
 
 NSString *const WordPressRestApiEndpointURL = @"https://public-api.wordpress.com/rest/v1.1/";
 NSString *const WordPressRestApiErrorDomain = @"WordPressRestApiError";
 NSString *const WordPressRestApiErrorCodeKey = @"WordPressRestApiErrorCodeKey";
 
+// Only a couple of images are decoded and encoded at the same time, to keep memory bounded
+static NSInteger const WordPressRestApiMaxConcurrentImageEncodings = 2;
+
 @implementation WordPressRestApi {
     NSString *_token;
     NSString *_siteId;
-    AFHTTPRequestOperationManager *_operationManager;
+    WordPressRestApiJSONRequestOperationManager *_operationManager;
 }
 
 static NSString *WordPressRestApiClient = nil;
@@ -35,6 +44,10 @@ static NSString *WordPressRestApiRedirectUrl = nil;
     NSAssert(NO, @"Not implemented yet");
 }
 
++ (void)warmUpConnectionWithCompletion:(void (^)(NSTimeInterval duration, NSError *error))completion {
+    [[WPConnectionPrewarmer sharedPrewarmer] warmUpURL:[NSURL URLWithString:WordPressRestApiEndpointURL] sessionTransport:nil completion:completion];
+}
+
 - (id<WordPressBaseApi>)initWithOauthToken:(NSString *)authToken siteId:(NSString *)siteId {
     self = [super init];
     
@@ -46,6 +59,7 @@ static NSString *WordPressRestApiRedirectUrl = nil;
 		
         _operationManager = [[WordPressRestApiJSONRequestOperationManager alloc] initWithBaseURL:baseURL
 																						   token:_token];
+        _galleryJPEGQuality = 1.f;
     }
 	
     return self;
@@ -70,6 +84,46 @@ static NSString *WordPressRestApiRedirectUrl = nil;
     [[WPComOAuthController sharedController] setRedirectUrl:redirectUrl];
 }
 
+- (WPResponseCache *)responseCache {
+    return _operationManager.responseCache;
+}
+
+- (void)setResponseCache:(WPResponseCache *)responseCache {
+    _operationManager.responseCache = responseCache;
+}
+
+- (id<WPRequestMetricsObserver>)metricsObserver {
+    return _operationManager.metricsObserver;
+}
+
+- (void)setMetricsObserver:(id<WPRequestMetricsObserver>)metricsObserver {
+    _operationManager.metricsObserver = metricsObserver;
+}
+
+- (WPRetryPolicy *)retryPolicy {
+    return _operationManager.retryPolicy;
+}
+
+- (void)setRetryPolicy:(WPRetryPolicy *)retryPolicy {
+    _operationManager.retryPolicy = retryPolicy;
+}
+
+- (NSString *)authToken {
+    return _token;
+}
+
+- (NSString *)siteId {
+    return _siteId;
+}
+
+- (dispatch_queue_t)completionQueue {
+    return _operationManager.completionQueue;
+}
+
+- (void)setCompletionQueue:(dispatch_queue_t)completionQueue {
+    _operationManager.completionQueue = completionQueue;
+}
+
 #pragma mark - WordPressBaseApi methods
 
 - (void)publishPostWithText:(NSString *)content title:(NSString *)title success:(void (^)(NSUInteger postId, NSURL *permalink))success failure:(void (^)(NSError *error))failure {
@@ -81,6 +135,7 @@ static NSString *WordPressRestApiRedirectUrl = nil;
 				 parameters:parameters
 					success:^(AFHTTPRequestOperation *operation, id responseObject)
 	{
+		[self.responseCache removeObjectsForEndpoint:_operationManager.baseURL];
 		NSUInteger postId = [[responseObject objectForKey:@"ID"] unsignedIntegerValue];
 		NSURL *permalink = [NSURL URLWithString:[responseObject objectForKey:@"URL"]];
 		success(postId, permalink);
@@ -100,58 +155,355 @@ static NSString *WordPressRestApiRedirectUrl = nil;
 - (void)publishPostWithGallery:(NSArray *)images description:(NSString *)content title:(NSString *)title success:(void (^)(NSUInteger postId, NSURL *permalink))success failure:(void (^)(NSError *error))failure {
     if (![images count]) {
         [self publishPostWithText:content title:title success:success failure:failure];
+        return;
     }
 
-	void(^contructionBlock)(id<AFMultipartFormData>) = ^(id<AFMultipartFormData> formData)
-	{
-		[images enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-			NSData *imageData = UIImageJPEGRepresentation(obj, 1.f);
-			[formData appendPartWithFileData:imageData name:@"media[]"
-									fileName:[NSString stringWithFormat:@"image-%lu.jpg", (unsigned long)idx]
-									mimeType:@"image/jpeg"];
-		}];
-	};
-	
-	void(^successBlock)(AFHTTPRequestOperation* operation, id responseObject) = ^(AFHTTPRequestOperation *operation,
-																				  id responseObject)
-	{
-		NSUInteger postId = [[responseObject objectForKey:@"ID"] unsignedIntegerValue];
-		NSURL *permalink = [NSURL URLWithString:[responseObject objectForKey:@"URL"]];
-		success(postId, permalink);
-	};
-	
-	void(^failureBlock)(AFHTTPRequestOperation *operation, NSError *error) = ^(AFHTTPRequestOperation *operation,
-																			   NSError *error)
-	{
-        failure(error);
-    };
-	
-    NSDictionary *parameters = @{
-                                 @"title": title,
-                                 @"content": content
-                                 };
-	[_operationManager POST:[self sitePath:@"posts/new"]
-				 parameters:parameters
-  constructingBodyWithBlock:contructionBlock
-					success:successBlock
-					failure:failureBlock];
+    [self writeImagesToTemporaryFiles:images completion:^(NSArray *fileURLs, NSError *error) {
+        if (error) {
+            [self removeTemporaryFiles:fileURLs];
+            failure(error);
+            return;
+        }
+
+        __block NSError *partError = nil;
+        void(^contructionBlock)(id<AFMultipartFormData>) = ^(id<AFMultipartFormData> formData)
+        {
+            // Parts backed by files are streamed from disk while the request is sent
+            [fileURLs enumerateObjectsUsingBlock:^(NSURL *fileURL, NSUInteger idx, BOOL *stop) {
+                NSError *error = nil;
+                if (![formData appendPartWithFileURL:fileURL
+                                                name:@"media[]"
+                                            fileName:[NSString stringWithFormat:@"image-%lu.jpg", (unsigned long)idx]
+                                            mimeType:@"image/jpeg"
+                                               error:&error]) {
+                    partError = error;
+                    *stop = YES;
+                }
+            }];
+        };
+
+        void(^successBlock)(AFHTTPRequestOperation* operation, id responseObject) = ^(AFHTTPRequestOperation *operation,
+                                                                                      id responseObject)
+        {
+            [self removeTemporaryFiles:fileURLs];
+            [self.responseCache removeObjectsForEndpoint:_operationManager.baseURL];
+            NSUInteger postId = [[responseObject objectForKey:@"ID"] unsignedIntegerValue];
+            NSURL *permalink = [NSURL URLWithString:[responseObject objectForKey:@"URL"]];
+            success(postId, permalink);
+        };
+
+        void(^failureBlock)(AFHTTPRequestOperation *operation, NSError *error) = ^(AFHTTPRequestOperation *operation,
+                                                                                   NSError *error)
+        {
+            [self removeTemporaryFiles:fileURLs];
+            failure(error);
+        };
+
+        NSDictionary *parameters = @{
+                                     @"title": title,
+                                     @"content": content
+                                     };
+        // The request is built here rather than with POST:, so a part which can't be read fails the post instead of being left out
+        NSString *URLString = [[NSURL URLWithString:[self sitePath:@"posts/new"] relativeToURL:_operationManager.baseURL] absoluteString];
+        NSError *serializationError = nil;
+        NSMutableURLRequest *request = [_operationManager.requestSerializer multipartFormRequestWithMethod:@"POST"
+                                                                                                URLString:URLString
+                                                                                               parameters:parameters
+                                                                                constructingBodyWithBlock:contructionBlock
+                                                                                                    error:&serializationError];
+        if (partError || serializationError) {
+            failureBlock(nil, partError ?: serializationError);
+            return;
+        }
+        AFHTTPRequestOperation *operation = [_operationManager HTTPRequestOperationWithRequest:request success:successBlock failure:failureBlock];
+        [_operationManager.operationQueue addOperation:operation];
+    }];
 }
 
 - (void)getPosts:(NSUInteger)count success:(void (^)(NSArray *posts))success failure:(void (^)(NSError *error))failure {
-    [_operationManager GET:[self sitePath:@"posts"]
-				parameters:nil
-				   success:^(AFHTTPRequestOperation *operation, id responseObject)
+    [self getPosts:count fields:nil success:success failure:failure];
+}
+
+- (void)getPosts:(NSUInteger)count fields:(NSArray *)fields success:(void (^)(NSArray *posts))success failure:(void (^)(NSError *error))failure {
+    NSMutableDictionary *parameters = [NSMutableDictionary dictionaryWithObject:@(count) forKey:@"number"];
+    if ([fields count]) {
+        parameters[@"fields"] = [fields componentsJoinedByString:@","];
+    }
+    [_operationManager cachedGET:[self sitePath:@"posts"]
+                      parameters:parameters
+                     cacheMethod:@"posts"
+                         success:^(AFHTTPRequestOperation *operation, id responseObject)
 	{
-		success([responseObject objectForKey:@"posts"]);
+		NSArray *posts = [responseObject objectForKey:@"posts"];
+		if (![fields count] && [posts isKindOfClass:[NSArray class]]) {
+			[self.postStore storePosts:posts forSite:[self postSyncSiteKey]];
+		}
+		success(posts);
 	} failure:^(AFHTTPRequestOperation *operation, NSError *error) {
 		failure(error);
 	}];
 }
 
+- (void)getPostModels:(NSUInteger)count success:(void (^)(NSArray *posts))success failure:(void (^)(NSError *error))failure {
+    [self getPosts:count fields:nil success:^(NSArray *posts) {
+        // The JSON is already parsed, so models just wrap it
+        NSMutableArray *models = [NSMutableArray arrayWithCapacity:[posts count]];
+        for (NSDictionary *post in posts) {
+            if ([post isKindOfClass:[NSDictionary class]]) {
+                [models addObject:[[WPPostModel alloc] initWithDictionary:post]];
+            }
+        }
+        success(models);
+    } failure:failure];
+}
+
+- (void)getPosts:(NSUInteger)count forSites:(NSArray *)siteIds success:(void (^)(NSDictionary *postsBySite, NSDictionary *errorsBySite))success failure:(void (^)(NSError *error))failure {
+    NSMutableArray *URLs = [NSMutableArray arrayWithCapacity:[siteIds count]];
+    for (NSString *siteId in siteIds) {
+        [URLs addObject:[NSString stringWithFormat:@"/sites/%@/posts?number=%lu", siteId, (unsigned long)count]];
+    }
+    [_operationManager GET:@"batch"
+                parameters:@{@"urls": URLs}
+                   success:^(AFHTTPRequestOperation *operation, id responseObject)
+    {
+        NSMutableDictionary *postsBySite = [NSMutableDictionary dictionary];
+        NSMutableDictionary *errorsBySite = [NSMutableDictionary dictionary];
+        [siteIds enumerateObjectsUsingBlock:^(NSString *siteId, NSUInteger idx, BOOL *stop) {
+            // Each response is keyed by the URL it answers
+            id response = [responseObject isKindOfClass:[NSDictionary class]] ? [responseObject objectForKey:URLs[idx]] : nil;
+            id posts = [response isKindOfClass:[NSDictionary class]] ? [response objectForKey:@"posts"] : nil;
+            if ([posts isKindOfClass:[NSArray class]]) {
+                postsBySite[siteId] = posts;
+            } else {
+                errorsBySite[siteId] = [[self class] errorForBatchResponse:response];
+            }
+        }];
+        success(postsBySite, errorsBySite);
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        failure(error);
+    }];
+}
+
+/**
+ Returns the error for a response in a batch, which has the same `error` and `message` fields as a failed request.
+ */
++ (NSError *)errorForBatchResponse:(id)response {
+    NSString *error = [response isKindOfClass:[NSDictionary class]] ? [response objectForKey:@"error"] : nil;
+    NSString *message = [response isKindOfClass:[NSDictionary class]] ? [response objectForKey:@"message"] : nil;
+    if (![error isKindOfClass:[NSString class]] || ![message isKindOfClass:[NSString class]]) {
+        return [NSError errorWithDomain:WordPressRestApiErrorDomain code:WordPressRestApiErrorJSON userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"The server returned an invalid response.", @"")}];
+    }
+    NSUInteger errorCode = WordPressRestApiErrorJSON;
+    if ([error isEqualToString:@"invalid_token"]) {
+        errorCode = WordPressRestApiErrorInvalidToken;
+    } else if ([error isEqualToString:@"authorization_required"]) {
+        errorCode = WordPressRestApiErrorAuthorizationRequired;
+    }
+    return [NSError errorWithDomain:WordPressRestApiErrorDomain code:errorCode userInfo:@{NSLocalizedDescriptionKey: message, WordPressRestApiErrorCodeKey: error}];
+}
+
+- (void)syncPostsWithPageSize:(NSUInteger)pageSize pageHandler:(void (^)(NSArray *posts))pageHandler success:(void (^)(NSDate *highWaterMark))success failure:(void (^)(NSError *error))failure {
+    NSString *site = [self postSyncSiteKey];
+    NSDate *since = [WPPostSyncState highWaterMarkForSite:site];
+    WPPostStore *postStore = self.postStore;
+    [self syncPostsWithPageHandle:nil
+                         pageSize:MAX(pageSize, 1)
+                            since:since
+                    highWaterMark:nil
+                      pageHandler:^(NSArray *posts) {
+                          [postStore storePosts:posts forSite:site];
+                          if (pageHandler) {
+                              pageHandler(posts);
+                          }
+                      }
+                          success:^(NSDate *highWaterMark) {
+                              if (highWaterMark) {
+                                  [WPPostSyncState setHighWaterMark:highWaterMark forSite:site];
+                              }
+                              if (success) {
+                                  success(highWaterMark ?: since);
+                              }
+                          }
+                          failure:failure];
+}
+
+- (void)resetPostsSync {
+    [WPPostSyncState setHighWaterMark:nil forSite:[self postSyncSiteKey]];
+}
+
+- (NSArray *)storedPosts:(NSUInteger)count {
+    return [self.postStore postsForSite:[self postSyncSiteKey] limit:count] ?: @[];
+}
+
+/**
+ Requests a page of posts modified after `since`, and follows `meta.next_page` until there are no more pages.
+
+ Pages are fetched with a plain GET so they are never served from the response cache.
+ */
+- (void)syncPostsWithPageHandle:(NSString *)pageHandle pageSize:(NSUInteger)pageSize since:(NSDate *)since highWaterMark:(NSDate *)highWaterMark pageHandler:(void (^)(NSArray *posts))pageHandler success:(void (^)(NSDate *highWaterMark))success failure:(void (^)(NSError *error))failure {
+    NSMutableDictionary *parameters = [NSMutableDictionary dictionary];
+    parameters[@"number"] = @(pageSize);
+    parameters[@"order_by"] = @"modified";
+    parameters[@"order"] = @"DESC";
+    if (since) {
+        parameters[@"modified_after"] = [[[self class] dateFormatter] stringFromDate:since];
+    }
+    if (pageHandle) {
+        parameters[@"page_handle"] = pageHandle;
+    }
+
+    [_operationManager GET:[self sitePath:@"posts"]
+                parameters:parameters
+                   success:^(AFHTTPRequestOperation *operation, id responseObject)
+    {
+        NSArray *posts = [responseObject objectForKey:@"posts"];
+        if (![posts isKindOfClass:[NSArray class]]) {
+            posts = @[];
+        }
+        NSDate *newestModified = highWaterMark;
+        for (NSDictionary *post in posts) {
+            NSDate *modified = [[[self class] dateFormatter] dateFromString:[post objectForKey:@"modified"]];
+            if (modified && (!newestModified || [modified compare:newestModified] == NSOrderedDescending)) {
+                newestModified = modified;
+            }
+        }
+        if (pageHandler && [posts count]) {
+            pageHandler(posts);
+        }
+
+        NSString *nextPageHandle = [[responseObject objectForKey:@"meta"] objectForKey:@"next_page"];
+        if (![nextPageHandle isKindOfClass:[NSString class]] || ![posts count]) {
+            if (success) {
+                success(newestModified);
+            }
+            return;
+        }
+        [self syncPostsWithPageHandle:nextPageHandle
+                             pageSize:pageSize
+                                since:since
+                        highWaterMark:newestModified
+                          pageHandler:pageHandler
+                              success:success
+                              failure:failure];
+    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        if (failure) {
+            failure(error);
+        }
+    }];
+}
+
++ (NSDateFormatter *)dateFormatter {
+    static NSDateFormatter *formatter;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        formatter = [[NSDateFormatter alloc] init];
+        formatter.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+        formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+        formatter.dateFormat = @"yyyy-MM-dd'T'HH:mm:ssZZZZZ";
+    });
+    return formatter;
+}
+
+#pragma mark - Gallery Helpers
+
++ (NSOperationQueue *)imageEncodingQueue {
+    static NSOperationQueue *queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = [[NSOperationQueue alloc] init];
+        queue.name = @"org.wordpress.restapi.image-encoding";
+        queue.maxConcurrentOperationCount = WordPressRestApiMaxConcurrentImageEncodings;
+    });
+    return queue;
+}
+
+/**
+ Encodes each image as JPEG on a background queue, and writes it to a temporary file as soon as it's encoded, so only a few encoded images are in memory at any time.
+
+ The completion block is called on the main queue with the file URLs in the same order as the images.
+ */
+- (void)writeImagesToTemporaryFiles:(NSArray *)images completion:(void (^)(NSArray *fileURLs, NSError *error))completion {
+    NSMutableArray *fileURLs = [NSMutableArray arrayWithCapacity:[images count]];
+    for (NSUInteger i = 0; i < [images count]; i++) {
+        NSString *fileName = [NSString stringWithFormat:@"wpgallery-%@.jpg", [[NSUUID UUID] UUIDString]];
+        [fileURLs addObject:[NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:fileName]]];
+    }
+
+    CGFloat maximumDimension = self.galleryMaximumDimension;
+    CGFloat quality = self.galleryJPEGQuality;
+    __block NSError *encodingError = nil;
+    NSObject *lock = [[NSObject alloc] init];
+
+    NSBlockOperation *completionOperation = [NSBlockOperation blockOperationWithBlock:^{
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(fileURLs, encodingError);
+        });
+    }];
+
+    [images enumerateObjectsUsingBlock:^(UIImage *image, NSUInteger idx, BOOL *stop) {
+        NSURL *fileURL = fileURLs[idx];
+        NSBlockOperation *encodingOperation = [NSBlockOperation blockOperationWithBlock:^{
+            @autoreleasepool {
+                UIImage *scaledImage = [[self class] image:image scaledToMaximumDimension:maximumDimension];
+                NSData *imageData = UIImageJPEGRepresentation(scaledImage, quality);
+                NSError *error = nil;
+                if (!imageData) {
+                    error = [NSError errorWithDomain:WordPressRestApiErrorDomain
+                                                code:WordPressRestApiErrorInvalidImage
+                                            userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"The image couldn't be encoded.", @"")}];
+                }
+                if (!imageData || ![imageData writeToURL:fileURL options:NSDataWritingAtomic error:&error]) {
+                    @synchronized(lock) {
+                        encodingError = encodingError ?: error;
+                    }
+                }
+            }
+        }];
+        [completionOperation addDependency:encodingOperation];
+        [[[self class] imageEncodingQueue] addOperation:encodingOperation];
+    }];
+    [[[self class] imageEncodingQueue] addOperation:completionOperation];
+}
+
++ (UIImage *)image:(UIImage *)image scaledToMaximumDimension:(CGFloat)maximumDimension {
+    CGSize size = image.size;
+    CGFloat largestDimension = MAX(size.width, size.height);
+    if (maximumDimension <= 0 || largestDimension <= maximumDimension) {
+        return image;
+    }
+    CGFloat ratio = maximumDimension / largestDimension;
+    CGSize scaledSize = CGSizeMake(floor(size.width * ratio), floor(size.height * ratio));
+    UIGraphicsBeginImageContextWithOptions(scaledSize, YES, 1.0);
+    [image drawInRect:CGRectMake(0, 0, scaledSize.width, scaledSize.height)];
+    UIImage *scaledImage = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    return scaledImage;
+}
+
+- (void)removeTemporaryFiles:(NSArray *)fileURLs {
+    for (NSURL *fileURL in fileURLs) {
+        [[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil];
+    }
+}
+
 #pragma mark - API Helpers
 
 - (NSString *)sitePath:(NSString *)path {
     return [NSString stringWithFormat:@"sites/%@/%@", _siteId, path];
 }
 
+/**
+ Returns the key of the synced posts: the site, and a digest of the token so two accounts with access to the same site don't share posts they may not both see. The token itself isn't stored.
+ */
+- (NSString *)postSyncSiteKey {
+    NSData *data = [_token ?: @"" dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+    CC_SHA1([data bytes], (CC_LONG)[data length], digest);
+    NSMutableString *account = [NSMutableString stringWithCapacity:CC_SHA1_DIGEST_LENGTH * 2];
+    for (NSUInteger i = 0; i < CC_SHA1_DIGEST_LENGTH; i++) {
+        [account appendFormat:@"%02x", digest[i]];
+    }
+    return [NSString stringWithFormat:@"%@sites/%@#%@", WordPressRestApiEndpointURL, _siteId, account];
+}
+
 @end
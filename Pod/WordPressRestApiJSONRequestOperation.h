@@ -1,5 +1,22 @@
 #import <AFNetworking/AFHTTPRequestOperation.h>
 
+@class WPRequestMetrics;
+
 @interface WordPressRestApiJSONRequestOperation : AFHTTPRequestOperation
 
+/**
+ *	@brief		If set, the timing and sizes of the request are recorded here as it goes.
+ */
+@property (nonatomic, strong) WPRequestMetrics *metrics;
+
+/**
+ *	@brief		Hands over to an operation sending the same request again, after this one failed.
+ *
+ *	@details	Cancelling this operation cancels the retry too, and the upload progress block is
+ *				carried over to it.
+ *
+ *	@returns	NO if this operation was cancelled, in which case the retry shouldn't be enqueued.
+ */
+- (BOOL)continueWithRetryOperation:(AFHTTPRequestOperation *)retryOperation;
+
 @end
@@ -1,5 +1,11 @@
 #import "WordPressRestApiJSONRequestOperation.h"
 #import "WordPressRestApi.h"
+#import "WPRequestMetrics.h"
+#import "WPRetryHandover.h"
+
+@interface WordPressRestApiJSONRequestOperation ()
+@property (nonatomic, strong) WPRetryHandover *retryHandover;
+@end
 
 @implementation WordPressRestApiJSONRequestOperation
 
@@ -28,4 +34,67 @@
     return [super error];
 }
 
-@end
\ No newline at end of file
+- (id)responseObject {
+    if (!self.metrics) {
+        return [super responseObject];
+    }
+    // The JSON is parsed the first time the response object is asked for
+    [self.metrics decodingDidStart];
+    id responseObject = [super responseObject];
+    [self.metrics decodingDidFinish];
+    return responseObject;
+}
+
+- (instancetype)initWithRequest:(NSURLRequest *)urlRequest {
+    self = [super initWithRequest:urlRequest];
+    if (self) {
+        _retryHandover = [[WPRetryHandover alloc] init];
+    }
+    return self;
+}
+
+- (void)start {
+    [self.metrics operationDidStart];
+    [super start];
+}
+
+- (void)cancel {
+    [self.retryHandover cancel];
+    [super cancel];
+}
+
+- (void)setUploadProgressBlock:(void (^)(NSUInteger bytesWritten, long long totalBytesWritten, long long totalBytesExpectedToWrite))block {
+    [self.retryHandover setUploadProgressBlock:block];
+    [super setUploadProgressBlock:block];
+}
+
+- (BOOL)continueWithRetryOperation:(AFHTTPRequestOperation *)retryOperation {
+    return [self.retryHandover continueWithRetryOperation:retryOperation];
+}
+
+#pragma mark - NSURLConnectionDataDelegate
+
+- (void)connection:(NSURLConnection *)connection
+   didSendBodyData:(NSInteger)bytesWritten
+ totalBytesWritten:(NSInteger)totalBytesWritten
+totalBytesExpectedToWrite:(NSInteger)totalBytesExpectedToWrite {
+    [self.metrics didSendBodyBytes:totalBytesWritten];
+    [super connection:connection didSendBodyData:bytesWritten totalBytesWritten:totalBytesWritten totalBytesExpectedToWrite:totalBytesExpectedToWrite];
+}
+
+- (void)connection:(NSURLConnection *)connection didReceiveResponse:(NSURLResponse *)response {
+    [self.metrics didReceiveResponse:response];
+    [super connection:connection didReceiveResponse:response];
+}
+
+- (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data {
+    [self.metrics didReceiveDataOfLength:[data length]];
+    [super connection:connection didReceiveData:data];
+}
+
+- (void)connectionDidFinishLoading:(NSURLConnection *)connection {
+    [self.metrics didFinishLoading];
+    [super connectionDidFinishLoading:connection];
+}
+
+@end
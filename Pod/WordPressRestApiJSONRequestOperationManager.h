@@ -1,11 +1,78 @@
 #import <AFNetworking/AFHTTPRequestOperationManager.h>
+#import "WPRequestMetrics.h"
+#import "WPRequestScheduler.h"
+
+@class WPResponseCache, WPRetryPolicy, WPInFlightRequests, WPRequestHandle;
 
 @interface WordPressRestApiJSONRequestOperationManager : AFHTTPRequestOperationManager
 
+/**
+ *	@brief		The cache used by cachedGET:parameters:cacheMethod:success:failure:.  Defaults to nil, which disables caching.
+ */
+@property (nonatomic, strong) WPResponseCache *responseCache;
+
+/**
+ *	@brief		An object told how every request went: sizes, timings and outcome.  Metrics are only
+ *				collected while there's an observer.  Defaults to nil.
+ */
+@property (nonatomic, weak) id<WPRequestMetricsObserver> metricsObserver;
+
+/**
+ *	@brief		The policy deciding when failed requests are sent again.  Defaults to nil, which
+ *				disables retries.
+ *
+ *	@details	Only GET and HEAD requests are idempotent; other requests are only retried when the
+ *				server never got them.  Multipart bodies are rebuilt for each attempt, and the success
+ *				or failure block is only called with the outcome of the last attempt.
+ */
+@property (nonatomic, strong) WPRetryPolicy *retryPolicy;
+
+/**
+ *	@brief		The priority class of the requests made by the manager.  Defaults to
+ *				WPRequestPriorityInteractive.
+ *
+ *	@details	Requests are run by the shared WPRequestScheduler, which limits the connections to
+ *				each host across all clients.
+ */
+@property (nonatomic, assign) WPRequestPriority priority;
+
+/**
+ *	@brief		Whether identical calls to cachedGET:parameters:cacheMethod:success:failure: share a
+ *				single request while it's pending.  Defaults to YES.
+ *
+ *	@details	Calls are identical when they have the same path, parameters and token.  The caller
+ *				who sent the request gets the response object, and the callers attached to it an
+ *				immutable deep copy, shared between them, so no caller can change what the others see.
+ */
+@property (nonatomic, assign) BOOL deduplicatesRequests;
+
+/**
+ *	@brief		The GET requests pending for the manager, used to share identical ones.
+ */
+@property (nonatomic, strong, readonly) WPInFlightRequests *inFlightRequests;
+
 /**
  *	@brief		Default initializer.
  */
 - (id)initWithBaseURL:(NSURL *)url
 				token:(NSString*)token;
 
+/**
+ *	@brief		Performs a GET request, using the response cache when possible.
+ *
+ *	@details	A fresh cached response is returned without going to the network.  An expired one is
+ *				revalidated with If-None-Match and If-Modified-Since, and returned again if the server
+ *				answers 304 Not Modified.
+ *
+ *	@param		path			The path, relative to the base URL.
+ *	@param		parameters		The query parameters.
+ *	@param		cacheMethod		The name used to look up the time to live in the cache.
+ *	@returns	A handle to cancel the call.  A request shared with other callers goes on for them.
+ */
+- (WPRequestHandle *)cachedGET:(NSString *)path
+					parameters:(NSDictionary *)parameters
+				   cacheMethod:(NSString *)cacheMethod
+					   success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+					   failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure;
+
 @end
@@ -1,5 +1,14 @@
 #import "WordPressRestApiJSONRequestOperationManager.h"
 #import "WordPressRestApiJSONRequestOperation.h"
+#import "WPResponseCache.h"
+#import "WPRetryPolicy.h"
+#import "WPInFlightRequests.h"
+
+static NSString *const WordPressRestApiRetryAttemptPropertyKey = @"WordPressRestApiRetryAttempt";
+
+@interface WordPressRestApiJSONRequestOperationManager ()
+@property (readwrite, nonatomic, strong) WPInFlightRequests *inFlightRequests;
+@end
 
 @implementation WordPressRestApiJSONRequestOperationManager
 
@@ -26,11 +35,24 @@
 		NSString* bearerString = [NSString stringWithFormat:@"Bearer %@", token];
 		
 		[self.requestSerializer setValue:bearerString forHTTPHeaderField:@"Authorization"];
+		self.operationQueue = [[WPRequestSchedulerQueue alloc] initWithScheduler:[WPRequestScheduler sharedScheduler]];
+		self.inFlightRequests = [[WPInFlightRequests alloc] init];
+		self.deduplicatesRequests = YES;
 	}
 	
 	return self;
 }
 
+- (WPRequestPriority)priority
+{
+	return [(WPRequestSchedulerQueue *)self.operationQueue priority];
+}
+
+- (void)setPriority:(WPRequestPriority)priority
+{
+	[(WPRequestSchedulerQueue *)self.operationQueue setPriority:priority];
+}
+
 - (AFHTTPRequestOperation *)HTTPRequestOperationWithRequest:(NSURLRequest *)request
                                                     success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
                                                     failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure
@@ -41,10 +63,223 @@
     operation.shouldUseCredentialStorage = self.shouldUseCredentialStorage;
     operation.credential = self.credential;
     operation.securityPolicy = self.securityPolicy;
+	operation.completionQueue = self.completionQueue;
+	operation.completionGroup = self.completionGroup;
+
+	WPRetryPolicy *retryPolicy = self.retryPolicy;
+	if (retryPolicy)
+	{
+		void (^callerSuccess)(AFHTTPRequestOperation *, id) = success;
+		void (^callerFailure)(AFHTTPRequestOperation *, NSError *) = failure;
+		success = ^(AFHTTPRequestOperation *operation, id responseObject) {
+			[retryPolicy requestDidSucceed];
+			if (callerSuccess) {
+				callerSuccess(operation, responseObject);
+			}
+		};
+		failure = ^(AFHTTPRequestOperation *operation, NSError *error) {
+			BOOL retrying = [self retryFailedOperation:operation error:error success:callerSuccess failure:callerFailure];
+			if (!retrying && callerFailure) {
+				callerFailure(operation, error);
+			}
+		};
+	}
+
+	WPRequestMetrics *metrics = [self metricsForRequest:request];
+	if (metrics)
+	{
+		operation.metrics = metrics;
+		void (^networkSuccess)(AFHTTPRequestOperation *, id) = success;
+		void (^networkFailure)(AFHTTPRequestOperation *, NSError *) = failure;
+		success = ^(AFHTTPRequestOperation *operation, id responseObject) {
+			[metrics finishWithError:nil];
+			[self.metricsObserver requestDidFinishWithMetrics:metrics];
+			if (networkSuccess) {
+				networkSuccess(operation, responseObject);
+			}
+		};
+		failure = ^(AFHTTPRequestOperation *operation, NSError *error) {
+			[metrics finishWithError:error];
+			[self.metricsObserver requestDidFinishWithMetrics:metrics];
+			if (networkFailure) {
+				networkFailure(operation, error);
+			}
+		};
+	}
 	
     [operation setCompletionBlockWithSuccess:success failure:failure];
 	
     return operation;
 }
 
+/**
+ *	@brief		Sends a failed request again if the retry policy allows it, after the backoff delay.
+ *
+ *	@details	Must be called on the completion queue of the operation.  If the operation is cancelled while waiting for the
+ *				retry, failure is called with a cancellation error.
+ *
+ *	@returns	YES if the request will be retried, in which case the failure must not be reported yet.
+ */
+- (BOOL)retryFailedOperation:(AFHTTPRequestOperation *)operation
+					   error:(NSError *)error
+					 success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+					 failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure
+{
+	WPRetryPolicy *retryPolicy = self.retryPolicy;
+	if (!retryPolicy || [operation isCancelled] || ![operation isKindOfClass:[WordPressRestApiJSONRequestOperation class]])
+	{
+		return NO;
+	}
+	NSURLRequest *request = operation.request;
+	NSMutableURLRequest *retryRequest = [request mutableCopy];
+	if (request.HTTPBodyStream)
+	{
+		// Multipart bodies can be produced again, other streams can't
+		if (![request.HTTPBodyStream conformsToProtocol:@protocol(NSCopying)])
+		{
+			return NO;
+		}
+		retryRequest.HTTPBodyStream = [(id<NSCopying>)request.HTTPBodyStream copyWithZone:nil];
+	}
+	NSUInteger attempt = [[NSURLProtocol propertyForKey:WordPressRestApiRetryAttemptPropertyKey inRequest:request] unsignedIntegerValue];
+	BOOL idempotent = [request.HTTPMethod isEqualToString:@"GET"] || [request.HTTPMethod isEqualToString:@"HEAD"];
+	if (![retryPolicy shouldRetryIdempotent:idempotent response:operation.response error:error attempt:attempt])
+	{
+		return NO;
+	}
+	[NSURLProtocol setProperty:@(attempt + 1) forKey:WordPressRestApiRetryAttemptPropertyKey inRequest:retryRequest];
+
+	NSTimeInterval delay = [retryPolicy delayBeforeRetryAttempt:attempt response:operation.response];
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), operation.completionQueue ?: dispatch_get_main_queue(), ^{
+		AFHTTPRequestOperation *retryOperation = [self HTTPRequestOperationWithRequest:retryRequest success:success failure:failure];
+		retryOperation.completionQueue = operation.completionQueue;
+		if ([(WordPressRestApiJSONRequestOperation *)operation continueWithRetryOperation:retryOperation])
+		{
+			[self.operationQueue addOperation:retryOperation];
+		}
+		else if (failure)
+		{
+			failure(operation, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]);
+		}
+	});
+	return YES;
+}
+
+/**
+ *	@brief		Returns new metrics for a request, named after its path relative to the base URL, or
+ *				nil if there's no observer.
+ */
+- (WPRequestMetrics *)metricsForRequest:(NSURLRequest *)request
+{
+	if (!self.metricsObserver)
+	{
+		return nil;
+	}
+	NSString *path = request.URL.path;
+	NSString *basePath = self.baseURL.path;
+	if ([basePath length] > 0 && [path hasPrefix:basePath])
+	{
+		path = [path substringFromIndex:[basePath length]];
+	}
+	if ([path hasPrefix:@"/"])
+	{
+		path = [path substringFromIndex:1];
+	}
+	return [[WPRequestMetrics alloc] initWithName:path request:request];
+}
+
+- (WPRequestHandle *)cachedGET:(NSString *)path
+					parameters:(NSDictionary *)parameters
+				   cacheMethod:(NSString *)cacheMethod
+					   success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+					   failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure
+{
+	// Responses depend on who is asking, so the token is part of the key
+	NSString *authorization = [self.requestSerializer valueForHTTPHeaderField:@"Authorization"];
+	NSString *key = [WPResponseCache keyForEndpoint:self.baseURL method:path parameters:@[parameters ?: @{}, authorization ?: @""]];
+	return [self.inFlightRequests requestWithKey:(self.deduplicatesRequests ? key : nil)
+								 completionQueue:self.completionQueue
+										 success:success
+										 failure:failure
+										  sender:^id(void (^success)(AFHTTPRequestOperation *, id), void (^failure)(AFHTTPRequestOperation *, NSError *)) {
+		return [self sendCachedGET:path parameters:parameters cacheMethod:cacheMethod cacheKey:key success:success failure:failure];
+	}];
+}
+
+/**
+ *	@brief		Sends a GET request, or answers it from the cache.  Returns the operation sending it,
+ *				or nil if it was answered from the cache.
+ */
+- (AFHTTPRequestOperation *)sendCachedGET:(NSString *)path
+							   parameters:(NSDictionary *)parameters
+							  cacheMethod:(NSString *)cacheMethod
+								 cacheKey:(NSString *)cacheKey
+								  success:(void (^)(AFHTTPRequestOperation *operation, id responseObject))success
+								  failure:(void (^)(AFHTTPRequestOperation *operation, NSError *error))failure
+{
+	WPResponseCache *responseCache = self.responseCache;
+	if ([responseCache timeToLiveForMethod:cacheMethod] <= 0)
+	{
+		return [self GET:path parameters:parameters success:success failure:failure];
+	}
+
+	WPCachedResponse *cachedResponse = [responseCache cachedResponseForKey:cacheKey];
+	if (cachedResponse && ![cachedResponse isExpired])
+	{
+		dispatch_async(self.completionQueue ?: dispatch_get_main_queue(), ^{
+			if (self.metricsObserver) {
+				NSURL *URL = [NSURL URLWithString:path relativeToURL:self.baseURL];
+				[self.metricsObserver requestDidFinishWithMetrics:[[WPRequestMetrics alloc] initWithCachedResponseForName:path URL:URL]];
+			}
+			if (success) {
+				success(nil, cachedResponse.object);
+			}
+		});
+		return nil;
+	}
+
+	NSString *URLString = [[NSURL URLWithString:path relativeToURL:self.baseURL] absoluteString];
+	NSMutableURLRequest *request = [self.requestSerializer requestWithMethod:@"GET" URLString:URLString parameters:parameters error:nil];
+	// Revalidation is handled here, the URL loading system shouldn't answer from its own cache
+	request.cachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+	if (cachedResponse.ETag)
+	{
+		[request setValue:cachedResponse.ETag forHTTPHeaderField:@"If-None-Match"];
+	}
+	if (cachedResponse.lastModified)
+	{
+		[request setValue:cachedResponse.lastModified forHTTPHeaderField:@"If-Modified-Since"];
+	}
+
+	AFHTTPRequestOperation *operation = [self HTTPRequestOperationWithRequest:request success:^(AFHTTPRequestOperation *operation, id responseObject) {
+		NSDictionary *headers = operation.response.allHeaderFields;
+		[responseCache storeObject:responseObject
+							forKey:cacheKey
+							method:cacheMethod
+							  ETag:headers[@"ETag"]
+					  lastModified:headers[@"Last-Modified"]];
+		if (success) {
+			success(operation, responseObject);
+		}
+	} failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+		if (cachedResponse && operation.response.statusCode == 304)
+		{
+			[responseCache storeObject:cachedResponse.object
+								forKey:cacheKey
+								method:cacheMethod
+								  ETag:cachedResponse.ETag
+						  lastModified:cachedResponse.lastModified];
+			if (success) {
+				success(operation, cachedResponse.object);
+			}
+			return;
+		}
+		if (failure) {
+			failure(operation, error);
+		}
+	}];
+	[self.operationQueue addOperation:operation];
+	return operation;
+}
+
 @end
@@ -1,6 +1,9 @@
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 #import "WordPressBaseApi.h"
+#import "WPRequestMetrics.h"
+
+@class WPResponseCache, WPRetryPolicy, WPURLSessionTransport, WPPostStore;
 
 extern NSString *const WordPressXMLRPCApiErrorDomain;
 
@@ -13,6 +16,11 @@ typedef NS_ENUM(NSInteger, WordPressXMLRPCApiError) {
     WordPressXMLRPCApiInvalid, // Doesn't look to be valid XMLRPC Endpoint.
 };
 
+/**
+ A block called while media is being uploaded. It takes three arguments: the index of the asset being uploaded, the number of bytes of that asset sent so far, and the total number of bytes to send for it.
+ */
+typedef void (^WordPressXMLRPCApiMediaProgressBlock)(NSUInteger assetIndex, long long totalBytesWritten, long long totalBytesExpectedToWrite);
+
 /**
  WordPress API for iOS 
 */
@@ -25,6 +33,47 @@ typedef NS_ENUM(NSInteger, WordPressXMLRPCApiError) {
 @property (readonly, nonatomic, retain) NSURL *xmlrpc;
 @property (readonly, nonatomic, strong) NSOperationQueue *operationQueue;
 
+/**
+ The cache used for `getPosts:success:failure:`, `getBlogsWithSuccess:failure:` and `getBlogOptionsWithSuccess:failure:`. Defaults to `nil`, which disables caching.
+
+ Cached responses for this endpoint are discarded after publishing a post.
+ */
+@property (nonatomic, strong) WPResponseCache *responseCache;
+
+/**
+ The store the posts received are written to, so they can be read with `storedPosts:` before the network answers. Defaults to `nil`, which disables storing posts.
+
+ Posts are stored by `getPosts:fields:success:failure:` without fields and `syncPostsWithPageSize:pageHandler:success:failure:`, which both get the members of `wp.getPosts`, so every stored post has the same members. The `metaWeblog.getRecentPosts` structs of `getPosts:success:failure:` and `getPosts:postHandler:success:failure:` use other member names, and aren't stored. Posts with only some fields and post models aren't stored either.
+ */
+@property (nonatomic, strong) WPPostStore *postStore;
+
+/**
+ An object told how every request made by this API went: sizes, timings and outcome. Defaults to `nil`, which disables collecting metrics.
+ */
+@property (nonatomic, weak) id<WPRequestMetricsObserver> metricsObserver;
+
+/**
+ The policy deciding when failed requests are sent again. Defaults to `nil`, which disables retries.
+ */
+@property (nonatomic, strong) WPRetryPolicy *retryPolicy;
+
+/**
+ The transport sending buffered calls over `NSURLSession`, sharing connections with other clients. Defaults to `nil`, which sends every call as an operation.
+ */
+@property (nonatomic, strong) WPURLSessionTransport *sessionTransport;
+
+/**
+ The queue responses are decoded on. Defaults to `nil`, which decodes on the global concurrent queue.
+ */
+@property (nonatomic, strong) NSOperationQueue *decodeQueue;
+
+/**
+ The queue the success and failure blocks are called on. Defaults to `nil`, which uses the main queue. Upload progress is still reported on the main queue.
+
+ It can be a concurrent queue: calls made of several requests, like the uploads of a gallery, keep their state on a serial queue of their own and call back once.
+ */
+@property (nonatomic, strong) dispatch_queue_t completionQueue;
+
 
 ///-------------------------------------------------------
 /// @name Creating and Initializing a WordPress API Client
@@ -48,12 +97,25 @@ typedef NS_ENUM(NSInteger, WordPressXMLRPCApiError) {
  */
 - (id)initWithXMLRPCEndpoint:(NSURL *)xmlrpc username:(NSString *)username password:(NSString *)password;
 
+///-----------------------------
+/// @name Warming Up Connections
+///-----------------------------
+
+/**
+ Opens a connection to the XML-RPC endpoint ahead of the first request, e.g. on launch for saved sites.
+
+ @param completion A block object to execute on the main queue when the connection is open or failed to open. This block has no return value and takes two arguments: how long the warm-up took, `0` if the endpoint was already warm, and an error if it failed. Can be `nil`.
+ */
+- (void)warmUpConnectionWithCompletion:(void (^)(NSTimeInterval duration, NSError *error))completion;
+
 ///-------------------
 /// @name Authenticate
 ///-------------------
 
 /**
  Performs a XML-RPC test call just to verify that the credentials are correct.
+
+ The call always goes to the server, even when `responseCache` holds a response for it.
  
  @param success A block object to execute when the credentials are valid. This block has no return value.
  @param failure A block object to execute when the credentials can't be verified. This block has no return value and takes one argument: a NSError object with details on the error.
@@ -69,6 +131,14 @@ typedef NS_ENUM(NSInteger, WordPressXMLRPCApiError) {
  */
 - (void)getBlogsWithSuccess:(void (^)(NSArray *blogs))success failure:(void (^)(NSError *error))failure;
 
+/**
+ Authenticates and returns the blogs which the user can access as `WPBlogModel` objects, decoding their fields when they're first read.
+
+ @param success A block object to execute when the login is successful. This block has no return value and takes one argument: an array of `WPBlogModel` objects.
+ @param failure A block object to execute when the login failed. This block has no return value and takes one argument: a NSError object with details on the error.
+ */
+- (void)getBlogModelsWithSuccess:(void (^)(NSArray *blogs))success failure:(void (^)(NSError *error))failure;
+
 /**
  Authenticates and returns a dictionary of the blog's options.
 
@@ -77,6 +147,116 @@ typedef NS_ENUM(NSInteger, WordPressXMLRPCApiError) {
  */
 - (void)getBlogOptionsWithSuccess:(void (^)(id options))success failure:(void (^)(NSError *error))failure;
 
+/**
+ Authenticates and returns a dictionary with some of the blog's options.
+
+ Options that weren't asked for are skipped while decoding, even if the server returns them. The response is not cached.
+
+ @param optionNames The names of the options to get, e.g. `blog_title`. Pass `nil` to get every option.
+ @param success A block object to execute when the login is successful. This block has no return value and takes one argument: a dictionary with the blog options.
+ @param failure A block object to execute when the login failed. This block has no return value and takes one argument: a NSError object with details on the error.
+ */
+- (void)getBlogOptions:(NSArray *)optionNames success:(void (^)(id options))success failure:(void (^)(NSError *error))failure;
+
+///-------------------------
+/// @name Publishing media
+///-------------------------
+
+/**
+ Publishes a post with an image, reporting upload progress.
+
+ The image is uploaded with `wp.uploadFile`, embedded **before** the content, and set as the post thumbnail.
+
+ @param image An image to add to the post.
+ @param content The post content/body.
+ @param title The post title.
+ @param progress A block object to execute as the image is uploaded. Can be `nil`.
+ @param success A block object to execute when the post is published. This block has no return value and takes two arguments: the resulting post ID, and the permalink.
+ @param failure A block object to execute when the image can't be encoded or uploaded or the post can't be published. This block has no return value and takes one argument: a NSError object with details on the error.
+ */
+- (void)publishPostWithImage:(UIImage *)image
+                 description:(NSString *)content
+                       title:(NSString *)title
+                    progress:(WordPressXMLRPCApiMediaProgressBlock)progress
+                     success:(void (^)(NSUInteger postId, NSURL *permalink))success
+                     failure:(void (^)(NSError *error))failure;
+
+/**
+ Publishes a post with an image gallery, reporting upload progress for each image.
+
+ The images are uploaded in parallel with `wp.uploadFile`, and embedded **before** the content using the `[gallery]` shortcode.
+
+ @param images An array containing images (as UIImage) to add to the post.
+ @param content The post content/body.
+ @param title The post title.
+ @param progress A block object to execute as each image is uploaded. Can be `nil`.
+ @param success A block object to execute when the post is published. This block has no return value and takes two arguments: the resulting post ID, and the permalink.
+ @param failure A block object to execute when any image can't be encoded or uploaded, in which case nothing is published, or the post can't be published. This block has no return value and takes one argument: a NSError object with details on the error.
+ */
+- (void)publishPostWithGallery:(NSArray *)images
+                   description:(NSString *)content
+                         title:(NSString *)title
+                      progress:(WordPressXMLRPCApiMediaProgressBlock)progress
+                       success:(void (^)(NSUInteger postId, NSURL *permalink))success
+                       failure:(void (^)(NSError *error))failure;
+
+/**
+ Publishes a post with a video.
+
+ @see publishPostWithVideo:description:title:progress:success:failure:
+ */
+- (void)publishPostWithVideo:(NSString *)videoPath
+                 description:(NSString *)content
+                       title:(NSString *)title
+                     success:(void (^)(NSUInteger postId, NSURL *permalink))success
+                     failure:(void (^)(NSError *error))failure;
+
+/**
+ Publishes a post with a video, reporting upload progress.
+
+ The video file is streamed from disk while it's uploaded, so it's never loaded in memory. It's embedded **before** the content using the `[video]` shortcode.
+
+ @param videoPath The path to the video file.
+ @param content The post content/body.
+ @param title The post title.
+ @param progress A block object to execute as the video is uploaded. Can be `nil`.
+ @param success A block object to execute when the post is published. This block has no return value and takes two arguments: the resulting post ID, and the permalink.
+ @param failure A block object to execute when the video can't be uploaded or the post can't be published. This block has no return value and takes one argument: a NSError object with details on the error.
+ */
+- (void)publishPostWithVideo:(NSString *)videoPath
+                 description:(NSString *)content
+                       title:(NSString *)title
+                    progress:(WordPressXMLRPCApiMediaProgressBlock)progress
+                     success:(void (^)(NSUInteger postId, NSURL *permalink))success
+                     failure:(void (^)(NSError *error))failure;
+
+///---------------------
+/// @name Managing posts
+///---------------------
+
+/**
+ Get a list of the recent posts, reporting each post as soon as it's decoded.
+
+ The response is decoded while it's being downloaded, so the first posts are available before the whole list is received, and the full list is never held in memory by the API.
+
+ @param count Number of recent posts to get
+ @param postHandler A block object to execute for each post as it's decoded. This block has no return value and takes one argument: a dictionary with the post.
+ @param success A block object to execute when all the posts have been received. This block has no return value.
+ @param failure A block object to execute when the posts can't be fetched. This block has no return value and takes one argument: a NSError object with details on the error.
+ */
+- (void)getPosts:(NSUInteger)count
+     postHandler:(void (^)(NSDictionary *post))postHandler
+         success:(void (^)())success
+         failure:(void (^)(NSError *error))failure;
+
+/**
+ Returns the posts of the site kept in the `postStore`, most recently modified first, without going to the network.
+
+ @param count Maximum number of posts to return, or `0` to return every stored post.
+ @return An array of `WPPostModel` objects, empty if there's no `postStore`.
+ */
+- (NSArray *)storedPosts:(NSUInteger)count;
+
 ///--------------
 /// @name Helpers
 ///--------------
@@ -90,6 +270,10 @@ typedef NS_ENUM(NSInteger, WordPressXMLRPCApiError) {
  * If that fails, try a test XML-RPC request given URL, maybe it was the XML-RPC URL already
  * If that fails, fetch the given URL and search for an `EditURI` link pointing to the XML-RPC endpoint
  
+ These strategies are raced: each one gets a short head start, the first endpoint found wins and the remaining requests are cancelled. When no scheme is given, the HTTPS variant is tried too.
+ 
+ The endpoint found is remembered per site and scheme, so the next time it's validated directly instead of running the discovery again. See `removeDiscoveredEndpoints`.
+ 
  For additional URL typo fixing, see [NSURL-Guess](https://github.com/koke/NSURL-Guess)
  
  @param url what the user entered as the URL, e.g.: myblog.com
@@ -100,5 +284,10 @@ typedef NS_ENUM(NSInteger, WordPressXMLRPCApiError) {
                       success:(void (^)(NSURL *xmlrpcURL))success
                       failure:(void (^)(NSError *error))failure;
 
+/**
+ Forgets all the XML-RPC endpoints remembered by `guessXMLRPCURLForSite:success:failure:`.
+ */
++ (void)removeDiscoveredEndpoints;
+
 
 @end
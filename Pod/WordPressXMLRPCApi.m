@@ -1,9 +1,21 @@
 #import "WordPressXMLRPCApi.h"
 #import "WPXMLRPCClient.h"
 #import "WPRSDParser.h"
+#import "WPRSDLinkScanner.h"
+#import "WPHTTPRequestOperation.h"
+#import "WPResponseCache.h"
+#import "WPXMLRPCEndpointDiscovery.h"
+#import "WPPostSyncState.h"
+#import "WPPostModel.h"
+#import "WPBlogModel.h"
+#import "WPPostStore.h"
 
 NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
 
+static NSString *const WordPressXMLRPCApiDiscoveredEndpointsKey = @"WordPressXMLRPCApiDiscoveredEndpoints";
+static NSTimeInterval const WordPressXMLRPCApiDiscoveryValidationTimeout = 15;
+static NSTimeInterval const WordPressXMLRPCApiDiscoveryPageTimeout = 20;
+
 @interface WordPressXMLRPCApi ()
 
 @property (readwrite, nonatomic, retain) NSURL *xmlrpc;
@@ -40,23 +52,91 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
     return self.client.operationQueue;
 }
 
+- (WPResponseCache *)responseCache
+{
+    return self.client.responseCache;
+}
+
+- (void)setResponseCache:(WPResponseCache *)responseCache
+{
+    self.client.responseCache = responseCache;
+}
+
+- (id<WPRequestMetricsObserver>)metricsObserver
+{
+    return self.client.metricsObserver;
+}
+
+- (void)setMetricsObserver:(id<WPRequestMetricsObserver>)metricsObserver
+{
+    self.client.metricsObserver = metricsObserver;
+}
+
+- (WPRetryPolicy *)retryPolicy
+{
+    return self.client.retryPolicy;
+}
+
+- (void)setRetryPolicy:(WPRetryPolicy *)retryPolicy
+{
+    self.client.retryPolicy = retryPolicy;
+}
+
+- (WPURLSessionTransport *)sessionTransport
+{
+    return self.client.sessionTransport;
+}
+
+- (void)setSessionTransport:(WPURLSessionTransport *)sessionTransport
+{
+    self.client.sessionTransport = sessionTransport;
+}
+
+- (NSOperationQueue *)decodeQueue
+{
+    return self.client.decodeQueue;
+}
+
+- (void)setDecodeQueue:(NSOperationQueue *)decodeQueue
+{
+    self.client.decodeQueue = decodeQueue;
+}
+
+- (dispatch_queue_t)completionQueue
+{
+    return self.client.completionQueue;
+}
+
+- (void)setCompletionQueue:(dispatch_queue_t)completionQueue
+{
+    self.client.completionQueue = completionQueue;
+}
+
+
+#pragma mark - Warming up connections
+
+- (void)warmUpConnectionWithCompletion:(void (^)(NSTimeInterval duration, NSError *error))completion {
+    [self.client warmUpConnectionWithCompletion:completion];
+}
 
 #pragma mark - Authentication
 
 - (void)authenticateWithSuccess:(void (^)())success
                         failure:(void (^)(NSError *error))failure {
     NSArray *parameters = [NSArray arrayWithObjects:self.username, self.password, nil];
-    [self.client callMethod:@"wp.getUsersBlogs"
-                 parameters:parameters
-                    success:^(AFHTTPRequestOperation *operation, id responseObject) {
-                        if (success) {
-                            success();
-                        }
-                    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
-                        if (failure) {
-                            failure(error);
-                        }
-                    }];
+    // Sent as an operation, so the credentials are checked by the server rather than by a cached or shared response
+    NSURLRequest *request = [self.client requestWithMethod:@"wp.getUsersBlogs" parameters:parameters];
+    AFHTTPRequestOperation *operation = [self.client HTTPRequestOperationWithRequest:request
+                                                                              success:^(AFHTTPRequestOperation *operation, id responseObject) {
+                                                                                  if (success) {
+                                                                                      success();
+                                                                                  }
+                                                                              } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                                                                                  if (failure) {
+                                                                                      failure(error);
+                                                                                  }
+                                                                              }];
+    [self.client enqueueHTTPRequestOperation:operation];
 }
 
 - (void)getBlogsWithSuccess:(void (^)(NSArray *blogs))success failure:(void (^)(NSError *error))failure {
@@ -73,6 +153,14 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
                     }];
 }
 
+- (void)getBlogModelsWithSuccess:(void (^)(NSArray *blogs))success failure:(void (^)(NSError *error))failure {
+    [self callMethod:@"wp.getUsersBlogs"
+          parameters:[NSArray arrayWithObjects:self.username, self.password, nil]
+          modelClass:[WPBlogModel class]
+             success:success
+             failure:failure];
+}
+
 - (void)getBlogOptionsWithSuccess:(void (^)(id options))success failure:(void (^)(NSError *error))failure
 {
     [self.client callMethod:@"wp.getOptions"
@@ -88,35 +176,64 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
                     }];
 }
 
-#pragma mark - Publishing a post
-
-- (void)publishPostWithText:(NSString *)content title:(NSString *)title success:(void (^)(NSUInteger, NSURL *))success failure:(void (^)(NSError *))failure {
-    NSDictionary *postParameters = [NSDictionary dictionaryWithObjectsAndKeys:
-                                    title, @"post_title",
-                                    content, @"post_content",
-                                    @"publish", @"post_status",
-                                    nil];
-    NSArray *parameters = [self buildParametersWithExtra:postParameters];
-    [self.client callMethod:@"wp.newPost"
-                 parameters:parameters
+- (void)getBlogOptions:(NSArray *)optionNames success:(void (^)(id options))success failure:(void (^)(NSError *error))failure
+{
+    if (![optionNames count]) {
+        [self getBlogOptionsWithSuccess:success failure:failure];
+        return;
+    }
+    [self.client callMethod:@"wp.getOptions"
+                 parameters:[NSArray arrayWithObjects:@(1), self.username, self.password, optionNames, nil]
+               memberFilter:[NSSet setWithArray:optionNames]
+                    element:nil
                     success:^(AFHTTPRequestOperation *operation, id responseObject) {
                         if (success) {
-                            success([responseObject intValue], nil);
+                            success(responseObject);
                         }
-                    }
-                    failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                    } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
                         if (failure) {
                             failure(error);
                         }
                     }];
 }
 
+#pragma mark - Publishing a post
+
+- (void)publishPostWithText:(NSString *)content title:(NSString *)title success:(void (^)(NSUInteger, NSURL *))success failure:(void (^)(NSError *))failure {
+    [self publishPostWithContent:content title:title extraParameters:nil success:success failure:failure];
+}
+
 - (void)publishPostWithImage:(UIImage *)image
                  description:(NSString *)content
                        title:(NSString *)title
                      success:(void (^)(NSUInteger postId, NSURL *permalink))success
                      failure:(void (^)(NSError *error))failure {
-    [self publishPostWithText:content title:title success:success failure:failure];
+    [self publishPostWithImage:image description:content title:title progress:nil success:success failure:failure];
+}
+
+- (void)publishPostWithImage:(UIImage *)image
+                 description:(NSString *)content
+                       title:(NSString *)title
+                    progress:(WordPressXMLRPCApiMediaProgressBlock)progress
+                     success:(void (^)(NSUInteger postId, NSURL *permalink))success
+                     failure:(void (^)(NSError *error))failure {
+    if (!image) {
+        [self publishPostWithText:content title:title success:success failure:failure];
+        return;
+    }
+    [self uploadImages:@[image] progress:progress success:^(NSArray *media) {
+        NSDictionary *uploaded = [media firstObject];
+        NSString *imageTag = [NSString stringWithFormat:@"<img src=\"%@\" class=\"alignnone wp-image-%@\" />", uploaded[@"url"], uploaded[@"id"]];
+        NSMutableDictionary *postParameters = [NSMutableDictionary dictionary];
+        if (uploaded[@"id"]) {
+            postParameters[@"post_thumbnail"] = uploaded[@"id"];
+        }
+        [self publishPostWithContent:[self content:content prependingMedia:imageTag]
+                               title:title
+                     extraParameters:postParameters
+                             success:success
+                             failure:failure];
+    } failure:failure];
 }
 
 - (void)publishPostWithGallery:(NSArray *)images
@@ -124,15 +241,243 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
                          title:(NSString *)title
                        success:(void (^)(NSUInteger postId, NSURL *permalink))success
                        failure:(void (^)(NSError *error))failure {
-    [self publishPostWithText:content title:title success:success failure:failure];
+    [self publishPostWithGallery:images description:content title:title progress:nil success:success failure:failure];
+}
+
+- (void)publishPostWithGallery:(NSArray *)images
+                   description:(NSString *)content
+                         title:(NSString *)title
+                      progress:(WordPressXMLRPCApiMediaProgressBlock)progress
+                       success:(void (^)(NSUInteger postId, NSURL *permalink))success
+                       failure:(void (^)(NSError *error))failure {
+    if (![images count]) {
+        [self publishPostWithText:content title:title success:success failure:failure];
+        return;
+    }
+    [self uploadImages:images progress:progress success:^(NSArray *media) {
+        NSMutableArray *mediaIds = [NSMutableArray arrayWithCapacity:[media count]];
+        for (id uploaded in media) {
+            if ([uploaded isKindOfClass:[NSDictionary class]] && uploaded[@"id"]) {
+                [mediaIds addObject:uploaded[@"id"]];
+            }
+        }
+        NSString *gallery = [NSString stringWithFormat:@"[gallery ids=\"%@\"]", [mediaIds componentsJoinedByString:@","]];
+        [self publishPostWithContent:[self content:content prependingMedia:gallery]
+                               title:title
+                     extraParameters:nil
+                             success:success
+                             failure:failure];
+    } failure:failure];
+}
+
+- (void)publishPostWithVideo:(NSString *)videoPath
+                 description:(NSString *)content
+                       title:(NSString *)title
+                     success:(void (^)(NSUInteger postId, NSURL *permalink))success
+                     failure:(void (^)(NSError *error))failure {
+    [self publishPostWithVideo:videoPath description:content title:title progress:nil success:success failure:failure];
 }
 
 - (void)publishPostWithVideo:(NSString *)videoPath
                  description:(NSString *)content
                        title:(NSString *)title
+                    progress:(WordPressXMLRPCApiMediaProgressBlock)progress
                      success:(void (^)(NSUInteger postId, NSURL *permalink))success
                      failure:(void (^)(NSError *error))failure {
-    [self publishPostWithText:content title:title success:success failure:failure];
+    if (!videoPath) {
+        [self publishPostWithText:content title:title success:success failure:failure];
+        return;
+    }
+    // The video is read from disk while it's being uploaded, it's never loaded in memory
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingAtPath:videoPath];
+    if (!fileHandle) {
+        if (failure) {
+            failure([NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadNoSuchFileError userInfo:@{NSFilePathErrorKey: videoPath}]);
+        }
+        return;
+    }
+    NSDictionary *video = @{
+                            @"name": [videoPath lastPathComponent],
+                            @"type": [self mimeTypeForVideoAtPath:videoPath],
+                            @"bits": fileHandle,
+                            };
+    [self uploadMedia:@[video] progress:progress success:^(NSArray *media) {
+        NSDictionary *uploaded = [media firstObject];
+        NSString *videoShortcode = [NSString stringWithFormat:@"[video src=\"%@\"]", uploaded[@"url"]];
+        [self publishPostWithContent:[self content:content prependingMedia:videoShortcode]
+                               title:title
+                     extraParameters:nil
+                             success:success
+                             failure:failure];
+    } failure:failure];
+}
+
+#pragma mark - Uploading media
+
+- (void)uploadImages:(NSArray *)images
+            progress:(WordPressXMLRPCApiMediaProgressBlock)progress
+             success:(void (^)(NSArray *media))success
+             failure:(void (^)(NSError *error))failure {
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSMutableArray *files = [NSMutableArray arrayWithCapacity:[images count]];
+        __block BOOL encodingFailed = NO;
+        [images enumerateObjectsUsingBlock:^(UIImage *image, NSUInteger idx, BOOL *stop) {
+            NSData *imageData = UIImageJPEGRepresentation(image, 0.9f);
+            if (!imageData) {
+                encodingFailed = YES;
+                *stop = YES;
+                return;
+            }
+            [files addObject:@{
+                               @"name": [NSString stringWithFormat:@"image-%lu.jpg", (unsigned long)idx],
+                               @"type": @"image/jpeg",
+                               @"bits": imageData,
+                               }];
+        }];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            // The post would show a broken image, so nothing is uploaded
+            if (encodingFailed) {
+                if (failure) {
+                    failure([NSError errorWithDomain:WordPressXMLRPCApiErrorDomain
+                                                code:WordPressXMLRPCApiInvalid
+                                            userInfo:@{NSLocalizedDescriptionKey: NSLocalizedStringFromTable(@"The image couldn't be encoded", @"WordPressApi", nil)}]);
+                }
+                return;
+            }
+            [self uploadMedia:files progress:progress success:success failure:failure];
+        });
+    });
+}
+
+/**
+ Uploads every file with `wp.uploadFile`, in parallel on the client's operation queue.
+
+ `success` is called with the uploaded media structs, in the same order as `files`. If any upload fails, or its response has no `url`, the rest are cancelled and `failure` is called once. Uploads finish on the completion queue, which can be concurrent, so their state is only changed on a serial queue of its own.
+ */
+- (void)uploadMedia:(NSArray *)files
+           progress:(WordPressXMLRPCApiMediaProgressBlock)progress
+            success:(void (^)(NSArray *media))success
+            failure:(void (^)(NSError *error))failure {
+    NSMutableArray *uploadedMedia = [NSMutableArray arrayWithCapacity:[files count]];
+    for (NSUInteger i = 0; i < [files count]; i++) {
+        [uploadedMedia addObject:[NSNull null]];
+    }
+    NSMutableArray *operations = [NSMutableArray arrayWithCapacity:[files count]];
+    __block NSUInteger pendingUploads = [files count];
+    __block BOOL failed = NO;
+    dispatch_queue_t stateQueue = dispatch_queue_create("org.wordpress.xmlrpc.upload-media", DISPATCH_QUEUE_SERIAL);
+
+    [files enumerateObjectsUsingBlock:^(NSDictionary *file, NSUInteger idx, BOOL *stop) {
+        NSArray *parameters = [self buildParametersWithExtra:file];
+        NSURLRequest *request = [self.client streamingRequestWithMethod:@"wp.uploadFile" parameters:parameters];
+        if (!request) {
+            failed = YES;
+            *stop = YES;
+            return;
+        }
+        void (^uploadFailure)(NSError *) = ^(NSError *error) {
+            __block BOOL alreadyFailed = NO;
+            dispatch_sync(stateQueue, ^{
+                alreadyFailed = failed;
+                failed = YES;
+            });
+            if (alreadyFailed) {
+                return;
+            }
+            for (AFHTTPRequestOperation *pendingOperation in operations) {
+                [pendingOperation cancel];
+            }
+            if (failure) {
+                failure(error);
+            }
+        };
+        AFHTTPRequestOperation *operation = [self.client HTTPRequestOperationWithRequest:request success:^(AFHTTPRequestOperation *operation, id responseObject) {
+            // The post would link to nothing without the URL of the file
+            if (![responseObject isKindOfClass:[NSDictionary class]] || ![responseObject[@"url"] isKindOfClass:[NSString class]]) {
+                uploadFailure([NSError errorWithDomain:WordPressXMLRPCApiErrorDomain
+                                                  code:WordPressXMLRPCApiInvalid
+                                              userInfo:@{NSLocalizedDescriptionKey: NSLocalizedStringFromTable(@"The server didn't return the uploaded media", @"WordPressApi", nil)}]);
+                return;
+            }
+            __block NSArray *media = nil;
+            dispatch_sync(stateQueue, ^{
+                if (failed) {
+                    return;
+                }
+                [uploadedMedia replaceObjectAtIndex:idx withObject:responseObject];
+                pendingUploads--;
+                if (pendingUploads == 0) {
+                    media = [NSArray arrayWithArray:uploadedMedia];
+                }
+            });
+            if (media && success) {
+                success(media);
+            }
+        } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+            uploadFailure(error);
+        }];
+        if (progress) {
+            [operation setUploadProgressBlock:^(NSUInteger bytesWritten, long long totalBytesWritten, long long totalBytesExpectedToWrite) {
+                progress(idx, totalBytesWritten, totalBytesExpectedToWrite);
+            }];
+        }
+        [operations addObject:operation];
+    }];
+
+    if (failed) {
+        if (failure) {
+            failure([NSError errorWithDomain:WordPressXMLRPCApiErrorDomain
+                                        code:WordPressXMLRPCApiInvalid
+                                    userInfo:@{NSLocalizedDescriptionKey: NSLocalizedStringFromTable(@"The media file couldn't be read", @"WordPressApi", nil)}]);
+        }
+        return;
+    }
+
+    for (AFHTTPRequestOperation *operation in operations) {
+        [self.client enqueueHTTPRequestOperation:operation];
+    }
+}
+
+- (NSString *)mimeTypeForVideoAtPath:(NSString *)path {
+    NSDictionary *mimeTypes = @{
+                                @"mov": @"video/quicktime",
+                                @"mp4": @"video/mp4",
+                                @"m4v": @"video/x-m4v",
+                                @"3gp": @"video/3gpp",
+                                };
+    return mimeTypes[[[path pathExtension] lowercaseString]] ?: @"video/mp4";
+}
+
+- (NSString *)content:(NSString *)content prependingMedia:(NSString *)media {
+    if ([content length] == 0) {
+        return media;
+    }
+    return [NSString stringWithFormat:@"%@\n\n%@", media, content];
+}
+
+- (void)publishPostWithContent:(NSString *)content
+                         title:(NSString *)title
+               extraParameters:(NSDictionary *)extraParameters
+                       success:(void (^)(NSUInteger postId, NSURL *permalink))success
+                       failure:(void (^)(NSError *error))failure {
+    NSMutableDictionary *postParameters = [NSMutableDictionary dictionaryWithDictionary:extraParameters];
+    [postParameters setValue:title forKey:@"post_title"];
+    [postParameters setValue:content forKey:@"post_content"];
+    [postParameters setValue:@"publish" forKey:@"post_status"];
+    NSArray *parameters = [self buildParametersWithExtra:postParameters];
+    [self.client callMethod:@"wp.newPost"
+                 parameters:parameters
+                    success:^(AFHTTPRequestOperation *operation, id responseObject) {
+                        [self.responseCache removeObjectsForEndpoint:self.xmlrpc];
+                        if (success) {
+                            success([responseObject intValue], nil);
+                        }
+                    }
+                    failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                        if (failure) {
+                            failure(error);
+                        }
+                    }];
 }
 
 #pragma mark - Managing posts
@@ -140,7 +485,7 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
 - (void)getPosts:(NSUInteger)count
          success:(void (^)(NSArray *posts))success
          failure:(void (^)(NSError *error))failure {
-    NSArray *parameters = [self buildParametersWithExtra:nil];
+    NSArray *parameters = [self buildParametersWithExtra:@[@(count)]];
     [self.client callMethod:@"metaWeblog.getRecentPosts"
                  parameters:parameters
                     success:^(AFHTTPRequestOperation *operation, id responseObject) {
@@ -155,6 +500,240 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
                     }];
 }
 
+- (void)getPostModels:(NSUInteger)count
+              success:(void (^)(NSArray *posts))success
+              failure:(void (^)(NSError *error))failure {
+    [self callMethod:@"metaWeblog.getRecentPosts"
+          parameters:[self buildParametersWithExtra:@[@(count)]]
+          modelClass:[WPPostModel class]
+             success:success
+             failure:failure];
+}
+
+- (void)getPosts:(NSUInteger)count
+          fields:(NSArray *)fields
+         success:(void (^)(NSArray *posts))success
+         failure:(void (^)(NSError *error))failure {
+    if (![fields count]) {
+        // Same method as with fields, so posts have the same members either way, and the same as the stored ones
+        [self.client callMethod:@"wp.getPosts"
+                     parameters:[self buildParametersWithExtra:@[@{@"number": @(count)}]]
+                        success:^(AFHTTPRequestOperation *operation, id responseObject) {
+                            if ([responseObject isKindOfClass:[NSArray class]]) {
+                                [self.postStore storePosts:responseObject forSite:[self postSyncSiteKey]];
+                            }
+                            if (success) {
+                                success((NSArray *)responseObject);
+                            }
+                        }
+                        failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                            if (failure) {
+                                failure(error);
+                            }
+                        }];
+        return;
+    }
+    // Older sites and some plugins ignore `fields`, so unrequested members are skipped while decoding too
+    NSSet *memberFilter = [[NSSet setWithArray:fields] setByAddingObject:@"post_id"];
+    NSArray *parameters = [self buildParametersWithExtra:@[@{@"number": @(count)}, fields]];
+    [self.client callMethod:@"wp.getPosts"
+                 parameters:parameters
+               memberFilter:memberFilter
+                    element:nil
+                    success:^(AFHTTPRequestOperation *operation, id responseObject) {
+                        if (success) {
+                            success((NSArray *)responseObject);
+                        }
+                    }
+                    failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                        if (failure) {
+                            failure(error);
+                        }
+                    }];
+}
+
+- (void)getPosts:(NSUInteger)count
+     postHandler:(void (^)(NSDictionary *post))postHandler
+         success:(void (^)())success
+         failure:(void (^)(NSError *error))failure {
+    NSArray *parameters = [self buildParametersWithExtra:@[@(count)]];
+    [self.client callMethod:@"metaWeblog.getRecentPosts"
+                 parameters:parameters
+                    element:^(id element, NSUInteger index) {
+                        if (![element isKindOfClass:[NSDictionary class]]) {
+                            return;
+                        }
+                        if (postHandler) {
+                            postHandler(element);
+                        }
+                    }
+                    success:^(AFHTTPRequestOperation *operation, id responseObject) {
+                        if (success) {
+                            success();
+                        }
+                    }
+                    failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                        if (failure) {
+                            failure(error);
+                        }
+                    }];
+}
+
+- (void)syncPostsWithPageSize:(NSUInteger)pageSize
+                  pageHandler:(void (^)(NSArray *posts))pageHandler
+                      success:(void (^)(NSDate *highWaterMark))success
+                      failure:(void (^)(NSError *error))failure {
+    NSString *site = [self postSyncSiteKey];
+    NSDate *since = [WPPostSyncState highWaterMarkForSite:site];
+    WPPostStore *postStore = self.postStore;
+    [self syncPostsFromOffset:0
+                     pageSize:MAX(pageSize, 1)
+                        since:since
+               cursorModified:nil
+                cursorPostIds:nil
+                highWaterMark:nil
+                  pageHandler:^(NSArray *posts) {
+                      [postStore storePosts:posts forSite:site];
+                      if (pageHandler) {
+                          pageHandler(posts);
+                      }
+                  }
+                      success:^(NSDate *highWaterMark) {
+                          if (highWaterMark) {
+                              [WPPostSyncState setHighWaterMark:highWaterMark forSite:site];
+                          }
+                          if (success) {
+                              success(highWaterMark ?: since);
+                          }
+                      }
+                      failure:failure];
+}
+
+- (void)resetPostsSync {
+    [WPPostSyncState setHighWaterMark:nil forSite:[self postSyncSiteKey]];
+}
+
+- (NSArray *)storedPosts:(NSUInteger)count {
+    return [self.postStore postsForSite:[self postSyncSiteKey] limit:count] ?: @[];
+}
+
+/**
+ Requests a page of posts, most recently modified first, and keeps paging until a page is short or reaches posts already synced.
+
+ `wp.getPosts` can only page by offset, which shifts when posts are edited or deleted during the sync. So each page after the first also asks for the last post already received, and posts are matched against a cursor: the oldest modified date received and the IDs received with it. Posts at or after the cursor are skipped as already received. A page that doesn't reach back to the cursor means posts were removed before the offset, and the sync steps back a page so none are missed.
+
+ The streaming call is used so pages are never served from the response cache.
+ */
+- (void)syncPostsFromOffset:(NSUInteger)offset
+                   pageSize:(NSUInteger)pageSize
+                      since:(NSDate *)since
+             cursorModified:(NSDate *)cursorModified
+              cursorPostIds:(NSSet *)cursorPostIds
+              highWaterMark:(NSDate *)highWaterMark
+                pageHandler:(void (^)(NSArray *posts))pageHandler
+                    success:(void (^)(NSDate *highWaterMark))success
+                    failure:(void (^)(NSError *error))failure {
+    // Overlap the previous page by one post, to tell whether the offset shifted
+    BOOL overlaps = cursorModified && offset > 0;
+    NSUInteger requestOffset = overlaps ? offset - 1 : offset;
+    NSUInteger requestCount = overlaps ? pageSize + 1 : pageSize;
+    NSDictionary *filter = @{
+                             @"post_type": @"post",
+                             @"number": @(requestCount),
+                             @"offset": @(requestOffset),
+                             @"orderby": @"modified",
+                             @"order": @"DESC",
+                             };
+    NSArray *parameters = [self buildParametersWithExtra:filter];
+    NSMutableArray *posts = [NSMutableArray arrayWithCapacity:pageSize];
+    __block NSUInteger received = 0;
+    __block BOOL reachedCursor = NO;
+    __block BOOL reachedSyncedPosts = NO;
+    __block NSDate *newestModified = highWaterMark;
+    __block NSDate *oldestModified = cursorModified;
+    NSMutableSet *oldestPostIds = [NSMutableSet setWithSet:cursorPostIds ?: [NSSet set]];
+    [self.client callMethod:@"wp.getPosts"
+                 parameters:parameters
+                    element:^(id element, NSUInteger index) {
+                        received++;
+                        if (![element isKindOfClass:[NSDictionary class]] || reachedSyncedPosts) {
+                            return;
+                        }
+                        NSDate *modified = element[@"post_modified_gmt"];
+                        if (![modified isKindOfClass:[NSDate class]]) {
+                            modified = nil;
+                        }
+                        NSString *postId = [element[@"post_id"] description];
+                        if (cursorModified && modified) {
+                            NSComparisonResult order = [modified compare:cursorModified];
+                            if (order == NSOrderedDescending || (order == NSOrderedSame && [cursorPostIds containsObject:postId])) {
+                                reachedCursor = YES;
+                                return;
+                            }
+                        }
+                        if (since && modified && [modified compare:since] == NSOrderedAscending) {
+                            reachedSyncedPosts = YES;
+                            return;
+                        }
+                        if (modified && (!newestModified || [modified compare:newestModified] == NSOrderedDescending)) {
+                            newestModified = modified;
+                        }
+                        if (modified) {
+                            if (!oldestModified || [modified compare:oldestModified] == NSOrderedAscending) {
+                                oldestModified = modified;
+                                [oldestPostIds removeAllObjects];
+                            }
+                            if ([modified isEqualToDate:oldestModified] && postId) {
+                                [oldestPostIds addObject:postId];
+                            }
+                        }
+                        [posts addObject:element];
+                    }
+                    success:^(AFHTTPRequestOperation *operation, id responseObject) {
+                        if (overlaps && requestOffset > 0 && received > 0 && !reachedCursor && !reachedSyncedPosts) {
+                            // Posts were removed before the offset, so the page may have skipped some: step back
+                            NSUInteger previousOffset = requestOffset > pageSize ? requestOffset - pageSize + 1 : 1;
+                            [self syncPostsFromOffset:previousOffset
+                                             pageSize:pageSize
+                                                since:since
+                                       cursorModified:cursorModified
+                                        cursorPostIds:cursorPostIds
+                                        highWaterMark:highWaterMark
+                                          pageHandler:pageHandler
+                                              success:success
+                                              failure:failure];
+                            return;
+                        }
+                        if (pageHandler && [posts count]) {
+                            pageHandler([NSArray arrayWithArray:posts]);
+                        }
+                        if (reachedSyncedPosts || received < requestCount) {
+                            if (success) {
+                                success(newestModified);
+                            }
+                            return;
+                        }
+                        [self syncPostsFromOffset:requestOffset + received
+                                         pageSize:pageSize
+                                            since:since
+                                   cursorModified:oldestModified
+                                    cursorPostIds:oldestPostIds
+                                    highWaterMark:newestModified
+                                      pageHandler:pageHandler
+                                          success:success
+                                          failure:failure];
+                    }
+                    failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                        if (failure) {
+                            failure(error);
+                        }
+                    }];
+}
+
+- (NSString *)postSyncSiteKey {
+    return [NSString stringWithFormat:@"%@#%@", [self.xmlrpc absoluteString], self.username];
+}
+
 #pragma mark - Helpers
 
 + (NSURL *)urlForXMLRPCFromUrl:(NSString *)url addXMLRPC:(BOOL) addXMLRPC error:(NSError **)error
@@ -221,70 +800,128 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
         }
         return;
     }
-    [self logExtraInfo: @"Trying the following URL: %@", xmlrpcURL ];
-    [self validateXMLRPCUrl:xmlrpcURL success:^(NSURL *validatedXmlrpcURL){
+    NSURL *originalXmlrpcURL = [self urlForXMLRPCFromUrl:url addXMLRPC:NO error:nil];
+    NSString *cacheKey = [self discoveredEndpointKeyForURL:xmlrpcURL];
+
+    void (^discoveredSuccess)(NSURL *) = ^(NSURL *validatedXmlrpcURL){
+        [self storeDiscoveredEndpoint:validatedXmlrpcURL forKey:cacheKey];
         if (success) {
             success(validatedXmlrpcURL);
         }
-    } failure:^(NSError *error){
+    };
+    void (^discover)(void) = ^{
+        [self discoverXMLRPCURLForSite:url xmlrpcURL:xmlrpcURL originalXmlrpcURL:originalXmlrpcURL success:discoveredSuccess failure:failure];
+    };
+
+    // -------------------------------------------
+    // Skip the discovery if we already found the endpoint for this site
+    // -------------------------------------------
+    NSURL *cachedXmlrpcURL = [self discoveredEndpointForKey:cacheKey];
+    if (cachedXmlrpcURL == nil) {
+        discover();
+        return;
+    }
+    [self logExtraInfo:@"Trying the previously discovered endpoint: %@", cachedXmlrpcURL];
+    [self validateXMLRPCUrl:cachedXmlrpcURL discovery:nil success:discoveredSuccess failure:^(NSError *error){
         [self logError:error];
-        if (([error.domain isEqual:NSURLErrorDomain] && error.code == NSURLErrorUserCancelledAuthentication)
-            || ([error.domain isEqual:WordPressXMLRPCApiErrorDomain] && error.code == WordPressXMLRPCApiMobilePluginRedirectedError)) {
+        if ([self isFatalDiscoveryError:error]) {
             if (failure) {
                 failure(error);
             }
             return;
         }
-        // -------------------------------------------
-        // Try the original given url as an XML-RPC endpoint
-        // -------------------------------------------
-        NSURL *originalXmlrpcURL = [self urlForXMLRPCFromUrl:url addXMLRPC:NO error:nil];
-        [self logExtraInfo: @"Try the given url as an XML-RPC endpoint: %@", originalXmlrpcURL];
-        [self validateXMLRPCUrl:originalXmlrpcURL success:^(NSURL *validatedXmlrpcURL){
-            if (success) {
-                success(validatedXmlrpcURL);
-            }
-        } failure:^(NSError *error){
-            [self logError:error];
-            if ([error.domain isEqual:WordPressXMLRPCApiErrorDomain] && error.code == WordPressXMLRPCApiMobilePluginRedirectedError) {
-                if (failure) {
-                    failure(error);
-                }
-                return;
-            }
-            // Fetch the original url and look for the RSD link
-            [self guessXMLRPCURLFromHTMLURL:originalXmlrpcURL success:success failure:failure];
-        }];
-    }];}
+        [self storeDiscoveredEndpoint:nil forKey:cacheKey];
+        discover();
+    }];
+}
+
++ (void)discoverXMLRPCURLForSite:(NSString *)url
+                       xmlrpcURL:(NSURL *)xmlrpcURL
+               originalXmlrpcURL:(NSURL *)originalXmlrpcURL
+                         success:(void (^)(NSURL *xmlrpcURL))success
+                         failure:(void (^)(NSError *error))failure {
+    NSMutableArray *strategies = [NSMutableArray array];
+    // -------------------------------------------
+    // The given url is the home page and XML-RPC sits at /xmlrpc.php
+    // -------------------------------------------
+    [strategies addObject:[^(WPXMLRPCEndpointDiscovery *discovery, void (^found)(NSURL *), void (^failed)(NSError *)) {
+        [self logExtraInfo: @"Trying the following URL: %@", xmlrpcURL ];
+        [self validateXMLRPCUrl:xmlrpcURL discovery:discovery success:found failure:failed];
+    } copy]];
+    // -------------------------------------------
+    // The original given url is the XML-RPC endpoint
+    // -------------------------------------------
+    if (![originalXmlrpcURL isEqual:xmlrpcURL]) {
+        [strategies addObject:[^(WPXMLRPCEndpointDiscovery *discovery, void (^found)(NSURL *), void (^failed)(NSError *)) {
+            [self logExtraInfo: @"Try the given url as an XML-RPC endpoint: %@", originalXmlrpcURL];
+            [self validateXMLRPCUrl:originalXmlrpcURL discovery:discovery success:found failure:failed];
+        } copy]];
+    }
+    // -------------------------------------------
+    // No scheme was given, so the site might only answer over HTTPS
+    // -------------------------------------------
+    if ([NSURL URLWithString:url].scheme == nil) {
+        NSURLComponents *components = [NSURLComponents componentsWithURL:xmlrpcURL resolvingAgainstBaseURL:NO];
+        components.scheme = @"https";
+        NSURL *secureXmlrpcURL = components.URL;
+        if (secureXmlrpcURL) {
+            [strategies addObject:[^(WPXMLRPCEndpointDiscovery *discovery, void (^found)(NSURL *), void (^failed)(NSError *)) {
+                [self logExtraInfo: @"Trying the following URL: %@", secureXmlrpcURL];
+                [self validateXMLRPCUrl:secureXmlrpcURL discovery:discovery success:found failure:failed];
+            } copy]];
+        }
+    }
+    // -------------------------------------------
+    // Fetch the original url and look for the RSD link
+    // -------------------------------------------
+    NSUInteger htmlStrategyIndex = [strategies count];
+    [strategies addObject:[^(WPXMLRPCEndpointDiscovery *discovery, void (^found)(NSURL *), void (^failed)(NSError *)) {
+        [self guessXMLRPCURLFromHTMLURL:originalXmlrpcURL discovery:discovery success:found failure:failed];
+    } copy]];
+
+    WPXMLRPCEndpointDiscovery *discovery = [[WPXMLRPCEndpointDiscovery alloc] initWithStrategies:strategies];
+    // The HTML page error is the most meaningful one, as it's the page the user asked for
+    discovery.preferredErrorStrategyIndex = htmlStrategyIndex;
+    discovery.isFatalError = ^BOOL(NSError *error) {
+        return [self isFatalDiscoveryError:error];
+    };
+    [discovery startWithSuccess:success failure:failure];
+}
+
++ (BOOL)isFatalDiscoveryError:(NSError *)error {
+    return ([error.domain isEqual:NSURLErrorDomain] && error.code == NSURLErrorUserCancelledAuthentication)
+        || ([error.domain isEqual:WordPressXMLRPCApiErrorDomain] && error.code == WordPressXMLRPCApiMobilePluginRedirectedError);
+}
 
 + (void)guessXMLRPCURLFromHTMLURL:(NSURL *)htmlURL
+                        discovery:(WPXMLRPCEndpointDiscovery *)discovery
                       success:(void (^)(NSURL *xmlrpcURL))success
                       failure:(void (^)(NSError *error))failure {
-    [self logExtraInfo:@"Fetch the original url and look for the RSD link by using RegExp"];
-    NSURLRequest *request = [NSURLRequest requestWithURL:htmlURL];
-    AFHTTPRequestOperation *operation = [[AFHTTPRequestOperation alloc] initWithRequest:request];
-    [operation setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
-        NSError *error = nil;
-        NSString *responseString = operation.responseString;
-        NSArray *matches = nil;
-        if (responseString) {
-            NSRegularExpression *rsdURLRegExp = [NSRegularExpression regularExpressionWithPattern:@"<link\\s+rel=\"EditURI\"\\s+type=\"application/rsd\\+xml\"\\s+title=\"RSD\"\\s+href=\"([^\"]*)\"[^/]*/>" options:NSRegularExpressionCaseInsensitive error:&error];
-            matches = [rsdURLRegExp matchesInString:responseString options:0 range:NSMakeRange(0, [responseString length])];
+    [self logExtraInfo:@"Fetch the original url and scan its head for the RSD link"];
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:htmlURL];
+    request.timeoutInterval = WordPressXMLRPCApiDiscoveryPageTimeout;
+    WPHTTPRequestOperation *operation = [[WPHTTPRequestOperation alloc] initWithRequest:request];
+    WPRSDLinkScanner *scanner = [[WPRSDLinkScanner alloc] init];
+    __weak WPHTTPRequestOperation *weakOperation = operation;
+    operation.dataReceivedBlock = ^(NSData *data) {
+        WPHTTPRequestOperation *operation = weakOperation;
+        // Error pages are left to fail as usual
+        if (![operation.responseSerializer.acceptableStatusCodes containsIndex:(NSUInteger)operation.response.statusCode]) {
+            return;
         }
-        NSString *rsdURL = nil;
-        if ([matches count]) {
-            NSRange rsdURLRange = [[matches objectAtIndex:0] rangeAtIndex:1];
-            if(rsdURLRange.location != NSNotFound)
-                rsdURL = [responseString substringWithRange:rsdURLRange];
+        if (!scanner.isFinished && [scanner appendData:data]) {
+            // No need to download the rest of the page
+            [operation cancel];
         }
+    };
 
+    void (^scannedPage)(void) = ^{
+        NSString *rsdURL = scanner.rsdURL;
         if (rsdURL == nil) {
             if (failure) {
-                if (error == nil) {
-                    error = [NSError errorWithDomain:WordPressXMLRPCApiErrorDomain
-                                                code:WordPressXMLRPCApiInvalid
-                                            userInfo:@{NSLocalizedDescriptionKey:NSLocalizedString(@"Cannot find a valid WordPress XMLRPC endpoint", @"Message to show when not valid WordPress XMLRPC endpoint is found on the URL provided")}];
-                }
+                NSError *error = [NSError errorWithDomain:WordPressXMLRPCApiErrorDomain
+                                                     code:WordPressXMLRPCApiInvalid
+                                                 userInfo:@{NSLocalizedDescriptionKey:NSLocalizedString(@"Cannot find a valid WordPress XMLRPC endpoint", @"Message to show when not valid WordPress XMLRPC endpoint is found on the URL provided")}];
                 failure(error);
             }
             return;
@@ -293,37 +930,53 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
         NSString *xmlrpc = [rsdURL stringByReplacingOccurrencesOfString:@"?rsd" withString:@""];
         if (![xmlrpc isEqualToString:rsdURL]) {
             NSURL *xmlrpcURL = [NSURL URLWithString:xmlrpc];
-            [self validateXMLRPCUrl:xmlrpcURL success:^(NSURL *validatedXmlrpcURL){
+            [self validateXMLRPCUrl:xmlrpcURL discovery:discovery success:^(NSURL *validatedXmlrpcURL){
                 if (success) {
                     success(validatedXmlrpcURL);
                 }
             } failure:^(NSError *error){
-                [self guessXMLRPCURLFromRSD:rsdURL success:success failure:failure];
+                [self guessXMLRPCURLFromRSD:rsdURL discovery:discovery success:success failure:failure];
             }];
         } else {
-            [self guessXMLRPCURLFromRSD:rsdURL success:success failure:failure];
+            [self guessXMLRPCURLFromRSD:rsdURL discovery:discovery success:success failure:failure];
         }
+    };
+    [operation setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
+        scannedPage();
     } failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+        // The scanner cancels the download once it's done with the head
+        if (scanner.isFinished && !discovery.isFinished) {
+            scannedPage();
+            return;
+        }
         [self logError:error];
         if (failure) failure(error);
     }];
+    [discovery addOperation:operation];
     NSOperationQueue *queue = [[NSOperationQueue alloc] init];
     [queue addOperation:operation];
 }
 
 + (void)guessXMLRPCURLFromRSD:(NSString *)rsd
+                    discovery:(WPXMLRPCEndpointDiscovery *)discovery
                          success:(void (^)(NSURL *xmlrpcURL))success
                          failure:(void (^)(NSError *error))failure {
     [self logExtraInfo:@"Parse the RSD document at the following URL: %@", rsd];
     NSURL *rsdURL = [NSURL URLWithString:rsd];
-    NSURLRequest *request = [NSURLRequest requestWithURL:rsdURL];
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:rsdURL];
+    request.timeoutInterval = WordPressXMLRPCApiDiscoveryPageTimeout;
     AFHTTPRequestOperation *operation = [[AFHTTPRequestOperation alloc] initWithRequest:request];
     [operation setCompletionBlockWithSuccess:^(AFHTTPRequestOperation *operation, id responseObject) {
         NSError *error;
-        WPRSDParser *parser = [[WPRSDParser alloc] initWithXmlString:operation.responseString];
+        WPRSDParser *parser = [[WPRSDParser alloc] initWithData:operation.responseData];
         NSString *parsedEndpoint = [parser parsedEndpointWithError:&error];
         if (parsedEndpoint == nil) {
             if (failure) {
+                if (error == nil) {
+                    error = [NSError errorWithDomain:WordPressXMLRPCApiErrorDomain
+                                                code:WordPressXMLRPCApiInvalid
+                                            userInfo:@{NSLocalizedDescriptionKey:NSLocalizedString(@"Cannot find a valid WordPress XMLRPC endpoint", @"Message to show when not valid WordPress XMLRPC endpoint is found on the URL provided")}];
+                }
                 failure(error);
             }
             return;
@@ -331,7 +984,7 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
         NSString *xmlrpc = parsedEndpoint;
         NSURL *xmlrpcURL = [NSURL URLWithString:xmlrpc];
         [self logExtraInfo:@"Bingo! We found the WordPress XML-RPC element: %@", xmlrpcURL];
-        [self validateXMLRPCUrl:xmlrpcURL success:^(NSURL *validatedXmlrpcURL){
+        [self validateXMLRPCUrl:xmlrpcURL discovery:discovery success:^(NSURL *validatedXmlrpcURL){
             if (success) {
                 success(validatedXmlrpcURL);
             }
@@ -343,9 +996,50 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
         [self logError:error];
         if (failure) failure(error);
     }];
+    [discovery addOperation:operation];
     NSOperationQueue *queue = [[NSOperationQueue alloc] init];
     [queue addOperation:operation];
 }
+
+#pragma mark - Discovered endpoints
+
++ (NSString *)discoveredEndpointKeyForURL:(NSURL *)xmlrpcURL {
+    NSString *path = xmlrpcURL.path ?: @"";
+    if ([[path lastPathComponent] isEqualToString:@"xmlrpc.php"]) {
+        path = [path stringByDeletingLastPathComponent];
+    }
+    while ([path hasSuffix:@"/"]) {
+        path = [path substringToIndex:[path length] - 1];
+    }
+    NSString *port = xmlrpcURL.port ? [NSString stringWithFormat:@":%@", xmlrpcURL.port] : @"";
+    // The scheme is part of the key, so a site asked for over HTTPS is never answered with an HTTP endpoint
+    return [NSString stringWithFormat:@"%@://%@%@%@", [xmlrpcURL.scheme lowercaseString], [xmlrpcURL.host lowercaseString], port, path];
+}
+
++ (NSURL *)discoveredEndpointForKey:(NSString *)key {
+    NSDictionary *endpoints = [[NSUserDefaults standardUserDefaults] dictionaryForKey:WordPressXMLRPCApiDiscoveredEndpointsKey];
+    NSString *endpoint = endpoints[key];
+    return [endpoint isKindOfClass:[NSString class]] ? [NSURL URLWithString:endpoint] : nil;
+}
+
++ (void)storeDiscoveredEndpoint:(NSURL *)xmlrpcURL forKey:(NSString *)key {
+    if (key == nil) {
+        return;
+    }
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    NSMutableDictionary *endpoints = [[defaults dictionaryForKey:WordPressXMLRPCApiDiscoveredEndpointsKey] mutableCopy] ?: [NSMutableDictionary dictionary];
+    if (xmlrpcURL) {
+        endpoints[key] = [xmlrpcURL absoluteString];
+    } else {
+        [endpoints removeObjectForKey:key];
+    }
+    [defaults setObject:endpoints forKey:WordPressXMLRPCApiDiscoveredEndpointsKey];
+}
+
++ (void)removeDiscoveredEndpoints {
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:WordPressXMLRPCApiDiscoveredEndpointsKey];
+}
+
 #pragma mark - Private Methods
 
 - (NSArray *)buildParametersWithExtra:(id)extra {
@@ -362,9 +1056,34 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
     return [NSArray arrayWithArray:result];
 }
 
-+ (void)validateXMLRPCUrl:(NSURL *)url success:(void (^)(NSURL *validatedXmlrpURL))success failure:(void (^)(NSError *error))failure {
+/**
+ Calls a method returning an array of structs, and hands them back as lazily decoded models.
+
+ The call goes straight to an operation, so it skips batching and the response cache, which both keep decoded objects.
+ */
+- (void)callMethod:(NSString *)method parameters:(NSArray *)parameters modelClass:(Class)modelClass success:(void (^)(NSArray *models))success failure:(void (^)(NSError *error))failure {
+    NSMutableURLRequest *request = [self.client requestWithMethod:method parameters:parameters];
+    AFHTTPRequestOperation *operation = [self.client HTTPRequestOperationWithRequest:request
+                                                                      responseParser:^id(NSData *responseData, NSError **error) {
+                                                                          return [modelClass modelsWithXMLRPCResponseData:responseData error:error];
+                                                                      }
+                                                                             success:^(AFHTTPRequestOperation *operation, id responseObject) {
+                                                                                 if (success) {
+                                                                                     success(responseObject);
+                                                                                 }
+                                                                             }
+                                                                             failure:^(AFHTTPRequestOperation *operation, NSError *error) {
+                                                                                 if (failure) {
+                                                                                     failure(error);
+                                                                                 }
+                                                                             }];
+    [self.client enqueueHTTPRequestOperation:operation];
+}
+
++ (void)validateXMLRPCUrl:(NSURL *)url discovery:(WPXMLRPCEndpointDiscovery *)discovery success:(void (^)(NSURL *validatedXmlrpURL))success failure:(void (^)(NSError *error))failure {
     WPXMLRPCClient *client = [WPXMLRPCClient clientWithXMLRPCEndpoint:url];
-    NSURLRequest *request = [client requestWithMethod:@"system.listMethods" parameters:@[]];
+    NSMutableURLRequest *request = [client requestWithMethod:@"system.listMethods" parameters:@[]];
+    request.timeoutInterval = WordPressXMLRPCApiDiscoveryValidationTimeout;
     __block BOOL isRedirected = NO;
     AFHTTPRequestOperation *operation = [client HTTPRequestOperationWithRequest:request success:^(AFHTTPRequestOperation *operation, id responseObject) {
         NSArray *methods = responseObject;
@@ -399,12 +1118,14 @@ NSString *const WordPressXMLRPCApiErrorDomain = @"WordPressXMLRPCApiError";
             [self logExtraInfo:@"Redirected to %@", redirectRequest.URL];
             NSMutableURLRequest *postRequest = postRequest = [client requestWithMethod:@"system.listMethods" parameters:@[]];
             [postRequest setURL:redirectRequest.URL];
+            postRequest.timeoutInterval = WordPressXMLRPCApiDiscoveryValidationTimeout;
             return postRequest;
         }
 
         return redirectRequest;
     }];
 
+    [discovery addOperation:operation];
     [client enqueueHTTPRequestOperation:operation];
 }
 